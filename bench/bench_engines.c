@@ -0,0 +1,102 @@
+#include <expression.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <summation.h>
+#include <time.h>
+
+#define LOWER_BOUND 1
+#define UPPER_BOUND 2000000
+#define NANOSECONDS_PER_SECOND 1000000000.0
+
+static double seconds_now(void) {
+	struct timespec time;
+	(void)clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+ * @brief Sums by walking the expression tree for every index, as summations used to.
+ */
+static double summation_tree(long lower_bound, long upper_bound, const char *summand) {
+	struct environment environment = environment_new();
+	struct expression expression = expression_from_string(summand);
+	expression_simplify(&expression, &environment);
+
+	double sum = 0;
+	for (long i = lower_bound; i <= upper_bound; i++) {
+		environment_set_variable(&environment, 'i', (double)i);
+		sum += expression_evaluate(&expression, &environment);
+	}
+
+	expression_drop(&expression);
+
+	return sum;
+}
+
+static double summation_engine(
+	long lower_bound,
+	long upper_bound,
+	const char *summand,
+	enum summation_engine engine
+) {
+	struct summation_options options = summation_options_default();
+	options.threads_count = 1;
+	options.engine = engine;
+
+	double sum = 0;
+	summation_fused(lower_bound, upper_bound, 1, &summand, &sum, &options);
+
+	return sum;
+}
+
+int main(void) {
+	const char *summands[] = {
+		"i",
+		"1 / i ^ 2",
+		"(i + 1) * (i - 1) / (i * i + 3)",
+		"(i * 2 + 1) * (i * 3 - 2) * (i + 7) - i * i * i / (i + 1)",
+		"sin(i) / i",
+		"sin(i) * cos(i) + exp(-i / 1000000)",
+		"if(i % 3, max(i - 500000, 0), -abs(i - 1000)) / (i + 1)",
+	};
+
+	printf("single thread, %d terms, nanoseconds per term\n", UPPER_BOUND - LOWER_BOUND + 1);
+	printf("%-60s %8s %8s %8s %10s\n", "summand", "tree", "scalar", "block", "recurrence");
+
+	for (size_t i = 0; i < sizeof(summands) / sizeof(summands[0]); i++) {
+		double nanoseconds[4];
+		double sums[4];
+
+		double start = seconds_now();
+		sums[0] = summation_tree(LOWER_BOUND, UPPER_BOUND, summands[i]);
+		nanoseconds[0] = seconds_now() - start;
+
+		start = seconds_now();
+		sums[1] = summation_engine(LOWER_BOUND, UPPER_BOUND, summands[i], summation_engine_scalar);
+		nanoseconds[1] = seconds_now() - start;
+
+		start = seconds_now();
+		sums[2] = summation_engine(LOWER_BOUND, UPPER_BOUND, summands[i], summation_engine_block);
+		nanoseconds[2] = seconds_now() - start;
+
+		start = seconds_now();
+		sums[3] =
+			summation_engine(LOWER_BOUND, UPPER_BOUND, summands[i], summation_engine_recurrence);
+		nanoseconds[3] = seconds_now() - start;
+
+		for (size_t j = 0; j < 4; j++) {
+			nanoseconds[j] *= NANOSECONDS_PER_SECOND / (UPPER_BOUND - LOWER_BOUND + 1);
+		}
+
+		printf(
+			"%-60s %8.2f %8.2f %8.2f %10.2f%s\n",
+			summands[i],
+			nanoseconds[0],
+			nanoseconds[1],
+			nanoseconds[2],
+			nanoseconds[3],
+			// the plain loop adds up the terms in a different order, and recurrences round differently
+			sums[1] == sums[2] ? "" : "  (engines disagree)"
+		);
+	}
+}
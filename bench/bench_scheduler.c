@@ -0,0 +1,179 @@
+#include <math.h>
+#include <pthread.h>
+#include <scheduler.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <summation.h>
+#include <time.h>
+
+#define LEAVES_COUNT 1024
+#define WORK_PER_LEAF 2000
+#define NANOSECONDS_PER_SECOND 1000000000.0
+
+static double seconds_now(void) {
+	struct timespec time;
+	(void)clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+ * @brief The cost of each leaf of a workload, in units of work.
+ */
+typedef size_t (*workload)(size_t leaf);
+
+static size_t workload_uniform(size_t leaf) {
+	(void)leaf;
+	return WORK_PER_LEAF;
+}
+
+// like the outer loop of a triangular nested loop
+static size_t workload_triangular(size_t leaf) {
+	return 2 * WORK_PER_LEAF * leaf / LEAVES_COUNT;
+}
+
+// like `i^i`, where the last few terms dominate the cost
+static size_t workload_tail(size_t leaf) {
+	return leaf >= LEAVES_COUNT - LEAVES_COUNT / 16 ? 16 * WORK_PER_LEAF : WORK_PER_LEAF / 16;
+}
+
+struct context {
+	workload workload;
+	double results[LEAVES_COUNT];
+};
+
+static void leaf_function(void *context_, size_t thread, size_t leaf) {
+	(void)thread;
+
+	struct context *context = context_;
+
+	double result = 0;
+	size_t work = context->workload(leaf);
+	for (size_t i = 0; i < work; i++) {
+		result += sin((double)(leaf + i));
+	}
+	context->results[leaf] = result;
+}
+
+/**
+ * @brief A static split of the leaves into one contiguous share per thread, for comparison.
+ */
+struct static_thread {
+	struct context *context;
+	size_t thread;
+	size_t threads_count;
+	double busy_seconds;
+};
+
+static void *static_thread(void *argument) {
+	struct static_thread *thread = argument;
+
+	double start = seconds_now();
+	size_t first = thread->thread * LEAVES_COUNT / thread->threads_count;
+	size_t last = (thread->thread + 1) * LEAVES_COUNT / thread->threads_count;
+	for (size_t leaf = first; leaf < last; leaf++) {
+		leaf_function(thread->context, thread->thread, leaf);
+	}
+	thread->busy_seconds = seconds_now() - start;
+
+	return NULL;
+}
+
+static double run_static(struct context *context, size_t threads_count, double busy_seconds[]) {
+	struct static_thread threads[threads_count];
+	pthread_t handles[threads_count];
+
+	double start = seconds_now();
+	for (size_t i = 0; i < threads_count; i++) {
+		threads[i] = (struct static_thread){
+			.context = context,
+			.thread = i,
+			.threads_count = threads_count,
+		};
+		pthread_create(&handles[i], NULL, static_thread, &threads[i]);
+	}
+	for (size_t i = 0; i < threads_count; i++) {
+		pthread_join(handles[i], NULL);
+		busy_seconds[i] = threads[i].busy_seconds;
+	}
+
+	return seconds_now() - start;
+}
+
+/**
+ * @brief The ratio of the busiest thread's time to the mean time, 1 is a perfect balance.
+ */
+static double imbalance(const double busy_seconds[], size_t threads_count) {
+	double maximum = 0;
+	double total = 0;
+	for (size_t i = 0; i < threads_count; i++) {
+		maximum = fmax(maximum, busy_seconds[i]);
+		total += busy_seconds[i];
+	}
+	return total > 0 ? maximum * (double)threads_count / total : 1;
+}
+
+int main(void) {
+	size_t threads_count = scheduler_default_threads_count();
+	if (threads_count < 2) {
+		threads_count = 4;
+	}
+
+	const struct {
+		const char *name;
+		workload workload;
+	} workloads[] = {
+		{ "uniform", workload_uniform },
+		{ "triangular", workload_triangular },
+		{ "tail", workload_tail },
+	};
+
+	printf("%zu threads, %d leaves\n", threads_count, LEAVES_COUNT);
+	printf("%-12s %-15s %10s %10s %8s\n", "workload", "scheduler", "seconds", "imbalance", "steals");
+
+	double busy_seconds[threads_count];
+	size_t leaves_count[threads_count];
+	for (size_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+		struct context context = { .workload = workloads[i].workload };
+
+		double seconds = run_static(&context, threads_count, busy_seconds);
+		printf(
+			"%-12s %-15s %10.4f %10.3f %8s\n",
+			workloads[i].name,
+			"static",
+			seconds,
+			imbalance(busy_seconds, threads_count),
+			"-"
+		);
+
+		struct scheduler_statistics statistics = {
+			.busy_seconds = busy_seconds,
+			.leaves_count = leaves_count,
+		};
+		double start = seconds_now();
+		scheduler_run(threads_count, LEAVES_COUNT, leaf_function, &context, &statistics);
+		seconds = seconds_now() - start;
+		printf(
+			"%-12s %-15s %10.4f %10.3f %8zu\n",
+			workloads[i].name,
+			"work-stealing",
+			seconds,
+			imbalance(busy_seconds, threads_count),
+			statistics.steals_count
+		);
+	}
+
+	const char *summands[] = { "i ^ (i / 1000000)", "sin(i) * log(i)" };
+
+	printf("\n%-20s %8s %10s %s\n", "summand", "threads", "seconds", "sum");
+	for (size_t i = 0; i < sizeof(summands) / sizeof(summands[0]); i++) {
+		for (size_t threads = 1; threads <= threads_count; threads *= 2) {
+			struct summation_options options = summation_options_default();
+			options.threads_count = threads;
+
+			double sum = 0;
+			double start = seconds_now();
+			summation_fused(1, 4000000, 1, &summands[i], &sum, &options);
+			printf("%-20s %8zu %10.4f %.17g\n", summands[i], threads, seconds_now() - start, sum);
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The initial value of a cache hash.
+ */
+#define CACHE_HASH_INITIAL UINT64_C(0xcbf29ce484222325)
+
+/**
+ * @brief Hashes data for use as a cache key.
+ *
+ * Continues the 64-bit FNV-1a hash `hash` with the `size` bytes of `data`, so that a key made of
+ * several pieces can be hashed by chaining calls starting from `CACHE_HASH_INITIAL`.
+ *
+ * @param[in] hash The hash of the preceding data.
+ * @param[in] data The data to be hashed.
+ * @param[in] size The size of the data.
+ * @return The continued hash.
+ */
+uint64_t cache_hash(uint64_t hash, const void *data, size_t size);
+
+/**
+ * @brief Gets the path of a cache entry.
+ *
+ * Creates the cache directory `directory` if it doesn't exist yet, and returns the path of the
+ * entry with key `key` and extension `extension` inside it.
+ * The returned string must be freed with `free()`
+ *
+ * @param[in] directory The cache directory.
+ * @param[in] key The key of the entry.
+ * @param[in] extension The extension of the entry's file.
+ * @return The newly created path, or `NULL` on error.
+ */
+char *cache_path(const char *directory, uint64_t key, const char *extension);
+
+#endif
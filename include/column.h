@@ -0,0 +1,95 @@
+#ifndef COLUMN_H
+#define COLUMN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <summation.h>
+
+/**
+ * @brief a column of data.
+ *
+ * This data structure represents a memory-mapped file of raw doubles in the machine's byte
+ * order, one per row, bound to a variable of the summands.
+ */
+struct column {
+	char variable;		  ///< The name of the variable taking the values of the column.
+	const double *values; ///< The values of the column, inside `mapping`.
+	size_t rows_count;	  ///< The number of rows of the column.
+	void *mapping;		  ///< The memory mapping of the file, or `NULL` if it's empty.
+	size_t mapping_size;  ///< The size of `mapping`.
+};
+
+/**
+ * @brief Maps a column.
+ *
+ * Memory-maps the file at `path`, which holds the values of the column as raw doubles, and
+ * advises the kernel that it's going to be read sequentially soon.
+ *
+ * @param[out] column The column to map.
+ * @param[in] variable The name of the variable taking the values of the column.
+ * @param[in] path The path of the column's file.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error.
+ *
+ * @memberof column
+ */
+int column_map(struct column *column, char variable, const char *path);
+
+/**
+ * @brief Unmaps a column.
+ *
+ * Releases all memory and resources owned by the column
+ *
+ * @param[in,out] column The column to unmap.
+ *
+ * @memberof column
+ */
+void column_unmap(struct column *column);
+
+/**
+ * @brief Converts a field of CSV data into a column.
+ *
+ * Reads the lines of comma-separated values from `input`, and writes the values of the field
+ * with index `field`, counting from 0, to a column file at `path`, one row for each line but the
+ * header and blank lines, so that the rows of the columns of different fields line up. Missing or
+ * empty fields are written as NaN, and fields which aren't numbers are an error.
+ *
+ * @param[in] input The CSV data.
+ * @param[in] field The index of the field.
+ * @param[in] has_header Whether the first line is a header, to be skipped.
+ * @param[in] path The path of the column's file.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error.
+ *
+ * @memberof column
+ */
+int column_from_csv(FILE *input, size_t field, bool has_header, const char *path);
+
+/**
+ * @brief Evaluates several summations over the rows of columns
+ *
+ * Evaluates the summations of each of the `count` expressions in `summands` over the rows of the
+ * `columns_count` columns in `columns`, each bound to its variable, and stores their totals in
+ * `sums`. The index of the row, counting from 0, is named i, unless a column is bound to it.
+ *
+ * The rows are split into leaves summed in parallel and combined pairwise like the indices of
+ * `summation_fused()`, and each leaf is evaluated in blocks read directly from the mappings.
+ *
+ * @param[in] columns_count The number of columns.
+ * @param[in] columns Array of the columns, of the same number of rows.
+ * @param[in] count The number of summands
+ * @param[in] summands Array of the summands of the summations
+ * @param[out] sums Array of `count` totals, one for each summand
+ * @param[in] options The options of the summations, or `NULL` for the default options, of which
+ * only the number of threads is used.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE if the columns have different numbers of rows.
+ */
+int column_summation_fused(
+	size_t columns_count,
+	const struct column columns[],
+	size_t count,
+	const char *const summands[],
+	double sums[],
+	const struct summation_options *options
+);
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef COST_MODEL_H
+#define COST_MODEL_H
+
+#include <expression.h>
+#include <program.h>
+#include <stddef.h>
+
+/**
+ * @brief a model of the cost of evaluating programs.
+ *
+ * This data structure holds the time the building blocks of evaluating a program take on the
+ * machine it was calibrated on, from which the time to evaluate a whole program with each engine
+ * can be estimated.
+ */
+struct cost_model {
+	/// Time to apply each type of operation to one value of a block.
+	double operation_seconds[OPERATION_TYPES_COUNT];
+	double load_seconds;	   ///< Time to load a constant or variable into one value of a block.
+	double dispatch_seconds;   ///< Extra time evaluating one instruction for a single index takes.
+	double recurrence_seconds; ///< Time to advance a recurrence by one index.
+	double thread_seconds;	   ///< Time to start and join one more thread.
+};
+
+/**
+ * @brief Calibrates a cost model.
+ *
+ * Times the evaluation of small programs on the current machine, which takes a few milliseconds.
+ *
+ * @return The calibrated cost model.
+ *
+ * @memberof cost_model
+ */
+struct cost_model cost_model_calibrate(void);
+
+/**
+ * @brief Gets the cost model of the current machine.
+ *
+ * Returns the cost model of the current process, which is loaded from the profile saved in
+ * `cache_directory` when there's one, and calibrated (and then saved there) otherwise.
+ * Subsequent calls return the same model.
+ *
+ * @param[in] cache_directory The cache directory holding the saved profile, or `NULL`.
+ * @return The cost model.
+ *
+ * @memberof cost_model
+ */
+const struct cost_model *cost_model_get(const char *cache_directory);
+
+/**
+ * @brief Saves a cost model to a file.
+ *
+ * @param[in] cost_model The cost model to be saved.
+ * @param[in] path The path of the file.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error
+ *
+ * @memberof cost_model
+ */
+int cost_model_save(const struct cost_model *cost_model, const char *path);
+
+/**
+ * @brief Loads a cost model from a file.
+ *
+ * Only files saved by a build with the same operations are accepted. A missing file isn't
+ * reported.
+ *
+ * @param[out] cost_model Pointer to the cost model to store the result.
+ * @param[in] path The path of the file.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error
+ *
+ * @memberof cost_model
+ */
+int cost_model_load(struct cost_model *cost_model, const char *path);
+
+/**
+ * @brief Estimates the time to evaluate a program for one index.
+ *
+ * @param[in] cost_model The cost model.
+ * @param[in] program The program.
+ * @param[in] is_blocked Whether the program is evaluated over blocks of indices.
+ * @param[in] steps The steps of the instructions of the program when evaluating it using
+ * recurrences, see `program_steps()`, or `NULL`.
+ * @return The estimated time in seconds.
+ *
+ * @memberof cost_model
+ */
+double cost_model_estimate(
+	const struct cost_model *cost_model,
+	const struct program *program,
+	bool is_blocked,
+	const double steps[]
+);
+
+#endif
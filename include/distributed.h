@@ -0,0 +1,125 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <summation.h>
+
+/**
+ * @brief The default milliseconds a coordinator waits without workers.
+ */
+#define COORDINATOR_TIMEOUT 10000
+
+/**
+ * @brief The default milliseconds a coordinator waits for a worker to return the result of a
+ * shard.
+ */
+#define COORDINATOR_SHARD_TIMEOUT 60000
+
+/**
+ * @brief a coordinator of a distributed summation.
+ *
+ * This data structure represents a coordinator that splits the range of a summation into shards
+ * and hands them out to worker processes connecting to it over TCP, possibly from other machines.
+ * A shard handed to a worker that disconnects before returning its result is handed out again, and
+ * the results of the shards are combined in a fixed order, so the total doesn't depend on which
+ * worker evaluated which shard.
+ *
+ * Protocol
+ * --------
+ * All messages are lines of text, numbers are sent in hexadecimal floating-point so they are exact.
+ * * coordinator: `SUMMANDS <count>`, followed by one line for each summand
+ * * coordinator: `SHARD <shard> <lower bound> <upper bound>`
+ * * worker: `RESULT <shard> <sum>...`
+ * * coordinator: `DONE`
+ */
+struct coordinator {
+	int socket;	   ///< The listening socket.
+	uint16_t port; ///< The port the coordinator listens on.
+	/// The milliseconds to wait while no worker is connected before evaluating the remaining
+	/// shards locally.
+	int timeout;
+	/// The milliseconds to wait for the result of a shard before dropping the worker evaluating
+	/// it, and handing the shard out again.
+	int shard_timeout;
+};
+
+/**
+ * @brief Opens a coordinator.
+ *
+ * Starts listening for workers on `port` of the IPv4 address `host`, or of the loopback interface
+ * if `host` is `NULL`, as the protocol is unauthenticated and workers evaluate whatever summands
+ * they're sent. Listens on an ephemeral port if `port` is 0, in which case the chosen port is
+ * stored in `coordinator->port`. The coordinator waits for workers for `COORDINATOR_TIMEOUT`
+ * milliseconds and for the result of each shard for `COORDINATOR_SHARD_TIMEOUT` milliseconds,
+ * which can be changed in `coordinator->timeout` and `coordinator->shard_timeout`.
+ *
+ * @param[out] coordinator Pointer to the coordinator to be opened.
+ * @param[in] host The IPv4 address to listen on, like `0.0.0.0` for all interfaces, or `NULL`.
+ * @param[in] port The port to listen on.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error
+ *
+ * @memberof coordinator
+ */
+int coordinator_open(struct coordinator *coordinator, const char *host, uint16_t port);
+
+/**
+ * @brief Closes a coordinator.
+ *
+ * Stops listening for workers.
+ *
+ * @param[in,out] coordinator The coordinator to be closed.
+ *
+ * @memberof coordinator
+ */
+void coordinator_close(struct coordinator *coordinator);
+
+/**
+ * @brief Evaluates summations using workers
+ *
+ * Splits the range from `lower_bound` to `upper_bound` inclusive into `shards_count` shards and
+ * distributes them to the workers connecting to the coordinator, until the summations of each of
+ * the `count` expressions in `summands` over every shard are known. Waits for workers for as long
+ * as there are shards left, except that once no worker has been connected for
+ * `coordinator->timeout` milliseconds, the remaining shards are evaluated locally instead. Workers
+ * which don't return the result of their shard within `coordinator->shard_timeout` milliseconds
+ * are dropped, and the shard handed out again. The summands must not contain newlines.
+ *
+ * @param[in] coordinator The coordinator.
+ * @param[in] lower_bound The lower bound of the summations
+ * @param[in] upper_bound The upper bound of the summations
+ * @param[in] count The number of summands
+ * @param[in] summands Array of the summands of the summations
+ * @param[in] shards_count The number of shards to split the range into
+ * @param[out] sums Array of `count` totals, one for each summand
+ * @param[in] options The options of the summations of the shards evaluated locally, or `NULL`
+ * for the default options
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error
+ *
+ * @memberof coordinator
+ */
+int coordinator_run(
+	const struct coordinator *coordinator,
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	size_t shards_count,
+	double sums[],
+	const struct summation_options *options
+);
+
+/**
+ * @brief Runs a worker
+ *
+ * Connects to the coordinator at `host` and `port`, and evaluates the shards it's handed until
+ * the coordinator is done.
+ *
+ * @param[in] host The host name or address of the coordinator.
+ * @param[in] port The port of the coordinator.
+ * @param[in] options The options of the summations, or `NULL` for the default options
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error
+ */
+int worker_run(const char *host, uint16_t port, const struct summation_options *options);
+
+#endif
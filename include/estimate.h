@@ -0,0 +1,101 @@
+#ifndef ESTIMATE_H
+#define ESTIMATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The number of indices at each end of the range which are always evaluated.
+ */
+#define ESTIMATE_BOUNDARY_SIZE 1024
+
+/**
+ * @brief The number of strata the rest of the range is split into, half from each end.
+ */
+#define ESTIMATE_STRATA_COUNT 256
+
+/**
+ * @brief The number of samples of each stratum in the first round of sampling.
+ *
+ * Ranges with fewer than 4 times as many indices as the first round samples are evaluated
+ * exactly.
+ */
+#define ESTIMATE_SAMPLES_INITIAL 4
+
+/**
+ * @brief The number of standard errors of the half-width of the confidence intervals.
+ *
+ * The intervals of estimates cover the totals with a probability of 95%.
+ */
+#define ESTIMATE_STANDARD_ERRORS 1.959963984540054
+
+/**
+ * @brief the options of an estimate.
+ *
+ * Sampling is refined round after round until either budget is met. A budget of 0 is no budget,
+ * and without any the totals are eventually computed exactly.
+ */
+struct estimate_options {
+	double seconds;		   ///< The time budget, which rounds of sampling aren't expected to exceed.
+	double relative_error; ///< The error budget, relative to the magnitude of the estimates.
+	uint64_t seed;		   ///< The seed of the pseudo-random choices of the samples.
+};
+
+/**
+ * @brief Creates the default estimate options.
+ *
+ * @return The default options, of 10 ms and an error of 0.1%.
+ *
+ * @memberof estimate_options
+ */
+static inline struct estimate_options estimate_options_default(void) {
+	return (struct estimate_options){
+		.seconds = 0.01,
+		.relative_error = 0.001,
+		.seed = 0,
+	};
+}
+
+/**
+ * @brief an estimate of the total of a summation.
+ */
+struct estimate {
+	double sum;					///< The estimated total.
+	double error;				///< The half-width of the confidence interval around `sum`.
+	unsigned long terms_count;	///< Number of terms evaluated.
+	bool is_exact;				///< Whether `sum` is the exact total, with an `error` of 0.
+};
+
+/**
+ * @brief Estimates several summations over the same range
+ *
+ * Estimates the totals of the summations of each of the `count` expressions in `summands` from
+ * `lower_bound` to `upper_bound` inclusive by stratified sampling, and stores them in
+ * `estimates`. The index of summation is named i.
+ *
+ * The first and last `ESTIMATE_BOUNDARY_SIZE` indices are evaluated exactly, where summands often
+ * behave differently, and the rest of the range is split into `ESTIMATE_STRATA_COUNT` strata
+ * growing geometrically from both ends towards the middle, each sampled uniformly. Each round of
+ * sampling doubles the samples, allocated to the strata in proportion to their sizes and the
+ * deviations of their samples so far, until every confidence interval is within the error budget
+ * or the next round would exceed the time budget. When sampling would cost as much as evaluating
+ * a quarter of the range, the summations are evaluated exactly with `summation_fused()` instead.
+ *
+ * @param[in] lower_bound The lower bound of the summations
+ * @param[in] upper_bound The upper bound of the summations
+ * @param[in] count The number of summands
+ * @param[in] summands Array of the summands of the summations
+ * @param[out] estimates Array of `count` estimates, one for each summand
+ * @param[in] options The options of the estimates, or `NULL` for the default options
+ */
+void estimate_fused(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	struct estimate estimates[],
+	const struct estimate_options *options
+);
+
+#endif
@@ -7,20 +7,47 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+/**
+ * @brief The maximum number of operands an operation can take.
+ */
+#define OPERATION_ARITY_MAXIMUM 3
+
+/**
+ * @brief The number of operation types.
+ */
+#define OPERATION_TYPES_COUNT ((size_t)operation_type_conditional + 1)
+
+/**
+ * @brief The version of the simplifications of `expression_simplify()`, to be incremented
+ * whenever they change, so that programs compiled from expressions simplified differently aren't
+ * taken from caches.
+ */
+#define EXPRESSION_SIMPLIFY_VERSION 2
+
 /**
  * @brief a mathematical expression.
  *
  * This data structure represents a mathematical expression that might contain variables.
  * variables are represented with a single alphabet letter.
  *
+ * The operands of operations are immutable, and shared by reference-counted clones, so that
+ * cloning takes constant time and clones can be used from several threads. They're freed when the
+ * last expression referencing them is dropped.
+ *
  * Expression grammar
  * ------------------
- * * atom = number | identifier, [ "(", [ expression ], { ",", expression }, ")" ] | "(" expression
+ * * atom = number | identifier, [ "(", [ comparison ], { ",", comparison }, ")" ] | "(" comparison
  * ")"
- * * primary = atom, [ "^", factor ]
+ * * postfix = atom, { "!" }
+ * * primary = postfix, [ "^", factor ]
  * * factor = "-" factor | primary
- * * term = factor, { ("*" | "/"), factor }
+ * * term = factor, { ("*" | "/" | "%"), factor }
  * * expression = term, { ("+" | "-"), term }
+ * * comparison = expression, [ ("<" | "<=" | ">" | ">=" | "==" | "!="), expression ]
+ *
+ * Comparisons are 1 when they hold and 0 otherwise, and `if(condition, a, b)` is `a` when the
+ * condition is non-zero and `b` otherwise. Both `a` and `b` are always evaluated, so that
+ * conditionals select between values instead of branching.
  */
 struct expression {
 	/**
@@ -54,6 +81,25 @@ struct expression {
 				operation_type_tangent,
 				operation_type_exponential,
 				operation_type_logarithm,
+				operation_type_factorial,
+				operation_type_gamma,
+				operation_type_log_gamma,
+				operation_type_log_factorial,
+				operation_type_binomial,
+				operation_type_log_binomial,
+				operation_type_modulo,
+				operation_type_absolute_value,
+				operation_type_floor,
+				operation_type_ceiling,
+				operation_type_minimum,
+				operation_type_maximum,
+				operation_type_less,
+				operation_type_less_equal,
+				operation_type_greater,
+				operation_type_greater_equal,
+				operation_type_equal,
+				operation_type_not_equal,
+				operation_type_conditional,
 			} type;						 ///< Type of the operation.
 			struct expression *operands; ///< Array of the operation's operands.
 		} operation;
@@ -71,7 +117,38 @@ struct expression {
  * @memberof operation_type
  */
 static inline size_t operation_type_arity(enum operation_type type) {
-	return 1 + (type <= operation_type_exponentiation);
+	switch (type) {
+		case operation_type_addition:
+		case operation_type_subtraction:
+		case operation_type_multiplication:
+		case operation_type_division:
+		case operation_type_exponentiation:
+		case operation_type_binomial:
+		case operation_type_log_binomial:
+		case operation_type_modulo:
+		case operation_type_minimum:
+		case operation_type_maximum:
+		case operation_type_less:
+		case operation_type_less_equal:
+		case operation_type_greater:
+		case operation_type_greater_equal:
+		case operation_type_equal:
+		case operation_type_not_equal: return 2;
+		case operation_type_conditional: return 3;
+		case operation_type_negation:
+		case operation_type_sine:
+		case operation_type_cosine:
+		case operation_type_tangent:
+		case operation_type_exponential:
+		case operation_type_logarithm:
+		case operation_type_factorial:
+		case operation_type_gamma:
+		case operation_type_log_gamma:
+		case operation_type_log_factorial:
+		case operation_type_absolute_value:
+		case operation_type_floor:
+		case operation_type_ceiling: return 1;
+	}
 }
 
 /**
@@ -86,20 +163,99 @@ static inline size_t operation_type_arity(enum operation_type type) {
  */
 static inline size_t operation_type_precedence(enum operation_type type) {
 	switch (type) {
+		case operation_type_less:
+		case operation_type_less_equal:
+		case operation_type_greater:
+		case operation_type_greater_equal:
+		case operation_type_equal:
+		case operation_type_not_equal: return 0;
 		case operation_type_addition:
-		case operation_type_subtraction: return 0;
+		case operation_type_subtraction: return 1;
 		case operation_type_multiplication:
-		case operation_type_division: return 1;
+		case operation_type_division:
+		case operation_type_modulo: return 2;
 		case operation_type_exponentiation:
-		case operation_type_negation: return 2;
+		case operation_type_negation: return 3;
 		case operation_type_sine:
 		case operation_type_cosine:
 		case operation_type_tangent:
 		case operation_type_exponential:
-		case operation_type_logarithm: return 3;
+		case operation_type_logarithm:
+		case operation_type_gamma:
+		case operation_type_log_gamma:
+		case operation_type_log_factorial:
+		case operation_type_binomial:
+		case operation_type_log_binomial:
+		case operation_type_absolute_value:
+		case operation_type_floor:
+		case operation_type_ceiling:
+		case operation_type_minimum:
+		case operation_type_maximum:
+		case operation_type_conditional: return 4;
+		case operation_type_factorial: return 5;
+	}
+}
+
+/**
+ * @brief Gets the name of a function.
+ *
+ * Returns the name an operation of type `type` is written with in function call notation, or
+ * `NULL` if it's written with an operator instead.
+ *
+ * @param[in] type The type of the operation.
+ * @return The name of the function, or `NULL`.
+ *
+ * @memberof operation_type
+ */
+static inline const char *operation_type_function_name(enum operation_type type) {
+	switch (type) {
+		case operation_type_sine: return "sin";
+		case operation_type_cosine: return "cos";
+		case operation_type_tangent: return "tan";
+		case operation_type_exponential: return "exp";
+		case operation_type_logarithm: return "log";
+		case operation_type_gamma: return "gamma";
+		case operation_type_log_gamma: return "lgamma";
+		case operation_type_log_factorial: return "lfact";
+		case operation_type_binomial: return "binom";
+		case operation_type_log_binomial: return "lbinom";
+		case operation_type_absolute_value: return "abs";
+		case operation_type_floor: return "floor";
+		case operation_type_ceiling: return "ceil";
+		case operation_type_minimum: return "min";
+		case operation_type_maximum: return "max";
+		case operation_type_conditional: return "if";
+		case operation_type_addition:
+		case operation_type_subtraction:
+		case operation_type_multiplication:
+		case operation_type_division:
+		case operation_type_exponentiation:
+		case operation_type_negation:
+		case operation_type_factorial:
+		case operation_type_modulo:
+		case operation_type_less:
+		case operation_type_less_equal:
+		case operation_type_greater:
+		case operation_type_greater_equal:
+		case operation_type_equal:
+		case operation_type_not_equal: return NULL;
 	}
 }
 
+/**
+ * @brief Applies an operation to its operands.
+ *
+ * Returns the result of applying an operation of type `type` to the already evaluated `operands`.
+ * The number of operands must match the arity of the operation.
+ *
+ * @param[in] type The type of the operation.
+ * @param[in] operands The values of the operation's operands.
+ * @return The result of the operation.
+ *
+ * @memberof operation_type
+ */
+double operation_type_evaluate(enum operation_type type, const double operands[]);
+
 /**
  * @brief Creates a new expression of type constant.
  *
@@ -152,7 +308,7 @@ struct expression expression_operation(enum operation_type type, ...);
 /**
  * @brief Clones an expression
  *
- * Returns a deep copy of `expression`
+ * Returns a copy of `expression` sharing its operands, in constant time. Both must be dropped.
  *
  * @param[in] expression The expression to be cloned
  * @return The newly created clone.
@@ -164,7 +320,8 @@ struct expression expression_clone(const struct expression *expression);
 /**
  * @brief Drops an expression.
  *
- * Releases all memory and resources owned by the expression
+ * Releases all memory and resources owned by the expression, and the operands it shares with its
+ * clones if it's the last one referencing them.
  *
  * @param[in,out] expression The expression to drop.
  *
@@ -211,12 +368,39 @@ struct expression expression_from_string(const char *string);
  */
 char *expression_to_string(const struct expression *expression);
 
+/**
+ * @brief Creates a simplified expression
+ *
+ * Returns `expression` simplified like `expression_simplify()` does, leaving `expression` as it
+ * is. The sub-expressions which are left as they are are shared with it rather than copied.
+ *
+ * @param[in] expression The expression to be simplified
+ * @param[in] environment The environment the expression is simplified in.
+ * @return The newly created simplified expression.
+ *
+ * @memberof expression
+ */
+struct expression expression_simplified(
+	const struct expression *expression,
+	const struct environment *environment
+);
+
 /**
  * @brief Simplifies an expression
  *
  * Constant folds any constant sub-expressions in the given expression.
  * and might perform some mathematical simplifications if possible.
  *
+ * Sub-expressions which are polynomials of degree 2 to 16 in a single variable, such as
+ * `3 * i^3 + i^2 - 2`, are collected into their coefficients and rewritten in Horner form, such as
+ * `(3 * i + 1) * i * i - 2`, when that takes fewer operations to evaluate. Exponentiations are
+ * weighed as several multiplications. Only sums of products of the variable and constants are
+ * collected: products and powers of sums, like `(i - 100000) ^ 4`, are left as written, as
+ * expanding them would give coefficients cancelling out far from the origin. The coefficients
+ * may still round differently from the original expression's operations.
+ *
+ * The expression is replaced by a new one, so that its clones are left as they are.
+ *
  * @param[in,out] expression The expression to be simplified
  * @param[in] environment The environment the expression is simplified in.
  *
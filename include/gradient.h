@@ -0,0 +1,50 @@
+#ifndef GRADIENT_H
+#define GRADIENT_H
+
+#include <environment.h>
+#include <stddef.h>
+#include <summation.h>
+
+/**
+ * @brief Evaluates several summations and their gradients with respect to some variables.
+ *
+ * Evaluates the summations of each of the `count` expressions in `summands` from `lower_bound` to
+ * `upper_bound` inclusive, with the other variables taking their values in `environment`, and
+ * stores their totals in `sums` and their partial derivatives with respect to each of the
+ * `variables_count` variables in `variables` in `gradients`: those of the first summand, then
+ * those of the second, and so on.
+ *
+ * The derivatives are computed in forward mode, in the same pass as the terms: along with its
+ * value over a block of indices, each instruction depending on a variable gets its derivative
+ * with respect to it, from those of its operands and its partial derivatives, and the
+ * derivatives of the terms are added up like the terms. Rounding, remainders, comparisons and
+ * selections are differentiated piecewise, as if their operands were constant across the points
+ * where they jump. The range is split into leaves evaluated in parallel. The summations are always
+ * iterated, without closed forms.
+ *
+ * @param[in] lower_bound The lower bound of the summations
+ * @param[in] upper_bound The upper bound of the summations
+ * @param[in] environment The environment giving the values of the other variables
+ * @param[in] variables_count The number of variables of the gradients
+ * @param[in] variables Array of the names of the variables of the gradients, which can't be i
+ * @param[in] count The number of summands
+ * @param[in] summands Array of the summands of the summations
+ * @param[out] sums Array of `count` totals
+ * @param[out] gradients Array of `count * variables_count` partial derivatives of the totals
+ * @param[in] options The options of the summations, or `NULL` for the default options, of which
+ * only the number of threads is used.
+ */
+void gradient_summation_fused(
+	long lower_bound,
+	long upper_bound,
+	const struct environment *environment,
+	size_t variables_count,
+	const char variables[],
+	size_t count,
+	const char *const summands[],
+	double sums[],
+	double gradients[],
+	const struct summation_options *options
+);
+
+#endif
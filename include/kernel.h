@@ -0,0 +1,108 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include <program.h>
+#include <stddef.h>
+
+/**
+ * @brief The name of the function of a kernel's shared object.
+ */
+#define KERNEL_SYMBOL "summation_kernel"
+
+/**
+ * @brief A function evaluating an operation without a counterpart in C, for kernels.
+ *
+ * @param[in] type The type of the operation, as an `enum operation_type`.
+ * @param[in] operands Array of the operation's operands.
+ * @return The result of the operation.
+ */
+typedef double (*kernel_operation_function)(unsigned type, const double operands[]);
+
+/**
+ * @brief A function adding the terms of the outputs of a program over a range to their sums.
+ *
+ * @param[in] lower_bound The lower bound of the range.
+ * @param[in] upper_bound The upper bound of the range.
+ * @param[in,out] sums Array of sums, one for each output of the program.
+ * @param[in] operation The function evaluating the operations without a counterpart in C.
+ */
+typedef void (*kernel_function)(
+	long lower_bound,
+	long upper_bound,
+	double sums[],
+	kernel_operation_function operation
+);
+
+/**
+ * @brief a kernel.
+ *
+ * This data structure represents a program translated into C, compiled by the system's C compiler
+ * into a shared object and loaded, which adds up the terms of its outputs in a single loop with
+ * the constants inlined.
+ */
+struct kernel {
+	void *handle;			 ///< The handle of the loaded shared object.
+	kernel_function function; ///< The function of the shared object.
+};
+
+/**
+ * @brief Translates a program into the C source of a kernel.
+ *
+ * Creates the source of a function named `KERNEL_SYMBOL`, of type `kernel_function`, computing
+ * the outputs of `program` for each index of its range, named i, and adding them to their sums in
+ * order, so that it computes the same sums as the block engine. Variables other than i are NaN.
+ * The returned string must be freed with `free()`
+ *
+ * @param[in] program The program to be translated.
+ * @return The newly created source.
+ *
+ * @memberof kernel
+ */
+char *kernel_source(const struct program *program);
+
+/**
+ * @brief Creates a new kernel.
+ *
+ * Translates `program` into C, and loads the shared object compiled from it. When a cache
+ * directory is given, the shared object is looked up in it by the hash of the source, the
+ * compiler and its options, and newly compiled shared objects are saved to it, so that later runs
+ * skip the compiler.
+ *
+ * The compiler is the one named by the `CC` environment variable, or else `cc`.
+ *
+ * @param[out] kernel The kernel to create.
+ * @param[in] program The program to be compiled.
+ * @param[in] cache_directory The cache directory, or `NULL`.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE if no compiler is available or it fails.
+ *
+ * @memberof kernel
+ */
+int kernel_new(struct kernel *kernel, const struct program *program, const char *cache_directory);
+
+/**
+ * @brief Drops a kernel.
+ *
+ * Releases all memory and resources owned by the kernel
+ *
+ * @param[in,out] kernel The kernel to drop.
+ *
+ * @memberof kernel
+ */
+void kernel_drop(struct kernel *kernel);
+
+/**
+ * @brief Runs a kernel.
+ *
+ * Adds the terms of the outputs of the kernel's program from `lower_bound` to `upper_bound`
+ * inclusive to `sums`, in order.
+ *
+ * @param[in] kernel The kernel to be run.
+ * @param[in] lower_bound The lower bound of the range.
+ * @param[in] upper_bound The upper bound of the range.
+ * @param[in,out] sums Array of sums, one for each output of the program.
+ *
+ * @memberof kernel
+ */
+void kernel_run(const struct kernel *kernel, long lower_bound, long upper_bound, double sums[]);
+
+#endif
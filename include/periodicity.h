@@ -0,0 +1,98 @@
+#ifndef PERIODICITY_H
+#define PERIODICITY_H
+
+#include <program.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief The maximum period of a periodic summand.
+ */
+#define PERIODICITY_PERIOD_MAXIMUM 4096
+
+/**
+ * @brief The number of roundings by which the slope of the argument of a periodic trigonometric
+ * function may be off.
+ *
+ * The slopes of the arguments of trigonometric functions are folded from rounded constants, so
+ * they're rational multiples of pi only up to a few roundings. Beyond those, the phases of the
+ * terms drift from those of the nearest periodic function by more than the rounding errors of
+ * their direct summation, which is then more accurate.
+ */
+#define PERIODICITY_SLOPE_ROUNDINGS 2
+
+/**
+ * @brief a periodic summand.
+ *
+ * This data structure represents a summand over a range of integers which repeats itself with a
+ * period that is a small integer, so that its summation is that of its first period, scaled by
+ * the number of whole periods in the range, plus that of the start of the next one.
+ */
+struct periodicity {
+	struct program function; ///< Program computing the summand, as its single output.
+	char variable;			 ///< The name of the variable of `function`.
+	size_t period;			 ///< The period of the summand.
+	long lower_bound;		 ///< The lower bound of the range.
+	long upper_bound;		 ///< The upper bound of the range.
+};
+
+/**
+ * @brief Gets the periodic summands computed by a program over a range.
+ *
+ * Checks whether each of the expressions compiled into `program` is periodic in the variable
+ * `variable` over the integers from `lower_bound` to `upper_bound` inclusive, with a period of
+ * at least 2 and at most `PERIODICITY_PERIOD_MAXIMUM`, shorter than the range. Periods are
+ * proven from the structure of the expressions. Affine functions and floors and ceilings of
+ * integral affine functions divided by integers, like `floor(i / 3)`, and their sums and
+ * multiples by constants are staircases, which grow by a step whenever the variable grows by a
+ * shift. Remainders of staircases with integral steps by integers, powers of -1 to them, sines,
+ * cosines and tangents of staircases whose steps are rational multiples of pi, up to
+ * `PERIODICITY_SLOPE_ROUNDINGS` roundings, and integral staircases with flat steps, like
+ * `i - 3 * floor(i / 3)`, are periodic, and so are operations on periodic operands and on
+ * functions that don't depend on the variable, with the least common multiple of their periods.
+ *
+ * @param[in] program The program.
+ * @param[in] variable The name of the variable.
+ * @param[in] lower_bound The lower bound of the range.
+ * @param[in] upper_bound The upper bound of the range, not less than `lower_bound`.
+ * @param[out] periodicities Array of `program->outputs_count` periodic summands, one for each
+ * expression, those which are periodic to be dropped with `periodicity_drop()`.
+ * @param[out] is_periodic Array of `program->outputs_count` flags, set for the expressions which
+ * are periodic.
+ *
+ * @memberof periodicity
+ */
+void periodicity_from_program(
+	const struct program *program,
+	char variable,
+	long lower_bound,
+	long upper_bound,
+	struct periodicity periodicities[],
+	bool is_periodic[]
+);
+
+/**
+ * @brief Drops a periodic summand.
+ *
+ * Releases all memory and resources owned by the periodic summand
+ *
+ * @param[in,out] periodicity The periodic summand to drop.
+ *
+ * @memberof periodicity
+ */
+void periodicity_drop(struct periodicity *periodicity);
+
+/**
+ * @brief Sums a periodic summand in closed form.
+ *
+ * Returns the summation of `periodicity` over its whole range, evaluating the summand over its
+ * first period only.
+ *
+ * @param[in] periodicity The periodic summand to be summed.
+ * @return The total of the summation.
+ *
+ * @memberof periodicity
+ */
+double periodicity_sum(const struct periodicity *periodicity);
+
+#endif
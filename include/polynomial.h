@@ -0,0 +1,276 @@
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+#include <program.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief The maximum degree of a polynomial.
+ */
+#define POLYNOMIAL_DEGREE_MAXIMUM 16
+
+/**
+ * @brief a polynomial in a single variable.
+ *
+ * This data structure represents a polynomial with real coefficients in the monomial basis.
+ */
+struct polynomial {
+	size_t degree; ///< Degree of the polynomial, the index of the last coefficient.
+	/// Coefficients of the polynomial, the `i`-th being that of the variable raised to `i`.
+	double coefficients[POLYNOMIAL_DEGREE_MAXIMUM + 1];
+};
+
+/**
+ * @brief The maximum number of pieces of a piecewise polynomial.
+ */
+#define PIECEWISE_POLYNOMIAL_PIECES_MAXIMUM 64
+
+/**
+ * @brief a piecewise polynomial over a range of integers.
+ *
+ * This data structure represents a function of an integer variable which is a polynomial over
+ * each of the consecutive pieces its range is split into.
+ */
+struct piecewise_polynomial {
+	size_t pieces_count;		///< Number of pieces.
+	long *lower_bounds;			///< Lower bound of each piece, the next one's minus one is its upper.
+	long upper_bound;			///< Upper bound of the last piece.
+	struct polynomial *pieces;	///< Polynomial over each piece.
+};
+
+/**
+ * @brief Creates a new constant polynomial.
+ *
+ * @param[in] value The value of the polynomial.
+ * @return The newly created polynomial.
+ *
+ * @memberof polynomial
+ */
+static inline struct polynomial polynomial_constant(double value) {
+	return (struct polynomial){
+		.degree = 0,
+		.coefficients = { value },
+	};
+}
+
+/**
+ * @brief Gets the polynomials computed by a program.
+ *
+ * Checks whether each of the expressions compiled into `program` is a polynomial in the variable
+ * `variable`, built from constants and that variable with additions, subtractions,
+ * multiplications, negations, divisions by constants, raising to constant non-negative integer
+ * powers and binomial coefficients over such integers, of degree at most
+ * `POLYNOMIAL_DEGREE_MAXIMUM`. Other variables aren't treated as
+ * constants, as their values aren't known yet.
+ *
+ * @param[in] program The program.
+ * @param[in] variable The name of the variable.
+ * @param[out] polynomials Array of `program->outputs_count` polynomials, one for each expression.
+ * @param[out] is_polynomial Array of `program->outputs_count` flags, set for the expressions
+ * which are polynomials.
+ *
+ * @memberof polynomial
+ */
+void polynomial_from_program(
+	const struct program *program,
+	char variable,
+	struct polynomial polynomials[],
+	bool is_polynomial[]
+);
+
+/**
+ * @brief The number of points spread over the range a sampled polynomial is interpolated from
+ * and checked at.
+ */
+#define POLYNOMIAL_SAMPLES_SPREAD_COUNT 64
+
+/**
+ * @brief The number of pseudo-random points a sampled polynomial is checked at.
+ */
+#define POLYNOMIAL_SAMPLES_RANDOM_COUNT 32
+
+/**
+ * @brief The error allowed between a sampled polynomial and the samples, relative to the largest
+ * sample.
+ */
+#define POLYNOMIAL_SAMPLES_ERROR 1e-11
+
+/**
+ * @brief Gets the polynomials computed by a program over a range, from their values.
+ *
+ * Finds the polynomials `polynomial_from_program()` can't see through, like `exp(2 * log(i))` or
+ * `sin(i)^2 + cos(i)^2`, by evaluating each of the expressions compiled into `program` at integers
+ * of the range from `lower_bound` to `upper_bound` inclusive. The degree is the least one whose
+ * next finite differences over `POLYNOMIAL_DEGREE_MAXIMUM + 2` consecutive integers vanish, and
+ * the coefficients are interpolated from samples spread over the range, and rounded to multiples
+ * of `1 / (q d!)` for polynomials of degree `d` whose consecutive samples are multiples of `1 / q`.
+ * The polynomial must then match the expression at `POLYNOMIAL_SAMPLES_SPREAD_COUNT` points spread
+ * over the range and `POLYNOMIAL_SAMPLES_RANDOM_COUNT` pseudo-random ones, within
+ * `POLYNOMIAL_SAMPLES_ERROR`.
+ *
+ * As expressions are only sampled, those which could differ from a polynomial at a few integers
+ * only aren't considered: those rounding, comparing or selecting values, those with an
+ * exponential or a power underflowing at a sample, and those dividing by, raising to a negative
+ * power or taking the logarithm of anything but a polynomial of degree at most 2 with a sign over
+ * the range. Others which aren't polynomials, but are within
+ * the allowed error of one at every sample, are still taken for it. Ranges too short to be worth
+ * sampling yield no polynomial, and other variables are NaN, so expressions of them neither.
+ *
+ * @param[in] program The program.
+ * @param[in] variable The name of the variable.
+ * @param[in] lower_bound The lower bound of the range.
+ * @param[in] upper_bound The upper bound of the range.
+ * @param[out] polynomials Array of `program->outputs_count` polynomials, one for each expression.
+ * @param[out] is_polynomial Array of `program->outputs_count` flags, set for the expressions
+ * which are polynomials over the range.
+ *
+ * @memberof polynomial
+ */
+void polynomial_from_samples(
+	const struct program *program,
+	char variable,
+	long lower_bound,
+	long upper_bound,
+	struct polynomial polynomials[],
+	bool is_polynomial[]
+);
+
+/**
+ * @brief Evaluates a polynomial.
+ *
+ * @param[in] polynomial The polynomial to be evaluated.
+ * @param[in] value The value of the variable.
+ * @return The value of the polynomial.
+ *
+ * @memberof polynomial
+ */
+double polynomial_evaluate(const struct polynomial *polynomial, double value);
+
+/**
+ * @brief Sums a polynomial in closed form.
+ *
+ * Returns the summation of `polynomial` from `lower_bound` to `upper_bound` inclusive, computed
+ * in a number of steps that only depends on the degree of the polynomial.
+ *
+ * The polynomial is shifted to start at `lower_bound` and rewritten in the basis of falling
+ * factorials, whose sums over `0` to `n - 1` are falling factorials of `n` themselves, so the
+ * only large numbers involved are the sums of the basis over the range. The finite differences of
+ * polynomials taking integer values at integers are rounded to integers, within the rounding
+ * errors of the change of basis, so that their sums are exact where representable.
+ *
+ * @param[in] polynomial The polynomial to be summed.
+ * @param[in] lower_bound The lower bound of the summation.
+ * @param[in] upper_bound The upper bound of the summation.
+ * @return The total of the summation.
+ *
+ * @memberof polynomial
+ */
+double polynomial_sum(const struct polynomial *polynomial, long lower_bound, long upper_bound);
+
+/**
+ * @brief Checks whether a polynomial can be summed accurately in closed form over a range.
+ *
+ * The coefficients of polynomials like `(i - 100000) ^ 4` are much larger than their values
+ * near 100000, and cancel out catastrophically there. The magnitudes of the terms of the
+ * polynomial at the bounds and the middle of the range are compared with its values there.
+ *
+ * @param[in] polynomial The polynomial.
+ * @param[in] lower_bound The lower bound of the range.
+ * @param[in] upper_bound The upper bound of the range.
+ * @return Whether the coefficients of the polynomial don't cancel out over the range.
+ *
+ * @memberof polynomial
+ */
+bool polynomial_is_well_conditioned(
+	const struct polynomial *polynomial,
+	long lower_bound,
+	long upper_bound
+);
+
+/**
+ * @brief Gets the piecewise polynomials computed by a program over a range.
+ *
+ * Checks whether each of the expressions compiled into `program` is a piecewise polynomial in
+ * the variable `variable` over the integers from `lower_bound` to `upper_bound` inclusive, of at
+ * most `PIECEWISE_POLYNOMIAL_PIECES_MAXIMUM` pieces. On top of the operations supported by
+ * `polynomial_from_program()`, these may take absolute values, minimums, maximums, comparisons
+ * and conditionals of piecewise polynomials whose differences are linear in each piece, and so
+ * change sign at most once in it, and round piecewise polynomials with integer coefficients.
+ *
+ * @param[in] program The program.
+ * @param[in] variable The name of the variable.
+ * @param[in] lower_bound The lower bound of the range.
+ * @param[in] upper_bound The upper bound of the range, not less than `lower_bound`.
+ * @param[out] piecewise_polynomials Array of `program->outputs_count` piecewise polynomials, one
+ * for each expression, each to be dropped with `piecewise_polynomial_drop()`.
+ * @param[out] is_piecewise_polynomial Array of `program->outputs_count` flags, set for the
+ * expressions which are piecewise polynomials.
+ *
+ * @memberof piecewise_polynomial
+ */
+void piecewise_polynomial_from_program(
+	const struct program *program,
+	char variable,
+	long lower_bound,
+	long upper_bound,
+	struct piecewise_polynomial piecewise_polynomials[],
+	bool is_piecewise_polynomial[]
+);
+
+/**
+ * @brief Creates a new piecewise polynomial of a single piece.
+ *
+ * @param[in] polynomial The polynomial over the whole range.
+ * @param[in] lower_bound The lower bound of the range.
+ * @param[in] upper_bound The upper bound of the range.
+ * @return The newly created piecewise polynomial, to be dropped with
+ * `piecewise_polynomial_drop()`.
+ *
+ * @memberof piecewise_polynomial
+ */
+struct piecewise_polynomial piecewise_polynomial_from_polynomial(
+	const struct polynomial *polynomial,
+	long lower_bound,
+	long upper_bound
+);
+
+/**
+ * @brief Drops a piecewise polynomial.
+ *
+ * Releases all memory and resources owned by the piecewise polynomial
+ *
+ * @param[in,out] piecewise_polynomial The piecewise polynomial to drop.
+ *
+ * @memberof piecewise_polynomial
+ */
+void piecewise_polynomial_drop(struct piecewise_polynomial *piecewise_polynomial);
+
+/**
+ * @brief Sums a piecewise polynomial in closed form.
+ *
+ * Returns the summation of `piecewise_polynomial` over its whole range, as the sum of the
+ * closed forms of its pieces.
+ *
+ * @param[in] piecewise_polynomial The piecewise polynomial to be summed.
+ * @return The total of the summation.
+ *
+ * @memberof piecewise_polynomial
+ */
+double piecewise_polynomial_sum(const struct piecewise_polynomial *piecewise_polynomial);
+
+/**
+ * @brief Checks whether a piecewise polynomial can be summed accurately in closed form.
+ *
+ * Each piece is checked by `polynomial_is_well_conditioned()` over its own range.
+ *
+ * @param[in] piecewise_polynomial The piecewise polynomial.
+ * @return Whether the coefficients of each piece don't cancel out over it.
+ *
+ * @memberof piecewise_polynomial
+ */
+bool piecewise_polynomial_is_well_conditioned(
+	const struct piecewise_polynomial *piecewise_polynomial
+);
+
+#endif
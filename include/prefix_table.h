@@ -0,0 +1,114 @@
+#ifndef PREFIX_TABLE_H
+#define PREFIX_TABLE_H
+
+#include <expression.h>
+#include <stddef.h>
+
+/**
+ * @brief a table of prefix sums.
+ *
+ * This data structure represents the prefix sums of a summand over the range `[lower_bound,
+ * upper_bound]`, which allows the summation over any sub-range to be answered without iterating
+ * over it. The prefix sums are stored compensated, as an unevaluated sum of two doubles, so that
+ * subtracting two of them doesn't lose the precision of a small sub-range to cancellation.
+ *
+ * A table can be blocked, storing only every `block_size`-th prefix sum to cap its memory usage,
+ * in which case a query also evaluates the summand at the at most `block_size / 2` indices on
+ * either edge of the queried sub-range.
+ */
+struct prefix_table {
+	long lower_bound;  ///< The lower bound of the table's range.
+	long upper_bound;  ///< The upper bound of the table's range.
+	size_t block_size; ///< The number of indices between stored prefix sums, 1 for a dense table.
+	size_t sums_count; ///< The number of stored prefix sums.
+	/**
+	 * @brief a compensated prefix sum.
+	 */
+	struct prefix_sum {
+		double sum;			 ///< The rounded prefix sum.
+		double compensation; ///< The rounding error of `sum`.
+	} *sums;					///< The `k`-th prefix sum is the sum of the first `k * block_size` terms.
+	struct expression summand;	///< The simplified summand, used to evaluate the edges of queries.
+	char *summand_string;		///< The summand the table was built from.
+	void *mapping;				///< The memory mapping backing the table, or `NULL`.
+	size_t mapping_size;		///< The size of `mapping`.
+};
+
+/**
+ * @brief Creates a new prefix table.
+ *
+ * Evaluates `summand` once over every index from `lower_bound` to `upper_bound` inclusive, and
+ * builds the table of its prefix sums. The index of summation is named i.
+ *
+ * @param[in] lower_bound The lower bound of the table's range.
+ * @param[in] upper_bound The upper bound of the table's range.
+ * @param[in] summand The summand of the summations.
+ * @param[in] block_size The number of indices between stored prefix sums, 1 for a dense table.
+ * @return The newly created table, without prefix sums, `sums` being `NULL`, if the range is too
+ * large for them to be allocated.
+ *
+ * @memberof prefix_table
+ */
+struct prefix_table prefix_table_new(
+	long lower_bound,
+	long upper_bound,
+	const char *summand,
+	size_t block_size
+);
+
+/**
+ * @brief Drops a prefix table.
+ *
+ * Releases all memory and resources owned by the table, unmapping it if it was loaded.
+ *
+ * @param[in,out] table The table to drop.
+ *
+ * @memberof prefix_table
+ */
+void prefix_table_drop(struct prefix_table *table);
+
+/**
+ * @brief Queries a prefix table.
+ *
+ * Returns the total of the summation of the table's summand from `lower_bound` to `upper_bound`
+ * inclusive, in constant time for a dense table.
+ *
+ * @param[in] table The table to be queried.
+ * @param[in] lower_bound The lower bound of the summation.
+ * @param[in] upper_bound The upper bound of the summation.
+ * @return The total of the summation, or NAN if the range isn't within the table's range.
+ *
+ * @memberof prefix_table
+ */
+double prefix_table_query(const struct prefix_table *table, long lower_bound, long upper_bound);
+
+/**
+ * @brief Saves a prefix table to a file.
+ *
+ * Writes the table to the file at `path` in a format that can be memory-mapped by
+ * `prefix_table_load()`.
+ *
+ * @param[in] table The table to be saved.
+ * @param[in] path The path of the file.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error
+ *
+ * @memberof prefix_table
+ */
+int prefix_table_save(const struct prefix_table *table, const char *path);
+
+/**
+ * @brief Loads a prefix table from a file.
+ *
+ * Memory-maps a table saved by `prefix_table_save()`, so its prefix sums are paged in on demand
+ * instead of being read up front. Files whose header doesn't match their range, their prefix sums
+ * and their null-terminated summand are rejected.
+ *
+ * @param[out] table Pointer to the table to store the result.
+ * @param[in] path The path of the file.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error
+ *
+ * @memberof prefix_table
+ */
+int prefix_table_load(struct prefix_table *table, const char *path);
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef PRODUCT_H
+#define PRODUCT_H
+
+#include <math.h>
+#include <stddef.h>
+#include <summation.h>
+
+/**
+ * @brief The number of summands a product is evaluated with.
+ */
+#define PRODUCT_SUMMANDS_COUNT 3
+
+/**
+ * @brief a product of factors over a range.
+ *
+ * This data structure represents the total of a product by its sign and the logarithm of its
+ * absolute value, so that products far beyond the range of doubles are still represented.
+ */
+struct product {
+	double sign;	  ///< Sign of the product, 1, -1, or 0 when a factor is zero.
+	double logarithm; ///< Natural logarithm of the absolute value of the product.
+};
+
+/**
+ * @brief Gets the value of a product.
+ *
+ * @param[in] product The product.
+ * @return The value of the product, infinite if it's out of the range of doubles.
+ *
+ * @memberof product
+ */
+static inline double product_value(const struct product *product) {
+	return fpclassify(product->sign) == FP_ZERO ? 0 : product->sign * exp(product->logarithm);
+}
+
+/**
+ * @brief Gets the summands products are evaluated with.
+ *
+ * Products are evaluated as summations of `PRODUCT_SUMMANDS_COUNT` summands for each factor: the
+ * logarithm of its absolute value, whether it's negative and whether it's zero. Returns the
+ * `PRODUCT_SUMMANDS_COUNT * count` summands of the `count` products of `factors`, in order, so
+ * that they can be planned, explained or distributed like any other summations.
+ * The returned array and its strings must be freed with `product_summands_drop()`
+ *
+ * @param[in] count The number of factors
+ * @param[in] factors Array of the factors of the products
+ * @return The newly created summands.
+ *
+ * @memberof product
+ */
+char **product_summands(size_t count, const char *const factors[]);
+
+/**
+ * @brief Drops the summands of products.
+ *
+ * @param[in] count The number of factors the summands were created for
+ * @param[in,out] summands The summands to drop.
+ *
+ * @memberof product
+ */
+void product_summands_drop(size_t count, char **summands);
+
+/**
+ * @brief Gets products from the totals of their summands.
+ *
+ * @param[in] count The number of factors
+ * @param[in] sums Array of the `PRODUCT_SUMMANDS_COUNT * count` totals of the summands returned by
+ * `product_summands()`
+ * @param[out] products Array of `count` products, one for each factor
+ *
+ * @memberof product
+ */
+void product_from_sums(size_t count, const double sums[], struct product products[]);
+
+/**
+ * @brief Evaluates a product
+ *
+ * Returns the value of the product of expression `factor` from `lower_bound` to `upper_bound`
+ * inclusive. The index of the product is named i.
+ *
+ * @param[in] lower_bound The lower bound of the product
+ * @param[in] upper_bound The upper bound of the product
+ * @param[in] factor The factor of the product
+ * @return The value of the product
+ */
+double product(long lower_bound, long upper_bound, const char *factor);
+
+/**
+ * @brief Evaluates several products over the same range
+ *
+ * Evaluates the products of each of the `count` expressions in `factors` from `lower_bound` to
+ * `upper_bound` inclusive, and stores them in `products`. The index of the products is named i.
+ *
+ * The products are evaluated as summations of the logarithms of the absolute values of the
+ * factors and of the numbers of negative and zero factors with `summation_fused()`, so they never
+ * overflow, and they have the same engines and totals independent of the number of threads. The
+ * logarithms are added up with absolute errors, which become relative errors of the products.
+ *
+ * @param[in] lower_bound The lower bound of the products
+ * @param[in] upper_bound The upper bound of the products
+ * @param[in] count The number of factors
+ * @param[in] factors Array of the factors of the products
+ * @param[out] products Array of `count` products, one for each factor
+ * @param[in] options The options of the products, or `NULL` for the default options
+ */
+void product_fused(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const factors[],
+	struct product products[],
+	const struct summation_options *options
+);
+
+#endif
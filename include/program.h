@@ -0,0 +1,302 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <environment.h>
+#include <expression.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief The number of indices a block of a program is evaluated over at a time.
+ */
+#define PROGRAM_BLOCK_SIZE 256
+
+/**
+ * @brief a compiled expression program.
+ *
+ * This data structure represents one or more expressions flattened into a single list of
+ * instructions in evaluation order, where every instruction only refers to the results of the
+ * instructions before it. Sub-expressions that are shared between (or within) the compiled
+ * expressions are compiled only once, so evaluating the program computes each of them once.
+ */
+struct program {
+	struct instruction {
+		enum expression_type type; ///< Type of the instruction.
+		union {
+			double constant; ///< Value of the constant.
+			char variable;	 ///< Name of the variable, must be an alphabet letter.
+			struct {
+				enum operation_type type; ///< Type of the operation.
+				/// Indices of the instructions computing the operation's operands.
+				size_t operands[OPERATION_ARITY_MAXIMUM];
+			} operation;
+		};
+	} *instructions;		   ///< Array of the program's instructions.
+	size_t instructions_count; ///< Number of instructions in the program.
+	size_t *outputs;		   ///< Indices of the instructions computing each compiled expression.
+	size_t outputs_count;	   ///< Number of compiled expressions.
+	void *mapping;			   ///< The memory mapping backing the program, or `NULL`.
+	size_t mapping_size;	   ///< The size of `mapping`.
+};
+
+/**
+ * @brief Creates a new program.
+ *
+ * Compiles the `count` expressions in `expressions` into a single program, eliminating any
+ * common sub-expressions between them.
+ *
+ * @param[in] count The number of expressions.
+ * @param[in] expressions Array of the expressions to be compiled.
+ * @return The newly created program.
+ *
+ * @memberof program
+ */
+struct program program_new(size_t count, const struct expression expressions[]);
+
+/**
+ * @brief Creates a program computing some of the expressions of another one.
+ *
+ * Returns a new program computing only the `count` expressions of `program` with indices in
+ * `outputs`, in that order, without the instructions only the other expressions need.
+ *
+ * @param[in] program The program.
+ * @param[in] count The number of expressions to keep.
+ * @param[in] outputs Array of the indices of the expressions to keep.
+ * @return The newly created program.
+ *
+ * @memberof program
+ */
+struct program program_select(const struct program *program, size_t count, const size_t outputs[]);
+
+/**
+ * @brief Drops a program.
+ *
+ * Releases all memory and resources owned by the program
+ *
+ * @param[in,out] program The program to drop.
+ *
+ * @memberof program
+ */
+void program_drop(struct program *program);
+
+/**
+ * @brief Saves a program to a file.
+ *
+ * Writes the program to the file at `path` in a compact binary format that can be memory-mapped
+ * by `program_load()`, along with the `key_size` bytes of `key`, like the source the program was
+ * compiled from, which must be given again to load it. The file is written to a temporary file
+ * first and then renamed, so concurrent readers never observe a partially written program.
+ *
+ * @param[in] program The program to be saved.
+ * @param[in] key The key of the program.
+ * @param[in] key_size The size of `key` in bytes.
+ * @param[in] path The path of the file.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error
+ *
+ * @memberof program
+ */
+int program_save(
+	const struct program *program,
+	const void *key,
+	size_t key_size,
+	const char *path
+);
+
+/**
+ * @brief Loads a program from a file.
+ *
+ * Memory-maps a program saved by `program_save()` and uses its instructions in place, without
+ * any parsing. Only files saved by a build with the same instruction layout are accepted.
+ * A missing file, or one saved with another key than `key`, isn't reported, so that loading can
+ * be used to look up a cached program.
+ *
+ * @param[out] program Pointer to the program to store the result.
+ * @param[in] key The key the program was saved with.
+ * @param[in] key_size The size of `key` in bytes.
+ * @param[in] path The path of the file.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error
+ *
+ * @memberof program
+ */
+int program_load(struct program *program, const void *key, size_t key_size, const char *path);
+
+/**
+ * @brief Evaluates a program
+ *
+ * Evaluates all the instructions of the program in the given environment and stores the result
+ * of each compiled expression in `results`.
+ *
+ * @param[in] program The program to be evaluated.
+ * @param[in] environment The environment the program is evaluated in.
+ * @param[out] values Scratch array of `program->instructions_count` values.
+ * @param[out] results Array of `program->outputs_count` results.
+ *
+ * @memberof program
+ */
+void program_evaluate(
+	const struct program *program,
+	const struct environment *environment,
+	double values[],
+	double results[]
+);
+
+/**
+ * @brief Evaluates a program over a block of indices
+ *
+ * Evaluates the program for each of the `size` values in `indices` of the variable `variable`,
+ * taking any other variable from the given environment. Rather than evaluating every instruction
+ * for one index before moving to the next, each instruction is evaluated over the whole block in a
+ * single loop, so the dispatch on its type is paid once per block and the arithmetic can be
+ * vectorized. Each value is computed exactly as `program_evaluate()` would compute it.
+ *
+ * The values of the instruction `j` are stored in `values[j * size]` to `values[j * size + size -
+ * 1]`, so the results of the compiled expression `i` start at `values[program->outputs[i] *
+ * size]`.
+ *
+ * @param[in] program The program to be evaluated.
+ * @param[in] environment The environment the program is evaluated in.
+ * @param[in] variable The name of the variable taking the values in `indices`.
+ * @param[in] indices Array of the values of `variable`.
+ * @param[in] size The number of values in `indices`, at most `PROGRAM_BLOCK_SIZE`.
+ * @param[out] values Scratch array of `program->instructions_count * size` values.
+ *
+ * @memberof program
+ */
+void program_evaluate_block(
+	const struct program *program,
+	const struct environment *environment,
+	char variable,
+	const double indices[],
+	size_t size,
+	double values[]
+);
+
+/**
+ * @brief Evaluates a program over a block of rows
+ *
+ * Like `program_evaluate_block()`, but for several variables at once: the variable
+ * `variables[k]` takes the `size` values in `columns[k]`, one per row, and any other variable is
+ * taken from the given environment. The columns are read in place, so they may be memory-mapped.
+ *
+ * @param[in] program The program to be evaluated.
+ * @param[in] environment The environment the program is evaluated in.
+ * @param[in] columns_count The number of columns.
+ * @param[in] variables Array of the names of the variables taking the values of each column.
+ * @param[in] columns Array of the columns, each of `size` values.
+ * @param[in] size The number of rows, at most `PROGRAM_BLOCK_SIZE`.
+ * @param[out] values Scratch array of `program->instructions_count * size` values.
+ *
+ * @memberof program
+ */
+void program_evaluate_rows(
+	const struct program *program,
+	const struct environment *environment,
+	size_t columns_count,
+	const char variables[],
+	const double *const columns[],
+	size_t size,
+	double values[]
+);
+
+/**
+ * @brief Evaluates some instructions of a program over a block of rows
+ *
+ * Like `program_evaluate_rows()`, but only evaluates the instructions flagged in `is_evaluated`,
+ * and reads the values of the others from `values` as they are. Instructions whose values don't
+ * change from one block to the next can thus be evaluated once, and left out of the later blocks.
+ *
+ * @param[in] program The program to be evaluated.
+ * @param[in] environment The environment the program is evaluated in.
+ * @param[in] columns_count The number of columns.
+ * @param[in] variables Array of the names of the variables taking the values of each column.
+ * @param[in] columns Array of the columns, each of `size` values.
+ * @param[in] size The number of rows, at most `PROGRAM_BLOCK_SIZE`.
+ * @param[in] is_evaluated Array of `program->instructions_count` flags, set for the instructions
+ * to evaluate.
+ * @param[in,out] values Array of `program->instructions_count * size` values, holding those of
+ * the instructions not evaluated.
+ *
+ * @memberof program
+ */
+void program_evaluate_selected(
+	const struct program *program,
+	const struct environment *environment,
+	size_t columns_count,
+	const char variables[],
+	const double *const columns[],
+	size_t size,
+	const bool is_evaluated[],
+	double values[]
+);
+
+/**
+ * @brief Gets the steps of the instructions of a program.
+ *
+ * Gets by how much the value of each instruction of the program changes when `variable` increases
+ * by one, for the instructions whose values are affine functions of it, and NAN for the others.
+ * Instructions not depending on `variable` have a step of 0.
+ *
+ * @param[in] program The program.
+ * @param[in] environment The environment the program is evaluated in.
+ * @param[in] variable The name of the variable.
+ * @param[out] steps Array of `program->instructions_count` steps.
+ *
+ * @memberof program
+ */
+void program_steps(
+	const struct program *program,
+	const struct environment *environment,
+	char variable,
+	double steps[]
+);
+
+/**
+ * @brief Checks whether an instruction of a program can be evaluated by a recurrence.
+ *
+ * An instruction taking the sine, cosine or exponential of an affine function of a variable, or
+ * raising a constant to such a function, can be evaluated at consecutive values of the variable
+ * by a recurrence, which only takes a few multiplications per value. So can factorials, gamma
+ * functions and binomial coefficients, and their logarithms, of affine functions stepping by small
+ * positive integers, which are advanced by running products or ratios.
+ *
+ * @param[in] program The program.
+ * @param[in] steps The steps of the instructions of the program, see `program_steps()`.
+ * @param[in] instruction The index of the instruction.
+ * @return Whether the instruction can be evaluated by a recurrence.
+ *
+ * @memberof program
+ */
+bool program_is_recurrence(const struct program *program, const double steps[], size_t instruction);
+
+/**
+ * @brief Evaluates a program over a block of consecutive indices using recurrences
+ *
+ * Like `program_evaluate_block()`, except that the values in `indices` must be consecutive
+ * integers, and the instructions for which `program_is_recurrence()` holds are evaluated exactly
+ * for the first index only and by a recurrence for the others. Their values thus have a rounding
+ * error of a few units in the last place per index, growing with the size of the block for
+ * factorials and binomial coefficients, while sines, cosines and exponentials are evaluated
+ * exactly again every few dozen indices, and wherever the recurrence would underflow, overflow or
+ * miss a zero of the sine.
+ *
+ * @param[in] program The program to be evaluated.
+ * @param[in] environment The environment the program is evaluated in.
+ * @param[in] variable The name of the variable taking the values in `indices`.
+ * @param[in] indices Array of the values of `variable`, consecutive integers.
+ * @param[in] size The number of values in `indices`, at most `PROGRAM_BLOCK_SIZE`.
+ * @param[in] steps The steps of the instructions of the program, see `program_steps()`.
+ * @param[out] values Scratch array of `program->instructions_count * size` values.
+ *
+ * @memberof program
+ */
+void program_evaluate_recurrence(
+	const struct program *program,
+	const struct environment *environment,
+	char variable,
+	const double indices[],
+	size_t size,
+	const double steps[],
+	double values[]
+);
+
+#endif
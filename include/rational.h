@@ -0,0 +1,105 @@
+#ifndef RATIONAL_H
+#define RATIONAL_H
+
+#include <polynomial.h>
+#include <program.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief The maximum number of partial fractions of a rational summand.
+ */
+#define RATIONAL_FRACTIONS_MAXIMUM (2 * POLYNOMIAL_DEGREE_MAXIMUM)
+
+/**
+ * @brief The largest denominator of the roots of the denominators of rational summands.
+ */
+#define RATIONAL_DENOMINATOR_MAXIMUM 16
+
+/**
+ * @brief a rational summand.
+ *
+ * This data structure represents a summand over a range of integers which is a rational function
+ * with rational poles, decomposed into a polynomial and partial fractions `c / (i - r) ^ m`, each
+ * summed in closed form.
+ */
+struct rational {
+	struct polynomial quotient; ///< Polynomial part of the summand.
+	size_t fractions_count;		///< Number of partial fractions.
+	/// Coefficient of each partial fraction.
+	double coefficients[RATIONAL_FRACTIONS_MAXIMUM];
+	double roots[RATIONAL_FRACTIONS_MAXIMUM]; ///< Root of the denominator of each fraction.
+	/// Power of the denominator of each partial fraction.
+	size_t multiplicities[RATIONAL_FRACTIONS_MAXIMUM];
+	long lower_bound; ///< The lower bound of the range.
+	long upper_bound; ///< The upper bound of the range.
+};
+
+/**
+ * @brief Gets the rational summands computed by a program over a range.
+ *
+ * Checks whether each of the expressions compiled into `program` is a rational function of the
+ * variable `variable` without poles at the integers from `lower_bound` to `upper_bound` inclusive.
+ * The expression is split into terms along additions, subtractions, negations and multiplications
+ * and divisions by constants, and these must be polynomials or quotients `p(i) / q(i)` of
+ * polynomials, as understood by `polynomial_from_program()`, with `q` having real roots that
+ * are fractions of denominators at most `RATIONAL_DENOMINATOR_MAXIMUM`, like
+ * `i / (i + 5) ^ 2` or `1 / (4 * i ^ 2 - 1)`. Each quotient is decomposed into its polynomial
+ * part and partial fractions `c / (i - r) ^ m` at each root `r` of `q` of multiplicity at least
+ * `m`. Summands whose polynomial part isn't well conditioned over the range, as checked by
+ * `polynomial_is_well_conditioned()`, aren't rational.
+ *
+ * @param[in] program The program.
+ * @param[in] variable The name of the variable.
+ * @param[in] lower_bound The lower bound of the range.
+ * @param[in] upper_bound The upper bound of the range, not less than `lower_bound`.
+ * @param[out] rationals Array of `program->outputs_count` rational summands, one for each
+ * expression.
+ * @param[out] is_rational Array of `program->outputs_count` flags, set for the expressions which
+ * are rational.
+ *
+ * @memberof rational
+ */
+void rational_from_program(
+	const struct program *program,
+	char variable,
+	long lower_bound,
+	long upper_bound,
+	struct rational rationals[],
+	bool is_rational[]
+);
+
+/**
+ * @brief Sums a partial fraction in closed form.
+ *
+ * Returns the summation of `1 / (i - root) ^ multiplicity` from `lower_bound` to `upper_bound`
+ * inclusive, which mustn't include `root`. Over the indices on either side of the root, the sum
+ * is a difference of digammas for a multiplicity of 1, and of Hurwitz zetas otherwise. These
+ * differences are computed as such, in a number of steps that only depends on the multiplicity:
+ * the first terms are added up until the arguments are large enough, and the rest from the
+ * Euler-Maclaurin formula, whose terms are differences of powers computed without cancellation.
+ *
+ * @param[in] root The root of the denominator of the fraction.
+ * @param[in] multiplicity The power of the denominator of the fraction, at least 1.
+ * @param[in] lower_bound The lower bound of the summation.
+ * @param[in] upper_bound The upper bound of the summation.
+ * @return The total of the summation.
+ *
+ * @memberof rational
+ */
+double rational_fraction_sum(double root, size_t multiplicity, long lower_bound, long upper_bound);
+
+/**
+ * @brief Sums a rational summand in closed form.
+ *
+ * Returns the summation of `rational` over its whole range, as the closed form of its polynomial
+ * part plus the closed forms of its partial fractions.
+ *
+ * @param[in] rational The rational summand to be summed.
+ * @return The total of the summation.
+ *
+ * @memberof rational
+ */
+double rational_sum(const struct rational *rational);
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef REDUCTION_H
+#define REDUCTION_H
+
+#include <stddef.h>
+
+/**
+ * @brief a reduction of the terms of a summation.
+ *
+ * This data structure represents the partial state of several reductions of the terms of a
+ * summation over a range of indices, computed together in one pass: their sum, their extrema and
+ * the first indices where they're reached, their mean and variance, the number of non-finite
+ * terms, and their L1 and L2 norms. The sum includes every term, as summed by `summation()`,
+ * while the other reductions only include the finite terms, so that a NaN or an infinite term is
+ * counted instead of hiding the statistics of the others. The partial states of consecutive
+ * ranges are merged into the state of their union, so that ranges split across threads or shards
+ * are reduced like a single range.
+ */
+struct reduction {
+	unsigned long count;			///< Number of terms.
+	unsigned long non_finite_count; ///< Number of NaN or infinite terms.
+	double sum;						///< Sum of the terms.
+	double minimum;					///< Smallest finite term, or infinity if none.
+	long minimum_index;				///< First index of the smallest finite term.
+	double maximum;					///< Largest finite term, or minus infinity if none.
+	long maximum_index;				///< First index of the largest finite term.
+	double mean;					///< Mean of the finite terms, updated as by Welford.
+	/// Sum of the squared differences of the finite terms from their mean.
+	double squared_deviations;
+	double absolute_sum; ///< Sum of the magnitudes of the finite terms, their L1 norm.
+	/// Largest magnitude of the finite terms, by which the sum of their squares is scaled.
+	double scale;
+	/// Sum of the squares of the finite terms divided by the square of `scale`.
+	double scaled_squares;
+};
+
+/**
+ * @brief Creates a new reduction.
+ *
+ * Initializes the reduction of an empty range.
+ *
+ * @return The newly created reduction.
+ *
+ * @memberof reduction
+ */
+struct reduction reduction_new(void);
+
+/**
+ * @brief Adds a block of terms to a reduction.
+ *
+ * Adds the terms `terms[0]`, ..., `terms[size - 1]` at the consecutive indices starting from
+ * `first_index`, which follow the indices already reduced, in order.
+ *
+ * @param[in,out] reduction The reduction.
+ * @param[in] first_index The index of the first term.
+ * @param[in] size The number of terms.
+ * @param[in] terms Array of the terms.
+ *
+ * @memberof reduction
+ */
+void reduction_add(
+	struct reduction *reduction,
+	long first_index,
+	size_t size,
+	const double terms[]
+);
+
+/**
+ * @brief Merges a reduction into another.
+ *
+ * Merges the reduction of a range of indices following those of `reduction` into it, which is
+ * then the reduction of their union. Extrema reached in both keep the indices of `reduction`.
+ *
+ * @param[in,out] reduction The reduction of the first range.
+ * @param[in] other The reduction of the following range.
+ *
+ * @memberof reduction
+ */
+void reduction_merge(struct reduction *reduction, const struct reduction *other);
+
+/**
+ * @brief Merges reductions in a fixed order.
+ *
+ * Returns the merge of the `count` reductions `reductions[0]`, `reductions[stride]`, ..., of
+ * consecutive ranges, merged pairwise like `scheduler_sum()`, so that their sum is the one
+ * `scheduler_sum()` gives for their sums.
+ *
+ * @param[in] reductions The reductions to be merged.
+ * @param[in] count The number of reductions.
+ * @param[in] stride The distance between consecutive reductions.
+ * @return The merged reduction.
+ *
+ * @memberof reduction
+ */
+struct reduction reduction_combine(
+	const struct reduction reductions[],
+	size_t count,
+	size_t stride
+);
+
+/**
+ * @brief Gets the variance of the finite terms of a reduction.
+ *
+ * @param[in] reduction The reduction.
+ * @return The population variance of the finite terms, or NaN if there are none.
+ *
+ * @memberof reduction
+ */
+double reduction_variance(const struct reduction *reduction);
+
+/**
+ * @brief Gets the L2 norm of the finite terms of a reduction.
+ *
+ * The squares are summed scaled by the largest magnitude, so that the norm neither overflows nor
+ * underflows unless it's out of range itself.
+ *
+ * @param[in] reduction The reduction.
+ * @return The square root of the sum of the squares of the finite terms.
+ *
+ * @memberof reduction
+ */
+double reduction_l2_norm(const struct reduction *reduction);
+
+#endif
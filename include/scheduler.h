@@ -0,0 +1,94 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stddef.h>
+
+/**
+ * @brief A unit of work run by the scheduler.
+ *
+ * Processes the leaf with index `leaf` on the thread with index `thread`.
+ *
+ * @param[in,out] context The context passed to `scheduler_run()`.
+ * @param[in] thread The index of the thread running the leaf, less than the number of threads.
+ * @param[in] leaf The index of the leaf.
+ */
+typedef void (*scheduler_function)(void *context, size_t thread, size_t leaf);
+
+/**
+ * @brief the statistics of a scheduler run.
+ */
+struct scheduler_statistics {
+	double *busy_seconds; ///< Time each thread spent processing leaves, one per thread.
+	size_t *leaves_count; ///< Number of leaves each thread processed, one per thread.
+	size_t steals_count;  ///< Number of times a thread stole work from another one.
+};
+
+/**
+ * @brief Gets the number of threads to use by default.
+ *
+ * @return The number of online processors.
+ */
+size_t scheduler_default_threads_count(void);
+
+/**
+ * @brief Runs leaves in parallel.
+ *
+ * Calls `function` once for every leaf from 0 to `leaves_count - 1` on `threads_count` threads,
+ * including the calling thread, which has index 0, and returns when all of them are done.
+ *
+ * Each thread starts with a contiguous share of the leaves in its own deque, and works through it
+ * in order. While other threads are idle, a busy thread splits the rest of its current chunk in
+ * half and pushes the second half onto its deque, from where idle threads steal the oldest (and
+ * so largest) chunks. The work is thus only split as finely as the imbalance requires, while the
+ * leaves themselves, and so any results stored per leaf, don't depend on the schedule.
+ *
+ * @param[in] threads_count The number of threads, 0 for the default number.
+ * @param[in] leaves_count The number of leaves.
+ * @param[in] function The function processing a leaf.
+ * @param[in,out] context The context passed to `function`.
+ * @param[out] statistics Pointer to the statistics of the run, or `NULL`.
+ */
+void scheduler_run(
+	size_t threads_count,
+	size_t leaves_count,
+	scheduler_function function,
+	void *context,
+	struct scheduler_statistics *statistics
+);
+
+/**
+ * @brief Gets the bounds of a part of a range.
+ *
+ * Splits the range from `lower_bound` to `upper_bound` inclusive into `parts_count` contiguous
+ * parts whose sizes differ by at most one, and gets the bounds of the part with index `part`.
+ *
+ * @param[in] lower_bound The lower bound of the range.
+ * @param[in] upper_bound The upper bound of the range, not less than `lower_bound`.
+ * @param[in] parts_count The number of parts, not more than the size of the range.
+ * @param[in] part The index of the part.
+ * @param[out] part_lower_bound Pointer to store the lower bound of the part.
+ * @param[out] part_upper_bound Pointer to store the upper bound of the part.
+ */
+void scheduler_partition(
+	long lower_bound,
+	long upper_bound,
+	size_t parts_count,
+	size_t part,
+	long *part_lower_bound,
+	long *part_upper_bound
+);
+
+/**
+ * @brief Sums values in a fixed order.
+ *
+ * Returns the sum of the `count` values `values[0]`, `values[stride]`, ..., summed pairwise, which
+ * keeps the rounding error low and the result independent of how the values were computed.
+ *
+ * @param[in] values The values to be summed.
+ * @param[in] count The number of values.
+ * @param[in] stride The distance between consecutive values.
+ * @return The sum of the values.
+ */
+double scheduler_sum(const double values[], size_t count, size_t stride);
+
+#endif
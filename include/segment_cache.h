@@ -0,0 +1,125 @@
+#ifndef SEGMENT_CACHE_H
+#define SEGMENT_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The base 2 logarithm of the number of indices of the smallest cached segments.
+ *
+ * Segments are only worth caching when summing them takes much longer than looking them up.
+ */
+#define SEGMENT_CACHE_LEVEL_MINIMUM 20
+
+/**
+ * @brief The base 2 logarithm of the number of indices of the largest cached segments.
+ */
+#define SEGMENT_CACHE_LEVEL_MAXIMUM 63
+
+/**
+ * @brief a cached partial sum.
+ *
+ * The segments are aligned: a segment of level `l` is made of the `2^l` indices starting at a
+ * multiple of `2^l`, counting from the smallest `long`.
+ */
+struct segment_cache_entry {
+	int64_t start;		///< The first index of the segment.
+	uint64_t level;		///< Base 2 logarithm of the number of indices, 0 for an empty slot.
+	uint64_t last_used; ///< Value of the cache's clock when the entry was last used.
+	double sum;			///< The sum of the summand over the segment.
+};
+
+/**
+ * @brief a cache of partial sums over segments of indices.
+ *
+ * This data structure represents the partial sums of a summand over aligned segments of a power
+ * of two indices, stored in a memory-mapped file shared by all the processes using it, which lock
+ * it around every access. When full, the least recently used entry is evicted.
+ */
+struct segment_cache {
+	int file;							///< The file of the cache.
+	void *mapping;						///< The memory mapping of the file.
+	size_t mapping_size;				///< The size of `mapping`.
+	struct segment_cache_entry *entries; ///< The entries, inside `mapping`.
+	size_t entries_count;				///< The number of entries the cache can hold.
+};
+
+/**
+ * @brief Gets the size of the file of a cache of entries.
+ *
+ * @param[in] entries_count The number of entries of the cache.
+ * @return The size of the cache's file.
+ *
+ * @memberof segment_cache
+ */
+size_t segment_cache_size(size_t entries_count);
+
+/**
+ * @brief Opens a segment cache.
+ *
+ * Opens the cache in the file at `path`, creating it with room for as many entries as fit in
+ * `size` bytes if it doesn't exist yet or isn't a segment cache. An existing cache keeps its size.
+ *
+ * @param[out] cache The cache to open.
+ * @param[in] path The path of the cache's file.
+ * @param[in] size The maximum size of the cache's file, at least `segment_cache_size(1)`.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error.
+ *
+ * @memberof segment_cache
+ */
+int segment_cache_open(struct segment_cache *cache, const char *path, size_t size);
+
+/**
+ * @brief Closes a segment cache.
+ *
+ * Releases all memory and resources owned by the cache, whose file remains.
+ *
+ * @param[in,out] cache The cache to close.
+ *
+ * @memberof segment_cache
+ */
+void segment_cache_close(struct segment_cache *cache);
+
+/**
+ * @brief Looks up the partial sum over a segment.
+ *
+ * @param[in,out] cache The cache.
+ * @param[in] start The first index of the segment.
+ * @param[in] level The base 2 logarithm of the number of indices of the segment.
+ * @param[out] sum The partial sum, if cached.
+ * @return Whether the partial sum is cached.
+ *
+ * @memberof segment_cache
+ */
+bool segment_cache_get(struct segment_cache *cache, long start, size_t level, double *sum);
+
+/**
+ * @brief Checks whether any of the proper sub-segments of a segment are cached.
+ *
+ * @param[in,out] cache The cache.
+ * @param[in] start The first index of the segment.
+ * @param[in] level The base 2 logarithm of the number of indices of the segment.
+ * @return Whether any smaller segment inside it is cached.
+ *
+ * @memberof segment_cache
+ */
+bool segment_cache_has_inside(struct segment_cache *cache, long start, size_t level);
+
+/**
+ * @brief Caches the partial sum over a segment.
+ *
+ * Evicts the least recently used entry if the cache is full.
+ *
+ * @param[in,out] cache The cache.
+ * @param[in] start The first index of the segment, a multiple of `2^level` from the smallest
+ * `long`.
+ * @param[in] level The base 2 logarithm of the number of indices of the segment, between 1 and
+ * `SEGMENT_CACHE_LEVEL_MAXIMUM`.
+ * @param[in] sum The partial sum.
+ *
+ * @memberof segment_cache
+ */
+void segment_cache_put(struct segment_cache *cache, long start, size_t level, double sum);
+
+#endif
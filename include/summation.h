@@ -2,6 +2,263 @@
 #define SUMMATION_H
 
 #include <expression.h>
+#include <kernel.h>
+#include <periodicity.h>
+#include <polynomial.h>
+#include <program.h>
+#include <rational.h>
+#include <reduction.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <telescoping.h>
+
+/**
+ * @brief the options of a summation.
+ */
+struct summation_options {
+	/// Directory caching the compiled summands and the cost model across processes, or `NULL` to
+	/// disable caching.
+	const char *cache_directory;
+	/// Number of threads evaluating the summations, 0 to choose it automatically.
+	size_t threads_count;
+	/**
+	 * @brief An engine evaluating the terms of summations.
+	 */
+	enum summation_engine {
+		summation_engine_automatic,	 ///< Chooses the fastest way to evaluate each summation.
+		summation_engine_scalar,	 ///< Evaluates the whole program for one index at a time.
+		summation_engine_block,		 ///< Evaluates each instruction over a block of indices at a time.
+		summation_engine_recurrence, ///< Like block, but evaluates some functions by recurrences.
+		summation_engine_native,	 ///< Evaluates a kernel compiled by the system's C compiler.
+	} engine;						 ///< Engine evaluating the terms of the summations.
+	/// Maximum size in bytes of the file caching partial sums of each summand in the cache
+	/// directory, 0 to disable it.
+	size_t segment_cache_size;
+};
+
+/**
+ * @brief The number of summation engines.
+ */
+#define SUMMATION_ENGINES_COUNT ((size_t)summation_engine_native + 1)
+
+/**
+ * @brief Creates the default summation options.
+ *
+ * @return The default options.
+ *
+ * @memberof summation_options
+ */
+static inline struct summation_options summation_options_default(void) {
+	return (struct summation_options){
+		.cache_directory = NULL,
+		.threads_count = 0,
+		.engine = summation_engine_automatic,
+		.segment_cache_size = 0,
+	};
+}
+
+/**
+ * @brief Gets the name of a summation engine.
+ *
+ * @param[in] engine The engine.
+ * @return The name of the engine.
+ *
+ * @memberof summation_engine
+ */
+static inline const char *summation_engine_name(enum summation_engine engine) {
+	switch (engine) {
+		case summation_engine_automatic: return "automatic";
+		case summation_engine_scalar: return "scalar";
+		case summation_engine_block: return "block";
+		case summation_engine_recurrence: return "recurrence";
+		case summation_engine_native: return "native";
+	}
+}
+
+/**
+ * @brief a plan for evaluating summations.
+ *
+ * This data structure represents how summations over the same range are going to be evaluated:
+ * which of the summands are summed in closed form, which engine evaluates the terms of the others
+ * and on how many threads. Unless forced by the options, these are chosen based on the structure
+ * of the summands, the size of the range and the cost model of the machine.
+ */
+struct summation_plan {
+	long lower_bound;				///< The lower bound of the summations.
+	long upper_bound;				///< The upper bound of the summations.
+	size_t count;					///< Number of summands.
+	bool *is_closed_form; ///< Whether each summand is summed in closed form.
+	/// Piecewise polynomial of each summand summed in closed form, unless it telescopes.
+	struct piecewise_polynomial *polynomials;
+	bool *is_telescoping; ///< Whether each summand summed in closed form telescopes.
+	struct telescoping *telescopings; ///< Telescoping form of each summand which telescopes.
+	bool *is_periodic; ///< Whether each summand summed in closed form is periodic instead.
+	struct periodicity *periodicities; ///< Periodic form of each summand which is periodic.
+	bool *is_rational; ///< Whether each summand summed in closed form is rational instead.
+	struct rational *rationals; ///< Partial fractions of each summand which is rational.
+	struct program program;			///< Program computing the terms of the other summands.
+	double *steps;					///< Steps of the instructions of `program`.
+	enum summation_engine engine;	///< Engine evaluating `program`, never automatic.
+	struct kernel kernel;			///< Kernel compiled from `program`, for the native engine.
+	/// Estimated time to evaluate `program` for one index with each engine.
+	double term_seconds[SUMMATION_ENGINES_COUNT];
+	size_t leaves_count;	  ///< Number of leaves the range is split into.
+	size_t threads_count;	  ///< Number of threads evaluating the leaves.
+	double estimated_seconds; ///< Estimated time to execute the plan.
+};
+
+/**
+ * @brief Creates a new summation plan.
+ *
+ * Plans the evaluation of the summations of each of the `count` expressions in `summands` from
+ * `lower_bound` to `upper_bound` inclusive.
+ *
+ * With the automatic engine, the summands which are polynomials in the index, or piecewise
+ * polynomials of few enough pieces over the range, are summed in closed form piece by piece, the
+ * summands which telescope are summed from the values of their terms near the bounds, the
+ * periodic ones from their first period, the rational ones from their partial fractions, and the
+ * engine and the number of threads evaluating the others are those with the lowest time estimated
+ * by the cost model, calibrated once per process or loaded from the cache directory. The native
+ * engine is never chosen automatically, as it takes a run of the C compiler unless its kernel is
+ * cached. When forced but no kernel can be compiled, such as without a C compiler, the block engine
+ * is used instead.
+ *
+ * @param[in] lower_bound The lower bound of the summations
+ * @param[in] upper_bound The upper bound of the summations
+ * @param[in] count The number of summands
+ * @param[in] summands Array of the summands of the summations
+ * @param[in] options The options of the summations, or `NULL` for the default options
+ * @return The newly created plan.
+ *
+ * @memberof summation_plan
+ */
+struct summation_plan summation_plan_new(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	const struct summation_options *options
+);
+
+/**
+ * @brief Drops a summation plan.
+ *
+ * Releases all memory and resources owned by the plan
+ *
+ * @param[in,out] plan The plan to drop.
+ *
+ * @memberof summation_plan
+ */
+void summation_plan_drop(struct summation_plan *plan);
+
+/**
+ * @brief Executes a summation plan.
+ *
+ * Evaluates the planned summations and stores their totals in `sums`.
+ *
+ * @param[in] plan The plan to be executed.
+ * @param[out] sums Array of `plan->count` totals, one for each summand
+ *
+ * @memberof summation_plan
+ */
+void summation_plan_execute(const struct summation_plan *plan, double sums[]);
+
+/**
+ * @brief the progress of the execution of a summation plan.
+ */
+struct summation_progress {
+	unsigned long terms_done;  ///< Number of indices whose terms have been added up so far.
+	unsigned long terms_count; ///< Number of indices in the range.
+	double terms_per_second;   ///< Average number of indices done per second so far.
+	/// Partial totals of the summations, the closed forms and the leaves done so far.
+	const double *sums;
+	size_t count; ///< Number of summands.
+};
+
+/**
+ * @brief A function reporting the progress of the execution of a summation plan.
+ *
+ * @param[in,out] context The context of the monitor.
+ * @param[in] progress The progress of the execution, only valid during the call.
+ */
+typedef void (*summation_progress_function)(
+	void *context,
+	const struct summation_progress *progress
+);
+
+/**
+ * @brief a monitor of the execution of a summation plan.
+ *
+ * This data structure lets another thread cancel the execution of a summation plan, and reports
+ * its progress.
+ */
+struct summation_monitor {
+	atomic_bool is_cancelled; ///< Stops the execution at the next block of indices when set.
+	/// Function reporting the progress, or `NULL`. It's called on the thread executing the plan,
+	/// which doesn't evaluate any terms meanwhile.
+	summation_progress_function function;
+	void *context;			 ///< The context passed to `function`.
+	double interval_seconds; ///< The time between two reports.
+};
+
+/**
+ * @brief Executes a summation plan under a monitor.
+ *
+ * Works like `summation_plan_execute()`, but stops as soon as `monitor->is_cancelled` is set,
+ * which is checked after every block of indices and so takes effect within a fraction of a
+ * millisecond, and calls `monitor->function` about every `monitor->interval_seconds`, and once
+ * more when done.
+ *
+ * @param[in] plan The plan to be executed.
+ * @param[out] sums Array of `plan->count` totals, one for each summand, unspecified if cancelled
+ * @param[in,out] monitor The monitor of the execution.
+ * @return EXIT_SUCCESS when done, and EXIT_FAILURE when cancelled
+ *
+ * @memberof summation_plan
+ */
+int summation_plan_execute_monitored(
+	const struct summation_plan *plan,
+	double sums[],
+	struct summation_monitor *monitor
+);
+
+/**
+ * @brief Executes a summation plan, reducing the terms of the summands.
+ *
+ * Works like `summation_plan_execute()`, but reduces the terms of each summand as described by
+ * `struct reduction` instead of only summing them, in the same pass over the range. Each leaf is
+ * reduced in index order and the leaves are merged pairwise, so that the reductions are the same
+ * for any number of threads, and their sums are the totals `summation_plan_execute()` computes.
+ * The plan mustn't sum any summand in closed form nor use the native engine, which only give
+ * the sums.
+ *
+ * @param[in] plan The plan to be executed.
+ * @param[out] reductions Array of `plan->count` reductions, one for each summand
+ *
+ * @memberof summation_plan
+ */
+void summation_plan_execute_reduced(
+	const struct summation_plan *plan,
+	struct reduction reductions[]
+);
+
+/**
+ * @brief Explains a summation plan.
+ *
+ * Prints a human-readable description of the plan to `file`.
+ *
+ * @param[in] plan The plan to be explained.
+ * @param[in] summands Array of the summands the plan was created for.
+ * @param[in] file The file to print to.
+ *
+ * @memberof summation_plan
+ */
+void summation_plan_explain(
+	const struct summation_plan *plan,
+	const char *const summands[],
+	FILE *file
+);
 
 /**
  * @brief Evaluates a summation
@@ -16,4 +273,67 @@
  */
 double summation(long lower_bound, long upper_bound, const char *summand);
 
+/**
+ * @brief Evaluates several summations over the same range
+ *
+ * Evaluates the summations of each of the `count` expressions in `summands` from `lower_bound` to
+ * `upper_bound` inclusive in a single pass over the range, and stores their totals in `sums`.
+ * Sub-expressions shared between the summands are only evaluated once per index.
+ * The index of summation is named i.
+ *
+ * The summations are evaluated as planned by `summation_plan_new()`.
+ * The range is split into leaves whose sums are combined pairwise. As the leaves only depend on
+ * the range, the totals are the same for any number of threads. The scalar and block engines
+ * compute the same terms and add them up in the same order, as does the native engine, so their
+ * totals are the same too, while closed forms and recurrences may differ from them in the last
+ * places.
+ *
+ * With a segment cache, the summands not summed in closed form are summed one at a time, keyed by
+ * their simplified form, over aligned segments of a power of two indices, at least
+ * `2^SEGMENT_CACHE_LEVEL_MINIMUM`, whose partial sums are cached across calls and processes, and
+ * over the indices at the edges of the range outside of such segments. Segments are assembled
+ * from the cached segments inside them, if any, so that overlapping ranges only sum the indices
+ * they don't share. Totals assembled from segments may differ from those summed at once in the
+ * last places.
+ *
+ * @param[in] lower_bound The lower bound of the summations
+ * @param[in] upper_bound The upper bound of the summations
+ * @param[in] count The number of summands
+ * @param[in] summands Array of the summands of the summations
+ * @param[out] sums Array of `count` totals, one for each summand
+ * @param[in] options The options of the summations, or `NULL` for the default options
+ */
+void summation_fused(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	double sums[],
+	const struct summation_options *options
+);
+
+/**
+ * @brief Reduces several summations over the same range
+ *
+ * Works like `summation_fused()`, but reduces the terms of each of the `count` expressions in
+ * `summands` as described by `struct reduction`, with `summation_plan_execute_reduced()`. The
+ * terms are evaluated by the engine of the options, except that the automatic and native engines
+ * are replaced with the block engine, and without closed forms or a segment cache.
+ *
+ * @param[in] lower_bound The lower bound of the summations
+ * @param[in] upper_bound The upper bound of the summations
+ * @param[in] count The number of summands
+ * @param[in] summands Array of the summands of the summations
+ * @param[out] reductions Array of `count` reductions, one for each summand
+ * @param[in] options The options of the summations, or `NULL` for the default options
+ */
+void summation_reduce_fused(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	struct reduction reductions[],
+	const struct summation_options *options
+);
+
 #endif
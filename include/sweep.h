@@ -0,0 +1,78 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stddef.h>
+#include <summation.h>
+
+/**
+ * @brief a sweep of a parameter.
+ *
+ * This data structure represents the values a variable of the summands, the parameter, takes in
+ * turn, each giving its own totals of the summations.
+ */
+struct sweep {
+	char variable;		 ///< The name of the parameter.
+	double *values;		 ///< The values of the parameter.
+	size_t values_count; ///< The number of values of the parameter.
+};
+
+/**
+ * @brief Parses a sweep.
+ *
+ * Parses a string of the form `VARIABLE=START:STOP:COUNT`, for `COUNT` values evenly spaced from
+ * `START` to `STOP` inclusive, or `VARIABLE=VALUE,VALUE,...` for a list of values. The variable
+ * can't be i, which is the index of the summations.
+ *
+ * @param[out] sweep The sweep to create, to be dropped with `sweep_drop()`.
+ * @param[in] string The string to be parsed.
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE if the string isn't a valid sweep.
+ *
+ * @memberof sweep
+ */
+int sweep_parse(struct sweep *sweep, const char *string);
+
+/**
+ * @brief Drops a sweep.
+ *
+ * Releases all memory and resources owned by the sweep
+ *
+ * @param[in,out] sweep The sweep to drop.
+ *
+ * @memberof sweep
+ */
+void sweep_drop(struct sweep *sweep);
+
+/**
+ * @brief Evaluates several summations for each value of a parameter
+ *
+ * Evaluates the summations of each of the `count` expressions in `summands` from `lower_bound` to
+ * `upper_bound` inclusive, with the parameter of `sweep` bound to each of its values in turn, and
+ * stores their totals in `sums`: the `count` totals for the first value, then for the second, and
+ * so on.
+ *
+ * The summands are compiled once. The parts of them which don't depend on i are evaluated once
+ * per value of the parameter, and those which only depend on i once per index. The rest is
+ * evaluated at each index over blocks of values of the parameter, so that the arithmetic is
+ * vectorized across them, and the terms of each value are added up in index order. The blocks of
+ * values are evaluated in parallel. The summations are always iterated, without closed forms.
+ *
+ * @param[in] lower_bound The lower bound of the summations
+ * @param[in] upper_bound The upper bound of the summations
+ * @param[in] sweep The sweep of the parameter.
+ * @param[in] count The number of summands
+ * @param[in] summands Array of the summands of the summations
+ * @param[out] sums Array of `sweep->values_count * count` totals
+ * @param[in] options The options of the summations, or `NULL` for the default options, of which
+ * only the number of threads is used.
+ */
+void sweep_summation_fused(
+	long lower_bound,
+	long upper_bound,
+	const struct sweep *sweep,
+	size_t count,
+	const char *const summands[],
+	double sums[],
+	const struct summation_options *options
+);
+
+#endif
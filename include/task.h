@@ -0,0 +1,131 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <summation.h>
+
+/**
+ * @brief The number of threads of the pool running tasks.
+ *
+ * Summations run on several threads of their own, so a few tasks at a time keep the processors
+ * busy, while still letting short tasks overtake long ones.
+ */
+#define TASK_POOL_THREADS_COUNT 4
+
+/**
+ * @brief The time between two reports of the progress of a task.
+ */
+#define TASK_PROGRESS_INTERVAL_SECONDS 0.1
+
+/**
+ * @brief The status of a task.
+ */
+enum task_status {
+	task_status_queued,	   ///< Waiting for a thread of the pool.
+	task_status_running,   ///< Being evaluated.
+	task_status_done,	   ///< Evaluated, its totals are known.
+	task_status_cancelled, ///< Cancelled before it was done.
+};
+
+/**
+ * @brief a summation running in the background.
+ *
+ * This data structure represents summations submitted to a pool of threads shared by the whole
+ * process, which are planned and evaluated there while the submitting thread carries on. The
+ * submitting thread polls or waits for the task, and can cancel it, which stops the evaluation
+ * at the next block of indices.
+ */
+struct task;
+
+/**
+ * @brief Submits summations to the pool.
+ *
+ * Queues the evaluation of the summations of each of the `count` expressions in `summands` from
+ * `lower_bound` to `upper_bound` inclusive, like `summation_fused()` would. The summands and the
+ * options are copied, so they don't need to outlive the call.
+ *
+ * While the task runs, `progress` is called on its thread about every
+ * `TASK_PROGRESS_INTERVAL_SECONDS` with the partial totals, and once more with the totals when
+ * it's done.
+ *
+ * @param[in] lower_bound The lower bound of the summations
+ * @param[in] upper_bound The upper bound of the summations
+ * @param[in] count The number of summands
+ * @param[in] summands Array of the summands of the summations
+ * @param[in] options The options of the summations, or `NULL` for the default options
+ * @param[in] progress The function reporting the progress of the task, or `NULL`.
+ * @param[in,out] context The context passed to `progress`.
+ * @return The newly submitted task, to be dropped with `task_drop()`.
+ *
+ * @memberof task
+ */
+struct task *task_submit(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	const struct summation_options *options,
+	summation_progress_function progress,
+	void *context
+);
+
+/**
+ * @brief Gets the status of a task.
+ *
+ * @param[in] task The task.
+ * @return The status of the task.
+ *
+ * @memberof task
+ */
+enum task_status task_status(struct task *task);
+
+/**
+ * @brief Waits for a task to finish.
+ *
+ * Waits until the task is done or cancelled, or until `timeout_seconds` have passed.
+ *
+ * @param[in] task The task.
+ * @param[in] timeout_seconds The longest time to wait, or a negative number to wait forever.
+ * @return Whether the task has finished.
+ *
+ * @memberof task
+ */
+bool task_wait(struct task *task, double timeout_seconds);
+
+/**
+ * @brief Cancels a task.
+ *
+ * A queued task is removed from the queue, and a running one stops at the next block of
+ * indices, within a fraction of a millisecond. A task that's already finished isn't affected.
+ *
+ * @param[in,out] task The task to be cancelled.
+ *
+ * @memberof task
+ */
+void task_cancel(struct task *task);
+
+/**
+ * @brief Gets the totals of a task.
+ *
+ * @param[in] task The task.
+ * @param[out] sums Array of totals, one for each summand
+ * @return EXIT_SUCCESS if the task is done, and EXIT_FAILURE otherwise
+ *
+ * @memberof task
+ */
+int task_result(struct task *task, double sums[]);
+
+/**
+ * @brief Drops a task.
+ *
+ * Cancels the task if it hasn't finished yet, waits for it and releases all memory and resources
+ * owned by it.
+ *
+ * @param[in,out] task The task to drop.
+ *
+ * @memberof task
+ */
+void task_drop(struct task *task);
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef TELESCOPING_H
+#define TELESCOPING_H
+
+#include <program.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief The maximum number of shifted terms of a telescoping sum.
+ */
+#define TELESCOPING_TERMS_MAXIMUM 16
+
+/**
+ * @brief The maximum difference between the shifts of the terms of a telescoping sum.
+ *
+ * Summing in closed form evaluates the function at about this many indices at each end of the
+ * range.
+ */
+#define TELESCOPING_SHIFT_MAXIMUM 64
+
+/**
+ * @brief a telescoping summand.
+ *
+ * This data structure represents a summand over a range of integers which is a combination of a
+ * single function at shifted indices, `c_1 g(i + a_1) + ... + c_n g(i + a_n)`, whose
+ * coefficients add up to zero, so that its summation collapses to values of `g` near the bounds
+ * of the range.
+ */
+struct telescoping {
+	struct program function;  ///< Program computing the function `g`, as its single output.
+	char variable;			  ///< The name of the variable of `function`.
+	size_t terms_count;		  ///< Number of shifted terms.
+	/// Coefficient of each term.
+	double coefficients[TELESCOPING_TERMS_MAXIMUM];
+	long shifts[TELESCOPING_TERMS_MAXIMUM]; ///< Shift of the index of each term.
+	long lower_bound;						///< The lower bound of the range.
+	long upper_bound;						///< The upper bound of the range.
+};
+
+/**
+ * @brief Gets the telescoping summands computed by a program over a range.
+ *
+ * Checks whether each of the expressions compiled into `program` telescopes in the variable
+ * `variable` over the integers from `lower_bound` to `upper_bound` inclusive. The expression is
+ * split into terms along additions, subtractions, negations and multiplications and divisions
+ * by constants, and these must either be the same function of the variable shifted by integers,
+ * like `log(i + 1) - log(i)`, or rational functions whose denominators have distinct integer
+ * roots outside of the range and numerators of lower degrees, like `1 / (i * (i + 1))`, which are
+ * decomposed into partial fractions `c / (i + a)`. In both cases the coefficients of the terms
+ * must add up to zero, and the shifted function must be defined at every index it's evaluated at,
+ * as its poles wouldn't cancel out.
+ *
+ * @param[in] program The program.
+ * @param[in] variable The name of the variable.
+ * @param[in] lower_bound The lower bound of the range.
+ * @param[in] upper_bound The upper bound of the range, not less than `lower_bound`.
+ * @param[out] telescopings Array of `program->outputs_count` telescoping summands, one for each
+ * expression, those which telescope to be dropped with `telescoping_drop()`.
+ * @param[out] is_telescoping Array of `program->outputs_count` flags, set for the expressions
+ * which telescope.
+ *
+ * @memberof telescoping
+ */
+void telescoping_from_program(
+	const struct program *program,
+	char variable,
+	long lower_bound,
+	long upper_bound,
+	struct telescoping telescopings[],
+	bool is_telescoping[]
+);
+
+/**
+ * @brief Drops a telescoping summand.
+ *
+ * Releases all memory and resources owned by the telescoping summand
+ *
+ * @param[in,out] telescoping The telescoping summand to drop.
+ *
+ * @memberof telescoping
+ */
+void telescoping_drop(struct telescoping *telescoping);
+
+/**
+ * @brief Sums a telescoping summand in closed form.
+ *
+ * Returns the summation of `telescoping` over its whole range. Relative to the smallest shift
+ * `a`, the sum of each term `c g(i + a_k)` over the range is that of `c g(i + a)` plus the values
+ * of `g` past the upper bound and minus those before the lower bound, and the sums of the
+ * `c g(i + a)` cancel out, so only `g` at most `TELESCOPING_SHIFT_MAXIMUM` indices away from each
+ * bound is evaluated.
+ *
+ * @param[in] telescoping The telescoping summand to be summed.
+ * @return The total of the summation.
+ *
+ * @memberof telescoping
+ */
+double telescoping_sum(const struct telescoping *telescoping);
+
+#endif
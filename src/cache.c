@@ -0,0 +1,46 @@
+#include <cache.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define CACHE_HASH_PRIME UINT64_C(0x100000001b3)
+
+uint64_t cache_hash(uint64_t hash, const void *data, size_t size) {
+	assert(data != NULL || size == 0);
+
+	const unsigned char *bytes = data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= CACHE_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+char *cache_path(const char *directory, uint64_t key, const char *extension) {
+	assert(directory != NULL && extension != NULL);
+
+	if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+		(void)fprintf(stderr, "Warning: Failed to create cache directory \"%s\"\n", directory);
+		return NULL;
+	}
+
+	int length = snprintf(NULL, 0, "%s/%016" PRIx64 ".%s", directory, key, extension);
+	if (length < 0) {
+		return NULL;
+	}
+
+	char *path = malloc((size_t)length + 1);
+	if (path == NULL) {
+		return NULL;
+	}
+
+	(void)snprintf(path, (size_t)length + 1, "%s/%016" PRIx64 ".%s", directory, key, extension);
+
+	return path;
+}
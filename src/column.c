@@ -0,0 +1,339 @@
+#include <column.h>
+
+#include <assert.h>
+#include <ctype.h>
+#include <environment.h>
+#include <fcntl.h>
+#include <math.h>
+#include <program.h>
+#include <scheduler.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief The minimum number of rows in a leaf of a summation.
+ */
+#define COLUMN_LEAF_SIZE_MINIMUM 1024
+/**
+ * @brief The maximum number of leaves of a summation.
+ */
+#define COLUMN_LEAVES_MAXIMUM 4096
+
+int column_map(struct column *column, char variable, const char *path) {
+	assert(column != NULL && isalpha((unsigned char)variable) && path != NULL);
+
+	int file = open(path, O_RDONLY);
+	if (file < 0) {
+		(void)fprintf(stderr, "Error: Failed to open \"%s\"\n", path);
+		return EXIT_FAILURE;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || (size_t)status.st_size % sizeof(double) != 0) {
+		(void)fprintf(stderr, "Error: \"%s\" is not a column\n", path);
+		(void)close(file);
+		return EXIT_FAILURE;
+	}
+
+	size_t size = (size_t)status.st_size;
+	*column = (struct column){
+		.variable = variable,
+		.values = NULL,
+		.rows_count = size / sizeof(double),
+		.mapping = NULL,
+		.mapping_size = size,
+	};
+
+	// empty files can't be mapped
+	if (size == 0) {
+		(void)close(file);
+		return EXIT_SUCCESS;
+	}
+
+	void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, file, 0);
+	(void)close(file);
+	if (mapping == MAP_FAILED) {
+		(void)fprintf(stderr, "Error: Failed to map \"%s\"\n", path);
+		return EXIT_FAILURE;
+	}
+
+	// the advice only tunes the readahead, so failing to give it isn't fatal
+	(void)madvise(mapping, size, MADV_SEQUENTIAL);
+	(void)madvise(mapping, size, MADV_WILLNEED);
+
+	column->values = mapping;
+	column->mapping = mapping;
+
+	return EXIT_SUCCESS;
+}
+
+void column_unmap(struct column *column) {
+	assert(column != NULL);
+
+	if (column->mapping != NULL) {
+		munmap(column->mapping, column->mapping_size);
+	}
+	column->mapping = NULL;
+	column->values = NULL;
+}
+
+/**
+ * @brief Checks whether a string only holds blanks until a field separator or its end.
+ */
+static bool column_is_blank(const char *string) {
+	assert(string != NULL);
+
+	while (*string == ' ' || *string == '\t' || *string == '\r' || *string == '\n') {
+		++string;
+	}
+	return *string == ',' || *string == '\0';
+}
+
+/**
+ * @brief Parses a field of a line of CSV data.
+ *
+ * Missing and empty fields are NaN, like missing data.
+ *
+ * @return Whether the field is missing, empty or a number.
+ */
+static bool column_parse_field(const char *line, size_t field, double *value) {
+	assert(line != NULL && value != NULL);
+
+	*value = NAN;
+	for (size_t i = 0; i < field; i++) {
+		line = strchr(line, ',');
+		if (line == NULL) {
+			return true;
+		}
+		++line;
+	}
+
+	if (column_is_blank(line)) {
+		return true;
+	}
+
+	char *end = NULL;
+	*value = strtod(line, &end);
+	return end != line && column_is_blank(end);
+}
+
+int column_from_csv(FILE *input, size_t field, bool has_header, const char *path) {
+	assert(input != NULL && path != NULL);
+
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		(void)fprintf(stderr, "Error: Failed to open \"%s\" for writing\n", path);
+		return EXIT_FAILURE;
+	}
+
+	bool is_written = true;
+	bool is_parsed = true;
+	char *line = NULL;
+	size_t line_size = 0;
+	size_t number = 0;
+	while (is_written && is_parsed && getline(&line, &line_size, input) != -1) {
+		// blank lines hold no row
+		++number;
+		if ((number == 1 && has_header) || (column_is_blank(line) && strchr(line, ',') == NULL)) {
+			continue;
+		}
+
+		double value = 0;
+		is_parsed = column_parse_field(line, field, &value);
+		if (is_parsed) {
+			is_written = fwrite(&value, sizeof(value), 1, file) == 1;
+		} else {
+			(void)fprintf(stderr, "Error: Field %zu of line %zu is not a number\n", field, number);
+		}
+	}
+	free(line);
+
+	is_written = !ferror(input) && fclose(file) == 0 && is_written;
+	if (!is_written) {
+		(void)fprintf(stderr, "Error: Failed to write to \"%s\"\n", path);
+		return EXIT_FAILURE;
+	}
+
+	return is_parsed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief The state of a summation over columns shared by the threads evaluating it.
+ */
+struct column_context {
+	const struct program *program;
+	size_t columns_count;
+	const struct column *columns;
+	size_t rows_count;
+	size_t leaves_count;
+	double *values; ///< Scratch values of the program, one row of `values_count` per thread.
+	size_t values_count;
+	double *results; ///< Sums of the summands over each leaf, one row per leaf.
+};
+
+/**
+ * @brief Advises the kernel that a part of a column is going to be read soon.
+ */
+static void column_prefetch(const struct column *column, size_t first_row, size_t rows_count) {
+	assert(column != NULL);
+
+	uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+	uintptr_t start = (uintptr_t)&column->values[first_row] / page_size * page_size;
+	uintptr_t end = (uintptr_t)&column->values[first_row + rows_count];
+	(void)madvise((void *)start, end - start, MADV_WILLNEED);
+}
+
+static void column_leaf(void *context_, size_t thread, size_t leaf) {
+	assert(context_ != NULL);
+
+	struct column_context *context = context_;
+	const struct program *program = context->program;
+
+	long lower_bound = 0;
+	long upper_bound = 0;
+	scheduler_partition(
+		0,
+		(long)context->rows_count - 1,
+		context->leaves_count,
+		leaf,
+		&lower_bound,
+		&upper_bound
+	);
+	size_t first_row = (size_t)lower_bound;
+	size_t length = (size_t)(upper_bound - lower_bound + 1);
+
+	// the thread may have stolen the leaf from the middle of another thread's share
+	for (size_t i = 0; i < context->columns_count; i++) {
+		column_prefetch(&context->columns[i], first_row, length);
+	}
+
+	// the index of the row comes after the columns, so that a column bound to i hides it
+	char variables[VARIABLES_COUNT + 1];
+	const double *columns[VARIABLES_COUNT + 1];
+	for (size_t i = 0; i < context->columns_count; i++) {
+		variables[i] = context->columns[i].variable;
+	}
+	variables[context->columns_count] = 'i';
+
+	double indices[PROGRAM_BLOCK_SIZE];
+	columns[context->columns_count] = indices;
+
+	double *values = &context->values[thread * context->values_count];
+	double *sums = &context->results[leaf * program->outputs_count];
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		sums[i] = 0;
+	}
+
+	struct environment environment = environment_new();
+	for (size_t offset = 0; offset < length; offset += PROGRAM_BLOCK_SIZE) {
+		size_t size = length - offset < PROGRAM_BLOCK_SIZE ? length - offset : PROGRAM_BLOCK_SIZE;
+		for (size_t i = 0; i < context->columns_count; i++) {
+			columns[i] = &context->columns[i].values[first_row + offset];
+		}
+		for (size_t i = 0; i < size; i++) {
+			indices[i] = (double)(first_row + offset + i);
+		}
+
+		program_evaluate_rows(
+			program,
+			&environment,
+			context->columns_count + 1,
+			variables,
+			columns,
+			size,
+			values
+		);
+		for (size_t i = 0; i < program->outputs_count; i++) {
+			const double *terms = &values[program->outputs[i] * size];
+			for (size_t j = 0; j < size; j++) {
+				sums[i] += terms[j];
+			}
+		}
+	}
+}
+
+int column_summation_fused(
+	size_t columns_count,
+	const struct column columns[],
+	size_t count,
+	const char *const summands[],
+	double sums[],
+	const struct summation_options *options
+) {
+	assert(columns_count <= VARIABLES_COUNT && (columns_count == 0 || columns != NULL));
+	assert((count == 0 || summands != NULL) && (count == 0 || sums != NULL));
+
+	struct summation_options default_options = summation_options_default();
+	if (options == NULL) {
+		options = &default_options;
+	}
+
+	size_t rows_count = columns_count == 0 ? 0 : columns[0].rows_count;
+	for (size_t i = 1; i < columns_count; i++) {
+		if (columns[i].rows_count != rows_count) {
+			(void)fprintf(stderr, "Error: The columns have different numbers of rows\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		sums[i] = 0;
+	}
+	if (rows_count == 0 || count == 0) {
+		return EXIT_SUCCESS;
+	}
+
+	struct environment environment = environment_new();
+	struct expression *expressions = malloc(count * sizeof(*expressions));
+	for (size_t i = 0; i < count; i++) {
+		assert(summands[i] != NULL);
+
+		expressions[i] = expression_from_string(summands[i]);
+		expression_simplify(&expressions[i], &environment);
+	}
+
+	struct program program = program_new(count, expressions);
+
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+	free(expressions);
+
+	size_t leaves_count = (rows_count + COLUMN_LEAF_SIZE_MINIMUM - 1) / COLUMN_LEAF_SIZE_MINIMUM;
+	if (leaves_count > COLUMN_LEAVES_MAXIMUM) {
+		leaves_count = COLUMN_LEAVES_MAXIMUM;
+	}
+
+	size_t threads_count = options->threads_count != 0 ? options->threads_count
+														: scheduler_default_threads_count();
+	if (threads_count > leaves_count) {
+		threads_count = leaves_count;
+	}
+
+	struct column_context context = {
+		.program = &program,
+		.columns_count = columns_count,
+		.columns = columns,
+		.rows_count = rows_count,
+		.leaves_count = leaves_count,
+		.values_count = program.instructions_count * PROGRAM_BLOCK_SIZE,
+	};
+	context.values = malloc(threads_count * context.values_count * sizeof(*context.values));
+	context.results = malloc(leaves_count * count * sizeof(*context.results));
+
+	scheduler_run(threads_count, leaves_count, column_leaf, &context, NULL);
+
+	for (size_t i = 0; i < count; i++) {
+		sums[i] = scheduler_sum(&context.results[i], leaves_count, count);
+	}
+
+	free(context.results);
+	free(context.values);
+	program_drop(&program);
+
+	return EXIT_SUCCESS;
+}
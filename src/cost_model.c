@@ -0,0 +1,277 @@
+#include <cost_model.h>
+
+#include <assert.h>
+#include <cache.h>
+#include <math.h>
+#include <pthread.h>
+#include <scheduler.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define COST_MODEL_MAGIC "SUMCOST1"
+#define COST_MODEL_REPETITIONS 32
+#define COST_MODEL_THREADS_REPETITIONS 8
+#define NANOSECONDS_PER_SECOND 1000000000.0
+
+/**
+ * @brief The header of a saved cost model.
+ */
+struct cost_model_header {
+	char magic[8];
+	uint64_t size;					///< Guards against loading a model saved by an incompatible build.
+	uint64_t operation_types_count; ///< Guards against models saved before operations were added.
+};
+
+static double seconds_now(void) {
+	struct timespec time;
+	(void)clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+ * @brief Times the evaluation of a program, per index.
+ *
+ * The program is evaluated over a block of indices `COST_MODEL_REPETITIONS` times, either a block
+ * at a time, using recurrences if `steps` isn't `NULL`, or an index at a time.
+ */
+static double cost_model_time(const struct program *program, bool is_blocked, const double steps[]) {
+	assert(program != NULL);
+
+	double indices[PROGRAM_BLOCK_SIZE];
+	for (size_t i = 0; i < PROGRAM_BLOCK_SIZE; i++) {
+		indices[i] = (double)(i + 1);
+	}
+
+	double *values = malloc(program->instructions_count * PROGRAM_BLOCK_SIZE * sizeof(*values));
+	double *results = malloc(program->outputs_count * sizeof(*results));
+
+	struct environment environment = environment_new();
+
+	// the sink keeps the evaluations from being optimized away
+	volatile double sink = 0;
+
+	double start = seconds_now();
+	for (size_t i = 0; i < COST_MODEL_REPETITIONS; i++) {
+		if (!is_blocked) {
+			for (size_t j = 0; j < PROGRAM_BLOCK_SIZE; j++) {
+				environment_set_variable(&environment, 'x', indices[j]);
+				program_evaluate(program, &environment, values, results);
+				sink = sink + results[0];
+			}
+		} else if (steps != NULL) {
+			program_evaluate_recurrence(
+				program,
+				&environment,
+				'x',
+				indices,
+				PROGRAM_BLOCK_SIZE,
+				steps,
+				values
+			);
+			sink = sink + values[program->outputs[0] * PROGRAM_BLOCK_SIZE];
+		} else {
+			program_evaluate_block(program, &environment, 'x', indices, PROGRAM_BLOCK_SIZE, values);
+			sink = sink + values[program->outputs[0] * PROGRAM_BLOCK_SIZE];
+		}
+	}
+	double seconds = seconds_now() - start;
+
+	free(results);
+	free(values);
+
+	return seconds / (COST_MODEL_REPETITIONS * PROGRAM_BLOCK_SIZE);
+}
+
+static void cost_model_idle(void *context, size_t thread, size_t leaf) {
+	(void)context;
+	(void)thread;
+	(void)leaf;
+}
+
+struct cost_model cost_model_calibrate(void) {
+	struct cost_model cost_model;
+
+	// x, and x scaled into a range every operation is defined and finite on
+	struct instruction instructions[] = {
+		{ .type = expression_type_variable, .variable = 'x' },
+		{ .type = expression_type_constant, .constant = 1.0 / PROGRAM_BLOCK_SIZE },
+		{
+			.type = expression_type_operation,
+			.operation = { .type = operation_type_multiplication, .operands = { 0, 1 } },
+		},
+		{ .type = expression_type_operation },
+	};
+	size_t output = 2;
+	struct program program = {
+		.instructions = instructions,
+		.instructions_count = 3,
+		.outputs = &output,
+		.outputs_count = 1,
+	};
+
+	double base_seconds = cost_model_time(&program, true, NULL);
+	cost_model.load_seconds = fmax(base_seconds / 3, 0);
+
+	program.instructions_count = 4;
+	output = 3;
+
+	double scalar_seconds = 0;
+	double block_seconds = 0;
+	for (size_t i = 0; i < OPERATION_TYPES_COUNT; i++) {
+		instructions[3].operation.type = (enum operation_type)i;
+		instructions[3].operation.operands[0] = 2;
+		instructions[3].operation.operands[1] = 2;
+		instructions[3].operation.operands[2] = 2;
+
+		double seconds = cost_model_time(&program, true, NULL);
+		cost_model.operation_seconds[i] = fmax(seconds - base_seconds, 0);
+
+		if (instructions[3].operation.type == operation_type_addition) {
+			block_seconds = seconds;
+			scalar_seconds = cost_model_time(&program, false, NULL);
+		}
+	}
+	cost_model.dispatch_seconds = fmax((scalar_seconds - block_seconds) / 4, 0);
+
+	// a recurrence over exp(x)
+	instructions[3].operation.type = operation_type_exponential;
+	instructions[3].operation.operands[0] = 0;
+	double steps[sizeof(instructions) / sizeof(instructions[0])];
+	program_steps(&program, NULL, 'x', steps);
+	cost_model.recurrence_seconds =
+		fmax(cost_model_time(&program, true, steps) - base_seconds, 0);
+
+	double start = seconds_now();
+	for (size_t i = 0; i < COST_MODEL_THREADS_REPETITIONS; i++) {
+		scheduler_run(2, 2, cost_model_idle, NULL, NULL);
+	}
+	cost_model.thread_seconds = (seconds_now() - start) / COST_MODEL_THREADS_REPETITIONS;
+
+	return cost_model;
+}
+
+const struct cost_model *cost_model_get(const char *cache_directory) {
+	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	static struct cost_model cost_model;
+	static bool is_known = false;
+
+	pthread_mutex_lock(&mutex);
+
+	if (!is_known) {
+		char *path = NULL;
+		if (cache_directory != NULL) {
+			path = cache_path(
+				cache_directory,
+				cache_hash(CACHE_HASH_INITIAL, COST_MODEL_MAGIC, sizeof(COST_MODEL_MAGIC)),
+				"profile"
+			);
+		}
+
+		if (path == NULL || cost_model_load(&cost_model, path) == EXIT_FAILURE) {
+			cost_model = cost_model_calibrate();
+			if (path != NULL) {
+				// the profile is only an optimization, so failing to save it isn't fatal
+				(void)cost_model_save(&cost_model, path);
+			}
+		}
+
+		free(path);
+		is_known = true;
+	}
+
+	pthread_mutex_unlock(&mutex);
+
+	return &cost_model;
+}
+
+int cost_model_save(const struct cost_model *cost_model, const char *path) {
+	assert(cost_model != NULL && path != NULL);
+
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		(void)fprintf(stderr, "Error: Failed to open \"%s\" for writing\n", path);
+		return EXIT_FAILURE;
+	}
+
+	struct cost_model_header header = {
+		.size = sizeof(*cost_model),
+		.operation_types_count = OPERATION_TYPES_COUNT,
+	};
+	memcpy(header.magic, COST_MODEL_MAGIC, sizeof(header.magic));
+
+	bool is_written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+					  fwrite(cost_model, sizeof(*cost_model), 1, file) == 1;
+	if (fclose(file) != 0 || !is_written) {
+		(void)fprintf(stderr, "Error: Failed to write to \"%s\"\n", path);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int cost_model_load(struct cost_model *cost_model, const char *path) {
+	assert(cost_model != NULL && path != NULL);
+
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	struct cost_model_header header;
+	struct cost_model loaded;
+	bool is_read = fread(&header, sizeof(header), 1, file) == 1 &&
+				   fread(&loaded, sizeof(loaded), 1, file) == 1 && fgetc(file) == EOF;
+	(void)fclose(file);
+
+	if (!is_read || memcmp(header.magic, COST_MODEL_MAGIC, sizeof(header.magic)) != 0 ||
+		header.size != sizeof(loaded) || header.operation_types_count != OPERATION_TYPES_COUNT) {
+		(void)fprintf(stderr, "Error: \"%s\" is not a cost model\n", path);
+		return EXIT_FAILURE;
+	}
+
+	*cost_model = loaded;
+
+	return EXIT_SUCCESS;
+}
+
+double cost_model_estimate(
+	const struct cost_model *cost_model,
+	const struct program *program,
+	bool is_blocked,
+	const double steps[]
+) {
+	assert(cost_model != NULL && program != NULL);
+
+	double seconds = 0;
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		const struct instruction *instruction = &program->instructions[i];
+
+		if (instruction->type != expression_type_operation) {
+			seconds += cost_model->load_seconds;
+		} else if (is_blocked && steps != NULL && program_is_recurrence(program, steps, i)) {
+			seconds += cost_model->recurrence_seconds;
+
+			// logarithmic recurrences take a logarithm at every step
+			switch (instruction->operation.type) {
+				case operation_type_log_gamma:
+				case operation_type_log_factorial:
+				case operation_type_log_binomial:
+					seconds += cost_model->operation_seconds[operation_type_logarithm];
+					break;
+				default: break;
+			}
+		} else {
+			seconds += cost_model->operation_seconds[instruction->operation.type];
+		}
+
+		if (!is_blocked) {
+			seconds += cost_model->dispatch_seconds;
+		}
+	}
+
+	return seconds;
+}
@@ -0,0 +1,655 @@
+#include <distributed.h>
+
+#include <arpa/inet.h>
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <scheduler.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define COORDINATOR_BACKLOG 64
+
+/**
+ * @brief The most milliseconds a coordinator waits for workers before checking its timeout.
+ */
+#define COORDINATOR_POLL_TIMEOUT 1000
+#define MILLISECONDS_PER_SECOND 1000
+#define NANOSECONDS_PER_MILLISECOND 1000000
+
+static bool socket_send(int socket, const char *data, size_t length) {
+	assert(data != NULL);
+
+	while (length > 0) {
+		// a worker that died must not kill the coordinator with SIGPIPE
+		ssize_t sent = send(socket, data, length, MSG_NOSIGNAL);
+		if (sent < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += sent;
+		length -= (size_t)sent;
+	}
+
+	return true;
+}
+
+// NOLINTNEXTLINE(cert-dcl50-cpp)
+static bool socket_printf(int socket, const char *format, ...) {
+	assert(format != NULL);
+
+	va_list arguments;
+	va_start(arguments, format);
+	int length = vsnprintf(NULL, 0, format, arguments);
+	va_end(arguments);
+	if (length < 0) {
+		return false;
+	}
+
+	char *message = malloc((size_t)length + 1);
+	if (message == NULL) {
+		return false;
+	}
+
+	va_start(arguments, format);
+	(void)vsnprintf(message, (size_t)length + 1, format, arguments);
+	va_end(arguments);
+
+	bool is_sent = socket_send(socket, message, (size_t)length);
+
+	free(message);
+
+	return is_sent;
+}
+
+int coordinator_open(struct coordinator *coordinator, const char *host, uint16_t port) {
+	assert(coordinator != NULL);
+
+	// the protocol is unauthenticated, so other machines are only let in when asked to
+	struct sockaddr_in address = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port),
+		.sin_addr = { .s_addr = htonl(INADDR_LOOPBACK) },
+	};
+	if (host != NULL && inet_pton(AF_INET, host, &address.sin_addr) != 1) {
+		(void)fprintf(stderr, "Error: Invalid address \"%s\"\n", host);
+		return EXIT_FAILURE;
+	}
+
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener < 0) {
+		(void)fprintf(stderr, "Error: Failed to create a socket\n");
+		return EXIT_FAILURE;
+	}
+
+	int enable = 1;
+	(void)setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+	socklen_t address_length = sizeof(address);
+	if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+		listen(listener, COORDINATOR_BACKLOG) != 0 ||
+		getsockname(listener, (struct sockaddr *)&address, &address_length) != 0) {
+		(void)fprintf(stderr, "Error: Failed to listen on port %" PRIu16 "\n", port);
+		(void)close(listener);
+		return EXIT_FAILURE;
+	}
+
+	*coordinator = (struct coordinator){
+		.socket = listener,
+		.port = ntohs(address.sin_port),
+		.timeout = COORDINATOR_TIMEOUT,
+		.shard_timeout = COORDINATOR_SHARD_TIMEOUT,
+	};
+
+	return EXIT_SUCCESS;
+}
+
+void coordinator_close(struct coordinator *coordinator) {
+	assert(coordinator != NULL);
+
+	(void)close(coordinator->socket);
+	coordinator->socket = -1;
+}
+
+static long milliseconds_now(void) {
+	struct timespec time;
+	(void)clock_gettime(CLOCK_MONOTONIC, &time);
+	return (long)time.tv_sec * MILLISECONDS_PER_SECOND + time.tv_nsec / NANOSECONDS_PER_MILLISECOND;
+}
+
+/**
+ * @brief A worker connected to a coordinator.
+ */
+struct connection {
+	int socket;
+	size_t shard; ///< The shard the worker is evaluating, or `SIZE_MAX` if it's idle.
+	long deadline; ///< The milliseconds by which the worker must return the result of its shard.
+	char *buffer; ///< The received data that doesn't form a full line yet.
+	size_t length;
+	size_t capacity;
+};
+
+/**
+ * @brief The state of a distributed summation.
+ */
+struct shards {
+	long lower_bound;
+	long upper_bound;
+	size_t count;
+	size_t *pending; ///< Stack of the shards that aren't handed to any worker.
+	size_t pending_count;
+	bool *is_done;
+	size_t remaining; ///< The number of shards without a result.
+	double *results;  ///< The sums of each shard, one row per shard.
+	int timeout;	  ///< The milliseconds a worker has to return the result of a shard.
+};
+
+static bool connection_assign(struct connection *connection, struct shards *shards) {
+	assert(connection != NULL && shards != NULL);
+
+	if (connection->shard != SIZE_MAX || shards->pending_count == 0) {
+		return true;
+	}
+
+	size_t shard = shards->pending[--shards->pending_count];
+
+	long lower = 0;
+	long upper = 0;
+	scheduler_partition(
+		shards->lower_bound,
+		shards->upper_bound,
+		shards->count,
+		shard,
+		&lower,
+		&upper
+	);
+
+	connection->shard = shard;
+	connection->deadline = milliseconds_now() + shards->timeout;
+
+	return socket_printf(connection->socket, "SHARD %zu %ld %ld\n", shard, lower, upper);
+}
+
+static void connection_drop(struct connection *connection, struct shards *shards) {
+	assert(connection != NULL && shards != NULL);
+
+	// the shard of a worker that's gone is handed to another one
+	if (connection->shard != SIZE_MAX && !shards->is_done[connection->shard]) {
+		shards->pending[shards->pending_count++] = connection->shard;
+	}
+
+	(void)close(connection->socket);
+	free(connection->buffer);
+}
+
+/**
+ * @brief Handles a line received from a worker.
+ *
+ * @return `false` if the worker misbehaved and should be dropped.
+ */
+static bool connection_handle(
+	struct connection *connection,
+	struct shards *shards,
+	size_t count,
+	const char *line
+) {
+	assert(connection != NULL && shards != NULL && line != NULL);
+
+	if (strncmp(line, "RESULT ", strlen("RESULT ")) != 0) {
+		return false;
+	}
+	line += strlen("RESULT ");
+
+	char *end = NULL;
+	errno = 0;
+	unsigned long long shard = strtoull(line, &end, 10);
+	if (end == line || errno == ERANGE || shard != connection->shard) {
+		return false;
+	}
+
+	double *results = &shards->results[shard * count];
+	for (size_t i = 0; i < count; i++) {
+		line = end;
+		results[i] = strtod(line, &end);
+		if (end == line) {
+			return false;
+		}
+	}
+
+	if (!shards->is_done[shard]) {
+		shards->is_done[shard] = true;
+		--shards->remaining;
+	}
+	connection->shard = SIZE_MAX;
+
+	return connection_assign(connection, shards);
+}
+
+/**
+ * @brief Receives data from a worker.
+ *
+ * @return `false` if the worker disconnected or misbehaved and should be dropped.
+ */
+static bool connection_receive(struct connection *connection, struct shards *shards, size_t count) {
+	assert(connection != NULL && shards != NULL);
+
+	if (connection->capacity - connection->length < BUFSIZ) {
+		connection->capacity = 2 * connection->capacity + BUFSIZ;
+		connection->buffer = realloc(connection->buffer, connection->capacity);
+	}
+
+	ssize_t received = recv(
+		connection->socket,
+		connection->buffer + connection->length,
+		connection->capacity - connection->length - 1,
+		0
+	);
+	if (received <= 0) {
+		return received < 0 && errno == EINTR;
+	}
+	connection->length += (size_t)received;
+	connection->buffer[connection->length] = '\0';
+
+	char *line = connection->buffer;
+	for (char *newline = strchr(line, '\n'); newline != NULL; newline = strchr(line, '\n')) {
+		*newline = '\0';
+		if (!connection_handle(connection, shards, count, line)) {
+			return false;
+		}
+		line = newline + 1;
+	}
+
+	connection->length -= (size_t)(line - connection->buffer);
+	memmove(connection->buffer, line, connection->length);
+
+	return true;
+}
+
+/**
+ * @brief Evaluates the shards that aren't handed to any worker locally.
+ */
+static void shards_evaluate(
+	struct shards *shards,
+	size_t count,
+	const char *const summands[],
+	const struct summation_options *options
+) {
+	assert(shards != NULL && summands != NULL);
+
+	while (shards->pending_count > 0) {
+		size_t shard = shards->pending[--shards->pending_count];
+		if (shards->is_done[shard]) {
+			continue;
+		}
+
+		long lower = 0;
+		long upper = 0;
+		scheduler_partition(
+			shards->lower_bound,
+			shards->upper_bound,
+			shards->count,
+			shard,
+			&lower,
+			&upper
+		);
+		summation_fused(lower, upper, count, summands, &shards->results[shard * count], options);
+
+		shards->is_done[shard] = true;
+		--shards->remaining;
+	}
+}
+
+static bool connection_greet(
+	const struct connection *connection,
+	size_t count,
+	const char *const summands[]
+) {
+	assert(connection != NULL && summands != NULL);
+
+	if (!socket_printf(connection->socket, "SUMMANDS %zu\n", count)) {
+		return false;
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (!socket_printf(connection->socket, "%s\n", summands[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+int coordinator_run(
+	const struct coordinator *coordinator,
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	size_t shards_count,
+	double sums[],
+	const struct summation_options *options
+) {
+	assert(coordinator != NULL && (count == 0 || (summands != NULL && sums != NULL)));
+
+	for (size_t i = 0; i < count; i++) {
+		if (strchr(summands[i], '\n') != NULL) {
+			(void)fprintf(stderr, "Error: Summands of distributed summations can't span lines\n");
+			return EXIT_FAILURE;
+		}
+		sums[i] = 0;
+	}
+
+	if (lower_bound > upper_bound || count == 0) {
+		return EXIT_SUCCESS;
+	}
+
+	unsigned long range = (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+	if (shards_count == 0) {
+		shards_count = 1;
+	}
+	if (shards_count > range) {
+		shards_count = range;
+	}
+
+	struct shards shards = {
+		.lower_bound = lower_bound,
+		.upper_bound = upper_bound,
+		.count = shards_count,
+		.pending = malloc(shards_count * sizeof(*shards.pending)),
+		.pending_count = shards_count,
+		.is_done = calloc(shards_count, sizeof(*shards.is_done)),
+		.remaining = shards_count,
+		.results = malloc(shards_count * count * sizeof(*shards.results)),
+		.timeout = coordinator->shard_timeout,
+	};
+	// the stack is popped from the end, so the first shards are handed out first
+	for (size_t i = 0; i < shards_count; i++) {
+		shards.pending[i] = shards_count - 1 - i;
+	}
+
+	struct connection *connections = NULL;
+	size_t connections_count = 0;
+	struct pollfd *descriptors = NULL;
+
+	int status = EXIT_SUCCESS;
+	long idle_since = milliseconds_now();
+	while (shards.remaining > 0) {
+		// without workers, the summations would never end
+		long now = milliseconds_now();
+		if (connections_count != 0) {
+			idle_since = now;
+		} else if (now - idle_since >= coordinator->timeout) {
+			(void)fprintf(stderr, "Warning: No workers, evaluating the remaining shards locally\n");
+			shards_evaluate(&shards, count, summands, options);
+			break;
+		}
+		long timeout = connections_count != 0 ? COORDINATOR_POLL_TIMEOUT
+											  : coordinator->timeout - (now - idle_since);
+
+		descriptors = realloc(descriptors, (connections_count + 1) * sizeof(*descriptors));
+		descriptors[0] = (struct pollfd){ .fd = coordinator->socket, .events = POLLIN };
+		for (size_t i = 0; i < connections_count; i++) {
+			descriptors[i + 1] = (struct pollfd){ .fd = connections[i].socket, .events = POLLIN };
+		}
+
+		int polled = poll(
+			descriptors,
+			connections_count + 1,
+			(int)(timeout < COORDINATOR_POLL_TIMEOUT ? timeout : COORDINATOR_POLL_TIMEOUT)
+		);
+		if (polled < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			(void)fprintf(stderr, "Error: Failed to wait for workers\n");
+			status = EXIT_FAILURE;
+			break;
+		}
+
+		// connections are only dropped after the loop, as descriptors refer to them by position,
+		// and so are stalled workers, whose shards are handed to others or evaluated locally
+		size_t polled_count = connections_count;
+		now = milliseconds_now();
+		for (size_t i = 0, j = 0; i < polled_count; i++) {
+			bool is_alive = true;
+			if (descriptors[i + 1].revents != 0) {
+				is_alive = connection_receive(&connections[i], &shards, count);
+			}
+			if (is_alive && connections[i].shard != SIZE_MAX && now >= connections[i].deadline) {
+				(void)fprintf(
+					stderr,
+					"Warning: A worker timed out on shard %zu, handing it out again\n",
+					connections[i].shard
+				);
+				is_alive = false;
+			}
+
+			if (is_alive) {
+				connections[j++] = connections[i];
+			} else {
+				connection_drop(&connections[i], &shards);
+				--connections_count;
+			}
+		}
+
+		if (descriptors[0].revents & POLLIN) {
+			int worker = accept(coordinator->socket, NULL, NULL);
+			if (worker >= 0) {
+				int enable = 1;
+				(void)setsockopt(worker, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+
+				connections =
+					realloc(connections, (connections_count + 1) * sizeof(*connections));
+				connections[connections_count] = (struct connection){
+					.socket = worker,
+					.shard = SIZE_MAX,
+					.deadline = 0,
+					.buffer = NULL,
+					.length = 0,
+					.capacity = 0,
+				};
+				if (connection_greet(&connections[connections_count], count, summands)) {
+					++connections_count;
+				} else {
+					connection_drop(&connections[connections_count], &shards);
+				}
+			}
+		}
+
+		// hand out the shards of dropped workers, and any shards for new ones
+		for (size_t i = 0, j = 0; i < connections_count; i++) {
+			if (connection_assign(&connections[i], &shards)) {
+				connections[j++] = connections[i];
+			} else {
+				connection_drop(&connections[i], &shards);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < connections_count; i++) {
+		(void)socket_printf(connections[i].socket, "DONE\n");
+		connection_drop(&connections[i], &shards);
+	}
+	free(connections);
+	free(descriptors);
+
+	if (status == EXIT_SUCCESS) {
+		for (size_t i = 0; i < count; i++) {
+			sums[i] = scheduler_sum(&shards.results[i], shards.count, count);
+		}
+	}
+
+	free(shards.results);
+	free(shards.is_done);
+	free(shards.pending);
+
+	return status;
+}
+
+static int worker_connect(const char *host, uint16_t port) {
+	assert(host != NULL);
+
+	char service[sizeof("65535")];
+	(void)snprintf(service, sizeof(service), "%" PRIu16, port);
+
+	struct addrinfo hints = {
+		.ai_family = AF_UNSPEC,
+		.ai_socktype = SOCK_STREAM,
+	};
+	struct addrinfo *addresses = NULL;
+	if (getaddrinfo(host, service, &hints, &addresses) != 0) {
+		(void)fprintf(stderr, "Error: Failed to resolve \"%s\"\n", host);
+		return -1;
+	}
+
+	int worker = -1;
+	for (struct addrinfo *address = addresses; address != NULL; address = address->ai_next) {
+		worker = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (worker < 0) {
+			continue;
+		}
+		if (connect(worker, address->ai_addr, address->ai_addrlen) == 0) {
+			break;
+		}
+		(void)close(worker);
+		worker = -1;
+	}
+
+	freeaddrinfo(addresses);
+
+	if (worker < 0) {
+		(void)fprintf(stderr, "Error: Failed to connect to %s:%" PRIu16 "\n", host, port);
+	}
+
+	return worker;
+}
+
+/**
+ * @brief Receives the summands from the coordinator.
+ *
+ * @return The array of the `*count` summands, or `NULL` on error.
+ */
+static char **worker_receive_summands(FILE *input, size_t *count) {
+	assert(input != NULL && count != NULL);
+
+	char *line = NULL;
+	size_t capacity = 0;
+	bool is_valid = getline(&line, &capacity, input) >= 0 && sscanf(line, "SUMMANDS %zu", count) == 1;
+	free(line);
+	if (!is_valid) {
+		(void)fprintf(stderr, "Error: Unexpected message from the coordinator\n");
+		return NULL;
+	}
+
+	char **summands = calloc(*count, sizeof(*summands));
+	for (size_t i = 0; i < *count; i++) {
+		capacity = 0;
+		if (getline(&summands[i], &capacity, input) < 0) {
+			(void)fprintf(stderr, "Error: Unexpected end of the summands\n");
+			for (size_t j = 0; j <= i; j++) {
+				free(summands[j]);
+			}
+			free(summands);
+			return NULL;
+		}
+		summands[i][strcspn(summands[i], "\n")] = '\0';
+	}
+
+	return summands;
+}
+
+/**
+ * @brief Evaluates the shards handed out by the coordinator until it's done.
+ */
+static int worker_serve(
+	int worker,
+	FILE *input,
+	size_t count,
+	const char *const summands[],
+	const struct summation_options *options
+) {
+	assert(input != NULL && summands != NULL);
+
+	double *sums = malloc(count * sizeof(*sums));
+	size_t result_capacity = sizeof("RESULT \n") + 3 * sizeof(size_t) + count * 32;
+	char *result = malloc(result_capacity);
+
+	int status = EXIT_SUCCESS;
+
+	char *line = NULL;
+	size_t line_capacity = 0;
+	while (getline(&line, &line_capacity, input) >= 0 && strcmp(line, "DONE\n") != 0) {
+		size_t shard = 0;
+		long lower_bound = 0;
+		long upper_bound = 0;
+		if (sscanf(line, "SHARD %zu %ld %ld", &shard, &lower_bound, &upper_bound) != 3) {
+			(void)fprintf(stderr, "Error: Unexpected message from the coordinator\n");
+			status = EXIT_FAILURE;
+			break;
+		}
+
+		summation_fused(lower_bound, upper_bound, count, summands, sums, options);
+
+		size_t length = (size_t)snprintf(result, result_capacity, "RESULT %zu", shard);
+		for (size_t i = 0; i < count; i++) {
+			length += (size_t)snprintf(result + length, result_capacity - length, " %a", sums[i]);
+		}
+		length += (size_t)snprintf(result + length, result_capacity - length, "\n");
+
+		if (!socket_send(worker, result, length)) {
+			(void)fprintf(stderr, "Error: Lost the connection to the coordinator\n");
+			status = EXIT_FAILURE;
+			break;
+		}
+	}
+
+	free(line);
+	free(result);
+	free(sums);
+
+	return status;
+}
+
+int worker_run(const char *host, uint16_t port, const struct summation_options *options) {
+	assert(host != NULL);
+
+	int worker = worker_connect(host, port);
+	if (worker < 0) {
+		return EXIT_FAILURE;
+	}
+
+	FILE *input = fdopen(dup(worker), "r");
+	if (input == NULL) {
+		(void)close(worker);
+		return EXIT_FAILURE;
+	}
+
+	int status = EXIT_FAILURE;
+
+	size_t count = 0;
+	char **summands = worker_receive_summands(input, &count);
+	if (summands != NULL) {
+		status = worker_serve(worker, input, count, (const char *const *)summands, options);
+
+		for (size_t i = 0; i < count; i++) {
+			free(summands[i]);
+		}
+		free(summands);
+	}
+
+	(void)fclose(input);
+	(void)close(worker);
+
+	return status;
+}
@@ -0,0 +1,376 @@
+#include <estimate.h>
+
+#include <assert.h>
+#include <environment.h>
+#include <expression.h>
+#include <math.h>
+#include <program.h>
+#include <stdlib.h>
+#include <summation.h>
+#include <time.h>
+
+#define NANOSECONDS_PER_SECOND 1000000000.0
+
+/**
+ * @brief The statistics of the samples of a summand in a stratum.
+ */
+struct estimate_statistics {
+	unsigned long count; ///< Number of samples.
+	double mean;		 ///< Mean of the samples.
+	double deviations;	 ///< Sum of the squared deviations of the samples from their mean.
+};
+
+/**
+ * @brief The state of estimates, shared by the rounds of sampling.
+ */
+struct estimate_context {
+	const struct program *program;
+	size_t count;			   ///< Number of summands.
+	long lower_bound;		   ///< The lower bound of the strata.
+	/// Offsets of the strata from `lower_bound`, and of the end of the last one.
+	unsigned long offsets[ESTIMATE_STRATA_COUNT + 1];
+	unsigned long allocations[ESTIMATE_STRATA_COUNT]; ///< Samples of each stratum in the round.
+	double *values; ///< Scratch values of the program over a block.
+	double indices[PROGRAM_BLOCK_SIZE];
+	size_t strata[PROGRAM_BLOCK_SIZE]; ///< Stratum of each index of the block, if sampled.
+	size_t size;					   ///< Number of indices in the block.
+	/// Statistics of the summands in each stratum, one row per stratum.
+	struct estimate_statistics *statistics;
+	double *boundary_sums; ///< Totals of the summands over the indices evaluated exactly.
+	uint64_t state;		   ///< State of the pseudo-random generator.
+};
+
+static double seconds_now(void) {
+	struct timespec time;
+	(void)clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+ * @brief Draws a pseudo-random number, with the SplitMix64 generator.
+ */
+static uint64_t estimate_random(uint64_t *state) {
+	assert(state != NULL);
+
+	uint64_t z = (*state += UINT64_C(0x9e3779b97f4a7c15));
+	z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+	return z ^ (z >> 31);
+}
+
+/**
+ * @brief Evaluates the summands over the block of indices, and accounts for their terms.
+ */
+static void estimate_flush(struct estimate_context *context) {
+	assert(context != NULL);
+
+	if (context->size == 0) {
+		return;
+	}
+
+	struct environment environment = environment_new();
+	program_evaluate_block(
+		context->program,
+		&environment,
+		'i',
+		context->indices,
+		context->size,
+		context->values
+	);
+
+	for (size_t i = 0; i < context->count; i++) {
+		const double *terms = &context->values[context->program->outputs[i] * context->size];
+
+		for (size_t j = 0; j < context->size; j++) {
+			if (context->strata[j] == SIZE_MAX) {
+				context->boundary_sums[i] += terms[j];
+				continue;
+			}
+
+			// Welford's update, which doesn't cancel out like sums of squares
+			struct estimate_statistics *statistics =
+				&context->statistics[context->strata[j] * context->count + i];
+			++statistics->count;
+			double deviation = terms[j] - statistics->mean;
+			statistics->mean += deviation / (double)statistics->count;
+			statistics->deviations += deviation * (terms[j] - statistics->mean);
+		}
+	}
+
+	context->size = 0;
+}
+
+/**
+ * @brief Adds an index to the block, in the stratum `stratum` or `SIZE_MAX` if evaluated exactly.
+ */
+static void estimate_push(struct estimate_context *context, long index, size_t stratum) {
+	assert(context != NULL);
+
+	context->indices[context->size] = (double)index;
+	context->strata[context->size] = stratum;
+	if (++context->size == PROGRAM_BLOCK_SIZE) {
+		estimate_flush(context);
+	}
+}
+
+static unsigned long estimate_stratum_size(const struct estimate_context *context, size_t stratum) {
+	assert(context != NULL && stratum < ESTIMATE_STRATA_COUNT);
+
+	return context->offsets[stratum + 1] - context->offsets[stratum];
+}
+
+/**
+ * @brief Gets the offset of the `k`-th of `count` strata growing geometrically over `size` indices.
+ *
+ * The strata are of equal sizes in the logarithm of the distance from the end of the range they
+ * start at, plus `ESTIMATE_BOUNDARY_SIZE`, so that each is about as long as its distance from
+ * that end, and summands concentrated near the ends vary little within each stratum. The sizes
+ * grow with `k`, and the first is at least one index long over ranges of at least `count` indices.
+ */
+static unsigned long estimate_offset(unsigned long size, size_t k, size_t count) {
+	assert(k <= count && size >= count);
+
+	if (k == count) {
+		return size;
+	}
+
+	double scale = log1p((double)size / ESTIMATE_BOUNDARY_SIZE) * (double)k / (double)count;
+	return (unsigned long)(ESTIMATE_BOUNDARY_SIZE * expm1(scale));
+}
+
+/**
+ * @brief Splits the interior of the range in strata, from both ends towards its middle.
+ */
+static void estimate_strata(struct estimate_context *context, unsigned long interior) {
+	assert(context != NULL && interior >= ESTIMATE_STRATA_COUNT);
+
+	size_t half_count = ESTIMATE_STRATA_COUNT / 2;
+	unsigned long lower_size = interior / 2;
+	unsigned long upper_size = interior - lower_size;
+	for (size_t i = 0; i <= half_count; i++) {
+		context->offsets[i] = estimate_offset(lower_size, i, half_count);
+		context->offsets[ESTIMATE_STRATA_COUNT - i] =
+			interior - estimate_offset(upper_size, i, half_count);
+	}
+}
+
+/**
+ * @brief Allocates `count` samples to the strata, for the next round of sampling.
+ *
+ * Each stratum gets a share of the samples proportional to its size and the standard deviation
+ * of its samples (Neyman allocation), averaged over the summands, and at least one sample.
+ */
+static void estimate_allocate(struct estimate_context *context, unsigned long count) {
+	assert(context != NULL);
+
+	double shares[ESTIMATE_STRATA_COUNT] = { 0 };
+	double shares_total = 0;
+	for (size_t i = 0; i < context->count; i++) {
+		double deviations[ESTIMATE_STRATA_COUNT];
+		double total = 0;
+		for (size_t j = 0; j < ESTIMATE_STRATA_COUNT; j++) {
+			const struct estimate_statistics *statistics =
+				&context->statistics[j * context->count + i];
+			double variance = statistics->deviations / (double)(statistics->count - 1);
+			deviations[j] = (double)estimate_stratum_size(context, j) * sqrt(variance);
+			total += deviations[j];
+		}
+
+		// summands which are constant or undefined over all the strata don't need more samples
+		if (!isfinite(total) || total <= 0) {
+			continue;
+		}
+
+		for (size_t j = 0; j < ESTIMATE_STRATA_COUNT; j++) {
+			shares[j] += deviations[j] / total;
+		}
+		shares_total += 1;
+	}
+
+	for (size_t i = 0; i < ESTIMATE_STRATA_COUNT; i++) {
+		double share = shares_total > 0 ? shares[i] / shares_total : 1.0 / ESTIMATE_STRATA_COUNT;
+		context->allocations[i] = 1 + (unsigned long)(share * (double)count);
+	}
+}
+
+/**
+ * @brief Computes the estimates from the samples so far.
+ *
+ * @return Whether all the estimates are within the error budget.
+ */
+static bool estimate_update(
+	const struct estimate_context *context,
+	const struct estimate_options *options,
+	unsigned long terms_count,
+	struct estimate estimates[]
+) {
+	assert(context != NULL && options != NULL && estimates != NULL);
+
+	bool is_within_budget = options->relative_error > 0;
+	for (size_t i = 0; i < context->count; i++) {
+		double sum = context->boundary_sums[i];
+		double variance = 0;
+		for (size_t j = 0; j < ESTIMATE_STRATA_COUNT; j++) {
+			const struct estimate_statistics *statistics =
+				&context->statistics[j * context->count + i];
+			double size = (double)estimate_stratum_size(context, j);
+			double count = (double)statistics->count;
+
+			sum += size * statistics->mean;
+			variance += size * size * statistics->deviations / (count - 1) / count;
+		}
+
+		estimates[i] = (struct estimate){
+			.sum = sum,
+			.error = ESTIMATE_STANDARD_ERRORS * sqrt(variance),
+			.terms_count = terms_count,
+			.is_exact = false,
+		};
+
+		is_within_budget =
+			is_within_budget && estimates[i].error <= options->relative_error * fabs(sum);
+	}
+
+	return is_within_budget;
+}
+
+/**
+ * @brief Evaluates the summations exactly.
+ */
+static void estimate_exactly(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	struct estimate estimates[]
+) {
+	double *sums = malloc(count * sizeof(*sums));
+	summation_fused(lower_bound, upper_bound, count, summands, sums, NULL);
+
+	unsigned long range =
+		lower_bound > upper_bound ? 0 : (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+	for (size_t i = 0; i < count; i++) {
+		estimates[i] = (struct estimate){
+			.sum = sums[i],
+			.error = 0,
+			.terms_count = range,
+			.is_exact = true,
+		};
+	}
+
+	free(sums);
+}
+
+void estimate_fused(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	struct estimate estimates[],
+	const struct estimate_options *options
+) {
+	assert((count == 0 || summands != NULL) && (count == 0 || estimates != NULL));
+
+	struct estimate_options default_options = estimate_options_default();
+	if (options == NULL) {
+		options = &default_options;
+	}
+
+	double start_seconds = seconds_now();
+
+	// sampling is only worth it over ranges much larger than the first samples
+	unsigned long range =
+		lower_bound > upper_bound ? 0 : (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+	unsigned long interior = range > 2 * ESTIMATE_BOUNDARY_SIZE ? range - 2 * ESTIMATE_BOUNDARY_SIZE
+																: 0;
+	if (count == 0 || interior / ESTIMATE_STRATA_COUNT < 4 * ESTIMATE_SAMPLES_INITIAL) {
+		estimate_exactly(lower_bound, upper_bound, count, summands, estimates);
+		return;
+	}
+
+	struct environment environment = environment_new();
+	struct expression *expressions = malloc(count * sizeof(*expressions));
+	for (size_t i = 0; i < count; i++) {
+		assert(summands[i] != NULL);
+
+		expressions[i] = expression_from_string(summands[i]);
+		expression_simplify(&expressions[i], &environment);
+	}
+
+	struct program program = program_new(count, expressions);
+
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+	free(expressions);
+
+	struct estimate_context context = {
+		.program = &program,
+		.count = count,
+		.lower_bound = lower_bound + ESTIMATE_BOUNDARY_SIZE,
+		.values = malloc(program.instructions_count * PROGRAM_BLOCK_SIZE * sizeof(*context.values)),
+		.size = 0,
+		.statistics = calloc(ESTIMATE_STRATA_COUNT * count, sizeof(*context.statistics)),
+		.boundary_sums = calloc(count, sizeof(*context.boundary_sums)),
+		.state = options->seed,
+	};
+
+	estimate_strata(&context, interior);
+
+	for (long i = 0; i < ESTIMATE_BOUNDARY_SIZE; i++) {
+		estimate_push(&context, lower_bound + i, SIZE_MAX);
+	}
+	for (long i = ESTIMATE_BOUNDARY_SIZE; i > 0; i--) {
+		estimate_push(&context, upper_bound - i + 1, SIZE_MAX);
+	}
+
+	// the first round samples all the strata alike, and each next one doubles the samples
+	for (size_t i = 0; i < ESTIMATE_STRATA_COUNT; i++) {
+		context.allocations[i] = ESTIMATE_SAMPLES_INITIAL;
+	}
+
+	unsigned long samples_count = 0;
+	bool is_exact = false;
+	while (true) {
+		double round_seconds = seconds_now();
+
+		for (size_t i = 0; i < ESTIMATE_STRATA_COUNT; i++) {
+			unsigned long size = estimate_stratum_size(&context, i);
+			for (unsigned long j = 0; j < context.allocations[i]; j++) {
+				unsigned long index = context.offsets[i] + estimate_random(&context.state) % size;
+				estimate_push(&context, (long)((unsigned long)context.lower_bound + index), i);
+			}
+			samples_count += context.allocations[i];
+		}
+		estimate_flush(&context);
+
+		round_seconds = seconds_now() - round_seconds;
+
+		unsigned long terms_count = 2 * ESTIMATE_BOUNDARY_SIZE + samples_count;
+		if (estimate_update(&context, options, terms_count, estimates)) {
+			break;
+		}
+
+		// the next round takes about twice as long
+		if (options->seconds > 0 &&
+			seconds_now() - start_seconds + 2 * round_seconds > options->seconds) {
+			break;
+		}
+
+		if (4 * samples_count >= interior) {
+			is_exact = true;
+			break;
+		}
+
+		estimate_allocate(&context, samples_count);
+	}
+
+	free(context.boundary_sums);
+	free(context.statistics);
+	free(context.values);
+	program_drop(&program);
+
+	if (is_exact) {
+		estimate_exactly(lower_bound, upper_bound, count, summands, estimates);
+	}
+}
@@ -4,18 +4,50 @@
 #include <float.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * @brief the operands of an operation, shared by its clones.
+ *
+ * The operands are immutable once created, and freed with the last reference to them.
+ */
+struct expression_operands {
+	atomic_size_t references_count;
+	struct expression operands[];
+};
+
+/**
+ * @brief Allocates the operands of an operation, with a single reference to them.
+ */
+static struct expression *expression_operands_new(size_t arity) {
+	struct expression_operands *operands =
+		malloc(sizeof(*operands) + arity * sizeof(*operands->operands));
+	atomic_init(&operands->references_count, 1);
+	return operands->operands;
+}
+
+/**
+ * @brief Gets the shared operands owning the operands of an operation.
+ */
+static struct expression_operands *expression_operands_of(struct expression *operands) {
+	assert(operands != NULL);
+
+	return (struct expression_operands *)(void *)((char *)operands -
+												   offsetof(struct expression_operands, operands));
+}
+
 struct expression expression_operation(enum operation_type type, ...) {
 	va_list arguments;
 	va_start(arguments, type);
 
 	size_t arity = operation_type_arity(type);
 
-	struct expression *operands = malloc(arity * sizeof(*operands));
+	struct expression *operands = expression_operands_new(arity);
 	for (size_t i = 0; i < arity; i++) {
 		operands[i] = va_arg(arguments, struct expression);
 	}
@@ -31,37 +63,33 @@ struct expression expression_operation(enum operation_type type, ...) {
 struct expression expression_clone(const struct expression *expression) {
 	assert(expression != NULL);
 
-	switch (expression->type) {
-		case expression_type_constant:
-		case expression_type_variable: return *expression;
-		case expression_type_operation: {
-			size_t arity = operation_type_arity(expression->operation.type);
-			struct expression *operands = malloc(arity * sizeof(*operands));
-			for (size_t i = 0; i < arity; i++) {
-				operands[i] = expression_clone(&expression->operation.operands[i]);
-			}
-			return (struct expression){
-				.type = expression_type_operation,
-				.operation = { .type = expression->operation.type, .operands = operands },
-			};
-		} break;
+	if (expression->type == expression_type_operation) {
+		struct expression_operands *operands =
+			expression_operands_of(expression->operation.operands);
+		atomic_fetch_add_explicit(&operands->references_count, 1, memory_order_relaxed);
 	}
+
+	return *expression;
 }
 
 void expression_drop(struct expression *expression) {
 	assert(expression != NULL);
 
-	switch (expression->type) {
-		case expression_type_constant:
-		case expression_type_variable: break;
-		case expression_type_operation: {
-			size_t arity = operation_type_arity(expression->operation.type);
-			for (size_t i = 0; i < arity; i++) {
-				expression_drop(&expression->operation.operands[i]);
-			}
-			free(expression->operation.operands);
-		} break;
+	if (expression->type != expression_type_operation) {
+		return;
 	}
+
+	// the last reference frees the operands, after all the others are done with them
+	struct expression_operands *operands = expression_operands_of(expression->operation.operands);
+	if (atomic_fetch_sub_explicit(&operands->references_count, 1, memory_order_acq_rel) != 1) {
+		return;
+	}
+
+	size_t arity = operation_type_arity(expression->operation.type);
+	for (size_t i = 0; i < arity; i++) {
+		expression_drop(&operands->operands[i]);
+	}
+	free(operands);
 }
 
 static bool double_equals(double value_1, double value_2, double epsilon) {
@@ -116,7 +144,63 @@ bool expression_equals(
 	}
 }
 
-static struct expression expression_from_string_expression(const char **string);
+static struct expression expression_from_string_comparison(const char **string);
+static struct expression expression_from_string_atom(const char **string);
+static struct expression expression_from_string_call(enum operation_type type, const char **string) {
+	assert(string != NULL && *string != NULL);
+
+	size_t arity = operation_type_arity(type);
+
+	// a single argument is an atom, so that the function doesn't swallow the rest of the term
+	if (arity == 1) {
+		return expression_operation(type, expression_from_string_atom(string));
+	}
+
+	// skip whitespace
+	while (isspace(**string)) {
+		++*string;
+	}
+
+	if (**string == '(') {
+		++*string;
+	} else {
+		(void)fprintf(stderr, "Warning: expected arguments \"%s\"\n", *string);
+	}
+
+	struct expression *operands = expression_operands_new(arity);
+	for (size_t i = 0; i < arity; i++) {
+		if (i != 0) {
+			// skip whitespace
+			while (isspace(**string)) {
+				++*string;
+			}
+
+			if (**string == ',') {
+				++*string;
+			} else {
+				(void)fprintf(stderr, "Warning: expected another argument \"%s\"\n", *string);
+			}
+		}
+
+		operands[i] = expression_from_string_comparison(string);
+	}
+
+	// skip whitespace
+	while (isspace(**string)) {
+		++*string;
+	}
+
+	if (**string == ')') {
+		++*string;
+	} else {
+		(void)fprintf(stderr, "Warning: unclosed parentheses \"%s\"\n", *string);
+	}
+
+	return (struct expression){
+		.type = expression_type_operation,
+		.operation = { .type = type, .operands = operands },
+	};
+}
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 static struct expression expression_from_string_atom(const char **string) {
 	assert(string != NULL && *string != NULL);
@@ -131,7 +215,7 @@ static struct expression expression_from_string_atom(const char **string) {
 	if (**string == '(') {
 		++*string;
 
-		atom = expression_from_string_expression(string);
+		atom = expression_from_string_comparison(string);
 
 		// skip whitespace
 		while (isspace(**string)) {
@@ -148,27 +232,19 @@ static struct expression expression_from_string_atom(const char **string) {
 		while (isalpha((*string)[length])) {
 			++length;
 		}
-		struct {
-			const char *name;
-			enum operation_type type;
-		} functions[] = {
-			{ "sin", operation_type_sine },		 { "cos", operation_type_cosine },
-			{ "tan", operation_type_tangent },	 { "exp", operation_type_exponential },
-			{ "log", operation_type_logarithm },
-		};
 
 		bool is_function = false;
 
-		for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++) {
-			if (strncmp(functions[i].name, *string, length) == 0) {
+		for (size_t i = 0; i < OPERATION_TYPES_COUNT; i++) {
+			const char *name = operation_type_function_name((enum operation_type)i);
+
+			// the whole identifier has to match, so that a variable isn't taken for a function
+			if (name != NULL && strlen(name) == length && strncmp(name, *string, length) == 0) {
 				is_function = true;
 
 				*string += length;
 
-				atom = expression_operation(
-					functions[i].type,
-					expression_from_string_expression(string)
-				);
+				atom = expression_from_string_call((enum operation_type)i, string);
 
 				break;
 			}
@@ -182,6 +258,7 @@ static struct expression expression_from_string_atom(const char **string) {
 			atom = expression_variable(name);
 		}
 	} else {
+		errno = 0;
 		char *end = NULL;
 		double value = strtod(*string, &end);
 		if (end == *string) {
@@ -201,11 +278,32 @@ static struct expression expression_from_string_atom(const char **string) {
 
 	return atom;
 }
+static struct expression expression_from_string_postfix(const char **string) {
+	assert(string != NULL && *string != NULL);
+
+	struct expression postfix = expression_from_string_atom(string);
+
+	while (1) {
+		// skip whitespace
+		while (isspace(**string)) {
+			++*string;
+		}
+
+		// not to be confused with the inequality operator
+		if (**string != '!' || (*string)[1] == '=') {
+			return postfix;
+		}
+
+		++*string;
+
+		postfix = expression_operation(operation_type_factorial, postfix);
+	}
+}
 static struct expression expression_from_string_factor(const char **string);
 static struct expression expression_from_string_primary(const char **string) {
 	assert(string != NULL && *string != NULL);
 
-	struct expression primary = expression_from_string_atom(string);
+	struct expression primary = expression_from_string_postfix(string);
 
 	// skip whitespace
 	while (isspace(**string)) {
@@ -275,6 +373,15 @@ static struct expression expression_from_string_term(const char **string) {
 					expression_from_string_factor(string)
 				);
 			} break;
+			case '%': {
+				++*string;
+
+				expression = expression_operation(
+					operation_type_modulo,
+					expression,
+					expression_from_string_factor(string)
+				);
+			} break;
 			default: return expression;
 		}
 	}
@@ -314,10 +421,44 @@ static struct expression expression_from_string_expression(const char **string)
 	}
 }
 
+static struct expression expression_from_string_comparison(const char **string) {
+	assert(string != NULL && *string != NULL);
+
+	struct expression expression = expression_from_string_expression(string);
+
+	// skip whitespace
+	while (isspace(**string)) {
+		++*string;
+	}
+
+	if (**string == '\0') {
+		return expression;
+	}
+
+	enum operation_type type;
+	bool is_equal = (*string)[1] == '=';
+	switch (**string) {
+		case '<': type = is_equal ? operation_type_less_equal : operation_type_less; break;
+		case '>': type = is_equal ? operation_type_greater_equal : operation_type_greater; break;
+		case '=':
+		case '!': {
+			if (!is_equal) {
+				return expression;
+			}
+			type = **string == '=' ? operation_type_equal : operation_type_not_equal;
+		} break;
+		default: return expression;
+	}
+
+	*string += is_equal ? 2 : 1;
+
+	return expression_operation(type, expression, expression_from_string_expression(string));
+}
+
 struct expression expression_from_string(const char *string) {
 	assert(string != NULL);
 
-	return expression_from_string_expression(&string);
+	return expression_from_string_comparison(&string);
 }
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
@@ -353,10 +494,21 @@ static int expression_to_string_(
 				case operation_type_addition:
 				case operation_type_subtraction:
 				case operation_type_multiplication:
-				case operation_type_division: {
+				case operation_type_division:
+				case operation_type_modulo:
+				case operation_type_less:
+				case operation_type_less_equal:
+				case operation_type_greater:
+				case operation_type_greater_equal:
+				case operation_type_equal:
+				case operation_type_not_equal: {
+					size_t precedence = operation_type_precedence(expression->operation.type);
+					// comparisons don't chain, so they need parentheses on either side
+					bool is_comparison = precedence == operation_type_precedence(operation_type_less);
+
 					if (expression->operation.operands[0].type == expression_type_operation &&
 						(operation_type_precedence(expression->operation.operands[0].operation.type
-						 ) < operation_type_precedence(expression->operation.type))) {
+						 ) < precedence + is_comparison)) {
 						print(snprintf, "(");
 						print(expression_to_string_, &expression->operation.operands[0]);
 						print(snprintf, ")");
@@ -369,13 +521,20 @@ static int expression_to_string_(
 						case operation_type_subtraction: print(snprintf, " - "); break;
 						case operation_type_multiplication: print(snprintf, " * "); break;
 						case operation_type_division: print(snprintf, " / "); break;
+						case operation_type_modulo: print(snprintf, " %% "); break;
+						case operation_type_less: print(snprintf, " < "); break;
+						case operation_type_less_equal: print(snprintf, " <= "); break;
+						case operation_type_greater: print(snprintf, " > "); break;
+						case operation_type_greater_equal: print(snprintf, " >= "); break;
+						case operation_type_equal: print(snprintf, " == "); break;
+						case operation_type_not_equal: print(snprintf, " != "); break;
 						// we have already checked the operation's type before
 						default: __builtin_unreachable();
 					}
 
 					if (expression->operation.operands[1].type == expression_type_operation &&
 						(operation_type_precedence(expression->operation.operands[1].operation.type
-						 ) <= operation_type_precedence(expression->operation.type))) {
+						 ) <= precedence)) {
 						print(snprintf, "(");
 						print(expression_to_string_, &expression->operation.operands[1]);
 						print(snprintf, ")");
@@ -419,23 +578,48 @@ static int expression_to_string_(
 						print(expression_to_string_, &expression->operation.operands[0]);
 					}
 				} break;
+				case operation_type_factorial: {
+					const struct expression *operand = &expression->operation.operands[0];
+					if ((operand->type == expression_type_operation &&
+						 operation_type_function_name(operand->operation.type) == NULL &&
+						 operand->operation.type != operation_type_factorial) ||
+						(operand->type == expression_type_constant &&
+						 signbit(operand->constant.value))) {
+						print(snprintf, "(");
+						print(expression_to_string_, operand);
+						print(snprintf, ")");
+					} else {
+						print(expression_to_string_, operand);
+					}
+
+					print(snprintf, "!");
+				} break;
 				case operation_type_sine:
 				case operation_type_cosine:
 				case operation_type_tangent:
 				case operation_type_exponential:
-				case operation_type_logarithm: {
-					switch (expression->operation.type) {
-
-						case operation_type_sine: print(snprintf, "sin"); break;
-						case operation_type_cosine: print(snprintf, "cos"); break;
-						case operation_type_tangent: print(snprintf, "tan"); break;
-						case operation_type_exponential: print(snprintf, "exp"); break;
-						case operation_type_logarithm: print(snprintf, "log"); break;
-						// we have already checked the operation's type before
-						default: __builtin_unreachable();
+				case operation_type_logarithm:
+				case operation_type_gamma:
+				case operation_type_log_gamma:
+				case operation_type_log_factorial:
+				case operation_type_binomial:
+				case operation_type_log_binomial:
+				case operation_type_absolute_value:
+				case operation_type_floor:
+				case operation_type_ceiling:
+				case operation_type_minimum:
+				case operation_type_maximum:
+				case operation_type_conditional: {
+					print(snprintf, "%s(", operation_type_function_name(expression->operation.type));
+
+					size_t arity = operation_type_arity(expression->operation.type);
+					for (size_t i = 0; i < arity; i++) {
+						if (i != 0) {
+							print(snprintf, ", ");
+						}
+						print(expression_to_string_, &expression->operation.operands[i]);
 					}
-					print(snprintf, "(");
-					print(expression_to_string_, &expression->operation.operands[0]);
+
 					print(snprintf, ")");
 				} break;
 			}
@@ -467,37 +651,440 @@ char *expression_to_string(const struct expression *expression) {
 	return string;
 }
 
-void expression_simplify(struct expression *expression, const struct environment *environment) {
+/**
+ * @brief Checks whether two values are exactly equal, which comparisons are meant to.
+ */
+static bool double_is_equal(double value_1, double value_2) {
+	return value_1 >= value_2 && value_1 <= value_2;
+}
+
+static bool double_is_integer(double value) {
+	return isfinite(value) && fpclassify(value - nearbyint(value)) == FP_ZERO;
+}
+
+/**
+ * @brief The maximum degree of the polynomials the simplifier rewrites in Horner form.
+ */
+#define HORNER_DEGREE_MAXIMUM 16
+/**
+ * @brief The cost of an exponentiation, in additions or multiplications.
+ */
+#define HORNER_POWER_COST 16
+
+/**
+ * @brief a polynomial in a single variable, in coefficient form.
+ */
+struct horner_polynomial {
+	char variable; ///< The name of the variable, or '\0' for a constant polynomial.
+	size_t degree;
+	double coefficients[HORNER_DEGREE_MAXIMUM + 1]; ///< Coefficients, of increasing degree.
+};
+
+static struct horner_polynomial horner_constant(double value) {
+	struct horner_polynomial polynomial = { .variable = '\0', .degree = 0 };
+	polynomial.coefficients[0] = value;
+	return polynomial;
+}
+
+/**
+ * @brief Counts the terms of non-zero coefficients of a polynomial.
+ */
+static size_t horner_terms_count(const struct horner_polynomial *polynomial) {
+	assert(polynomial != NULL);
+
+	size_t count = 0;
+	for (size_t i = 0; i <= polynomial->degree; i++) {
+		count += fpclassify(polynomial->coefficients[i]) != FP_ZERO;
+	}
+
+	return count;
+}
+
+/**
+ * @brief Multiplies two polynomials, failing if the product's degree is too large or if it would
+ * expand a product of sums.
+ *
+ * Expanding products of sums, like `(i - 100000) ^ 4`, gives large coefficients that cancel
+ * out catastrophically far from the origin, so only products by monomials are expanded.
+ */
+static bool horner_multiply(
+	const struct horner_polynomial *polynomial_1,
+	const struct horner_polynomial *polynomial_2,
+	struct horner_polynomial *product
+) {
+	assert(polynomial_1 != NULL && polynomial_2 != NULL && product != NULL);
+
+	if (polynomial_1->degree + polynomial_2->degree > HORNER_DEGREE_MAXIMUM ||
+		(horner_terms_count(polynomial_1) > 1 && horner_terms_count(polynomial_2) > 1)) {
+		return false;
+	}
+
+	struct horner_polynomial result = horner_constant(0);
+	result.variable = polynomial_1->variable != '\0' ? polynomial_1->variable
+													: polynomial_2->variable;
+	result.degree = polynomial_1->degree + polynomial_2->degree;
+	for (size_t i = 1; i <= result.degree; i++) {
+		result.coefficients[i] = 0;
+	}
+	for (size_t i = 0; i <= polynomial_1->degree; i++) {
+		for (size_t j = 0; j <= polynomial_2->degree; j++) {
+			result.coefficients[i + j] +=
+				polynomial_1->coefficients[i] * polynomial_2->coefficients[j];
+		}
+	}
+
+	*product = result;
+	return true;
+}
+
+/**
+ * @brief Collects an expression into a polynomial in a single variable, if it's one.
+ *
+ * Sums, differences, negations and products of polynomials, quotients of polynomials by
+ * constants and powers of polynomials to small non-negative integers are polynomials.
+ */
+static bool horner_collect(
+	const struct expression *expression,
+	struct horner_polynomial *polynomial
+) {
+	assert(expression != NULL && polynomial != NULL);
+
+	switch (expression->type) {
+		case expression_type_constant:
+			*polynomial = horner_constant(expression->constant.value);
+			return isfinite(expression->constant.value);
+		case expression_type_variable:
+			*polynomial = horner_constant(0);
+			polynomial->variable = expression->variable.name;
+			polynomial->degree = 1;
+			polynomial->coefficients[1] = 1;
+			return true;
+		case expression_type_operation: break;
+	}
+
+	enum operation_type type = expression->operation.type;
+	const struct expression *operands = expression->operation.operands;
+
+	struct horner_polynomial operand_1;
+	struct horner_polynomial operand_2;
+	if (!horner_collect(&operands[0], &operand_1)) {
+		return false;
+	}
+
+	if (type == operation_type_negation) {
+		*polynomial = operand_1;
+		for (size_t i = 0; i <= polynomial->degree; i++) {
+			polynomial->coefficients[i] = -polynomial->coefficients[i];
+		}
+		return true;
+	}
+
+	if (type == operation_type_exponentiation) {
+		// only powers to small integers are expanded
+		if (operands[1].type != expression_type_constant) {
+			return false;
+		}
+		double exponent = operands[1].constant.value;
+		if (exponent < 0 || exponent > HORNER_DEGREE_MAXIMUM || !double_is_integer(exponent)) {
+			return false;
+		}
+
+		*polynomial = horner_constant(1);
+		for (double i = 0; i < exponent; i++) {
+			if (!horner_multiply(polynomial, &operand_1, polynomial)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool is_binary = type == operation_type_addition || type == operation_type_subtraction ||
+					 type == operation_type_multiplication || type == operation_type_division;
+	if (!is_binary || !horner_collect(&operands[1], &operand_2)) {
+		return false;
+	}
+
+	// polynomials in different variables don't make a polynomial in one
+	if (operand_1.variable != '\0' && operand_2.variable != '\0' &&
+		operand_1.variable != operand_2.variable) {
+		return false;
+	}
+
+	switch (type) {
+		case operation_type_addition:
+		case operation_type_subtraction: {
+			double sign = type == operation_type_addition ? 1 : -1;
+			if (operand_2.degree > operand_1.degree) {
+				for (size_t i = operand_1.degree + 1; i <= operand_2.degree; i++) {
+					operand_1.coefficients[i] = 0;
+				}
+				operand_1.degree = operand_2.degree;
+			}
+			for (size_t i = 0; i <= operand_2.degree; i++) {
+				operand_1.coefficients[i] += sign * operand_2.coefficients[i];
+			}
+			if (operand_1.variable == '\0') {
+				operand_1.variable = operand_2.variable;
+			}
+			*polynomial = operand_1;
+			return true;
+		}
+		case operation_type_multiplication:
+			return horner_multiply(&operand_1, &operand_2, polynomial);
+		case operation_type_division: {
+			if (operand_2.degree != 0 || fpclassify(operand_2.coefficients[0]) == FP_ZERO) {
+				return false;
+			}
+			*polynomial = operand_1;
+			for (size_t i = 0; i <= polynomial->degree; i++) {
+				polynomial->coefficients[i] /= operand_2.coefficients[0];
+			}
+			return true;
+		}
+		default: return false;
+	}
+}
+
+/**
+ * @brief Gets the cost of evaluating an expression, in additions or multiplications.
+ */
+static size_t horner_cost(const struct expression *expression) {
+	assert(expression != NULL);
+
+	if (expression->type != expression_type_operation) {
+		return 0;
+	}
+
+	size_t cost = expression->operation.type == operation_type_exponentiation ? HORNER_POWER_COST
+																			   : 1;
+	size_t arity = operation_type_arity(expression->operation.type);
+	for (size_t i = 0; i < arity; i++) {
+		cost += horner_cost(&expression->operation.operands[i]);
+	}
+
+	return cost;
+}
+
+/**
+ * @brief Adds a constant to an expression, subtracting its opposite if it's negative.
+ */
+static struct expression horner_add(struct expression expression, double value) {
+	if (value < 0) {
+		return expression_operation(
+			operation_type_subtraction,
+			expression,
+			expression_constant(-value)
+		);
+	}
+
+	return expression_operation(operation_type_addition, expression, expression_constant(value));
+}
+
+/**
+ * @brief Emits a polynomial in Horner form, c_0 + x (c_1 + x (c_2 + ...)).
+ *
+ * The terms of zero coefficients are left out, as are the factors of unit leading coefficients.
+ */
+static struct expression horner_emit(const struct horner_polynomial *polynomial) {
+	assert(polynomial != NULL && polynomial->degree >= 1 && polynomial->variable != '\0');
+
+	const double *coefficients = polynomial->coefficients;
+	struct expression variable = expression_variable(polynomial->variable);
+
+	size_t degree = polynomial->degree;
+	struct expression result = variable;
+	if (double_is_equal(coefficients[degree], -1)) {
+		result = expression_operation(operation_type_negation, variable);
+	} else if (!double_is_equal(coefficients[degree], 1)) {
+		result = expression_operation(
+			operation_type_multiplication,
+			expression_constant(coefficients[degree]),
+			variable
+		);
+	}
+
+	for (size_t i = degree; i-- > 0;) {
+		if (fpclassify(coefficients[i]) != FP_ZERO) {
+			result = horner_add(result, coefficients[i]);
+		}
+		if (i != 0) {
+			result = expression_operation(operation_type_multiplication, result, variable);
+		}
+	}
+
+	return result;
+}
+
+/**
+ * @brief Checks whether two expressions are the same node, sharing their operands.
+ */
+static bool expression_is_same(
+	const struct expression *expression_1,
+	const struct expression *expression_2
+) {
+	assert(expression_1 != NULL && expression_2 != NULL);
+
+	if (expression_1->type != expression_2->type) {
+		return false;
+	}
+
+	switch (expression_1->type) {
+		case expression_type_constant:
+			return memcmp(
+					   &expression_1->constant.value,
+					   &expression_2->constant.value,
+					   sizeof(expression_1->constant.value)
+				   ) == 0;
+		case expression_type_variable:
+			return expression_1->variable.name == expression_2->variable.name;
+		case expression_type_operation:
+			return expression_1->operation.type == expression_2->operation.type &&
+				   expression_1->operation.operands == expression_2->operation.operands;
+	}
+}
+
+/**
+ * @brief Creates an operation like `expression` from new operands, unless they're the same.
+ *
+ * Takes ownership of the operands, and shares those of `expression` if they're all the same.
+ */
+static struct expression expression_rebuild(
+	const struct expression *expression,
+	struct expression operands[]
+) {
+	assert(expression != NULL && expression->type == expression_type_operation);
+
+	size_t arity = operation_type_arity(expression->operation.type);
+
+	bool is_same = true;
+	for (size_t i = 0; i < arity; i++) {
+		is_same = is_same && expression_is_same(&operands[i], &expression->operation.operands[i]);
+	}
+
+	if (is_same) {
+		for (size_t i = 0; i < arity; i++) {
+			expression_drop(&operands[i]);
+		}
+		return expression_clone(expression);
+	}
+
+	struct expression *shared = expression_operands_new(arity);
+	memcpy(shared, operands, arity * sizeof(*operands));
+
+	return (struct expression){
+		.type = expression_type_operation,
+		.operation = { .type = expression->operation.type, .operands = shared },
+	};
+}
+
+/**
+ * @brief Rewrites the largest polynomial sub-expressions in Horner form, when it's cheaper.
+ */
+static struct expression expression_horner(const struct expression *expression) {
+	assert(expression != NULL);
+
+	if (expression->type != expression_type_operation) {
+		return *expression;
+	}
+
+	struct horner_polynomial polynomial;
+	if (horner_collect(expression, &polynomial)) {
+		// trailing coefficients may have cancelled out
+		while (polynomial.degree > 0 &&
+			   fpclassify(polynomial.coefficients[polynomial.degree]) == FP_ZERO) {
+			--polynomial.degree;
+		}
+
+		// linear polynomials are left as written, for the analyses matching their shapes
+		if (polynomial.degree < 2) {
+			return expression_clone(expression);
+		}
+
+		struct expression horner = horner_emit(&polynomial);
+		if (horner_cost(&horner) < horner_cost(expression)) {
+			return horner;
+		}
+
+		expression_drop(&horner);
+		return expression_clone(expression);
+	}
+
+	struct expression operands[OPERATION_ARITY_MAXIMUM];
+	size_t arity = operation_type_arity(expression->operation.type);
+	for (size_t i = 0; i < arity; i++) {
+		operands[i] = expression_horner(&expression->operation.operands[i]);
+	}
+
+	return expression_rebuild(expression, operands);
+}
+
+/**
+ * @brief Constant folds the constant sub-expressions of an expression.
+ */
+static struct expression expression_fold(
+	const struct expression *expression,
+	const struct environment *environment
+) {
 	assert(expression != NULL);
 
 	switch (expression->type) {
-		case expression_type_constant: break;
+		case expression_type_constant: return *expression;
 		case expression_type_variable: {
 			if (environment != NULL) {
 				double value = environment_get_variable(environment, expression->variable.name);
 				if (!isnan(value)) {
-					*expression = expression_constant(value);
+					return expression_constant(value);
 				}
 			}
-		} break;
+			return *expression;
+		}
 		case expression_type_operation: {
 			bool is_constant = true;
 
+			struct expression operands[OPERATION_ARITY_MAXIMUM];
+			double values[OPERATION_ARITY_MAXIMUM];
 			size_t arity = operation_type_arity(expression->operation.type);
 			for (size_t i = 0; i < arity; i++) {
-				expression_simplify(&expression->operation.operands[i], environment);
-				if (expression->operation.operands[i].type != expression_type_constant) {
+				operands[i] = expression_fold(&expression->operation.operands[i], environment);
+				if (operands[i].type != expression_type_constant) {
 					is_constant = false;
+				} else {
+					values[i] = operands[i].constant.value;
 				}
 			}
 
 			if (is_constant) {
-				*expression = expression_constant(expression_evaluate(expression, environment));
+				return expression_constant(
+					operation_type_evaluate(expression->operation.type, values)
+				);
 			}
+
+			return expression_rebuild(expression, operands);
 		}
 	}
 }
 
+struct expression expression_simplified(
+	const struct expression *expression,
+	const struct environment *environment
+) {
+	assert(expression != NULL);
+
+	struct expression folded = expression_fold(expression, environment);
+	struct expression simplified = expression_horner(&folded);
+	expression_drop(&folded);
+
+	return simplified;
+}
+
+void expression_simplify(struct expression *expression, const struct environment *environment) {
+	assert(expression != NULL);
+
+	struct expression simplified = expression_simplified(expression, environment);
+	expression_drop(expression);
+	*expression = simplified;
+}
+
 void expression_print(const struct expression *expression) {
 	assert(expression != 0);
 
@@ -528,6 +1115,25 @@ void expression_debug_print(const struct expression *expression) {
 				case operation_type_tangent: printf("tangent("); break;
 				case operation_type_exponential: printf("exponential("); break;
 				case operation_type_logarithm: printf("logarithm("); break;
+				case operation_type_factorial: printf("factorial("); break;
+				case operation_type_gamma: printf("gamma("); break;
+				case operation_type_log_gamma: printf("log_gamma("); break;
+				case operation_type_log_factorial: printf("log_factorial("); break;
+				case operation_type_binomial: printf("binomial("); break;
+				case operation_type_log_binomial: printf("log_binomial("); break;
+				case operation_type_modulo: printf("modulo("); break;
+				case operation_type_absolute_value: printf("absolute_value("); break;
+				case operation_type_floor: printf("floor("); break;
+				case operation_type_ceiling: printf("ceiling("); break;
+				case operation_type_minimum: printf("minimum("); break;
+				case operation_type_maximum: printf("maximum("); break;
+				case operation_type_less: printf("less("); break;
+				case operation_type_less_equal: printf("less_equal("); break;
+				case operation_type_greater: printf("greater("); break;
+				case operation_type_greater_equal: printf("greater_equal("); break;
+				case operation_type_equal: printf("equal("); break;
+				case operation_type_not_equal: printf("not_equal("); break;
+				case operation_type_conditional: printf("conditional("); break;
 			}
 			size_t arity = operation_type_arity(expression->operation.type);
 			for (size_t i = 0; i < arity; i++) {
@@ -541,6 +1147,133 @@ void expression_debug_print(const struct expression *expression) {
 	}
 }
 
+/**
+ * @brief The largest number of factors a binomial coefficient is computed as a product of.
+ */
+#define BINOMIAL_PRODUCT_MAXIMUM 64
+
+/**
+ * @brief Computes the logarithm of the absolute value of the gamma function, and its sign.
+ *
+ * Unlike `lgamma()`, doesn't store the sign in a global variable, so it's safe to use from several
+ * threads.
+ */
+static double log_gamma(double value, int *sign) {
+	assert(sign != NULL);
+
+	return lgamma_r(value, sign);
+}
+
+/**
+ * @brief Computes a binomial coefficient.
+ *
+ * For an integer `k`, the coefficient is the product n (n - 1) ... (n - k + 1) / k!, which is 0
+ * for a negative `k`, and also for `k` greater than `n` when `n` is a non-negative integer. Small
+ * coefficients are computed as that product, which is exact for integers as long as the result
+ * is, and the others using the gamma function.
+ */
+static double binomial(double n, double k) {
+	if (double_is_integer(k)) {
+		if (k < 0) {
+			return 0;
+		}
+
+		if (double_is_integer(n) && n >= 0) {
+			if (k > n) {
+				return 0;
+			}
+			k = fmin(k, n - k);
+		}
+
+		if (k <= BINOMIAL_PRODUCT_MAXIMUM) {
+			double result = 1;
+			for (double i = 0; i < k; i++) {
+				result = result * (n - i) / (i + 1);
+			}
+			return result;
+		}
+	}
+
+	int sign_1 = 1;
+	int sign_2 = 1;
+	int sign_3 = 1;
+	double result = exp(
+		log_gamma(n + 1, &sign_1) - log_gamma(k + 1, &sign_2) - log_gamma(n - k + 1, &sign_3)
+	);
+	result *= (double)(sign_1 * sign_2 * sign_3);
+
+	return double_is_integer(n) && double_is_integer(k) ? nearbyint(result) : result;
+}
+
+/**
+ * @brief Computes the logarithm of the absolute value of a binomial coefficient.
+ *
+ * Falls back to the gamma function when the coefficient itself overflows.
+ */
+static double log_binomial(double n, double k) {
+	double result = binomial(n, k);
+	if (isfinite(result)) {
+		return log(fabs(result));
+	}
+
+	int sign = 1;
+	return log_gamma(n + 1, &sign) - log_gamma(k + 1, &sign) - log_gamma(n - k + 1, &sign);
+}
+
+/**
+ * @brief Computes the remainder of the floored division, which has the sign of the divisor.
+ */
+static double modulo(double dividend, double divisor) {
+	double remainder = fmod(dividend, divisor);
+	bool is_opposite = (remainder < 0 && divisor > 0) || (remainder > 0 && divisor < 0);
+	return remainder + (is_opposite ? divisor : 0);
+}
+
+double operation_type_evaluate(enum operation_type type, const double operands[]) {
+	assert(operands != NULL);
+
+	switch (type) {
+		case operation_type_addition: return operands[0] + operands[1];
+		case operation_type_subtraction: return operands[0] - operands[1];
+		case operation_type_multiplication: return operands[0] * operands[1];
+		case operation_type_division: return operands[0] / operands[1];
+		case operation_type_exponentiation: return pow(operands[0], operands[1]);
+		case operation_type_negation: return -operands[0];
+		case operation_type_sine: return sin(operands[0]);
+		case operation_type_cosine: return cos(operands[0]);
+		case operation_type_tangent: return tan(operands[0]);
+		case operation_type_exponential: return exp(operands[0]);
+		case operation_type_logarithm: return log(operands[0]);
+		case operation_type_factorial: return tgamma(operands[0] + 1);
+		case operation_type_gamma: return tgamma(operands[0]);
+		case operation_type_log_gamma: {
+			int sign = 1;
+			return log_gamma(operands[0], &sign);
+		}
+		case operation_type_log_factorial: {
+			int sign = 1;
+			return log_gamma(operands[0] + 1, &sign);
+		}
+		case operation_type_binomial: return binomial(operands[0], operands[1]);
+		case operation_type_log_binomial: return log_binomial(operands[0], operands[1]);
+		case operation_type_modulo: return modulo(operands[0], operands[1]);
+		case operation_type_absolute_value: return fabs(operands[0]);
+		case operation_type_floor: return floor(operands[0]);
+		case operation_type_ceiling: return ceil(operands[0]);
+		// the comparisons and selections below compile to conditional moves and blends
+		case operation_type_minimum: return operands[0] < operands[1] ? operands[0] : operands[1];
+		case operation_type_maximum: return operands[0] > operands[1] ? operands[0] : operands[1];
+		case operation_type_less: return operands[0] < operands[1];
+		case operation_type_less_equal: return operands[0] <= operands[1];
+		case operation_type_greater: return operands[0] > operands[1];
+		case operation_type_greater_equal: return operands[0] >= operands[1];
+		case operation_type_equal: return double_is_equal(operands[0], operands[1]);
+		case operation_type_not_equal: return !double_is_equal(operands[0], operands[1]);
+		case operation_type_conditional:
+			return !double_is_equal(operands[0], 0) ? operands[1] : operands[2];
+	}
+}
+
 double expression_evaluate(
 	const struct expression *expression,
 	const struct environment *environment
@@ -555,42 +1288,14 @@ double expression_evaluate(
 			}
 			return environment_get_variable(environment, expression->variable.name);
 		case expression_type_operation: {
-			switch (expression->operation.type) {
-				case operation_type_addition:
-					return expression_evaluate(&expression->operation.operands[0], environment) +
-						   expression_evaluate(&expression->operation.operands[1], environment);
-				case operation_type_subtraction:
-					return expression_evaluate(&expression->operation.operands[0], environment) -
-						   expression_evaluate(&expression->operation.operands[1], environment);
-				case operation_type_multiplication:
-					return expression_evaluate(&expression->operation.operands[0], environment) *
-						   expression_evaluate(&expression->operation.operands[1], environment);
-				case operation_type_division:
-					return expression_evaluate(&expression->operation.operands[0], environment) /
-						   expression_evaluate(&expression->operation.operands[1], environment);
-				case operation_type_exponentiation:
-					return pow(
-						expression_evaluate(&expression->operation.operands[0], environment),
-						expression_evaluate(&expression->operation.operands[1], environment)
-					);
-				case operation_type_negation:
-					return -expression_evaluate(&expression->operation.operands[0], environment);
-				case operation_type_sine:
-					return sin(expression_evaluate(&expression->operation.operands[0], environment)
-					);
-				case operation_type_cosine:
-					return cos(expression_evaluate(&expression->operation.operands[0], environment)
-					);
-				case operation_type_tangent:
-					return tan(expression_evaluate(&expression->operation.operands[0], environment)
-					);
-				case operation_type_exponential:
-					return exp(expression_evaluate(&expression->operation.operands[0], environment)
-					);
-				case operation_type_logarithm:
-					return log(expression_evaluate(&expression->operation.operands[0], environment)
-					);
+			double operands[OPERATION_ARITY_MAXIMUM];
+
+			size_t arity = operation_type_arity(expression->operation.type);
+			for (size_t i = 0; i < arity; i++) {
+				operands[i] = expression_evaluate(&expression->operation.operands[i], environment);
 			}
+
+			return operation_type_evaluate(expression->operation.type, operands);
 		}
 	}
 }
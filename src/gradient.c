@@ -0,0 +1,353 @@
+#include <gradient.h>
+
+#include <assert.h>
+#include <math.h>
+#include <program.h>
+#include <scheduler.h>
+#include <stdlib.h>
+
+/**
+ * @brief The minimum number of indices in a leaf of a summation.
+ */
+#define GRADIENT_LEAF_SIZE_MINIMUM 1024
+/**
+ * @brief The maximum number of leaves of a summation.
+ */
+#define GRADIENT_LEAVES_MAXIMUM 4096
+
+/**
+ * @brief Computes the digamma function, the derivative of the logarithm of the gamma function.
+ *
+ * Small arguments are reflected and shifted up to 10, from where the asymptotic series is within
+ * rounding errors.
+ */
+static double gradient_digamma(double value) {
+	if (value <= 0 && floor(value) >= value) {
+		return NAN;
+	}
+
+	double result = 0;
+	if (value < 0.5) {
+		result -= M_PI / tan(M_PI * value);
+		value = 1 - value;
+	}
+	while (value < 10) {
+		result -= 1 / value;
+		value += 1;
+	}
+
+	double inverse = 1 / (value * value);
+	double series = 1.0 / 132 - inverse * 691.0 / 32760;
+	series = 1.0 / 252 - inverse * (1.0 / 240 - inverse * series);
+	series = inverse * (1.0 / 12 - inverse * (1.0 / 120 - inverse * series));
+
+	return result + log(value) - 0.5 / value - series;
+}
+
+/**
+ * @brief Computes the partial derivative of an operation with respect to one of its operands.
+ *
+ * Takes the values of the operands and of the result of the operation. Operations that are
+ * piecewise constant have no derivative, and selections that of the operand they select.
+ */
+static double gradient_partial(
+	enum operation_type type,
+	size_t operand,
+	const double operands[],
+	double result
+) {
+	assert(operands != NULL);
+
+	double x = operands[0];
+	double y = operands[1];
+	switch (type) {
+		case operation_type_addition: return 1;
+		case operation_type_subtraction: return operand == 0 ? 1 : -1;
+		case operation_type_multiplication: return operand == 0 ? y : x;
+		case operation_type_division: return operand == 0 ? 1 / y : -result / y;
+		case operation_type_exponentiation:
+			return operand == 0 ? y * pow(x, y - 1) : result * log(x);
+		case operation_type_negation: return -1;
+		case operation_type_sine: return cos(x);
+		case operation_type_cosine: return -sin(x);
+		case operation_type_tangent: return 1 + result * result;
+		case operation_type_exponential: return result;
+		case operation_type_logarithm: return 1 / x;
+		case operation_type_factorial: return result * gradient_digamma(x + 1);
+		case operation_type_gamma: return result * gradient_digamma(x);
+		case operation_type_log_gamma: return gradient_digamma(x);
+		case operation_type_log_factorial: return gradient_digamma(x + 1);
+		case operation_type_binomial:
+		case operation_type_log_binomial: {
+			// binom(n, k) = (n)! / ((k)! * (n - k)!)
+			double derivative = operand == 0
+									? gradient_digamma(x + 1) - gradient_digamma(x - y + 1)
+									: gradient_digamma(x - y + 1) - gradient_digamma(y + 1);
+			return type == operation_type_binomial ? result * derivative : derivative;
+		}
+		case operation_type_modulo: return operand == 0 ? 1 : -floor(x / y);
+		case operation_type_absolute_value: return (double)(x > 0) - (double)(x < 0);
+		case operation_type_floor:
+		case operation_type_ceiling:
+		case operation_type_less:
+		case operation_type_less_equal:
+		case operation_type_greater:
+		case operation_type_greater_equal:
+		case operation_type_equal:
+		case operation_type_not_equal: return 0;
+		case operation_type_minimum: return (double)((x < y) == (operand == 0));
+		case operation_type_maximum: return (double)((x > y) == (operand == 0));
+		case operation_type_conditional: {
+			bool is_first = !(x >= 0 && x <= 0);
+			return operand == 0 ? 0 : (double)(is_first == (operand == 1));
+		}
+	}
+}
+
+/**
+ * @brief The state of a summation and its gradients shared by the threads evaluating it.
+ */
+struct gradient_context {
+	const struct program *program;
+	const struct environment *environment;
+	size_t variables_count;
+	/// Whether each instruction depends on each variable, one row of `variables_count` per
+	/// instruction.
+	const bool *is_dependent;
+	long lower_bound;
+	long upper_bound;
+	size_t leaves_count;
+	double *values; ///< Scratch values of the program, one row of `values_count` per thread.
+	size_t values_count;
+	/// Scratch derivatives of the program, one row of `values_count * variables_count` per thread.
+	double *tangents;
+	/// Sums of the summands and of their derivatives over each leaf, one row per leaf.
+	double *results;
+};
+
+static void gradient_leaf(void *context_, size_t thread, size_t leaf) {
+	assert(context_ != NULL);
+
+	struct gradient_context *context = context_;
+	const struct program *program = context->program;
+	size_t variables_count = context->variables_count;
+	const bool *is_dependent = context->is_dependent;
+
+	long lower_bound = 0;
+	long upper_bound = 0;
+	scheduler_partition(
+		context->lower_bound,
+		context->upper_bound,
+		context->leaves_count,
+		leaf,
+		&lower_bound,
+		&upper_bound
+	);
+	unsigned long length = (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+
+	double *values = &context->values[thread * context->values_count];
+	double *tangents = &context->tangents[thread * context->values_count * variables_count];
+	size_t width = 1 + variables_count;
+	double *sums = &context->results[leaf * program->outputs_count * width];
+	for (size_t i = 0; i < program->outputs_count * width; i++) {
+		sums[i] = 0;
+	}
+
+	char index_variable = 'i';
+	double indices[PROGRAM_BLOCK_SIZE];
+	const double *index_column = indices;
+	for (unsigned long offset = 0; offset < length; offset += PROGRAM_BLOCK_SIZE) {
+		size_t size = length - offset < PROGRAM_BLOCK_SIZE ? (size_t)(length - offset)
+														   : PROGRAM_BLOCK_SIZE;
+		for (size_t i = 0; i < size; i++) {
+			indices[i] = (double)(long)((unsigned long)lower_bound + offset + i);
+		}
+
+		program_evaluate_rows(
+			program,
+			context->environment,
+			1,
+			&index_variable,
+			&index_column,
+			size,
+			values
+		);
+
+		// the derivatives of the instructions depending on each variable, in the same order
+		for (size_t i = 0; i < program->instructions_count; i++) {
+			const struct instruction *instruction = &program->instructions[i];
+			for (size_t j = 0; j < variables_count; j++) {
+				if (!is_dependent[i * variables_count + j]) {
+					continue;
+				}
+
+				double *tangent = &tangents[(i * variables_count + j) * size];
+				if (instruction->type == expression_type_variable) {
+					for (size_t k = 0; k < size; k++) {
+						tangent[k] = 1;
+					}
+					continue;
+				}
+
+				for (size_t k = 0; k < size; k++) {
+					tangent[k] = 0;
+				}
+
+				enum operation_type type = instruction->operation.type;
+				const size_t *operands = instruction->operation.operands;
+				size_t arity = operation_type_arity(type);
+				const double *results = &values[i * size];
+				for (size_t l = 0; l < arity; l++) {
+					if (!is_dependent[operands[l] * variables_count + j]) {
+						continue;
+					}
+
+					const double *operand_tangent =
+						&tangents[(operands[l] * variables_count + j) * size];
+					for (size_t k = 0; k < size; k++) {
+						double lane[OPERATION_ARITY_MAXIMUM] = { 0 };
+						for (size_t m = 0; m < arity; m++) {
+							lane[m] = values[operands[m] * size + k];
+						}
+						double partial = gradient_partial(type, l, lane, results[k]);
+						tangent[k] += partial * operand_tangent[k];
+					}
+				}
+			}
+		}
+
+		for (size_t i = 0; i < program->outputs_count; i++) {
+			size_t output = program->outputs[i];
+			const double *terms = &values[output * size];
+			for (size_t k = 0; k < size; k++) {
+				sums[i * width] += terms[k];
+			}
+
+			for (size_t j = 0; j < variables_count; j++) {
+				if (!is_dependent[output * variables_count + j]) {
+					continue;
+				}
+
+				const double *derivatives = &tangents[(output * variables_count + j) * size];
+				for (size_t k = 0; k < size; k++) {
+					sums[i * width + 1 + j] += derivatives[k];
+				}
+			}
+		}
+	}
+}
+
+void gradient_summation_fused(
+	long lower_bound,
+	long upper_bound,
+	const struct environment *environment,
+	size_t variables_count,
+	const char variables[],
+	size_t count,
+	const char *const summands[],
+	double sums[],
+	double gradients[],
+	const struct summation_options *options
+) {
+	assert(variables_count <= VARIABLES_COUNT && (variables_count == 0 || variables != NULL));
+	assert((count == 0 || summands != NULL) && (count == 0 || sums != NULL));
+	assert(count == 0 || variables_count == 0 || gradients != NULL);
+
+	struct summation_options default_options = summation_options_default();
+	if (options == NULL) {
+		options = &default_options;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		sums[i] = 0;
+	}
+	for (size_t i = 0; i < count * variables_count; i++) {
+		gradients[i] = 0;
+	}
+	if (lower_bound > upper_bound || count == 0) {
+		return;
+	}
+
+	// the variables aren't folded into constants, so that their derivatives can be followed
+	struct environment unknowns = environment_new();
+	struct expression *expressions = malloc(count * sizeof(*expressions));
+	for (size_t i = 0; i < count; i++) {
+		assert(summands[i] != NULL);
+
+		expressions[i] = expression_from_string(summands[i]);
+		expression_simplify(&expressions[i], &unknowns);
+	}
+
+	struct program program = program_new(count, expressions);
+
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+	free(expressions);
+
+	// only the instructions depending on a variable have derivatives with respect to it
+	size_t instructions_count = program.instructions_count;
+	bool *is_dependent = calloc(instructions_count * variables_count + 1, sizeof(*is_dependent));
+	for (size_t i = 0; i < instructions_count; i++) {
+		const struct instruction *instruction = &program.instructions[i];
+		for (size_t j = 0; j < variables_count; j++) {
+			assert(variables[j] != 'i');
+
+			bool *dependent = &is_dependent[i * variables_count + j];
+			if (instruction->type == expression_type_variable) {
+				*dependent = instruction->variable == variables[j];
+			} else if (instruction->type == expression_type_operation) {
+				size_t arity = operation_type_arity(instruction->operation.type);
+				for (size_t k = 0; k < arity; k++) {
+					size_t operand = instruction->operation.operands[k];
+					*dependent = *dependent || is_dependent[operand * variables_count + j];
+				}
+			}
+		}
+	}
+
+	unsigned long range = (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+	size_t leaves_count = range / GRADIENT_LEAF_SIZE_MINIMUM + 1;
+	if (leaves_count > GRADIENT_LEAVES_MAXIMUM) {
+		leaves_count = GRADIENT_LEAVES_MAXIMUM;
+	}
+
+	size_t threads_count = options->threads_count != 0 ? options->threads_count
+														: scheduler_default_threads_count();
+	if (threads_count > leaves_count) {
+		threads_count = leaves_count;
+	}
+
+	struct gradient_context context = {
+		.program = &program,
+		.environment = environment,
+		.variables_count = variables_count,
+		.is_dependent = is_dependent,
+		.lower_bound = lower_bound,
+		.upper_bound = upper_bound,
+		.leaves_count = leaves_count,
+		.values_count = instructions_count * PROGRAM_BLOCK_SIZE,
+	};
+	size_t width = 1 + variables_count;
+	context.values = malloc(threads_count * context.values_count * sizeof(*context.values));
+	context.tangents = malloc(
+		threads_count * context.values_count * variables_count * sizeof(*context.tangents) + 1
+	);
+	context.results = malloc(leaves_count * count * width * sizeof(*context.results));
+
+	scheduler_run(threads_count, leaves_count, gradient_leaf, &context, NULL);
+
+	for (size_t i = 0; i < count; i++) {
+		sums[i] = scheduler_sum(&context.results[i * width], leaves_count, count * width);
+		for (size_t j = 0; j < variables_count; j++) {
+			gradients[i * variables_count + j] =
+				scheduler_sum(&context.results[i * width + 1 + j], leaves_count, count * width);
+		}
+	}
+
+	free(context.results);
+	free(context.tangents);
+	free(context.values);
+	free(is_dependent);
+	program_drop(&program);
+}
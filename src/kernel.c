@@ -0,0 +1,386 @@
+#include <kernel.h>
+
+#include <assert.h>
+#include <cache.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @brief The default C compiler, when the `CC` environment variable isn't set.
+ */
+#define KERNEL_COMPILER "cc"
+
+/**
+ * @brief The options kernels are compiled with.
+ *
+ * The kernel must round like the block engine, so contracting into FMAs is disabled.
+ */
+#define KERNEL_FLAGS "-O2", "-fPIC", "-shared", "-ffp-contract=off"
+
+/**
+ * @brief The version of the kernels' sources, which changes with the code generated for them.
+ */
+#define KERNEL_MAGIC "SUMKRNL1"
+
+static const char *kernel_compiler(void) {
+	const char *compiler = getenv("CC");
+	return compiler == NULL || compiler[0] == '\0' ? KERNEL_COMPILER : compiler;
+}
+
+/**
+ * @brief Prints an operand of an instruction of a program, as a C expression.
+ *
+ * Operations are the locals holding their results, while constants are inlined exactly.
+ */
+static void kernel_print_operand(FILE *file, const struct program *program, size_t instruction) {
+	assert(file != NULL && program != NULL && instruction < program->instructions_count);
+
+	const struct instruction *operand = &program->instructions[instruction];
+	switch (operand->type) {
+		case expression_type_constant: {
+			double value = operand->constant;
+			if (isnan(value)) {
+				(void)fprintf(file, "NAN");
+			} else if (isinf(value)) {
+				(void)fprintf(file, value < 0 ? "(-INFINITY)" : "INFINITY");
+			} else if (signbit(value)) {
+				(void)fprintf(file, "(%a)", value);
+			} else {
+				(void)fprintf(file, "%a", value);
+			}
+		} break;
+		case expression_type_variable:
+			(void)fprintf(file, operand->variable == 'i' ? "i" : "NAN");
+			break;
+		case expression_type_operation: (void)fprintf(file, "v%zu", instruction); break;
+	}
+}
+
+/**
+ * @brief Prints the C expression computing an operation of a program.
+ */
+static void kernel_print_operation(
+	FILE *file,
+	const struct program *program,
+	const struct instruction *instruction
+) {
+	assert(file != NULL && program != NULL && instruction != NULL);
+	assert(instruction->type == expression_type_operation);
+
+	enum operation_type type = instruction->operation.type;
+	const size_t *operands = instruction->operation.operands;
+
+	// the infix operators and the comparisons, which compute 0 or 1
+	const char *symbol = NULL;
+	switch (type) {
+		case operation_type_addition: symbol = "+"; break;
+		case operation_type_subtraction: symbol = "-"; break;
+		case operation_type_multiplication: symbol = "*"; break;
+		case operation_type_division: symbol = "/"; break;
+		case operation_type_less: symbol = "<"; break;
+		case operation_type_less_equal: symbol = "<="; break;
+		case operation_type_greater: symbol = ">"; break;
+		case operation_type_greater_equal: symbol = ">="; break;
+		case operation_type_equal: symbol = "=="; break;
+		case operation_type_not_equal: symbol = "!="; break;
+		default: break;
+	}
+	bool is_comparison = type >= operation_type_less && type <= operation_type_not_equal;
+
+	if (symbol != NULL) {
+		(void)fprintf(file, is_comparison ? "(double)(" : "");
+		kernel_print_operand(file, program, operands[0]);
+		(void)fprintf(file, " %s ", symbol);
+		kernel_print_operand(file, program, operands[1]);
+		(void)fprintf(file, is_comparison ? ")" : "");
+		return;
+	}
+
+	// the functions of the C library, and the selections
+	const char *function = NULL;
+	switch (type) {
+		case operation_type_exponentiation: function = "pow"; break;
+		case operation_type_sine: function = "sin"; break;
+		case operation_type_cosine: function = "cos"; break;
+		case operation_type_tangent: function = "tan"; break;
+		case operation_type_exponential: function = "exp"; break;
+		case operation_type_logarithm: function = "log"; break;
+		case operation_type_gamma: function = "tgamma"; break;
+		case operation_type_absolute_value: function = "fabs"; break;
+		case operation_type_floor: function = "floor"; break;
+		case operation_type_ceiling: function = "ceil"; break;
+		case operation_type_negation: {
+			(void)fprintf(file, "-");
+			kernel_print_operand(file, program, operands[0]);
+			return;
+		}
+		case operation_type_factorial: {
+			(void)fprintf(file, "tgamma(");
+			kernel_print_operand(file, program, operands[0]);
+			(void)fprintf(file, " + 1)");
+			return;
+		}
+		case operation_type_minimum:
+		case operation_type_maximum: {
+			kernel_print_operand(file, program, operands[0]);
+			(void)fprintf(file, type == operation_type_minimum ? " < " : " > ");
+			kernel_print_operand(file, program, operands[1]);
+			(void)fprintf(file, " ? ");
+			kernel_print_operand(file, program, operands[0]);
+			(void)fprintf(file, " : ");
+			kernel_print_operand(file, program, operands[1]);
+			return;
+		}
+		case operation_type_conditional: {
+			kernel_print_operand(file, program, operands[0]);
+			(void)fprintf(file, " != 0 ? ");
+			kernel_print_operand(file, program, operands[1]);
+			(void)fprintf(file, " : ");
+			kernel_print_operand(file, program, operands[2]);
+			return;
+		}
+		default: break;
+	}
+
+	// the others are evaluated by the caller, which computes them the same way as other engines
+	size_t arity = operation_type_arity(type);
+	if (function != NULL) {
+		(void)fprintf(file, "%s(", function);
+	} else {
+		(void)fprintf(file, "operation(%u, (const double[]){ ", (unsigned)type);
+	}
+	for (size_t i = 0; i < arity; i++) {
+		(void)fprintf(file, i == 0 ? "" : ", ");
+		kernel_print_operand(file, program, operands[i]);
+	}
+	(void)fprintf(file, function != NULL ? ")" : " })");
+}
+
+char *kernel_source(const struct program *program) {
+	assert(program != NULL);
+
+	char *source = NULL;
+	size_t size = 0;
+	FILE *file = open_memstream(&source, &size);
+	if (file == NULL) {
+		return NULL;
+	}
+
+	(void)fprintf(
+		file,
+		"#include <math.h>\n"
+		"\n"
+		"typedef double (*kernel_operation_function)(unsigned type, const double operands[]);\n"
+		"\n"
+		"void " KERNEL_SYMBOL "(\n"
+		"\tlong lower_bound,\n"
+		"\tlong upper_bound,\n"
+		"\tdouble sums[],\n"
+		"\tkernel_operation_function operation\n"
+		") {\n"
+		"\t(void)operation;\n"
+		"\tif (lower_bound > upper_bound) {\n"
+		"\t\treturn;\n"
+		"\t}\n"
+		"\n"
+	);
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		(void)fprintf(file, "\tdouble sum_%zu = sums[%zu];\n", i, i);
+	}
+
+	(void)fprintf(
+		file,
+		"\n"
+		"\tunsigned long length = (unsigned long)upper_bound - (unsigned long)lower_bound + 1;\n"
+		"\tfor (unsigned long offset = 0; offset < length; offset++) {\n"
+		"\t\tconst double i = (double)(lower_bound + (long)offset);\n"
+		"\t\t(void)i;\n"
+	);
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		const struct instruction *instruction = &program->instructions[i];
+		if (instruction->type == expression_type_operation) {
+			(void)fprintf(file, "\t\tconst double v%zu = ", i);
+			kernel_print_operation(file, program, instruction);
+			(void)fprintf(file, ";\n");
+		}
+	}
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		(void)fprintf(file, "\t\tsum_%zu += ", i);
+		kernel_print_operand(file, program, program->outputs[i]);
+		(void)fprintf(file, ";\n");
+	}
+	(void)fprintf(file, "\t}\n\n");
+
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		(void)fprintf(file, "\tsums[%zu] = sum_%zu;\n", i, i);
+	}
+	(void)fprintf(file, "}\n");
+
+	if (ferror(file)) {
+		(void)fclose(file);
+		free(source);
+		return NULL;
+	}
+	(void)fclose(file);
+
+	return source;
+}
+
+/**
+ * @brief Compiles the source of a kernel into a shared object at `path`.
+ *
+ * Writes the source and the shared object next to `path` first, and renames the shared object
+ * into place once it's complete, so that other processes never load a partial one.
+ */
+static int kernel_compile(const char *source, const char *path) {
+	assert(source != NULL && path != NULL);
+
+	size_t path_length = strlen(path);
+	char *source_path = malloc(path_length + 32);
+	char *temporary_path = malloc(path_length + 32);
+	(void)snprintf(source_path, path_length + 32, "%s.%ld.c", path, (long)getpid());
+	(void)snprintf(temporary_path, path_length + 32, "%s.%ld.tmp", path, (long)getpid());
+
+	int status = EXIT_FAILURE;
+	FILE *file = fopen(source_path, "w");
+	if (file != NULL) {
+		bool is_written = fputs(source, file) >= 0;
+		is_written = fclose(file) == 0 && is_written;
+
+		const char *compiler = kernel_compiler();
+		pid_t process = is_written ? fork() : -1;
+		if (process == 0) {
+			(void)execlp(
+				compiler,
+				compiler,
+				KERNEL_FLAGS,
+				"-o",
+				temporary_path,
+				source_path,
+				"-lm",
+				(char *)NULL
+			);
+			_exit(EXIT_FAILURE);
+		}
+
+		int process_status = 0;
+		if (process > 0) {
+			while (waitpid(process, &process_status, 0) < 0 && errno == EINTR) {
+			}
+			if (WIFEXITED(process_status) && WEXITSTATUS(process_status) == 0 &&
+				rename(temporary_path, path) == 0) {
+				status = EXIT_SUCCESS;
+			}
+		}
+	}
+
+	(void)unlink(temporary_path);
+	(void)unlink(source_path);
+	free(temporary_path);
+	free(source_path);
+
+	return status;
+}
+
+/**
+ * @brief Loads the shared object of a kernel.
+ */
+static int kernel_load(struct kernel *kernel, const char *path) {
+	assert(kernel != NULL && path != NULL);
+
+	void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (handle == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	// POSIX guarantees that the symbol's address converts to a function pointer
+	void *symbol = dlsym(handle, KERNEL_SYMBOL);
+	if (symbol == NULL) {
+		(void)dlclose(handle);
+		return EXIT_FAILURE;
+	}
+
+	kernel->handle = handle;
+	memcpy(&kernel->function, &symbol, sizeof(kernel->function));
+
+	return EXIT_SUCCESS;
+}
+
+int kernel_new(struct kernel *kernel, const struct program *program, const char *cache_directory) {
+	assert(kernel != NULL && program != NULL);
+
+	char *source = kernel_source(program);
+	if (source == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	int status = EXIT_FAILURE;
+	if (cache_directory != NULL) {
+		// shared objects compiled by other compilers, with other options or from the sources of
+		// other versions aren't reused
+		static const char *const flags[] = { KERNEL_FLAGS };
+		const char *compiler = kernel_compiler();
+		uint64_t key = cache_hash(CACHE_HASH_INITIAL, KERNEL_MAGIC, sizeof(KERNEL_MAGIC));
+		key = cache_hash(key, compiler, strlen(compiler) + 1);
+		for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+			key = cache_hash(key, flags[i], strlen(flags[i]) + 1);
+		}
+		key = cache_hash(key, source, strlen(source));
+		char *path = cache_path(cache_directory, key, "so");
+		if (path != NULL) {
+			status = kernel_load(kernel, path);
+			if (status == EXIT_FAILURE && kernel_compile(source, path) == EXIT_SUCCESS) {
+				status = kernel_load(kernel, path);
+			}
+			free(path);
+		}
+	} else {
+		// the shared object stays mapped once loaded, so its file is only needed until then
+		const char *directory = getenv("TMPDIR");
+		if (directory == NULL || directory[0] == '\0') {
+			directory = "/tmp";
+		}
+
+		size_t path_size = strlen(directory) + sizeof("/summation_kernel_XXXXXX");
+		char *path = malloc(path_size);
+		(void)snprintf(path, path_size, "%s/summation_kernel_XXXXXX", directory);
+		int file = mkstemp(path);
+		if (file >= 0) {
+			(void)close(file);
+			if (kernel_compile(source, path) == EXIT_SUCCESS) {
+				status = kernel_load(kernel, path);
+			}
+			(void)unlink(path);
+		}
+		free(path);
+	}
+
+	free(source);
+
+	return status;
+}
+
+void kernel_drop(struct kernel *kernel) {
+	assert(kernel != NULL);
+
+	(void)dlclose(kernel->handle);
+}
+
+/**
+ * @brief Evaluates an operation without a counterpart in C for a kernel.
+ */
+static double kernel_operation(unsigned type, const double operands[]) {
+	return operation_type_evaluate((enum operation_type)type, operands);
+}
+
+void kernel_run(const struct kernel *kernel, long lower_bound, long upper_bound, double sums[]) {
+	assert(kernel != NULL);
+
+	kernel->function(lower_bound, upper_bound, sums, kernel_operation);
+}
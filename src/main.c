@@ -1,11 +1,26 @@
+#include <column.h>
+#include <distributed.h>
 #include <errno.h>
+#include <estimate.h>
+#include <getopt.h>
+#include <gradient.h>
 #include <inttypes.h>
+#include <kernel.h>
+#include <math.h>
+#include <prefix_table.h>
+#include <product.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <summation.h>
+#include <sweep.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #define DEFAULT_BASE 10
+#define DEFAULT_SHARDS_COUNT 64
+#define PORT_MAXIMUM 65535
 
 /**
  * @brief Converts a string to a long int
@@ -19,6 +34,7 @@
 static inline int string_to_long(const char *string, long *result) {
 	assert(string != NULL && result != NULL);
 
+	errno = 0;
 	char *end = NULL;
 	long value = strtol(string, &end, DEFAULT_BASE);
 	if (end == string) {
@@ -44,23 +60,858 @@ static inline int string_to_long(const char *string, long *result) {
 	return EXIT_SUCCESS;
 }
 
+/**
+ * @brief Converts a string to a double
+ *
+ * Parses the string `string` into a double and stores it into `result`.
+ *
+ * @param[in] string The string to be parsed
+ * @param[out] result Pointer to the double to store the result
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error
+ */
+static inline int string_to_double(const char *string, double *result) {
+	assert(string != NULL && result != NULL);
+
+	errno = 0;
+	char *end = NULL;
+	double value = strtod(string, &end);
+	if (end == string) {
+		(void)fprintf(stderr, "Error: Failed to parse a number from \"%s\"\n", string);
+		return EXIT_FAILURE;
+	}
+
+	while (isspace(*end)) {
+		++end;
+	}
+	if (*end != '\0') {
+		(void)fprintf(stderr, "Error: Trailing characters after number \"%s\"\n", end);
+		return EXIT_FAILURE;
+	}
+
+	if (errno == ERANGE || !isfinite(value)) {
+		(void)fprintf(stderr, "Error: Number is out of the representable range \"%s\"\n", string);
+		return EXIT_FAILURE;
+	}
+
+	*result = value;
+
+	return EXIT_SUCCESS;
+}
+
+static void print_usage(const char *program) {
+	(void)fprintf(
+		stderr,
+		"Usage: %s [OPTIONS] LOWER_BOUND UPPER_BOUND SUMMAND...\n"
+		"       %s --load FILE\n"
+		"       %s --worker HOST:PORT\n"
+		"       %s --sweep VARIABLE=VALUES LOWER_BOUND UPPER_BOUND SUMMAND...\n"
+		"       %s --gradient VARIABLE=VALUE... LOWER_BOUND UPPER_BOUND SUMMAND...\n"
+		"       %s --column VARIABLE=FILE... SUMMAND...\n"
+		"       %s --csv-to-column FIELD [--csv-header] FILE < CSV\n"
+		"       %s --emit-c SUMMAND...\n"
+		"\n"
+		"Options:\n"
+		"  -p, --product         Evaluate the products of the summands instead of their sums\n"
+		"  -a, --approximate     Estimate the sums by sampling, with 95%% confidence intervals\n"
+		"      --seconds S       Refine the estimates for S seconds at most (default: 0.01)\n"
+		"      --relative-error E  Refine the estimates until within E of the sums\n"
+		"                        (default: 0.001)\n"
+		"  -q, --query           Answer summations over sub-ranges read from stdin\n"
+		"  -b, --block-size N    Store only every N-th prefix sum of the query table\n"
+		"  -s, --save FILE       Save the query table to FILE\n"
+		"  -l, --load FILE       Answer queries from the table saved in FILE\n"
+		"  -t, --threads N       Evaluate the summations on N threads (default: one per processor)\n"
+		"  -e, --engine ENGINE   Evaluate the terms with ENGINE: automatic, scalar, block,\n"
+		"                        recurrence or native (default: automatic)\n"
+		"      --explain         Print how the summations would be evaluated, instead of evaluating\n"
+		"                        them\n"
+		"  -c, --cache-dir DIR   Cache compiled summands in DIR (default: $SUMMATION_CACHE_DIR)\n"
+		"      --segment-cache SIZE  Cache partial sums of each summand in DIR, in SIZE bytes\n"
+		"      --coordinator [HOST:]PORT  Distribute the summations to workers connecting to\n"
+		"                        PORT of the address HOST (default: 127.0.0.1)\n"
+		"      --shards N        Split the range into N shards for the workers (default: 64)\n"
+		"      --spawn N         Spawn N local workers for the coordinator\n"
+		"      --worker HOST:PORT  Evaluate shards for the coordinator at HOST:PORT\n"
+		"      --column VARIABLE=FILE  Sum over the rows of the column of doubles in FILE, bound\n"
+		"                        to VARIABLE, with the index of the row bound to i\n"
+		"      --csv-to-column FIELD FILE  Write the FIELD-th field of the CSV read from stdin,\n"
+		"                        counting from 0, to the column FILE, with missing or empty\n"
+		"                        fields as NaN\n"
+		"      --csv-header      Skip the first line of the CSV, its header\n"
+		"      --sweep VARIABLE=VALUES  Evaluate the summations for each value of VARIABLE, given\n"
+		"                        as START:STOP:COUNT or VALUE,VALUE,...\n"
+		"      --gradient VARIABLE=VALUE  Bind VALUE to VARIABLE, and print the derivatives\n"
+		"                        of the sums with respect to it after each sum\n"
+		"      --statistics      Print the sum, minimum and its index, maximum and its index,\n"
+		"                        mean, variance, number of non-finite terms, and L1 and L2\n"
+		"                        norms of the terms of each summand\n"
+		"      --emit-c          Print the C source of the native kernel of the summands\n"
+		"  -h, --help            Print this help\n",
+		program,
+		program,
+		program,
+		program,
+		program,
+		program,
+		program,
+		program
+	);
+}
+
+/**
+ * @brief Answers queries from a prefix table
+ *
+ * Reads queries of the form "LOWER_BOUND UPPER_BOUND" from stdin, one per line, and prints the
+ * total of the summation over each of them.
+ *
+ * @param[in] table The table to be queried
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error
+ */
+static int answer_queries(const struct prefix_table *table) {
+	assert(table != NULL);
+
+	char line[BUFSIZ];
+	while (fgets(line, sizeof(line), stdin) != NULL) {
+		long lower_bound = 0;
+		long upper_bound = 0;
+		if (sscanf(line, "%ld %ld", &lower_bound, &upper_bound) != 2) {
+			line[strcspn(line, "\n")] = '\0';
+			(void)fprintf(stderr, "Error: Invalid query \"%s\"\n", line);
+			continue;
+		}
+
+		printf("%lg\n", prefix_table_query(table, lower_bound, upper_bound));
+		(void)fflush(stdout);
+	}
+
+	return ferror(stdin) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * @brief Prints a product
+ *
+ * Products out of the range of doubles are printed in scientific notation from their logarithms,
+ * with exponents of any size.
+ *
+ * @param[in] product The product to be printed
+ */
+static void print_product(const struct product *product) {
+	assert(product != NULL);
+
+	double value = product_value(product);
+	if (fpclassify(value) == FP_NORMAL || fpclassify(product->sign) == FP_ZERO ||
+		!isfinite(product->logarithm)) {
+		printf("%lg\n", value);
+		return;
+	}
+
+	double logarithm = product->logarithm / log(DEFAULT_BASE);
+	double exponent = floor(logarithm);
+	printf("%lge%+.0lf\n", product->sign * pow(DEFAULT_BASE, logarithm - exponent), exponent);
+}
+
+/**
+ * @brief Evaluates summations over the rows of columns, and prints their totals
+ */
+static int run_columns(
+	size_t columns_count,
+	const char variables[],
+	const char *const paths[],
+	size_t count,
+	const char *const summands[],
+	const struct summation_options *options
+) {
+	struct column columns[VARIABLES_COUNT];
+	int status = EXIT_SUCCESS;
+	size_t mapped_count = 0;
+	while (status == EXIT_SUCCESS && mapped_count < columns_count) {
+		status = column_map(&columns[mapped_count], variables[mapped_count], paths[mapped_count]);
+		mapped_count += status == EXIT_SUCCESS;
+	}
+
+	double *sums = malloc(count * sizeof(*sums));
+	if (status == EXIT_SUCCESS) {
+		status = column_summation_fused(columns_count, columns, count, summands, sums, options);
+	}
+	for (size_t i = 0; status == EXIT_SUCCESS && i < count; i++) {
+		printf("%lg\n", sums[i]);
+	}
+
+	free(sums);
+	for (size_t i = 0; i < mapped_count; i++) {
+		column_unmap(&columns[i]);
+	}
+
+	return status;
+}
+
+/**
+ * @brief Evaluates summations for each value of a parameter, and prints each value followed by
+ * the totals of the summations for it
+ */
+static int run_sweep(
+	const char *string,
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	const struct summation_options *options
+) {
+	struct sweep sweep;
+	if (sweep_parse(&sweep, string) == EXIT_FAILURE) {
+		return EXIT_FAILURE;
+	}
+
+	double *sums = malloc(sweep.values_count * count * sizeof(*sums));
+	sweep_summation_fused(lower_bound, upper_bound, &sweep, count, summands, sums, options);
+	for (size_t i = 0; i < sweep.values_count; i++) {
+		printf("%lg", sweep.values[i]);
+		for (size_t j = 0; j < count; j++) {
+			printf(" %lg", sums[i * count + j]);
+		}
+		printf("\n");
+	}
+
+	free(sums);
+	sweep_drop(&sweep);
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Reduces the terms of summations in one pass, and prints the statistics of each summation
+ */
+static int run_statistics(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	const struct summation_options *options
+) {
+	struct reduction *reductions = malloc(count * sizeof(*reductions));
+	if (reductions == NULL) {
+		(void)fprintf(stderr, "Error: Failed to allocate memory\n");
+		return EXIT_FAILURE;
+	}
+
+	summation_reduce_fused(lower_bound, upper_bound, count, summands, reductions, options);
+	for (size_t i = 0; i < count; i++) {
+		const struct reduction *reduction = &reductions[i];
+		printf(
+			"%lg %lg %ld %lg %ld %lg %lg %lu %lg %lg\n",
+			reduction->sum,
+			reduction->minimum,
+			reduction->minimum_index,
+			reduction->maximum,
+			reduction->maximum_index,
+			reduction->count == reduction->non_finite_count ? NAN : reduction->mean,
+			reduction_variance(reduction),
+			reduction->non_finite_count,
+			reduction->absolute_sum,
+			reduction_l2_norm(reduction)
+		);
+	}
+
+	free(reductions);
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Evaluates summations for values of some variables, and prints the total of each
+ * summation followed by its derivatives with respect to these variables
+ */
+static int run_gradient(
+	size_t variables_count,
+	const char variables[],
+	const double values[],
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	const struct summation_options *options
+) {
+	struct environment environment = environment_new();
+	for (size_t i = 0; i < variables_count; i++) {
+		environment_set_variable(&environment, variables[i], values[i]);
+	}
+
+	double *sums = malloc(count * sizeof(*sums));
+	double *gradients = malloc(count * variables_count * sizeof(*gradients));
+	if (sums == NULL || gradients == NULL) {
+		(void)fprintf(stderr, "Error: Failed to allocate memory\n");
+		free(gradients);
+		free(sums);
+		return EXIT_FAILURE;
+	}
+
+	gradient_summation_fused(
+		lower_bound,
+		upper_bound,
+		&environment,
+		variables_count,
+		variables,
+		count,
+		summands,
+		sums,
+		gradients,
+		options
+	);
+	for (size_t i = 0; i < count; i++) {
+		printf("%lg", sums[i]);
+		for (size_t j = 0; j < variables_count; j++) {
+			printf(" %lg", gradients[i * variables_count + j]);
+		}
+		printf("\n");
+	}
+
+	free(gradients);
+	free(sums);
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Prints the C source of the kernel summing the summands
+ */
+static int emit_c(size_t count, const char *const summands[]) {
+	assert(summands != NULL);
+
+	struct environment environment = environment_new();
+	struct expression *expressions = malloc(count * sizeof(*expressions));
+	if (expressions == NULL) {
+		(void)fprintf(stderr, "Error: Failed to allocate memory\n");
+		return EXIT_FAILURE;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		expressions[i] = expression_from_string(summands[i]);
+		expression_simplify(&expressions[i], &environment);
+	}
+
+	struct program program = program_new(count, expressions);
+
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+	free(expressions);
+
+	char *source = kernel_source(&program);
+	program_drop(&program);
+	if (source == NULL) {
+		(void)fprintf(stderr, "Error: Failed to generate the kernel\n");
+		return EXIT_FAILURE;
+	}
+
+	(void)fputs(source, stdout);
+	free(source);
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Parses a port number
+ *
+ * @param[in] string The string to be parsed
+ * @param[out] port Pointer to the port to store the result
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE on error
+ */
+static int string_to_port(const char *string, uint16_t *port) {
+	assert(string != NULL && port != NULL);
+
+	long value = 0;
+	if (string_to_long(string, &value) == EXIT_FAILURE || value < 0 || value > PORT_MAXIMUM) {
+		(void)fprintf(stderr, "Error: Invalid port \"%s\"\n", string);
+		return EXIT_FAILURE;
+	}
+
+	*port = (uint16_t)value;
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Runs a worker for the coordinator at `address`, of the form HOST:PORT
+ */
+static int run_worker(const char *address, const struct summation_options *options) {
+	assert(address != NULL);
+
+	const char *separator = strrchr(address, ':');
+	if (separator == NULL) {
+		(void)fprintf(stderr, "Error: Invalid coordinator address \"%s\"\n", address);
+		return EXIT_FAILURE;
+	}
+
+	uint16_t port = 0;
+	if (string_to_port(separator + 1, &port) == EXIT_FAILURE) {
+		return EXIT_FAILURE;
+	}
+
+	char *host = strndup(address, (size_t)(separator - address));
+	int status = worker_run(host, port, options);
+	free(host);
+
+	return status;
+}
+
+/**
+ * @brief Distributes summations to workers connecting to `address`, of the form [HOST:]PORT,
+ * spawning `spawn_count` local ones
+ */
+static int run_coordinator(
+	const char *address,
+	size_t spawn_count,
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	size_t shards_count,
+	double sums[],
+	const struct summation_options *options
+) {
+	assert(address != NULL);
+
+	const char *separator = strrchr(address, ':');
+	uint16_t port = 0;
+	if (string_to_port(separator != NULL ? separator + 1 : address, &port) == EXIT_FAILURE) {
+		return EXIT_FAILURE;
+	}
+
+	char *host = separator != NULL ? strndup(address, (size_t)(separator - address)) : NULL;
+	struct coordinator coordinator;
+	int status = coordinator_open(&coordinator, host, port);
+	free(host);
+	if (status == EXIT_FAILURE) {
+		return EXIT_FAILURE;
+	}
+	(void)fprintf(stderr, "Coordinator listening on port %" PRIu16 "\n", coordinator.port);
+
+	for (size_t i = 0; i < spawn_count; i++) {
+		pid_t worker = fork();
+		if (worker == 0) {
+			coordinator_close(&coordinator);
+			_exit(worker_run("127.0.0.1", coordinator.port, options));
+		}
+		if (worker < 0) {
+			(void)fprintf(stderr, "Warning: Failed to spawn a worker\n");
+		}
+	}
+
+	status = coordinator_run(
+		&coordinator,
+		lower_bound,
+		upper_bound,
+		count,
+		summands,
+		shards_count,
+		sums,
+		options
+	);
+
+	coordinator_close(&coordinator);
+
+	while (wait(NULL) > 0) {
+	}
+
+	return status;
+}
+
 int main(int argc, char *argv[]) {
-	if (argc != 4) {
-		(void)fprintf(stderr, "Usage: %s LOWER_BOUND UPPER_BOUND SUMMAND\n", argv[0]);
+	bool is_product = false;
+	bool is_approximate = false;
+	struct estimate_options estimate_options = estimate_options_default();
+	bool query = false;
+	long block_size = 1;
+	const char *save_path = NULL;
+	const char *load_path = NULL;
+	const char *worker_address = NULL;
+	bool explain = false;
+	bool is_emit_c = false;
+	bool is_coordinator = false;
+	const char *coordinator_address = NULL;
+	long shards_count = DEFAULT_SHARDS_COUNT;
+	long spawn_count = 0;
+	size_t columns_count = 0;
+	char column_variables[VARIABLES_COUNT];
+	const char *column_paths[VARIABLES_COUNT];
+	long csv_field = -1;
+	bool has_csv_header = false;
+	const char *sweep = NULL;
+	size_t gradient_count = 0;
+	char gradient_variables[VARIABLES_COUNT];
+	double gradient_values[VARIABLES_COUNT];
+	bool is_statistics = false;
+
+	struct summation_options summation_options = summation_options_default();
+	summation_options.cache_directory = getenv("SUMMATION_CACHE_DIR");
+
+	static const struct option options[] = {
+		{ "product", no_argument, NULL, 'p' },
+		{ "approximate", no_argument, NULL, 'a' },
+		{ "seconds", required_argument, NULL, 'T' },
+		{ "relative-error", required_argument, NULL, 'R' },
+		{ "query", no_argument, NULL, 'q' },
+		{ "block-size", required_argument, NULL, 'b' },
+		{ "save", required_argument, NULL, 's' },
+		{ "load", required_argument, NULL, 'l' },
+		{ "threads", required_argument, NULL, 't' },
+		{ "engine", required_argument, NULL, 'e' },
+		{ "cache-dir", required_argument, NULL, 'c' },
+		{ "segment-cache", required_argument, NULL, 'G' },
+		{ "explain", no_argument, NULL, 'E' },
+		{ "emit-c", no_argument, NULL, 'X' },
+		{ "coordinator", required_argument, NULL, 'C' },
+		{ "shards", required_argument, NULL, 'S' },
+		{ "spawn", required_argument, NULL, 'P' },
+		{ "worker", required_argument, NULL, 'W' },
+		{ "column", required_argument, NULL, 'K' },
+		{ "csv-to-column", required_argument, NULL, 'V' },
+		{ "csv-header", no_argument, NULL, 'H' },
+		{ "sweep", required_argument, NULL, 'Y' },
+		{ "gradient", required_argument, NULL, 'D' },
+		{ "statistics", no_argument, NULL, 'Z' },
+		{ "help", no_argument, NULL, 'h' },
+		{ NULL, 0, NULL, 0 },
+	};
+
+	// negative bounds end the options instead of being mistaken for them
+	int option = 0;
+	while ((optind >= argc || argv[optind][0] != '-' || !isdigit(argv[optind][1])) &&
+		   (option = getopt_long(argc, argv, "+paqb:s:l:t:e:c:h", options, NULL)) != -1) {
+		switch (option) {
+			case 'p': is_product = true; break;
+			case 'a': is_approximate = true; break;
+			case 'T': {
+				if (string_to_double(optarg, &estimate_options.seconds) == EXIT_FAILURE ||
+					estimate_options.seconds < 0) {
+					(void)fprintf(stderr, "Error: Invalid time budget \"%s\"\n", optarg);
+					return EXIT_FAILURE;
+				}
+			} break;
+			case 'R': {
+				if (string_to_double(optarg, &estimate_options.relative_error) == EXIT_FAILURE ||
+					estimate_options.relative_error < 0) {
+					(void)fprintf(stderr, "Error: Invalid error budget \"%s\"\n", optarg);
+					return EXIT_FAILURE;
+				}
+			} break;
+			case 'q': query = true; break;
+			case 'b': {
+				if (string_to_long(optarg, &block_size) == EXIT_FAILURE || block_size <= 0) {
+					(void)fprintf(stderr, "Error: Invalid block size \"%s\"\n", optarg);
+					return EXIT_FAILURE;
+				}
+			} break;
+			case 's': save_path = optarg; break;
+			case 'l': load_path = optarg; break;
+			case 't': {
+				long threads_count = 0;
+				if (string_to_long(optarg, &threads_count) == EXIT_FAILURE || threads_count <= 0) {
+					(void)fprintf(stderr, "Error: Invalid number of threads \"%s\"\n", optarg);
+					return EXIT_FAILURE;
+				}
+				summation_options.threads_count = (size_t)threads_count;
+			} break;
+			case 'e': {
+				size_t engine = 0;
+				while (engine < SUMMATION_ENGINES_COUNT &&
+					   strcmp(optarg, summation_engine_name((enum summation_engine)engine)) != 0) {
+					++engine;
+				}
+				if (engine == SUMMATION_ENGINES_COUNT) {
+					(void)fprintf(stderr, "Error: Unknown engine \"%s\"\n", optarg);
+					return EXIT_FAILURE;
+				}
+				summation_options.engine = (enum summation_engine)engine;
+			} break;
+			case 'c': summation_options.cache_directory = optarg; break;
+			case 'G': {
+				long size = 0;
+				if (string_to_long(optarg, &size) == EXIT_FAILURE || size <= 0) {
+					(void)fprintf(stderr, "Error: Invalid segment cache size \"%s\"\n", optarg);
+					return EXIT_FAILURE;
+				}
+				summation_options.segment_cache_size = (size_t)size;
+			} break;
+			case 'E': explain = true; break;
+			case 'X': is_emit_c = true; break;
+			case 'C': {
+				is_coordinator = true;
+				coordinator_address = optarg;
+			} break;
+			case 'S': {
+				if (string_to_long(optarg, &shards_count) == EXIT_FAILURE || shards_count <= 0) {
+					(void)fprintf(stderr, "Error: Invalid number of shards \"%s\"\n", optarg);
+					return EXIT_FAILURE;
+				}
+			} break;
+			case 'P': {
+				if (string_to_long(optarg, &spawn_count) == EXIT_FAILURE || spawn_count < 0) {
+					(void)fprintf(stderr, "Error: Invalid number of workers \"%s\"\n", optarg);
+					return EXIT_FAILURE;
+				}
+			} break;
+			case 'W': worker_address = optarg; break;
+			case 'K': {
+				if (!isalpha((unsigned char)optarg[0]) || optarg[1] != '=' ||
+					columns_count == VARIABLES_COUNT) {
+					(void)fprintf(stderr, "Error: Invalid column \"%s\"\n", optarg);
+					return EXIT_FAILURE;
+				}
+				column_variables[columns_count] = optarg[0];
+				column_paths[columns_count++] = &optarg[2];
+			} break;
+			case 'V': {
+				if (string_to_long(optarg, &csv_field) == EXIT_FAILURE || csv_field < 0) {
+					(void)fprintf(stderr, "Error: Invalid field \"%s\"\n", optarg);
+					return EXIT_FAILURE;
+				}
+			} break;
+			case 'H': has_csv_header = true; break;
+			case 'Y': sweep = optarg; break;
+			case 'D': {
+				if (!isalpha((unsigned char)optarg[0]) || optarg[0] == 'i' || optarg[1] != '=' ||
+					gradient_count == VARIABLES_COUNT ||
+					string_to_double(&optarg[2], &gradient_values[gradient_count]) ==
+						EXIT_FAILURE) {
+					(void)fprintf(stderr, "Error: Invalid gradient variable \"%s\"\n", optarg);
+					return EXIT_FAILURE;
+				}
+				gradient_variables[gradient_count++] = optarg[0];
+			} break;
+			case 'Z': is_statistics = true; break;
+			case 'h': print_usage(argv[0]); return EXIT_SUCCESS;
+			default: print_usage(argv[0]); return EXIT_FAILURE;
+		}
+	}
+
+	if (summation_options.segment_cache_size != 0 && summation_options.cache_directory == NULL) {
+		(void)fprintf(stderr, "Error: The segment cache needs a cache directory\n");
+		return EXIT_FAILURE;
+	}
+
+	if (worker_address != NULL) {
+		if (optind != argc) {
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+
+		return run_worker(worker_address, &summation_options);
+	}
+
+	if (is_emit_c) {
+		if (optind == argc) {
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+
+		return emit_c((size_t)(argc - optind), (const char *const *)&argv[optind]);
+	}
+
+	if (csv_field >= 0) {
+		if (argc - optind != 1) {
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+
+		return column_from_csv(stdin, (size_t)csv_field, has_csv_header, argv[optind]);
+	}
+
+	// the rows of columns take the place of the range
+	if (columns_count != 0) {
+		if (optind == argc || is_product || query || is_approximate || is_coordinator || explain ||
+			sweep != NULL || gradient_count != 0 || is_statistics) {
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+
+		return run_columns(
+			columns_count,
+			column_variables,
+			column_paths,
+			(size_t)(argc - optind),
+			(const char *const *)&argv[optind],
+			&summation_options
+		);
+	}
+
+	if (load_path != NULL) {
+		if (optind != argc) {
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+
+		struct prefix_table table;
+		if (prefix_table_load(&table, load_path) == EXIT_FAILURE) {
+			return EXIT_FAILURE;
+		}
+
+		int status = answer_queries(&table);
+
+		prefix_table_drop(&table);
+
+		return status;
+	}
+
+	// estimates are evaluated locally, of sums only
+	bool is_exclusive = is_product || is_coordinator || explain;
+	if (argc - optind < 3 || (query && (argc - optind != 3 || is_product || is_approximate)) ||
+		(is_approximate && is_exclusive) ||
+		(sweep != NULL && (is_exclusive || query || is_approximate)) ||
+		(gradient_count != 0 && (is_exclusive || query || is_approximate || sweep != NULL)) ||
+		(is_statistics && (is_exclusive || query || is_approximate || sweep != NULL ||
+						   gradient_count != 0))) {
+		print_usage(argv[0]);
 		return EXIT_FAILURE;
 	}
 
 	long lower_bound = 0;
-	if (string_to_long(argv[1], &lower_bound) == EXIT_FAILURE) {
-		(void)fprintf(stderr, "Error: Invalid lower bound \"%s\"\n", argv[1]);
+	if (string_to_long(argv[optind], &lower_bound) == EXIT_FAILURE) {
+		(void)fprintf(stderr, "Error: Invalid lower bound \"%s\"\n", argv[optind]);
 		return EXIT_FAILURE;
 	}
 
 	long upper_bound = 0;
-	if (string_to_long(argv[2], &upper_bound) == EXIT_FAILURE) {
-		(void)fprintf(stderr, "Error: Invalid upper bound \"%s\"\n", argv[2]);
+	if (string_to_long(argv[optind + 1], &upper_bound) == EXIT_FAILURE) {
+		(void)fprintf(stderr, "Error: Invalid upper bound \"%s\"\n", argv[optind + 1]);
 		return EXIT_FAILURE;
 	}
 
-	printf("%lg\n", summation(lower_bound, upper_bound, argv[3]));
+	if (sweep != NULL) {
+		return run_sweep(
+			sweep,
+			lower_bound,
+			upper_bound,
+			(size_t)(argc - optind - 2),
+			(const char *const *)&argv[optind + 2],
+			&summation_options
+		);
+	}
+
+	if (gradient_count != 0) {
+		return run_gradient(
+			gradient_count,
+			gradient_variables,
+			gradient_values,
+			lower_bound,
+			upper_bound,
+			(size_t)(argc - optind - 2),
+			(const char *const *)&argv[optind + 2],
+			&summation_options
+		);
+	}
+
+	if (is_statistics) {
+		return run_statistics(
+			lower_bound,
+			upper_bound,
+			(size_t)(argc - optind - 2),
+			(const char *const *)&argv[optind + 2],
+			&summation_options
+		);
+	}
+
+	if (query) {
+		if (lower_bound > upper_bound) {
+			(void)fprintf(stderr, "Error: The query table's range is empty\n");
+			return EXIT_FAILURE;
+		}
+
+		struct prefix_table table =
+			prefix_table_new(lower_bound, upper_bound, argv[optind + 2], (size_t)block_size);
+		if (table.sums == NULL) {
+			prefix_table_drop(&table);
+			return EXIT_FAILURE;
+		}
+
+		int status = EXIT_SUCCESS;
+		if (save_path != NULL) {
+			status = prefix_table_save(&table, save_path);
+		}
+		if (status == EXIT_SUCCESS) {
+			status = answer_queries(&table);
+		}
+
+		prefix_table_drop(&table);
+
+		return status;
+	}
+
+	// summands sharing the range are evaluated together in a single pass
+	size_t count = (size_t)(argc - optind - 2);
+	const char *const *summands = (const char *const *)&argv[optind + 2];
+
+	if (is_approximate) {
+		struct estimate *estimates = malloc(count * sizeof(*estimates));
+		if (estimates == NULL) {
+			(void)fprintf(stderr, "Error: Failed to allocate memory\n");
+			return EXIT_FAILURE;
+		}
+
+		estimate_fused(lower_bound, upper_bound, count, summands, estimates, &estimate_options);
+		for (size_t i = 0; i < count; i++) {
+			printf("%lg +/- %lg\n", estimates[i].sum, estimates[i].error);
+		}
+
+		free(estimates);
+
+		return EXIT_SUCCESS;
+	}
+
+	// products are evaluated as summations of logarithms and signs
+	size_t factors_count = count;
+	char **factors_summands = NULL;
+	if (is_product) {
+		factors_summands = product_summands(factors_count, summands);
+		count = PRODUCT_SUMMANDS_COUNT * factors_count;
+		summands = (const char *const *)factors_summands;
+	}
+
+	int status = EXIT_SUCCESS;
+	double *sums = malloc(count * sizeof(*sums));
+	if (sums == NULL) {
+		(void)fprintf(stderr, "Error: Failed to allocate memory\n");
+		status = EXIT_FAILURE;
+	} else if (explain) {
+		struct summation_plan plan =
+			summation_plan_new(lower_bound, upper_bound, count, summands, &summation_options);
+		summation_plan_explain(&plan, summands, stdout);
+		summation_plan_drop(&plan);
+	} else {
+		if (is_coordinator) {
+			status = run_coordinator(
+				coordinator_address,
+				(size_t)spawn_count,
+				lower_bound,
+				upper_bound,
+				count,
+				summands,
+				(size_t)shards_count,
+				sums,
+				&summation_options
+			);
+		} else {
+			summation_fused(lower_bound, upper_bound, count, summands, sums, &summation_options);
+		}
+
+		if (status == EXIT_SUCCESS && is_product) {
+			struct product *products = malloc(factors_count * sizeof(*products));
+			product_from_sums(factors_count, sums, products);
+			for (size_t i = 0; i < factors_count; i++) {
+				print_product(&products[i]);
+			}
+			free(products);
+		} else if (status == EXIT_SUCCESS) {
+			for (size_t i = 0; i < count; i++) {
+				printf("%lg\n", sums[i]);
+			}
+		}
+	}
+
+	free(sums);
+	if (factors_summands != NULL) {
+		product_summands_drop(factors_count, factors_summands);
+	}
+
+	return status;
 }
@@ -0,0 +1,434 @@
+#include <periodicity.h>
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <polynomial.h>
+#include <stdlib.h>
+
+/**
+ * @brief The bound of the integers doubles represent exactly.
+ */
+#define PERIODICITY_INTEGER_MAXIMUM 9007199254740992.0
+
+/**
+ * @brief Pi, more precisely than doubles, so that the slopes are compared with its multiples
+ * rather than those of the rounded `M_PI`.
+ */
+#define PERIODICITY_PI 3.141592653589793238462643383279502884L
+
+static size_t periodicity_gcd(size_t a, size_t b) {
+	while (b != 0) {
+		size_t remainder = a % b;
+		a = b;
+		b = remainder;
+	}
+
+	return a;
+}
+
+/**
+ * @brief Gets the period of a combination of periodic functions, 0 if it's too long or unknown.
+ */
+static size_t periodicity_lcm(size_t period_1, size_t period_2) {
+	if (period_1 == 0 || period_2 == 0) {
+		return 0;
+	}
+
+	size_t period = period_1 / periodicity_gcd(period_1, period_2) * period_2;
+	return period <= PERIODICITY_PERIOD_MAXIMUM ? period : 0;
+}
+
+static bool periodicity_is_integer(double value) {
+	return fabs(value) < PERIODICITY_INTEGER_MAXIMUM && nearbyint(value) >= value &&
+		   nearbyint(value) <= value;
+}
+
+/**
+ * @brief Checks whether a polynomial is affine with integer coefficients and values over a range.
+ */
+static bool periodicity_is_integral_affine(
+	const struct polynomial *polynomial,
+	long lower_bound,
+	long upper_bound
+) {
+	assert(polynomial != NULL);
+
+	return polynomial->degree <= 1 && periodicity_is_integer(polynomial->coefficients[0]) &&
+		   periodicity_is_integer(polynomial->coefficients[1]) &&
+		   periodicity_is_integer(polynomial_evaluate(polynomial, (double)lower_bound)) &&
+		   periodicity_is_integer(polynomial_evaluate(polynomial, (double)upper_bound));
+}
+
+/**
+ * @brief a staircase function of the variable.
+ *
+ * A function which grows by `step` whenever the variable grows by `shift`, like an affine
+ * function, with a shift of 1, or the floor of an affine function divided by an integer, like
+ * `floor(i / 3)`, with a shift of 3 and a step of 1.
+ */
+struct periodicity_staircase {
+	size_t shift;
+	double step;
+	bool is_integral; ///< Whether the function only takes integer values over the range.
+};
+
+/**
+ * @brief Gets the staircase function computed by an instruction, from those of its operands.
+ *
+ * Affine functions, the floors and ceilings of integral ones divided by integers, and the sums of
+ * staircase functions and their products by constants are staircase functions.
+ */
+static bool periodicity_staircase_from_instruction(
+	const struct program *program,
+	size_t instruction,
+	const struct polynomial polynomials[],
+	const bool is_polynomial[],
+	const struct periodicity_staircase staircases[],
+	const bool is_staircase[],
+	long lower_bound,
+	long upper_bound,
+	struct periodicity_staircase *staircase
+) {
+	assert(program != NULL && polynomials != NULL && is_polynomial != NULL);
+	assert(staircases != NULL && is_staircase != NULL && staircase != NULL);
+
+	const struct polynomial *polynomial = &polynomials[instruction];
+	if (is_polynomial[instruction] && polynomial->degree <= 1) {
+		*staircase = (struct periodicity_staircase){
+			.shift = 1,
+			.step = polynomial->degree == 1 ? polynomial->coefficients[1] : 0,
+			.is_integral = periodicity_is_integral_affine(polynomial, lower_bound, upper_bound),
+		};
+		return true;
+	}
+
+	const struct instruction *current = &program->instructions[instruction];
+	if (current->type != expression_type_operation) {
+		return false;
+	}
+
+	const size_t *operands = current->operation.operands;
+	switch (current->operation.type) {
+		case operation_type_floor:
+		case operation_type_ceiling: {
+			// floor((a i + b) / m) grows by a / g whenever i grows by m / g, where g = gcd(a, m),
+			// and rounding the quotient of integers below 2^53 never crosses an integer
+			const struct instruction *quotient = &program->instructions[operands[0]];
+			if (quotient->type != expression_type_operation ||
+				quotient->operation.type != operation_type_division) {
+				return false;
+			}
+
+			const struct polynomial *dividend = &polynomials[quotient->operation.operands[0]];
+			const struct polynomial *divisor = &polynomials[quotient->operation.operands[1]];
+			if (!is_polynomial[quotient->operation.operands[0]] ||
+				!is_polynomial[quotient->operation.operands[1]] ||
+				!periodicity_is_integral_affine(dividend, lower_bound, upper_bound) ||
+				divisor->degree != 0 || !periodicity_is_integer(divisor->coefficients[0]) ||
+				fpclassify(divisor->coefficients[0]) == FP_ZERO) {
+				return false;
+			}
+
+			double slope = dividend->degree == 1 ? dividend->coefficients[1] : 0;
+			size_t modulus = (size_t)fabs(divisor->coefficients[0]);
+			size_t shift = modulus / periodicity_gcd((size_t)fabs(slope), modulus);
+			if (shift > PERIODICITY_PERIOD_MAXIMUM) {
+				return false;
+			}
+
+			*staircase = (struct periodicity_staircase){
+				.shift = shift,
+				.step = slope * (double)shift / divisor->coefficients[0],
+				.is_integral = true,
+			};
+		} break;
+		case operation_type_addition:
+		case operation_type_subtraction: {
+			if (!is_staircase[operands[0]] || !is_staircase[operands[1]]) {
+				return false;
+			}
+
+			const struct periodicity_staircase *first = &staircases[operands[0]];
+			const struct periodicity_staircase *second = &staircases[operands[1]];
+			size_t shift = periodicity_lcm(first->shift, second->shift);
+			if (shift == 0) {
+				return false;
+			}
+
+			double sign = current->operation.type == operation_type_addition ? 1 : -1;
+			*staircase = (struct periodicity_staircase){
+				.shift = shift,
+				.step = first->step * (double)(shift / first->shift) +
+						sign * second->step * (double)(shift / second->shift),
+				.is_integral = first->is_integral && second->is_integral,
+			};
+		} break;
+		case operation_type_multiplication: {
+			// by a constant, on either side
+			bool is_first_constant =
+				is_polynomial[operands[0]] && polynomials[operands[0]].degree == 0;
+			size_t variable = is_first_constant ? operands[1] : operands[0];
+			size_t constant = is_first_constant ? operands[0] : operands[1];
+			if (!is_staircase[variable] || !is_polynomial[constant] ||
+				polynomials[constant].degree != 0) {
+				return false;
+			}
+
+			double factor = polynomials[constant].coefficients[0];
+			*staircase = (struct periodicity_staircase){
+				.shift = staircases[variable].shift,
+				.step = staircases[variable].step * factor,
+				.is_integral = staircases[variable].is_integral && periodicity_is_integer(factor),
+			};
+		} break;
+		case operation_type_negation: {
+			if (!is_staircase[operands[0]]) {
+				return false;
+			}
+
+			*staircase = staircases[operands[0]];
+			staircase->step = -staircase->step;
+		} break;
+		default: return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Gets the period of a function of period `turn` of an affine function of slope `slope`.
+ *
+ * The period is the smallest `q` for which `slope` is `k turn / q` for some integer `k`, up to
+ * the rounding errors of the terms of a direct summation at the index of largest magnitude
+ * `magnitude`.
+ */
+static size_t periodicity_trigonometric(double slope, long double turn, double magnitude) {
+	// the error of summing the periodic function instead is at most the drift of its phase at
+	// every index, times the number of indices, and that of a direct summation the rounding of
+	// the arguments and the terms, times the same number
+	double rounding = PERIODICITY_SLOPE_ROUNDINGS * DBL_EPSILON * fmax(fabs(slope) * magnitude, 1);
+	for (size_t period = 1; period <= PERIODICITY_PERIOD_MAXIMUM; period++) {
+		double turns = nearbyint((double)((long double)slope * (long double)period / turn));
+		double drift = (double)fabsl(slope - turns * turn / (long double)period) * magnitude;
+		if (fpclassify(turns) != FP_ZERO && drift <= rounding) {
+			return period;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Gets the period of an operation, from the periods, polynomials and staircase functions
+ * of its operands.
+ */
+static size_t periodicity_from_operation(
+	const struct instruction *instruction,
+	const size_t periods[],
+	const struct polynomial polynomials[],
+	const bool is_polynomial[],
+	const struct periodicity_staircase staircases[],
+	const bool is_staircase[],
+	long lower_bound,
+	long upper_bound
+) {
+	assert(instruction != NULL && instruction->type == expression_type_operation);
+	assert(periods != NULL && polynomials != NULL && is_polynomial != NULL);
+	assert(staircases != NULL && is_staircase != NULL);
+
+	const size_t *operands = instruction->operation.operands;
+	const struct periodicity_staircase *staircase = &staircases[operands[0]];
+	double magnitude = fmax(fabs((double)lower_bound), fabs((double)upper_bound));
+
+	switch (instruction->operation.type) {
+		case operation_type_sine:
+		case operation_type_cosine:
+		case operation_type_tangent: {
+			// repeats itself once the steps of the argument add up to a multiple of the period
+			if (is_staircase[operands[0]] && fpclassify(staircase->step) != FP_ZERO) {
+				bool is_tangent = instruction->operation.type == operation_type_tangent;
+				long double turn = is_tangent ? PERIODICITY_PI : 2 * PERIODICITY_PI;
+				size_t steps = periodicity_trigonometric(
+					staircase->step,
+					turn,
+					magnitude / (double)staircase->shift
+				);
+				size_t period = steps * staircase->shift;
+				return period <= PERIODICITY_PERIOD_MAXIMUM ? period : 0;
+			}
+		} break;
+		case operation_type_modulo: {
+			// (a i + b) % m repeats itself when a p is a multiple of m, and staircases when the
+			// sum of their steps is
+			const struct polynomial *divisor = &polynomials[operands[1]];
+			if (is_staircase[operands[0]] && staircase->is_integral &&
+				periodicity_is_integer(staircase->step) && is_polynomial[operands[1]] &&
+				divisor->degree == 0 && periodicity_is_integer(divisor->coefficients[0]) &&
+				fpclassify(divisor->coefficients[0]) != FP_ZERO) {
+				size_t step = (size_t)fabs(staircase->step);
+				size_t modulus = (size_t)fabs(divisor->coefficients[0]);
+				size_t period = modulus / periodicity_gcd(step, modulus) * staircase->shift;
+				return period <= PERIODICITY_PERIOD_MAXIMUM ? period : 0;
+			}
+		} break;
+		case operation_type_exponentiation: {
+			// (-1) ^ (a i + b) alternates unless a is even, and so does it to staircases by steps
+			const struct polynomial *base = &polynomials[operands[0]];
+			const struct periodicity_staircase *exponent = &staircases[operands[1]];
+			if (is_polynomial[operands[0]] && base->degree == 0 && base->coefficients[0] >= -1 &&
+				base->coefficients[0] <= -1 && is_staircase[operands[1]] &&
+				exponent->is_integral && periodicity_is_integer(exponent->step)) {
+				return (fmod(fabs(exponent->step), 2) < 1 ? 1 : 2) * exponent->shift;
+			}
+		} break;
+		default: break;
+	}
+
+	size_t period = 1;
+	size_t arity = operation_type_arity(instruction->operation.type);
+	for (size_t i = 0; i < arity; i++) {
+		period = periodicity_lcm(period, periods[operands[i]]);
+	}
+
+	return period;
+}
+
+void periodicity_from_program(
+	const struct program *program,
+	char variable,
+	long lower_bound,
+	long upper_bound,
+	struct periodicity periodicities[],
+	bool is_periodic[]
+) {
+	assert(program != NULL && lower_bound <= upper_bound);
+	assert(program->outputs_count == 0 || (periodicities != NULL && is_periodic != NULL));
+
+	size_t count = program->instructions_count;
+	if (count == 0) {
+		return;
+	}
+
+	// the polynomials of all the instructions, as if they were the outputs of the program
+	size_t *outputs = malloc(count * sizeof(*outputs));
+	for (size_t i = 0; i < count; i++) {
+		outputs[i] = i;
+	}
+
+	struct program instructions = *program;
+	instructions.outputs = outputs;
+	instructions.outputs_count = count;
+
+	struct polynomial *polynomials = malloc(count * sizeof(*polynomials));
+	bool *is_polynomial = malloc(count * sizeof(*is_polynomial));
+	polynomial_from_program(&instructions, variable, polynomials, is_polynomial);
+
+	// the period of each instruction, 1 if it doesn't depend on the variable and 0 if unknown,
+	// and the staircase function it computes, periodic if it's integral and its steps are flat
+	size_t *periods = malloc(count * sizeof(*periods));
+	struct periodicity_staircase *staircases = malloc(count * sizeof(*staircases));
+	bool *is_staircase = malloc(count * sizeof(*is_staircase));
+	for (size_t i = 0; i < count; i++) {
+		const struct instruction *instruction = &program->instructions[i];
+
+		is_staircase[i] = periodicity_staircase_from_instruction(
+			program,
+			i,
+			polynomials,
+			is_polynomial,
+			staircases,
+			is_staircase,
+			lower_bound,
+			upper_bound,
+			&staircases[i]
+		);
+
+		if (is_polynomial[i] && polynomials[i].degree == 0) {
+			periods[i] = 1;
+		} else if (is_staircase[i] && staircases[i].is_integral &&
+				   fpclassify(staircases[i].step) == FP_ZERO) {
+			periods[i] = staircases[i].shift;
+		} else if (instruction->type == expression_type_operation) {
+			periods[i] = periodicity_from_operation(
+				instruction,
+				periods,
+				polynomials,
+				is_polynomial,
+				staircases,
+				is_staircase,
+				lower_bound,
+				upper_bound
+			);
+		} else {
+			periods[i] = 0;
+		}
+	}
+
+	unsigned long range = (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		size_t period = periods[program->outputs[i]];
+
+		periodicities[i] = (struct periodicity){
+			.function = { .instructions = NULL, .outputs = NULL },
+			.variable = variable,
+			.period = period,
+			.lower_bound = lower_bound,
+			.upper_bound = upper_bound,
+		};
+
+		// constant summands are polynomials, and summing a single period saves little
+		is_periodic[i] = period >= 2 && range / 2 >= period;
+		if (is_periodic[i]) {
+			size_t output = i;
+			periodicities[i].function = program_select(program, 1, &output);
+		}
+	}
+
+	free(is_staircase);
+	free(staircases);
+	free(periods);
+	free(is_polynomial);
+	free(polynomials);
+	free(outputs);
+}
+
+void periodicity_drop(struct periodicity *periodicity) {
+	assert(periodicity != NULL);
+
+	if (periodicity->function.instructions != NULL) {
+		program_drop(&periodicity->function);
+	}
+	periodicity->function = (struct program){ .instructions = NULL, .outputs = NULL };
+}
+
+double periodicity_sum(const struct periodicity *periodicity) {
+	assert(periodicity != NULL && periodicity->period > 0);
+
+	unsigned long range =
+		(unsigned long)periodicity->upper_bound - (unsigned long)periodicity->lower_bound + 1;
+	unsigned long remainder = range % periodicity->period;
+
+	double *values = malloc(periodicity->function.instructions_count * sizeof(*values));
+	struct environment environment = environment_new();
+
+	// the first period, and the start of it the range ends with
+	double period_sum = 0;
+	double remainder_sum = 0;
+	for (size_t i = 0; i < periodicity->period; i++) {
+		long index = periodicity->lower_bound + (long)i;
+		environment_set_variable(&environment, periodicity->variable, (double)index);
+
+		double term = 0;
+		program_evaluate(&periodicity->function, &environment, values, &term);
+
+		if (i == remainder) {
+			remainder_sum = period_sum;
+		}
+		period_sum += term;
+	}
+
+	free(values);
+
+	return (double)(range / periodicity->period) * period_sum + remainder_sum;
+}
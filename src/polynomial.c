@@ -0,0 +1,1274 @@
+#include <polynomial.h>
+
+#include <assert.h>
+#include <environment.h>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief The number of consecutive integers the degree of a sampled polynomial is found from.
+ */
+#define POLYNOMIAL_SAMPLES_CONSECUTIVE_COUNT (POLYNOMIAL_DEGREE_MAXIMUM + 2)
+
+/**
+ * @brief The number of samples of a sampled polynomial, evaluated in a single block.
+ */
+#define POLYNOMIAL_SAMPLES_COUNT                                                     \
+	(POLYNOMIAL_SAMPLES_CONSECUTIVE_COUNT + POLYNOMIAL_SAMPLES_SPREAD_COUNT + \
+	 POLYNOMIAL_SAMPLES_RANDOM_COUNT)
+
+/**
+ * @brief The largest denominator of the values at integers of a sampled polynomial its
+ * coefficients are rounded for.
+ */
+#define POLYNOMIAL_SAMPLES_DENOMINATOR_MAXIMUM 12
+
+/**
+ * @brief The rounding error of the coefficients of a polynomial in another basis, relative to the
+ * magnitudes of the terms they're computed from.
+ */
+#define POLYNOMIAL_ROUNDING_ERROR (64 * DBL_EPSILON)
+
+/**
+ * @brief The largest ratio of the magnitudes of the terms of a polynomial to its value over a
+ * range for its coefficients to be summed in closed form.
+ */
+#define POLYNOMIAL_CONDITION_MAXIMUM 1024.0
+
+static bool polynomial_is_finite(const struct polynomial *polynomial) {
+	assert(polynomial != NULL);
+
+	for (size_t i = 0; i <= polynomial->degree; i++) {
+		if (!isfinite(polynomial->coefficients[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Drops leading zero coefficients.
+ */
+static void polynomial_normalize(struct polynomial *polynomial) {
+	assert(polynomial != NULL);
+
+	while (polynomial->degree > 0 &&
+		   fpclassify(polynomial->coefficients[polynomial->degree]) == FP_ZERO) {
+		--polynomial->degree;
+	}
+}
+
+static bool polynomial_is_constant(const struct polynomial *polynomial) {
+	assert(polynomial != NULL);
+
+	return polynomial->degree == 0;
+}
+
+static struct polynomial polynomial_add(
+	const struct polynomial *polynomial_1,
+	const struct polynomial *polynomial_2,
+	double sign
+) {
+	assert(polynomial_1 != NULL && polynomial_2 != NULL);
+
+	struct polynomial result = {
+		.degree = polynomial_1->degree > polynomial_2->degree ? polynomial_1->degree
+															  : polynomial_2->degree,
+	};
+
+	for (size_t i = 0; i <= result.degree; i++) {
+		result.coefficients[i] =
+			(i <= polynomial_1->degree ? polynomial_1->coefficients[i] : 0) +
+			sign * (i <= polynomial_2->degree ? polynomial_2->coefficients[i] : 0);
+	}
+
+	polynomial_normalize(&result);
+
+	return result;
+}
+
+static bool polynomial_multiply(
+	const struct polynomial *polynomial_1,
+	const struct polynomial *polynomial_2,
+	struct polynomial *result
+) {
+	assert(polynomial_1 != NULL && polynomial_2 != NULL && result != NULL);
+
+	if (polynomial_1->degree + polynomial_2->degree > POLYNOMIAL_DEGREE_MAXIMUM) {
+		return false;
+	}
+
+	struct polynomial product = { .degree = polynomial_1->degree + polynomial_2->degree };
+	for (size_t i = 0; i <= polynomial_1->degree; i++) {
+		for (size_t j = 0; j <= polynomial_2->degree; j++) {
+			product.coefficients[i + j] +=
+				polynomial_1->coefficients[i] * polynomial_2->coefficients[j];
+		}
+	}
+
+	polynomial_normalize(&product);
+	*result = product;
+
+	return true;
+}
+
+/**
+ * @brief Gets the polynomial computed by an operation from the polynomials of its operands.
+ */
+static bool polynomial_from_operation(
+	enum operation_type type,
+	const struct polynomial operands[],
+	struct polynomial *result
+) {
+	assert(operands != NULL && result != NULL);
+
+	size_t arity = operation_type_arity(type);
+
+	bool is_constant = true;
+	for (size_t i = 0; i < arity; i++) {
+		is_constant = is_constant && polynomial_is_constant(&operands[i]);
+	}
+
+	// evaluating constant operations keeps them exactly as the program computes them
+	if (is_constant) {
+		double values[OPERATION_ARITY_MAXIMUM];
+		for (size_t i = 0; i < arity; i++) {
+			values[i] = operands[i].coefficients[0];
+		}
+
+		*result = polynomial_constant(operation_type_evaluate(type, values));
+		return true;
+	}
+
+	switch (type) {
+		case operation_type_addition: *result = polynomial_add(&operands[0], &operands[1], 1); break;
+		case operation_type_subtraction:
+			*result = polynomial_add(&operands[0], &operands[1], -1);
+			break;
+		case operation_type_multiplication:
+			return polynomial_multiply(&operands[0], &operands[1], result);
+		case operation_type_division: {
+			if (!polynomial_is_constant(&operands[1]) ||
+				fpclassify(operands[1].coefficients[0]) == FP_ZERO) {
+				return false;
+			}
+
+			*result = operands[0];
+			for (size_t i = 0; i <= result->degree; i++) {
+				result->coefficients[i] /= operands[1].coefficients[0];
+			}
+		} break;
+		case operation_type_exponentiation: {
+			if (!polynomial_is_constant(&operands[1])) {
+				return false;
+			}
+
+			double exponent = operands[1].coefficients[0];
+			if (!(exponent >= 0 && exponent <= POLYNOMIAL_DEGREE_MAXIMUM) ||
+				nearbyint(exponent) < exponent || nearbyint(exponent) > exponent) {
+				return false;
+			}
+
+			struct polynomial power = polynomial_constant(1);
+			for (size_t i = 0; i < (size_t)exponent; i++) {
+				if (!polynomial_multiply(&power, &operands[0], &power)) {
+					return false;
+				}
+			}
+			*result = power;
+		} break;
+		case operation_type_binomial: {
+			if (!polynomial_is_constant(&operands[1])) {
+				return false;
+			}
+
+			// binom(p, k) = p (p - 1) ... (p - k + 1) / k! for an integer k
+			double k = operands[1].coefficients[0];
+			if (!(k >= 0 && k <= POLYNOMIAL_DEGREE_MAXIMUM) || nearbyint(k) < k || nearbyint(k) > k) {
+				return false;
+			}
+
+			struct polynomial product = polynomial_constant(1);
+			for (size_t i = 0; i < (size_t)k; i++) {
+				struct polynomial factor = operands[0];
+				factor.coefficients[0] -= (double)i;
+				for (size_t j = 0; j <= factor.degree; j++) {
+					factor.coefficients[j] /= (double)(i + 1);
+				}
+
+				if (!polynomial_multiply(&product, &factor, &product)) {
+					return false;
+				}
+			}
+			*result = product;
+		} break;
+		case operation_type_negation: {
+			*result = operands[0];
+			for (size_t i = 0; i <= result->degree; i++) {
+				result->coefficients[i] = -result->coefficients[i];
+			}
+		} break;
+		default: return false;
+	}
+
+	return true;
+}
+
+void polynomial_from_program(
+	const struct program *program,
+	char variable,
+	struct polynomial polynomials[],
+	bool is_polynomial[]
+) {
+	assert(program != NULL);
+	assert(program->outputs_count == 0 || (polynomials != NULL && is_polynomial != NULL));
+
+	struct polynomial *instructions =
+		malloc(program->instructions_count * sizeof(*instructions));
+	bool *is_instruction_polynomial =
+		malloc(program->instructions_count * sizeof(*is_instruction_polynomial));
+
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		const struct instruction *instruction = &program->instructions[i];
+
+		switch (instruction->type) {
+			case expression_type_constant: {
+				instructions[i] = polynomial_constant(instruction->constant);
+				is_instruction_polynomial[i] = true;
+			} break;
+			case expression_type_variable: {
+				instructions[i] = (struct polynomial){ .degree = 1, .coefficients = { 0, 1 } };
+				// other variables may be constant, but their values are unknown
+				is_instruction_polynomial[i] = instruction->variable == variable;
+			} break;
+			case expression_type_operation: {
+				struct polynomial operands[OPERATION_ARITY_MAXIMUM];
+
+				is_instruction_polynomial[i] = true;
+
+				size_t arity = operation_type_arity(instruction->operation.type);
+				for (size_t j = 0; j < arity; j++) {
+					size_t operand = instruction->operation.operands[j];
+					is_instruction_polynomial[i] =
+						is_instruction_polynomial[i] && is_instruction_polynomial[operand];
+					operands[j] = instructions[operand];
+				}
+
+				is_instruction_polynomial[i] = is_instruction_polynomial[i] &&
+											   polynomial_from_operation(
+												   instruction->operation.type,
+												   operands,
+												   &instructions[i]
+											   ) &&
+											   polynomial_is_finite(&instructions[i]);
+			} break;
+		}
+	}
+
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		polynomials[i] = instructions[program->outputs[i]];
+		is_polynomial[i] = is_instruction_polynomial[program->outputs[i]];
+	}
+
+	free(is_instruction_polynomial);
+	free(instructions);
+}
+
+double polynomial_evaluate(const struct polynomial *polynomial, double value) {
+	assert(polynomial != NULL);
+
+	double result = polynomial->coefficients[polynomial->degree];
+	for (size_t i = polynomial->degree; i-- > 0;) {
+		result = result * value + polynomial->coefficients[i];
+	}
+
+	return result;
+}
+
+double polynomial_sum(const struct polynomial *polynomial, long lower_bound, long upper_bound) {
+	assert(polynomial != NULL);
+
+	if (lower_bound > upper_bound) {
+		return 0;
+	}
+
+	size_t degree = polynomial->degree;
+
+	// the coefficients of the polynomial in x = i - lower_bound, by repeated synthetic division,
+	// and the magnitudes they're computed from, which bound their rounding errors
+	double shifted[POLYNOMIAL_DEGREE_MAXIMUM + 1];
+	double magnitudes[POLYNOMIAL_DEGREE_MAXIMUM + 1];
+	for (size_t i = 0; i <= degree; i++) {
+		shifted[i] = polynomial->coefficients[i];
+		magnitudes[i] = fabs(polynomial->coefficients[i]);
+	}
+	for (size_t i = 0; i < degree; i++) {
+		for (size_t j = degree; j-- > i;) {
+			shifted[j] += (double)lower_bound * shifted[j + 1];
+			magnitudes[j] += fabs((double)lower_bound) * magnitudes[j + 1];
+		}
+	}
+
+	// x^j is the sum of the falling factorials x^(k) weighted by the stirling numbers S(j, k)
+	double stirling[POLYNOMIAL_DEGREE_MAXIMUM + 1] = { 1 };
+	double falling[POLYNOMIAL_DEGREE_MAXIMUM + 1] = { shifted[0] };
+	double falling_magnitudes[POLYNOMIAL_DEGREE_MAXIMUM + 1] = { magnitudes[0] };
+	for (size_t j = 1; j <= degree; j++) {
+		for (size_t k = j; k > 0; k--) {
+			stirling[k] = (double)k * stirling[k] + stirling[k - 1];
+			falling[k] += shifted[j] * stirling[k];
+			falling_magnitudes[k] += magnitudes[j] * stirling[k];
+		}
+		stirling[0] = 0;
+	}
+
+	// the sum of x^(k) over x from 0 to n - 1 is n^(k + 1) / (k + 1), so that of the k-th finite
+	// difference k! x^(k) is binom(n, k + 1), and those of polynomials taking integer values at
+	// integers are integers, rounded to them within the rounding errors of their computation
+	double count = (double)((unsigned long)upper_bound - (unsigned long)lower_bound + 1);
+	double binomial = count;
+	double factorial = 1;
+	double sum = 0;
+	for (size_t k = 0; k <= degree; k++) {
+		double difference = falling[k] * factorial;
+		double error = POLYNOMIAL_ROUNDING_ERROR * falling_magnitudes[k] * factorial;
+		if (fabs(difference - nearbyint(difference)) <= error) {
+			difference = nearbyint(difference);
+		}
+
+		sum += difference * binomial;
+		binomial = binomial * (count - (double)(k + 1)) / (double)(k + 2);
+		factorial *= (double)(k + 1);
+	}
+
+	return sum;
+}
+
+/**
+ * @brief Draws a pseudo-random number, with the SplitMix64 generator.
+ */
+static uint64_t polynomial_random(uint64_t *state) {
+	assert(state != NULL);
+
+	uint64_t z = (*state += UINT64_C(0x9e3779b97f4a7c15));
+	z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+	return z ^ (z >> 31);
+}
+
+/**
+ * @brief Finds the degree of a polynomial from its values at consecutive integers.
+ *
+ * @return Whether some finite differences of the values vanish, within the allowed error relative
+ * to the largest value.
+ */
+static bool polynomial_degree_from_samples(const double samples[], size_t *degree) {
+	assert(samples != NULL && degree != NULL);
+
+	double differences[POLYNOMIAL_SAMPLES_CONSECUTIVE_COUNT];
+	double scale = 0;
+	for (size_t i = 0; i < POLYNOMIAL_SAMPLES_CONSECUTIVE_COUNT; i++) {
+		differences[i] = samples[i];
+		scale = fmax(scale, fabs(samples[i]));
+	}
+
+	double error = POLYNOMIAL_SAMPLES_ERROR * scale;
+	for (size_t order = 1; order < POLYNOMIAL_SAMPLES_CONSECUTIVE_COUNT; order++) {
+		bool is_vanishing = true;
+		for (size_t i = 0; i + order < POLYNOMIAL_SAMPLES_CONSECUTIVE_COUNT; i++) {
+			differences[i] = differences[i + 1] - differences[i];
+			is_vanishing = is_vanishing && fabs(differences[i]) <= error;
+		}
+
+		if (is_vanishing) {
+			*degree = order - 1;
+			return true;
+		}
+
+		// each order of differences may double the rounding errors
+		error *= 2;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Interpolates the polynomial of a given degree through values at distinct points.
+ *
+ * Computes the divided differences of the values, and expands the polynomial from Newton's form.
+ */
+static struct polynomial polynomial_interpolate(
+	const double points[],
+	const double values[],
+	size_t degree
+) {
+	assert(points != NULL && values != NULL && degree <= POLYNOMIAL_DEGREE_MAXIMUM);
+
+	double differences[POLYNOMIAL_DEGREE_MAXIMUM + 1];
+	memcpy(differences, values, (degree + 1) * sizeof(*differences));
+	for (size_t i = 1; i <= degree; i++) {
+		for (size_t j = degree; j >= i; j--) {
+			differences[j] = (differences[j] - differences[j - 1]) / (points[j] - points[j - i]);
+		}
+	}
+
+	// multiplies by the variable minus each point, and adds each difference in turn
+	struct polynomial result = polynomial_constant(differences[degree]);
+	for (size_t i = degree; i-- > 0;) {
+		result.coefficients[result.degree + 1] = 0;
+		for (size_t j = result.degree + 1; j > 0; j--) {
+			result.coefficients[j] =
+				result.coefficients[j - 1] - points[i] * result.coefficients[j];
+		}
+		result.coefficients[0] = differences[i] - points[i] * result.coefficients[0];
+		++result.degree;
+	}
+
+	polynomial_normalize(&result);
+
+	return result;
+}
+
+/**
+ * @brief Checks whether a polynomial matches samples, within the allowed error relative to the
+ * largest one.
+ */
+static bool polynomial_matches_samples(
+	const struct polynomial *polynomial,
+	const double indices[],
+	const double samples[],
+	double scale
+) {
+	assert(polynomial != NULL && indices != NULL && samples != NULL);
+
+	bool is_matching = polynomial_is_finite(polynomial);
+	for (size_t i = 0; i < POLYNOMIAL_SAMPLES_COUNT && is_matching; i++) {
+		is_matching = fabs(polynomial_evaluate(polynomial, indices[i]) - samples[i]) <=
+					  POLYNOMIAL_SAMPLES_ERROR * scale;
+	}
+
+	return is_matching;
+}
+
+/**
+ * @brief Rounds the coefficients of a sampled polynomial to the rationals they approximate.
+ *
+ * A polynomial of degree `d` whose values at `d + 1` consecutive integers are multiples of `1 / q`
+ * has multiples of `1 / (q d!)` as coefficients, so those at the consecutive samples are checked
+ * for the least such `q`.
+ *
+ * @return Whether the coefficients were rounded.
+ */
+static bool polynomial_round(struct polynomial *polynomial, const double samples[]) {
+	assert(polynomial != NULL && samples != NULL);
+
+	size_t denominator = 1;
+	for (; denominator <= POLYNOMIAL_SAMPLES_DENOMINATOR_MAXIMUM; denominator++) {
+		bool is_multiple = true;
+		for (size_t i = 0; i <= polynomial->degree && is_multiple; i++) {
+			double value = samples[i] * (double)denominator;
+			is_multiple =
+				fabs(value - nearbyint(value)) <= POLYNOMIAL_SAMPLES_ERROR * fmax(1, fabs(value));
+		}
+
+		if (is_multiple) {
+			break;
+		}
+	}
+	if (denominator > POLYNOMIAL_SAMPLES_DENOMINATOR_MAXIMUM) {
+		return false;
+	}
+
+	double scale = (double)denominator;
+	for (size_t i = 2; i <= polynomial->degree; i++) {
+		scale *= (double)i;
+	}
+	for (size_t i = 0; i <= polynomial->degree; i++) {
+		polynomial->coefficients[i] = nearbyint(polynomial->coefficients[i] * scale) / scale;
+	}
+	polynomial_normalize(polynomial);
+
+	return true;
+}
+
+/**
+ * @brief Checks whether an operation is smooth, so that it can't differ from a polynomial at just
+ * a few integers without its samples showing it.
+ */
+static bool operation_type_is_smooth(enum operation_type type) {
+	switch (type) {
+		case operation_type_modulo:
+		case operation_type_absolute_value:
+		case operation_type_floor:
+		case operation_type_ceiling:
+		case operation_type_minimum:
+		case operation_type_maximum:
+		case operation_type_less:
+		case operation_type_less_equal:
+		case operation_type_greater:
+		case operation_type_greater_equal:
+		case operation_type_equal:
+		case operation_type_not_equal:
+		case operation_type_conditional: return false;
+		default: return true;
+	}
+}
+
+/**
+ * @brief Checks whether a polynomial is nonzero, or positive, at every integer of a range.
+ *
+ * Its sign only changes at its roots, so it's only evaluated at the bounds and at the integers
+ * around its roots, which are only found for degrees up to 2.
+ */
+static bool polynomial_has_sign(
+	const struct polynomial *polynomial,
+	long lower_bound,
+	long upper_bound,
+	bool is_positive
+) {
+	assert(polynomial != NULL && lower_bound <= upper_bound);
+
+	double roots[2];
+	size_t roots_count = 0;
+	const double *coefficients = polynomial->coefficients;
+	if (polynomial->degree == 1) {
+		roots[roots_count++] = -coefficients[0] / coefficients[1];
+	} else if (polynomial->degree == 2) {
+		double discriminant =
+			coefficients[1] * coefficients[1] - 4 * coefficients[2] * coefficients[0];
+		if (discriminant >= 0) {
+			roots[roots_count++] = (-coefficients[1] - sqrt(discriminant)) / (2 * coefficients[2]);
+			roots[roots_count++] = (-coefficients[1] + sqrt(discriminant)) / (2 * coefficients[2]);
+		}
+	} else if (polynomial->degree > 2) {
+		return false;
+	}
+
+	double indices[2 + 2 * 4];
+	size_t indices_count = 0;
+	indices[indices_count++] = (double)lower_bound;
+	indices[indices_count++] = (double)upper_bound;
+	for (size_t i = 0; i < roots_count; i++) {
+		if (!isfinite(roots[i])) {
+			return false;
+		}
+
+		// the integers around the root, within one of it despite rounding errors
+		for (double index = floor(roots[i]) - 1; index <= ceil(roots[i]) + 1; index++) {
+			if (index > (double)lower_bound && index < (double)upper_bound) {
+				indices[indices_count++] = index;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < indices_count; i++) {
+		double value = polynomial_evaluate(polynomial, indices[i]);
+		if (is_positive ? !(value > 0) : fpclassify(value) == FP_ZERO || isnan(value)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Finds the instructions of a program whose samples tell whether they're polynomials.
+ *
+ * Those are the ones only computed by smooth operations, none of which underflows at a sample:
+ * an exponential underflowing almost everywhere could be a bump far from every sample. Neither
+ * can they divide by, raise to a negative power or take the logarithm of an operand which may
+ * vanish at an integer of the range, as a single pole could fall between the samples: the
+ * operand must be a polynomial with a sign over the range, given by `polynomials`.
+ */
+static void polynomial_samples_are_telling(
+	const struct program *program,
+	const double values[],
+	const struct polynomial polynomials[],
+	const bool is_polynomial[],
+	long lower_bound,
+	long upper_bound,
+	bool is_telling[]
+) {
+	assert(program != NULL && values != NULL && is_telling != NULL);
+	assert(polynomials != NULL && is_polynomial != NULL);
+
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		const struct instruction *instruction = &program->instructions[i];
+		is_telling[i] = true;
+		if (instruction->type != expression_type_operation) {
+			continue;
+		}
+
+		enum operation_type type = instruction->operation.type;
+		is_telling[i] = operation_type_is_smooth(type);
+
+		size_t arity = operation_type_arity(type);
+		const size_t *operands = instruction->operation.operands;
+		for (size_t j = 0; j < arity; j++) {
+			is_telling[i] = is_telling[i] && is_telling[operands[j]];
+		}
+
+		// the operand which may have poles at its roots, or is the argument of a logarithm
+		size_t singular = SIZE_MAX;
+		if (type == operation_type_division) {
+			singular = operands[1];
+		} else if (type == operation_type_logarithm) {
+			singular = operands[0];
+		} else if (type == operation_type_exponentiation) {
+			const struct polynomial *exponent = &polynomials[operands[1]];
+			bool is_natural = is_polynomial[operands[1]] && polynomial_is_constant(exponent) &&
+							  exponent->coefficients[0] >= 0 &&
+							  nearbyint(exponent->coefficients[0]) >= exponent->coefficients[0] &&
+							  nearbyint(exponent->coefficients[0]) <= exponent->coefficients[0];
+			singular = is_natural ? SIZE_MAX : operands[0];
+		}
+		if (singular != SIZE_MAX && is_telling[i]) {
+			is_telling[i] = is_polynomial[singular] && polynomial_has_sign(
+														   &polynomials[singular],
+														   lower_bound,
+														   upper_bound,
+														   type == operation_type_logarithm
+													   );
+		}
+
+		if (type == operation_type_exponential || type == operation_type_exponentiation) {
+			const double *samples = &values[i * POLYNOMIAL_SAMPLES_COUNT];
+			const double *bases =
+				&values[instruction->operation.operands[0] * POLYNOMIAL_SAMPLES_COUNT];
+			for (size_t j = 0; j < POLYNOMIAL_SAMPLES_COUNT && is_telling[i]; j++) {
+				bool is_underflowing = fabs(samples[j]) < DBL_MIN &&
+									   (type == operation_type_exponential || fabs(bases[j]) > 0);
+				is_telling[i] = !is_underflowing;
+			}
+		}
+	}
+}
+
+void polynomial_from_samples(
+	const struct program *program,
+	char variable,
+	long lower_bound,
+	long upper_bound,
+	struct polynomial polynomials[],
+	bool is_polynomial[]
+) {
+	assert(program != NULL);
+	assert(program->outputs_count == 0 || (polynomials != NULL && is_polynomial != NULL));
+
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		is_polynomial[i] = false;
+	}
+
+	// evaluating the samples takes as long as summing shorter ranges
+	unsigned long count = (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+	if (lower_bound > upper_bound || count < POLYNOMIAL_SAMPLES_COUNT ||
+		program->outputs_count == 0) {
+		return;
+	}
+
+	// consecutive integers from the lower bound, integers spread evenly over the range including
+	// both bounds, and pseudo-random ones, which only depend on the range
+	double indices[POLYNOMIAL_SAMPLES_COUNT];
+	double *spread = &indices[POLYNOMIAL_SAMPLES_CONSECUTIVE_COUNT];
+	double *pseudo_random = &spread[POLYNOMIAL_SAMPLES_SPREAD_COUNT];
+	for (size_t i = 0; i < POLYNOMIAL_SAMPLES_CONSECUTIVE_COUNT; i++) {
+		indices[i] = (double)lower_bound + (double)i;
+	}
+	for (size_t i = 0; i < POLYNOMIAL_SAMPLES_SPREAD_COUNT; i++) {
+		unsigned long offset = (unsigned long)((double)(count - 1) * (double)i /
+											   (double)(POLYNOMIAL_SAMPLES_SPREAD_COUNT - 1));
+		offset = offset < count - 1 ? offset : count - 1;
+		spread[i] = (double)(long)((unsigned long)lower_bound + offset);
+	}
+	uint64_t state = (uint64_t)lower_bound ^ ((uint64_t)upper_bound << 1);
+	for (size_t i = 0; i < POLYNOMIAL_SAMPLES_RANDOM_COUNT; i++) {
+		unsigned long offset = (unsigned long)(polynomial_random(&state) % count);
+		pseudo_random[i] = (double)(long)((unsigned long)lower_bound + offset);
+	}
+
+	double *values =
+		malloc(program->instructions_count * POLYNOMIAL_SAMPLES_COUNT * sizeof(*values));
+	struct environment environment = environment_new();
+	program_evaluate_block(
+		program,
+		&environment,
+		variable,
+		indices,
+		POLYNOMIAL_SAMPLES_COUNT,
+		values
+	);
+
+	// the polynomials of all the instructions, as if they were the outputs of the program
+	size_t *outputs = malloc(program->instructions_count * sizeof(*outputs));
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		outputs[i] = i;
+	}
+	struct program instructions = *program;
+	instructions.outputs = outputs;
+	instructions.outputs_count = program->instructions_count;
+
+	struct polynomial *instructions_polynomials =
+		malloc(program->instructions_count * sizeof(*instructions_polynomials));
+	bool *is_instruction_polynomial =
+		malloc(program->instructions_count * sizeof(*is_instruction_polynomial));
+	polynomial_from_program(
+		&instructions,
+		variable,
+		instructions_polynomials,
+		is_instruction_polynomial
+	);
+
+	bool *is_telling = malloc(program->instructions_count * sizeof(*is_telling));
+	polynomial_samples_are_telling(
+		program,
+		values,
+		instructions_polynomials,
+		is_instruction_polynomial,
+		lower_bound,
+		upper_bound,
+		is_telling
+	);
+	free(is_instruction_polynomial);
+	free(instructions_polynomials);
+	free(outputs);
+
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		if (!is_telling[program->outputs[i]]) {
+			continue;
+		}
+
+		const double *samples = &values[program->outputs[i] * POLYNOMIAL_SAMPLES_COUNT];
+
+		bool is_finite = true;
+		double scale = 0;
+		for (size_t j = 0; j < POLYNOMIAL_SAMPLES_COUNT; j++) {
+			is_finite = is_finite && isfinite(samples[j]);
+			scale = fmax(scale, fabs(samples[j]));
+		}
+
+		size_t degree = 0;
+		if (!is_finite || !polynomial_degree_from_samples(samples, &degree)) {
+			continue;
+		}
+
+		// the points spread evenly over the range keep the interpolation well-conditioned
+		double points[POLYNOMIAL_DEGREE_MAXIMUM + 1];
+		double points_values[POLYNOMIAL_DEGREE_MAXIMUM + 1];
+		for (size_t j = 0; j <= degree; j++) {
+			size_t k = degree == 0
+						   ? 0
+						   : (j * (POLYNOMIAL_SAMPLES_SPREAD_COUNT - 1) + degree / 2) / degree;
+			points[j] = spread[k];
+			points_values[j] = samples[POLYNOMIAL_SAMPLES_CONSECUTIVE_COUNT + k];
+		}
+		struct polynomial polynomial = polynomial_interpolate(points, points_values, degree);
+
+		// the interpolation leaves rounding errors in coefficients which are often exact
+		struct polynomial rounded = polynomial;
+		if (polynomial_round(&rounded, samples) &&
+			polynomial_matches_samples(&rounded, indices, samples, scale)) {
+			polynomial = rounded;
+		}
+
+		is_polynomial[i] = polynomial_matches_samples(&polynomial, indices, samples, scale);
+		polynomials[i] = polynomial;
+	}
+
+	free(is_telling);
+	free(values);
+}
+
+static bool polynomial_equals(
+	const struct polynomial *polynomial_1,
+	const struct polynomial *polynomial_2
+) {
+	assert(polynomial_1 != NULL && polynomial_2 != NULL);
+
+	return polynomial_1->degree == polynomial_2->degree &&
+		   memcmp(
+			   polynomial_1->coefficients,
+			   polynomial_2->coefficients,
+			   (polynomial_1->degree + 1) * sizeof(*polynomial_1->coefficients)
+		   ) == 0;
+}
+
+/**
+ * @brief Checks whether all the coefficients of a polynomial are integers, so that it's an integer
+ * at every integer.
+ */
+static bool polynomial_is_integral(const struct polynomial *polynomial) {
+	assert(polynomial != NULL);
+
+	for (size_t i = 0; i <= polynomial->degree; i++) {
+		double coefficient = polynomial->coefficients[i];
+		if (!isfinite(coefficient) || fpclassify(coefficient - nearbyint(coefficient)) != FP_ZERO) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static struct polynomial polynomial_negate(const struct polynomial *polynomial) {
+	assert(polynomial != NULL);
+
+	struct polynomial result = *polynomial;
+	for (size_t i = 0; i <= result.degree; i++) {
+		result.coefficients[i] = -result.coefficients[i];
+	}
+
+	return result;
+}
+
+/**
+ * @brief Checks whether an operation selects between its operands depending on a sign.
+ */
+static bool operation_type_is_selection(enum operation_type type) {
+	switch (type) {
+		case operation_type_absolute_value:
+		case operation_type_minimum:
+		case operation_type_maximum:
+		case operation_type_less:
+		case operation_type_less_equal:
+		case operation_type_greater:
+		case operation_type_greater_equal:
+		case operation_type_equal:
+		case operation_type_not_equal:
+		case operation_type_conditional: return true;
+		default: return false;
+	}
+}
+
+/**
+ * @brief Gets the polynomial a selection computes where the difference it depends on has the sign
+ * `sign`.
+ *
+ * The difference is the operand itself for absolute values and conditionals, and the first operand
+ * minus the second for the others.
+ */
+static struct polynomial polynomial_select(
+	enum operation_type type,
+	const struct polynomial operands[],
+	int sign
+) {
+	assert(operands != NULL);
+
+	switch (type) {
+		case operation_type_absolute_value:
+			return sign < 0 ? polynomial_negate(&operands[0]) : operands[0];
+		case operation_type_minimum: return sign < 0 ? operands[0] : operands[1];
+		case operation_type_maximum: return sign > 0 ? operands[0] : operands[1];
+		case operation_type_less: return polynomial_constant(sign < 0);
+		case operation_type_less_equal: return polynomial_constant(sign <= 0);
+		case operation_type_greater: return polynomial_constant(sign > 0);
+		case operation_type_greater_equal: return polynomial_constant(sign >= 0);
+		case operation_type_equal: return polynomial_constant(sign == 0);
+		case operation_type_not_equal: return polynomial_constant(sign != 0);
+		case operation_type_conditional: return sign != 0 ? operands[1] : operands[2];
+		// only called for selections
+		default: __builtin_unreachable();
+	}
+}
+
+/**
+ * @brief Checks whether a polynomial is non-negative, or positive if `is_strict`, at an offset from
+ * `lower_bound`.
+ */
+static bool polynomial_holds(
+	const struct polynomial *polynomial,
+	long lower_bound,
+	unsigned long offset,
+	bool is_strict
+) {
+	double value = polynomial_evaluate(polynomial, (double)(long)((unsigned long)lower_bound + offset));
+	return is_strict ? value > 0 : value >= 0;
+}
+
+/**
+ * @brief Gets the first offset from `lower_bound`, less than `count`, where an increasing linear
+ * polynomial is non-negative, or positive if `is_strict`, or `count` if there's none.
+ */
+static unsigned long polynomial_first(
+	const struct polynomial *line,
+	long lower_bound,
+	unsigned long count,
+	bool is_strict
+) {
+	assert(line != NULL && line->degree == 1);
+
+	// the root only gives an estimate, as it's rounded differently than the values are
+	double root = -line->coefficients[0] / line->coefficients[1] - (double)lower_bound;
+	double estimate = is_strict ? floor(root) + 1 : ceil(root);
+
+	unsigned long first = 0;
+	if (estimate >= (double)count) {
+		first = count;
+	} else if (estimate > 0) {
+		first = (unsigned long)estimate;
+	}
+
+	while (first > 0 && polynomial_holds(line, lower_bound, first - 1, is_strict)) {
+		--first;
+	}
+	while (first < count && !polynomial_holds(line, lower_bound, first, is_strict)) {
+		++first;
+	}
+
+	return first;
+}
+
+/**
+ * @brief Appends a piece to a piecewise polynomial, extending the last piece instead if it's the
+ * same polynomial.
+ *
+ * @return Whether the piecewise polynomial still has at most the maximum number of pieces.
+ */
+static bool piecewise_polynomial_push(
+	struct piecewise_polynomial *piecewise_polynomial,
+	long lower_bound,
+	const struct polynomial *polynomial
+) {
+	assert(piecewise_polynomial != NULL && polynomial != NULL);
+
+	size_t count = piecewise_polynomial->pieces_count;
+	if (count > 0 && polynomial_equals(&piecewise_polynomial->pieces[count - 1], polynomial)) {
+		return true;
+	}
+
+	if (count == PIECEWISE_POLYNOMIAL_PIECES_MAXIMUM) {
+		return false;
+	}
+
+	piecewise_polynomial->lower_bounds = realloc(
+		piecewise_polynomial->lower_bounds,
+		(count + 1) * sizeof(*piecewise_polynomial->lower_bounds)
+	);
+	piecewise_polynomial->pieces =
+		realloc(piecewise_polynomial->pieces, (count + 1) * sizeof(*piecewise_polynomial->pieces));
+
+	piecewise_polynomial->lower_bounds[count] = lower_bound;
+	piecewise_polynomial->pieces[count] = *polynomial;
+	++piecewise_polynomial->pieces_count;
+
+	return true;
+}
+
+/**
+ * @brief Appends the pieces computed by an operation over a range where each of its operands is a
+ * single polynomial.
+ *
+ * Selections split the range where the difference they depend on changes sign, which a linear
+ * difference does at most once.
+ */
+static bool piecewise_polynomial_push_operation(
+	struct piecewise_polynomial *result,
+	enum operation_type type,
+	const struct polynomial operands[],
+	long lower_bound,
+	long upper_bound
+) {
+	assert(result != NULL && operands != NULL && lower_bound <= upper_bound);
+
+	size_t arity = operation_type_arity(type);
+
+	bool is_constant = true;
+	for (size_t i = 0; i < arity; i++) {
+		is_constant = is_constant && polynomial_is_constant(&operands[i]);
+	}
+
+	// polynomials with integer coefficients are integers already
+	if ((type == operation_type_floor || type == operation_type_ceiling) && !is_constant &&
+		polynomial_is_integral(&operands[0])) {
+		return piecewise_polynomial_push(result, lower_bound, &operands[0]);
+	}
+
+	if (is_constant || !operation_type_is_selection(type)) {
+		struct polynomial polynomial;
+		return polynomial_from_operation(type, operands, &polynomial) &&
+			   polynomial_is_finite(&polynomial) &&
+			   piecewise_polynomial_push(result, lower_bound, &polynomial);
+	}
+
+	struct polynomial difference =
+		type == operation_type_absolute_value || type == operation_type_conditional
+			? operands[0]
+			: polynomial_add(&operands[0], &operands[1], -1);
+	if (difference.degree > 1 || !polynomial_is_finite(&difference)) {
+		return false;
+	}
+
+	// the difference is negative before `firsts[0]`, zero before `firsts[1]` and positive after
+	unsigned long count = (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+	unsigned long firsts[2] = { 0, 0 };
+	int signs[3] = { -1, 0, 1 };
+	if (difference.degree == 0) {
+		double value = difference.coefficients[0];
+		signs[2] = (value > 0) - (value < 0);
+	} else {
+		// the polynomial changes sign the other way when it's decreasing
+		struct polynomial line = difference;
+		if (difference.coefficients[1] < 0) {
+			line = polynomial_negate(&difference);
+			signs[0] = 1;
+			signs[2] = -1;
+		}
+
+		firsts[0] = polynomial_first(&line, lower_bound, count, false);
+		firsts[1] = polynomial_first(&line, lower_bound, count, true);
+	}
+
+	unsigned long starts[4] = { 0, firsts[0], firsts[1], count };
+	for (size_t i = 0; i < 3; i++) {
+		if (starts[i] < starts[i + 1]) {
+			struct polynomial piece = polynomial_select(type, operands, signs[i]);
+			long start = (long)((unsigned long)lower_bound + starts[i]);
+			if (!piecewise_polynomial_push(result, start, &piece)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Gets the piecewise polynomial computed by an operation from the piecewise polynomials of
+ * its operands.
+ *
+ * The operation is applied over each range where none of the operands changes pieces.
+ */
+static bool piecewise_polynomial_from_operation(
+	enum operation_type type,
+	const struct piecewise_polynomial *const operands[],
+	struct piecewise_polynomial *result
+) {
+	assert(operands != NULL && result != NULL);
+
+	size_t arity = operation_type_arity(type);
+
+	size_t pieces[OPERATION_ARITY_MAXIMUM] = { 0 };
+	long lower_bound = operands[0]->lower_bounds[0];
+	while (true) {
+		struct polynomial polynomials[OPERATION_ARITY_MAXIMUM];
+
+		long upper_bound = result->upper_bound;
+		for (size_t i = 0; i < arity; i++) {
+			polynomials[i] = operands[i]->pieces[pieces[i]];
+			if (pieces[i] + 1 < operands[i]->pieces_count &&
+				operands[i]->lower_bounds[pieces[i] + 1] <= upper_bound) {
+				upper_bound = operands[i]->lower_bounds[pieces[i] + 1] - 1;
+			}
+		}
+
+		if (!piecewise_polynomial_push_operation(
+				result,
+				type,
+				polynomials,
+				lower_bound,
+				upper_bound
+			)) {
+			return false;
+		}
+
+		if (upper_bound == result->upper_bound) {
+			return true;
+		}
+
+		lower_bound = upper_bound + 1;
+		for (size_t i = 0; i < arity; i++) {
+			if (pieces[i] + 1 < operands[i]->pieces_count &&
+				operands[i]->lower_bounds[pieces[i] + 1] == lower_bound) {
+				++pieces[i];
+			}
+		}
+	}
+}
+
+void piecewise_polynomial_from_program(
+	const struct program *program,
+	char variable,
+	long lower_bound,
+	long upper_bound,
+	struct piecewise_polynomial piecewise_polynomials[],
+	bool is_piecewise_polynomial[]
+) {
+	assert(program != NULL && lower_bound <= upper_bound);
+	assert(
+		program->outputs_count == 0 ||
+		(piecewise_polynomials != NULL && is_piecewise_polynomial != NULL)
+	);
+
+	struct piecewise_polynomial *instructions =
+		calloc(program->instructions_count, sizeof(*instructions));
+	bool *is_instruction_piecewise =
+		malloc(program->instructions_count * sizeof(*is_instruction_piecewise));
+
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		const struct instruction *instruction = &program->instructions[i];
+		struct piecewise_polynomial *result = &instructions[i];
+		result->upper_bound = upper_bound;
+
+		switch (instruction->type) {
+			case expression_type_constant: {
+				struct polynomial constant = polynomial_constant(instruction->constant);
+				is_instruction_piecewise[i] =
+					piecewise_polynomial_push(result, lower_bound, &constant);
+			} break;
+			case expression_type_variable: {
+				struct polynomial identity = { .degree = 1, .coefficients = { 0, 1 } };
+				// other variables may be constant, but their values are unknown
+				is_instruction_piecewise[i] =
+					instruction->variable == variable &&
+					piecewise_polynomial_push(result, lower_bound, &identity);
+			} break;
+			case expression_type_operation: {
+				const struct piecewise_polynomial *operands[OPERATION_ARITY_MAXIMUM];
+
+				is_instruction_piecewise[i] = true;
+
+				size_t arity = operation_type_arity(instruction->operation.type);
+				for (size_t j = 0; j < arity; j++) {
+					size_t operand = instruction->operation.operands[j];
+					is_instruction_piecewise[i] =
+						is_instruction_piecewise[i] && is_instruction_piecewise[operand];
+					operands[j] = &instructions[operand];
+				}
+
+				is_instruction_piecewise[i] =
+					is_instruction_piecewise[i] &&
+					piecewise_polynomial_from_operation(
+						instruction->operation.type,
+						operands,
+						result
+					);
+			} break;
+		}
+	}
+
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		const struct piecewise_polynomial *output = &instructions[program->outputs[i]];
+
+		is_piecewise_polynomial[i] = is_instruction_piecewise[program->outputs[i]];
+		piecewise_polynomials[i] = (struct piecewise_polynomial){ .upper_bound = upper_bound };
+		if (!is_piecewise_polynomial[i]) {
+			continue;
+		}
+
+		// outputs may share instructions, so each gets its own copy
+		for (size_t j = 0; j < output->pieces_count; j++) {
+			(void)piecewise_polynomial_push(
+				&piecewise_polynomials[i],
+				output->lower_bounds[j],
+				&output->pieces[j]
+			);
+		}
+	}
+
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		piecewise_polynomial_drop(&instructions[i]);
+	}
+	free(is_instruction_piecewise);
+	free(instructions);
+}
+
+struct piecewise_polynomial piecewise_polynomial_from_polynomial(
+	const struct polynomial *polynomial,
+	long lower_bound,
+	long upper_bound
+) {
+	assert(polynomial != NULL && lower_bound <= upper_bound);
+
+	struct piecewise_polynomial piecewise_polynomial = { .upper_bound = upper_bound };
+	(void)piecewise_polynomial_push(&piecewise_polynomial, lower_bound, polynomial);
+
+	return piecewise_polynomial;
+}
+
+void piecewise_polynomial_drop(struct piecewise_polynomial *piecewise_polynomial) {
+	assert(piecewise_polynomial != NULL);
+
+	free(piecewise_polynomial->pieces);
+	free(piecewise_polynomial->lower_bounds);
+	piecewise_polynomial->pieces = NULL;
+	piecewise_polynomial->lower_bounds = NULL;
+	piecewise_polynomial->pieces_count = 0;
+}
+
+double piecewise_polynomial_sum(const struct piecewise_polynomial *piecewise_polynomial) {
+	assert(piecewise_polynomial != NULL);
+
+	double sum = 0;
+	for (size_t i = 0; i < piecewise_polynomial->pieces_count; i++) {
+		long upper_bound = i + 1 < piecewise_polynomial->pieces_count
+							   ? piecewise_polynomial->lower_bounds[i + 1] - 1
+							   : piecewise_polynomial->upper_bound;
+		sum += polynomial_sum(
+			&piecewise_polynomial->pieces[i],
+			piecewise_polynomial->lower_bounds[i],
+			upper_bound
+		);
+	}
+
+	return sum;
+}
+
+bool polynomial_is_well_conditioned(
+	const struct polynomial *polynomial,
+	long lower_bound,
+	long upper_bound
+) {
+	assert(polynomial != NULL && lower_bound <= upper_bound);
+
+	unsigned long half = ((unsigned long)upper_bound - (unsigned long)lower_bound) / 2;
+	const double points[] = {
+		(double)lower_bound,
+		(double)(long)((unsigned long)lower_bound + half),
+		(double)upper_bound,
+	};
+
+	double magnitude = 0;
+	double value = 0;
+	for (size_t i = 0; i < sizeof(points) / sizeof(points[0]); i++) {
+		double point_magnitude = fabs(polynomial->coefficients[polynomial->degree]);
+		for (size_t j = polynomial->degree; j-- > 0;) {
+			point_magnitude = point_magnitude * fabs(points[i]) + fabs(polynomial->coefficients[j]);
+		}
+		magnitude = fmax(magnitude, point_magnitude);
+		value = fmax(value, fabs(polynomial_evaluate(polynomial, points[i])));
+	}
+
+	// integer coefficients are evaluated exactly at the integers while the terms are small enough
+	bool is_integral = magnitude * DBL_EPSILON <= 1;
+	for (size_t i = 0; i <= polynomial->degree; i++) {
+		double coefficient = polynomial->coefficients[i];
+		is_integral = is_integral && !(nearbyint(coefficient) < coefficient) &&
+					  !(nearbyint(coefficient) > coefficient);
+	}
+
+	return is_integral || magnitude <= POLYNOMIAL_CONDITION_MAXIMUM * value;
+}
+
+bool piecewise_polynomial_is_well_conditioned(
+	const struct piecewise_polynomial *piecewise_polynomial
+) {
+	assert(piecewise_polynomial != NULL);
+
+	for (size_t i = 0; i < piecewise_polynomial->pieces_count; i++) {
+		long upper_bound = i + 1 < piecewise_polynomial->pieces_count
+							   ? piecewise_polynomial->lower_bounds[i + 1] - 1
+							   : piecewise_polynomial->upper_bound;
+		if (!polynomial_is_well_conditioned(
+				&piecewise_polynomial->pieces[i],
+				piecewise_polynomial->lower_bounds[i],
+				upper_bound
+			)) {
+			return false;
+		}
+	}
+
+	return true;
+}
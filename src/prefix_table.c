@@ -0,0 +1,289 @@
+#include <prefix_table.h>
+
+#include <assert.h>
+#include <fcntl.h>
+#include <math.h>
+#include <program.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PREFIX_TABLE_MAGIC "SUMPRFX1"
+#define PREFIX_TABLE_ALIGNMENT 16
+
+/**
+ * @brief The header of a saved prefix table.
+ *
+ * The header is followed by the summand string, null-terminated and padded to
+ * `PREFIX_TABLE_ALIGNMENT` bytes, and then by the prefix sums.
+ */
+struct prefix_table_header {
+	char magic[8];
+	int64_t lower_bound;
+	int64_t upper_bound;
+	uint64_t block_size;
+	uint64_t sums_count;
+	uint64_t summand_length;
+};
+
+static size_t prefix_table_sums_offset(size_t summand_length) {
+	size_t offset = sizeof(struct prefix_table_header) + summand_length + 1;
+	return (offset + PREFIX_TABLE_ALIGNMENT - 1) / PREFIX_TABLE_ALIGNMENT * PREFIX_TABLE_ALIGNMENT;
+}
+
+static struct prefix_sum prefix_sum_add(struct prefix_sum prefix_sum, double term) {
+	// the error-free transformation of the addition (Knuth's TwoSum)
+	double sum = prefix_sum.sum + term;
+	double rounded_term = sum - prefix_sum.sum;
+	double error = (prefix_sum.sum - (sum - rounded_term)) + (term - rounded_term);
+
+	return (struct prefix_sum){
+		.sum = sum,
+		.compensation = prefix_sum.compensation + error,
+	};
+}
+
+struct prefix_table prefix_table_new(
+	long lower_bound,
+	long upper_bound,
+	const char *summand,
+	size_t block_size
+) {
+	assert(summand != NULL && block_size > 0 && lower_bound <= upper_bound);
+
+	struct environment environment = environment_new();
+
+	struct prefix_table table = {
+		.lower_bound = lower_bound,
+		.upper_bound = upper_bound,
+		.block_size = block_size,
+		.summand = expression_from_string(summand),
+		.summand_string = strdup(summand),
+		.mapping = NULL,
+		.mapping_size = 0,
+	};
+	expression_simplify(&table.summand, &environment);
+
+	// the full range of long has more indices than an unsigned long counts
+	unsigned long count = (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+	size_t blocks_count = count / block_size + (count % block_size != 0);
+	table.sums = count == 0 || blocks_count >= SIZE_MAX / sizeof(*table.sums)
+					 ? NULL
+					 : malloc((blocks_count + 1) * sizeof(*table.sums));
+	if (table.sums == NULL) {
+		(void)fprintf(stderr, "Error: The range of the prefix table is too large\n");
+		table.sums_count = 0;
+		return table;
+	}
+	table.sums_count = blocks_count + 1;
+
+	struct program program = program_new(1, &table.summand);
+	double *values = malloc(program.instructions_count * sizeof(*values));
+
+	struct prefix_sum prefix_sum = { .sum = 0, .compensation = 0 };
+	table.sums[0] = prefix_sum;
+	for (size_t i = 0; i < count; i++) {
+		environment_set_variable(&environment, 'i', (double)lower_bound + (double)i);
+
+		double term = 0;
+		program_evaluate(&program, &environment, values, &term);
+		prefix_sum = prefix_sum_add(prefix_sum, term);
+
+		if ((i + 1) % block_size == 0 || i + 1 == count) {
+			table.sums[(i + block_size) / block_size] = prefix_sum;
+		}
+	}
+
+	free(values);
+	program_drop(&program);
+
+	return table;
+}
+
+void prefix_table_drop(struct prefix_table *table) {
+	assert(table != NULL);
+
+	if (table->mapping != NULL) {
+		munmap(table->mapping, table->mapping_size);
+	} else {
+		free(table->sums);
+	}
+	free(table->summand_string);
+	expression_drop(&table->summand);
+}
+
+/**
+ * @brief Computes the prefix sum of the first `offset` terms of the table.
+ */
+static struct prefix_sum prefix_table_prefix_sum(const struct prefix_table *table, size_t offset) {
+	assert(table != NULL);
+
+	size_t count = (unsigned long)table->upper_bound - (unsigned long)table->lower_bound + 1;
+
+	size_t block = offset / table->block_size;
+	size_t remainder = offset % table->block_size;
+	if (remainder == 0) {
+		return table->sums[block];
+	}
+
+	struct environment environment = environment_new();
+
+	// walk from whichever stored prefix sum is nearer
+	size_t next = (block + 1) * table->block_size;
+	if (next > count) {
+		next = count;
+	}
+	if (remainder <= next - offset) {
+		struct prefix_sum prefix_sum = table->sums[block];
+		for (size_t i = offset - remainder; i < offset; i++) {
+			environment_set_variable(&environment, 'i', (double)table->lower_bound + (double)i);
+			prefix_sum =
+				prefix_sum_add(prefix_sum, expression_evaluate(&table->summand, &environment));
+		}
+		return prefix_sum;
+	}
+
+	struct prefix_sum prefix_sum = table->sums[block + 1];
+	for (size_t i = offset; i < next; i++) {
+		environment_set_variable(&environment, 'i', (double)table->lower_bound + (double)i);
+		prefix_sum =
+			prefix_sum_add(prefix_sum, -expression_evaluate(&table->summand, &environment));
+	}
+	return prefix_sum;
+}
+
+double prefix_table_query(const struct prefix_table *table, long lower_bound, long upper_bound) {
+	assert(table != NULL);
+
+	if (lower_bound > upper_bound) {
+		return 0;
+	}
+
+	if (lower_bound < table->lower_bound || upper_bound > table->upper_bound) {
+		return NAN;
+	}
+
+	struct prefix_sum lower = prefix_table_prefix_sum(
+		table,
+		(unsigned long)lower_bound - (unsigned long)table->lower_bound
+	);
+	struct prefix_sum upper = prefix_table_prefix_sum(
+		table,
+		(unsigned long)upper_bound - (unsigned long)table->lower_bound + 1
+	);
+
+	return (upper.sum - lower.sum) + (upper.compensation - lower.compensation);
+}
+
+int prefix_table_save(const struct prefix_table *table, const char *path) {
+	assert(table != NULL && path != NULL);
+
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		(void)fprintf(stderr, "Error: Failed to open \"%s\" for writing\n", path);
+		return EXIT_FAILURE;
+	}
+
+	struct prefix_table_header header = {
+		.lower_bound = table->lower_bound,
+		.upper_bound = table->upper_bound,
+		.block_size = table->block_size,
+		.sums_count = table->sums_count,
+		.summand_length = strlen(table->summand_string),
+	};
+	memcpy(header.magic, PREFIX_TABLE_MAGIC, sizeof(header.magic));
+
+	size_t offset = prefix_table_sums_offset(header.summand_length);
+	size_t padding = offset - sizeof(header) - header.summand_length;
+	static const char zeros[PREFIX_TABLE_ALIGNMENT + 1] = { 0 };
+
+	if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+		fwrite(table->summand_string, 1, header.summand_length, file) != header.summand_length ||
+		fwrite(zeros, 1, padding, file) != padding ||
+		fwrite(table->sums, sizeof(*table->sums), table->sums_count, file) != table->sums_count) {
+		(void)fprintf(stderr, "Error: Failed to write to \"%s\"\n", path);
+		(void)fclose(file);
+		return EXIT_FAILURE;
+	}
+
+	if (fclose(file) != 0) {
+		(void)fprintf(stderr, "Error: Failed to write to \"%s\"\n", path);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int prefix_table_load(struct prefix_table *table, const char *path) {
+	assert(table != NULL && path != NULL);
+
+	int file = open(path, O_RDONLY);
+	if (file < 0) {
+		(void)fprintf(stderr, "Error: Failed to open \"%s\" for reading\n", path);
+		return EXIT_FAILURE;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || (size_t)status.st_size < sizeof(struct prefix_table_header)) {
+		(void)fprintf(stderr, "Error: \"%s\" is not a prefix table\n", path);
+		(void)close(file);
+		return EXIT_FAILURE;
+	}
+
+	size_t size = (size_t)status.st_size;
+	void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, file, 0);
+	(void)close(file);
+	if (mapping == MAP_FAILED) {
+		(void)fprintf(stderr, "Error: Failed to map \"%s\"\n", path);
+		return EXIT_FAILURE;
+	}
+
+	// the header must describe the range and the prefix sums of the file exactly, and the summand
+	// must be a null-terminated string
+	const struct prefix_table_header *header = mapping;
+	const char *summand = (const char *)mapping + sizeof(*header);
+	unsigned long count =
+		(unsigned long)header->upper_bound - (unsigned long)header->lower_bound + 1;
+	size_t sums_size = 0;
+	if (header->summand_length < size - sizeof(*header) &&
+		prefix_table_sums_offset(header->summand_length) <= size) {
+		sums_size = size - prefix_table_sums_offset(header->summand_length);
+	}
+	if (memcmp(header->magic, PREFIX_TABLE_MAGIC, sizeof(header->magic)) != 0 ||
+		header->lower_bound > header->upper_bound || count == 0 || header->block_size == 0 ||
+		header->sums_count < 2 ||
+		header->sums_count - 1 != count / header->block_size + (count % header->block_size != 0) ||
+		header->summand_length >= size - sizeof(*header) ||
+		strnlen(summand, header->summand_length + 1) != header->summand_length ||
+		sums_size % sizeof(struct prefix_sum) != 0 ||
+		sums_size / sizeof(struct prefix_sum) != header->sums_count) {
+		(void)fprintf(stderr, "Error: \"%s\" is not a prefix table\n", path);
+		munmap(mapping, size);
+		return EXIT_FAILURE;
+	}
+
+	// queries are scattered over the table, so readahead would mostly be wasted
+	(void)madvise(mapping, size, MADV_RANDOM);
+
+	*table = (struct prefix_table){
+		.lower_bound = header->lower_bound,
+		.upper_bound = header->upper_bound,
+		.block_size = header->block_size,
+		.sums_count = header->sums_count,
+		.sums = (struct prefix_sum *)((char *)mapping +
+									  prefix_table_sums_offset(header->summand_length)),
+		.summand = expression_from_string(summand),
+		.summand_string = strndup(summand, header->summand_length),
+		.mapping = mapping,
+		.mapping_size = size,
+	};
+
+	struct environment environment = environment_new();
+	expression_simplify(&table->summand, &environment);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+#include <product.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief The formats of the summands of a factor, in order.
+ */
+static const char *const product_formats[PRODUCT_SUMMANDS_COUNT] = {
+	"log(abs(%s))",
+	"(%s) < 0",
+	"(%s) == 0",
+};
+
+char **product_summands(size_t count, const char *const factors[]) {
+	assert(count == 0 || factors != NULL);
+
+	char **summands = malloc(PRODUCT_SUMMANDS_COUNT * count * sizeof(*summands));
+	for (size_t i = 0; i < count; i++) {
+		assert(factors[i] != NULL);
+
+		for (size_t j = 0; j < PRODUCT_SUMMANDS_COUNT; j++) {
+			// the factors are parenthesised, so that they are compared as a whole
+			int length = snprintf(NULL, 0, product_formats[j], factors[i]);
+			char *summand = malloc((size_t)length + 1);
+			(void)snprintf(summand, (size_t)length + 1, product_formats[j], factors[i]);
+
+			summands[PRODUCT_SUMMANDS_COUNT * i + j] = summand;
+		}
+	}
+
+	return summands;
+}
+
+void product_summands_drop(size_t count, char **summands) {
+	assert(count == 0 || summands != NULL);
+
+	for (size_t i = 0; i < PRODUCT_SUMMANDS_COUNT * count; i++) {
+		free(summands[i]);
+	}
+	free(summands);
+}
+
+void product_from_sums(size_t count, const double sums[], struct product products[]) {
+	assert(count == 0 || (sums != NULL && products != NULL));
+
+	for (size_t i = 0; i < count; i++) {
+		const double *factor_sums = &sums[PRODUCT_SUMMANDS_COUNT * i];
+
+		products[i].logarithm = factor_sums[0];
+
+		// counts of indices are added up exactly, and a zero and an infinite factor make a NaN
+		if (isnan(factor_sums[0]) || factor_sums[2] < 1) {
+			products[i].sign = fmod(factor_sums[1], 2) < 1 ? 1 : -1;
+		} else {
+			products[i].sign = 0;
+			products[i].logarithm = -INFINITY;
+		}
+	}
+}
+
+double product(long lower_bound, long upper_bound, const char *factor) {
+	assert(factor != NULL);
+
+	struct product result;
+	product_fused(lower_bound, upper_bound, 1, &factor, &result, NULL);
+
+	return product_value(&result);
+}
+
+void product_fused(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const factors[],
+	struct product products[],
+	const struct summation_options *options
+) {
+	assert((count == 0 || factors != NULL) && (count == 0 || products != NULL));
+
+	char **summands = product_summands(count, factors);
+	double *sums = malloc(PRODUCT_SUMMANDS_COUNT * count * sizeof(*sums));
+
+	summation_fused(
+		lower_bound,
+		upper_bound,
+		PRODUCT_SUMMANDS_COUNT * count,
+		(const char *const *)summands,
+		sums,
+		options
+	);
+	product_from_sums(count, sums, products);
+
+	free(sums);
+	product_summands_drop(count, summands);
+}
@@ -0,0 +1,1003 @@
+#include <program.h>
+
+#include <assert.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PROGRAM_MAGIC "SUMPROG2"
+#define PROGRAM_ALIGNMENT 16
+#define PROGRAM_RECURRENCE_STEP_MAXIMUM 16
+/**
+ * @brief The number of indices after which the sines, cosines and exponentials advanced by
+ * recurrences are evaluated exactly again, so that their rounding errors don't keep growing.
+ */
+#define PROGRAM_RECURRENCE_PERIOD 32
+
+/**
+ * @brief The header of a saved program.
+ *
+ * The header is followed by the key, the outputs and then the instructions, each padded to
+ * `PROGRAM_ALIGNMENT` bytes.
+ */
+struct program_header {
+	char magic[8];
+	uint64_t instruction_size; ///< Guards against loading a program saved by an incompatible build.
+	uint64_t operation_types_count; ///< Guards against programs saved before operations were added.
+	uint64_t instructions_count;
+	uint64_t outputs_count;
+	uint64_t key_size;
+};
+
+static size_t program_aligned(size_t size) {
+	return (size + PROGRAM_ALIGNMENT - 1) / PROGRAM_ALIGNMENT * PROGRAM_ALIGNMENT;
+}
+
+static bool instruction_equals(
+	const struct instruction *instruction_1,
+	const struct instruction *instruction_2
+) {
+	assert(instruction_1 != NULL && instruction_2 != NULL);
+
+	if (instruction_1->type != instruction_2->type) {
+		return false;
+	}
+
+	switch (instruction_1->type) {
+		// compared bitwise, so that only identical constants are shared
+		case expression_type_constant:
+			return memcmp(
+					   &instruction_1->constant,
+					   &instruction_2->constant,
+					   sizeof(instruction_1->constant)
+				   ) == 0;
+		case expression_type_variable: return instruction_1->variable == instruction_2->variable;
+		case expression_type_operation: {
+			if (instruction_1->operation.type != instruction_2->operation.type) {
+				return false;
+			}
+
+			size_t arity = operation_type_arity(instruction_1->operation.type);
+			for (size_t i = 0; i < arity; i++) {
+				if (instruction_1->operation.operands[i] != instruction_2->operation.operands[i]) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+	}
+}
+
+static size_t program_push(
+	struct program *program,
+	size_t *capacity,
+	const struct instruction *instruction
+) {
+	assert(program != NULL && capacity != NULL && instruction != NULL);
+
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		if (instruction_equals(&program->instructions[i], instruction)) {
+			return i;
+		}
+	}
+
+	if (program->instructions_count == *capacity) {
+		*capacity = *capacity == 0 ? 8 : 2 * *capacity;
+		program->instructions =
+			realloc(program->instructions, *capacity * sizeof(*program->instructions));
+	}
+
+	program->instructions[program->instructions_count] = *instruction;
+
+	return program->instructions_count++;
+}
+
+static size_t program_compile(
+	struct program *program,
+	size_t *capacity,
+	const struct expression *expression
+) {
+	assert(program != NULL && capacity != NULL && expression != NULL);
+
+	struct instruction instruction = { .type = expression->type };
+
+	switch (expression->type) {
+		case expression_type_constant: instruction.constant = expression->constant.value; break;
+		case expression_type_variable: instruction.variable = expression->variable.name; break;
+		case expression_type_operation: {
+			instruction.operation.type = expression->operation.type;
+
+			size_t arity = operation_type_arity(expression->operation.type);
+			for (size_t i = 0; i < arity; i++) {
+				instruction.operation.operands[i] =
+					program_compile(program, capacity, &expression->operation.operands[i]);
+			}
+		} break;
+	}
+
+	return program_push(program, capacity, &instruction);
+}
+
+struct program program_new(size_t count, const struct expression expressions[]) {
+	assert(count == 0 || expressions != NULL);
+
+	struct program program = {
+		.instructions = NULL,
+		.instructions_count = 0,
+		.outputs = malloc(count * sizeof(*program.outputs)),
+		.outputs_count = count,
+		.mapping = NULL,
+		.mapping_size = 0,
+	};
+
+	size_t capacity = 0;
+	for (size_t i = 0; i < count; i++) {
+		program.outputs[i] = program_compile(&program, &capacity, &expressions[i]);
+	}
+
+	return program;
+}
+
+struct program program_select(const struct program *program, size_t count, const size_t outputs[]) {
+	assert(program != NULL && (count == 0 || outputs != NULL));
+
+	// maps every needed instruction to its index in the new program
+	size_t *indices = malloc(program->instructions_count * sizeof(*indices));
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		indices[i] = SIZE_MAX;
+	}
+	for (size_t i = 0; i < count; i++) {
+		assert(outputs[i] < program->outputs_count);
+		indices[program->outputs[outputs[i]]] = 0;
+	}
+	for (size_t i = program->instructions_count; i-- > 0;) {
+		const struct instruction *instruction = &program->instructions[i];
+		if (indices[i] == SIZE_MAX || instruction->type != expression_type_operation) {
+			continue;
+		}
+
+		size_t arity = operation_type_arity(instruction->operation.type);
+		for (size_t j = 0; j < arity; j++) {
+			indices[instruction->operation.operands[j]] = 0;
+		}
+	}
+
+	struct program selection = {
+		.instructions = malloc(program->instructions_count * sizeof(*selection.instructions)),
+		.instructions_count = 0,
+		.outputs = malloc(count * sizeof(*selection.outputs)),
+		.outputs_count = count,
+		.mapping = NULL,
+		.mapping_size = 0,
+	};
+
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		if (indices[i] == SIZE_MAX) {
+			continue;
+		}
+
+		struct instruction instruction = program->instructions[i];
+		if (instruction.type == expression_type_operation) {
+			size_t arity = operation_type_arity(instruction.operation.type);
+			for (size_t j = 0; j < arity; j++) {
+				instruction.operation.operands[j] = indices[instruction.operation.operands[j]];
+			}
+		}
+
+		indices[i] = selection.instructions_count;
+		selection.instructions[selection.instructions_count++] = instruction;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		selection.outputs[i] = indices[program->outputs[outputs[i]]];
+	}
+
+	free(indices);
+
+	return selection;
+}
+
+void program_drop(struct program *program) {
+	assert(program != NULL);
+
+	if (program->mapping != NULL) {
+		munmap(program->mapping, program->mapping_size);
+	} else {
+		free(program->instructions);
+		free(program->outputs);
+	}
+}
+
+int program_save(
+	const struct program *program,
+	const void *key,
+	size_t key_size,
+	const char *path
+) {
+	assert(program != NULL && (key_size == 0 || key != NULL) && path != NULL);
+
+	size_t path_length = strlen(path);
+	char *temporary_path = malloc(path_length + 32);
+	if (temporary_path == NULL) {
+		(void)fprintf(stderr, "Error: Failed to allocate memory\n");
+		return EXIT_FAILURE;
+	}
+	(void)snprintf(temporary_path, path_length + 32, "%s.%ld.tmp", path, (long)getpid());
+
+	FILE *file = fopen(temporary_path, "wb");
+	if (file == NULL) {
+		(void)fprintf(stderr, "Error: Failed to open \"%s\" for writing\n", temporary_path);
+		free(temporary_path);
+		return EXIT_FAILURE;
+	}
+
+	struct program_header header = {
+		.instruction_size = sizeof(struct instruction),
+		.operation_types_count = OPERATION_TYPES_COUNT,
+		.instructions_count = program->instructions_count,
+		.outputs_count = program->outputs_count,
+		.key_size = key_size,
+	};
+	memcpy(header.magic, PROGRAM_MAGIC, sizeof(header.magic));
+
+	static const char zeros[PROGRAM_ALIGNMENT] = { 0 };
+	size_t key_padding = program_aligned(key_size) - key_size;
+	size_t outputs_size = program->outputs_count * sizeof(*program->outputs);
+	size_t padding = program_aligned(outputs_size) - outputs_size;
+
+	bool is_written =
+		fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(key, 1, key_size, file) == key_size &&
+		fwrite(zeros, 1, key_padding, file) == key_padding &&
+		fwrite(program->outputs, sizeof(*program->outputs), program->outputs_count, file) ==
+			program->outputs_count &&
+		fwrite(zeros, 1, padding, file) == padding &&
+		fwrite(
+			program->instructions,
+			sizeof(*program->instructions),
+			program->instructions_count,
+			file
+		) == program->instructions_count;
+	is_written = fclose(file) == 0 && is_written;
+
+	if (!is_written || rename(temporary_path, path) != 0) {
+		(void)fprintf(stderr, "Error: Failed to write to \"%s\"\n", path);
+		(void)unlink(temporary_path);
+		free(temporary_path);
+		return EXIT_FAILURE;
+	}
+
+	free(temporary_path);
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Checks that every instruction of a loaded program is well-formed.
+ */
+static bool program_is_valid(const struct program *program) {
+	assert(program != NULL);
+
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		const struct instruction *instruction = &program->instructions[i];
+		switch (instruction->type) {
+			case expression_type_constant: break;
+			case expression_type_variable:
+				if (!isalpha((unsigned char)instruction->variable)) {
+					return false;
+				}
+				break;
+			case expression_type_operation: {
+				if ((size_t)instruction->operation.type >= OPERATION_TYPES_COUNT) {
+					return false;
+				}
+
+				// operands must have been computed before the operation
+				size_t arity = operation_type_arity(instruction->operation.type);
+				for (size_t j = 0; j < arity; j++) {
+					if (instruction->operation.operands[j] >= i) {
+						return false;
+					}
+				}
+			} break;
+			default: return false;
+		}
+	}
+
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		if (program->outputs[i] >= program->instructions_count) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int program_load(struct program *program, const void *key, size_t key_size, const char *path) {
+	assert(program != NULL && (key_size == 0 || key != NULL) && path != NULL);
+
+	int file = open(path, O_RDONLY);
+	if (file < 0) {
+		return EXIT_FAILURE;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || (size_t)status.st_size < sizeof(struct program_header)) {
+		(void)fprintf(stderr, "Error: \"%s\" is not a program\n", path);
+		(void)close(file);
+		return EXIT_FAILURE;
+	}
+
+	size_t size = (size_t)status.st_size;
+	void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, file, 0);
+	(void)close(file);
+	if (mapping == MAP_FAILED) {
+		(void)fprintf(stderr, "Error: Failed to map \"%s\"\n", path);
+		return EXIT_FAILURE;
+	}
+
+	const struct program_header *header = mapping;
+	size_t stored_key_size = program_aligned(header->key_size);
+	size_t outputs_size = program_aligned(header->outputs_count * sizeof(*program->outputs));
+	if (memcmp(header->magic, PROGRAM_MAGIC, sizeof(header->magic)) != 0 ||
+		header->instruction_size != sizeof(struct instruction) ||
+		header->operation_types_count != OPERATION_TYPES_COUNT ||
+		header->outputs_count > size || header->instructions_count > size ||
+		header->key_size > size ||
+		sizeof(*header) + stored_key_size + outputs_size +
+				header->instructions_count * sizeof(*program->instructions) !=
+			size) {
+		(void)fprintf(stderr, "Error: \"%s\" is not a program\n", path);
+		munmap(mapping, size);
+		return EXIT_FAILURE;
+	}
+
+	// the program of another key, whose hash collided with this one's
+	char *stored_key = (char *)mapping + sizeof(*header);
+	if (header->key_size != key_size || (key_size != 0 && memcmp(stored_key, key, key_size) != 0)) {
+		munmap(mapping, size);
+		return EXIT_FAILURE;
+	}
+
+	char *outputs = stored_key + stored_key_size;
+	*program = (struct program){
+		.instructions = (struct instruction *)(outputs + outputs_size),
+		.instructions_count = header->instructions_count,
+		.outputs = (size_t *)outputs,
+		.outputs_count = header->outputs_count,
+		.mapping = mapping,
+		.mapping_size = size,
+	};
+
+	if (!program_is_valid(program)) {
+		(void)fprintf(stderr, "Error: \"%s\" is not a program\n", path);
+		munmap(mapping, size);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void program_evaluate(
+	const struct program *program,
+	const struct environment *environment,
+	double values[],
+	double results[]
+) {
+	assert(program != NULL && values != NULL && results != NULL);
+
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		const struct instruction *instruction = &program->instructions[i];
+
+		switch (instruction->type) {
+			case expression_type_constant: values[i] = instruction->constant; break;
+			case expression_type_variable:
+				values[i] = environment == NULL
+								? NAN
+								: environment_get_variable(environment, instruction->variable);
+				break;
+			case expression_type_operation: {
+				double operands[OPERATION_ARITY_MAXIMUM];
+
+				size_t arity = operation_type_arity(instruction->operation.type);
+				for (size_t j = 0; j < arity; j++) {
+					operands[j] = values[instruction->operation.operands[j]];
+				}
+
+				values[i] = operation_type_evaluate(instruction->operation.type, operands);
+			} break;
+		}
+	}
+
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		results[i] = values[program->outputs[i]];
+	}
+}
+
+/**
+ * @brief Applies an operation to every element of a block.
+ *
+ * Each case is a separate loop, so that the loops over the arithmetic operations can be vectorized.
+ */
+static void block_apply(
+	enum operation_type type,
+	size_t size,
+	const double *restrict operands_1,
+	const double *restrict operands_2,
+	const double *restrict operands_3,
+	double *restrict results
+) {
+	switch (type) {
+		case operation_type_addition:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = operands_1[i] + operands_2[i];
+			}
+			break;
+		case operation_type_subtraction:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = operands_1[i] - operands_2[i];
+			}
+			break;
+		case operation_type_multiplication:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = operands_1[i] * operands_2[i];
+			}
+			break;
+		case operation_type_division:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = operands_1[i] / operands_2[i];
+			}
+			break;
+		case operation_type_negation:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = -operands_1[i];
+			}
+			break;
+		case operation_type_absolute_value:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = fabs(operands_1[i]);
+			}
+			break;
+		// selections are blends of both operands, so they vectorize instead of branching
+		case operation_type_minimum:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = operands_1[i] < operands_2[i] ? operands_1[i] : operands_2[i];
+			}
+			break;
+		case operation_type_maximum:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = operands_1[i] > operands_2[i] ? operands_1[i] : operands_2[i];
+			}
+			break;
+		case operation_type_less:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = operands_1[i] < operands_2[i];
+			}
+			break;
+		case operation_type_less_equal:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = operands_1[i] <= operands_2[i];
+			}
+			break;
+		case operation_type_greater:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = operands_1[i] > operands_2[i];
+			}
+			break;
+		case operation_type_greater_equal:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = operands_1[i] >= operands_2[i];
+			}
+			break;
+		case operation_type_equal:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = operands_1[i] >= operands_2[i] && operands_1[i] <= operands_2[i];
+			}
+			break;
+		case operation_type_not_equal:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = !(operands_1[i] >= operands_2[i] && operands_1[i] <= operands_2[i]);
+			}
+			break;
+		case operation_type_conditional:
+			for (size_t i = 0; i < size; i++) {
+				results[i] = !(operands_1[i] >= 0 && operands_1[i] <= 0) ? operands_2[i]
+																		   : operands_3[i];
+			}
+			break;
+		default: {
+			// library functions don't vectorize, but still save the dispatch per element
+			double operands[OPERATION_ARITY_MAXIMUM];
+			size_t arity = operation_type_arity(type);
+			for (size_t i = 0; i < size; i++) {
+				operands[0] = operands_1[i];
+				if (arity > 1) {
+					operands[1] = operands_2[i];
+				}
+				if (arity > 2) {
+					operands[2] = operands_3[i];
+				}
+				results[i] = operation_type_evaluate(type, operands);
+			}
+		} break;
+	}
+}
+
+/**
+ * @brief Advances a gamma-like function over a block of consecutive indices.
+ *
+ * gamma(x + n) = gamma(x) x (x + 1) ... (x + n - 1), so the function is advanced by a product at
+ * every index, or in the log-domain by the logarithm of that product.
+ */
+static bool block_recur_gamma(
+	enum operation_type type,
+	size_t size,
+	const double *restrict operands,
+	double step,
+	double *restrict results
+) {
+	// x! = gamma(x + 1)
+	double shift = type == operation_type_factorial || type == operation_type_log_factorial;
+	bool is_logarithmic = type == operation_type_log_gamma || type == operation_type_log_factorial;
+
+	// the recurrence can't step over the poles at the non-positive integers
+	double argument = operands[0] + shift;
+	if (!(argument > 0 && operands[size - 1] + shift > 0)) {
+		return false;
+	}
+
+	double value = operation_type_evaluate(type, operands);
+	for (size_t i = 0; i < size; i++) {
+		results[i] = value;
+
+		double ratio = 1;
+		for (double j = 0; j < step; j++) {
+			ratio *= argument + j;
+		}
+		argument += step;
+
+		value = is_logarithmic ? value + log(ratio) : value * ratio;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Advances a binomial coefficient over a block of consecutive indices.
+ *
+ * binom(n, k + 1) = binom(n, k) (n - k) / (k + 1) and binom(n + 1, k) = binom(n, k) (n + 1) / (n + 1
+ * - k), so the coefficient is advanced by a ratio at every index, or in the log-domain by the
+ * logarithm of that ratio.
+ */
+static bool block_recur_binomial(
+	enum operation_type type,
+	size_t size,
+	const double *restrict operands_1,
+	const double *restrict operands_2,
+	double step_1,
+	double step_2,
+	double *restrict results
+) {
+	bool is_logarithmic = type == operation_type_log_binomial;
+
+	double n = operands_1[0];
+	double k = operands_2[0];
+	bool is_lower = fpclassify(step_1) == FP_ZERO;
+
+	// the ratios would divide zero coefficients by zero below these
+	if (!(k >= 0) || (!is_lower && !(n >= k))) {
+		return false;
+	}
+
+	const double operands[] = { n, k };
+	double value = operation_type_evaluate(type, operands);
+	for (size_t i = 0; i < size; i++) {
+		results[i] = value;
+
+		double ratio = 1;
+		if (is_lower) {
+			for (double j = 0; j < step_2; j++) {
+				ratio *= (n - k - j) / (k + j + 1);
+			}
+			k += step_2;
+		} else {
+			for (double j = 0; j < step_1; j++) {
+				ratio *= (n + j + 1) / (n + j + 1 - k);
+			}
+			n += step_1;
+		}
+
+		value = is_logarithmic ? value + log(fabs(ratio)) : value * ratio;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Evaluates an instruction by a recurrence over a block of consecutive indices.
+ *
+ * @return Whether the recurrence applies to the operands' values.
+ */
+static bool block_recur(
+	enum operation_type type,
+	size_t size,
+	const double *restrict operands_1,
+	const double *restrict operands_2,
+	double step_1,
+	double step_2,
+	double *restrict results
+) {
+	switch (type) {
+		case operation_type_sine:
+		case operation_type_cosine: {
+			double sine_step = sin(step_1);
+			double cosine_step = cos(step_1);
+			if (!isfinite(sine_step) || !isfinite(cosine_step)) {
+				return false;
+			}
+
+			// rotates the point on the unit circle by the step at every index, except at the zero
+			// argument, where the sine vanishes exactly
+			double sine = 0;
+			double cosine = 1;
+			for (size_t i = 0; i < size; i++) {
+				if (i % PROGRAM_RECURRENCE_PERIOD == 0 || fpclassify(operands_1[i]) == FP_ZERO) {
+					sine = sin(operands_1[i]);
+					cosine = cos(operands_1[i]);
+				}
+				results[i] = type == operation_type_sine ? sine : cosine;
+
+				double next_sine = sine * cosine_step + cosine * sine_step;
+				cosine = cosine * cosine_step - sine * sine_step;
+				sine = next_sine;
+			}
+		} break;
+		case operation_type_exponential: {
+			double ratio = exp(step_1);
+			if (!isnormal(ratio)) {
+				return false;
+			}
+
+			// values which underflowed or overflowed can't be advanced, and are evaluated exactly
+			double value = 0;
+			for (size_t i = 0; i < size; i++) {
+				if (i % PROGRAM_RECURRENCE_PERIOD == 0 || !isnormal(value)) {
+					value = exp(operands_1[i]);
+				}
+				results[i] = value;
+				value *= ratio;
+			}
+		} break;
+		case operation_type_exponentiation: {
+			double base = operands_1[0];
+			double ratio = pow(base, step_2);
+			if (!(base > 0) || !isnormal(ratio)) {
+				return false;
+			}
+
+			double value = 0;
+			for (size_t i = 0; i < size; i++) {
+				if (i % PROGRAM_RECURRENCE_PERIOD == 0 || !isnormal(value)) {
+					value = pow(base, operands_2[i]);
+				}
+				results[i] = value;
+				value *= ratio;
+			}
+		} break;
+		case operation_type_factorial:
+		case operation_type_gamma:
+		case operation_type_log_gamma:
+		case operation_type_log_factorial:
+			return block_recur_gamma(type, size, operands_1, step_1, results);
+		case operation_type_binomial:
+		case operation_type_log_binomial:
+			return block_recur_binomial(
+				type,
+				size,
+				operands_1,
+				operands_2,
+				step_1,
+				step_2,
+				results
+			);
+		default: return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Evaluates a program over a block of rows of columns, each the values of a variable, using
+ * recurrences when `steps` isn't `NULL`, and only the instructions flagged in `is_evaluated` when
+ * it isn't `NULL`.
+ */
+static void program_evaluate_columns(
+	const struct program *program,
+	const struct environment *environment,
+	size_t columns_count,
+	const char variables[],
+	const double *const columns[],
+	size_t size,
+	const double steps[],
+	const bool is_evaluated[],
+	double values[]
+) {
+	assert(program != NULL && (columns_count == 0 || (variables != NULL && columns != NULL)));
+	assert(values != NULL && size <= PROGRAM_BLOCK_SIZE);
+
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		const struct instruction *instruction = &program->instructions[i];
+		double *results = &values[i * size];
+
+		if (is_evaluated != NULL && !is_evaluated[i]) {
+			continue;
+		}
+
+		switch (instruction->type) {
+			case expression_type_constant:
+				for (size_t j = 0; j < size; j++) {
+					results[j] = instruction->constant;
+				}
+				break;
+			case expression_type_variable: {
+				size_t column = 0;
+				while (column < columns_count && variables[column] != instruction->variable) {
+					++column;
+				}
+				if (column < columns_count) {
+					memcpy(results, columns[column], size * sizeof(*results));
+					break;
+				}
+
+				double value = environment == NULL
+								   ? NAN
+								   : environment_get_variable(environment, instruction->variable);
+				for (size_t j = 0; j < size; j++) {
+					results[j] = value;
+				}
+			} break;
+			case expression_type_operation: {
+				const size_t *operands = instruction->operation.operands;
+				// operands always come before the operation, so they never alias its results
+				const double *operands_1 = &values[operands[0] * size];
+				size_t arity = operation_type_arity(instruction->operation.type);
+				const double *operands_2 = arity > 1 ? &values[operands[1] * size] : NULL;
+				const double *operands_3 = arity > 2 ? &values[operands[2] * size] : NULL;
+
+				if (steps != NULL && program_is_recurrence(program, steps, i) &&
+					block_recur(
+						instruction->operation.type,
+						size,
+						operands_1,
+						operands_2,
+						steps[operands[0]],
+						operands_2 != NULL ? steps[operands[1]] : 0,
+						results
+					)) {
+					break;
+				}
+
+				block_apply(
+					instruction->operation.type,
+					size,
+					operands_1,
+					operands_2,
+					operands_3,
+					results
+				);
+			} break;
+		}
+	}
+}
+
+void program_evaluate_block(
+	const struct program *program,
+	const struct environment *environment,
+	char variable,
+	const double indices[],
+	size_t size,
+	double values[]
+) {
+	assert(indices != NULL);
+
+	program_evaluate_columns(
+		program,
+		environment,
+		1,
+		&variable,
+		&indices,
+		size,
+		NULL,
+		NULL,
+		values
+	);
+}
+
+void program_evaluate_rows(
+	const struct program *program,
+	const struct environment *environment,
+	size_t columns_count,
+	const char variables[],
+	const double *const columns[],
+	size_t size,
+	double values[]
+) {
+	program_evaluate_columns(
+		program,
+		environment,
+		columns_count,
+		variables,
+		columns,
+		size,
+		NULL,
+		NULL,
+		values
+	);
+}
+
+void program_evaluate_selected(
+	const struct program *program,
+	const struct environment *environment,
+	size_t columns_count,
+	const char variables[],
+	const double *const columns[],
+	size_t size,
+	const bool is_evaluated[],
+	double values[]
+) {
+	assert(is_evaluated != NULL);
+
+	program_evaluate_columns(
+		program,
+		environment,
+		columns_count,
+		variables,
+		columns,
+		size,
+		NULL,
+		is_evaluated,
+		values
+	);
+}
+
+void program_steps(
+	const struct program *program,
+	const struct environment *environment,
+	char variable,
+	double steps[]
+) {
+	assert(program != NULL && steps != NULL);
+
+	// the values of the instructions not depending on the variable, and garbage for the others
+	struct environment variables = environment != NULL ? *environment : environment_new();
+	environment_set_variable(&variables, variable, 0);
+
+	double *values = malloc(program->instructions_count * sizeof(*values));
+	double *results = malloc(program->outputs_count * sizeof(*results));
+	program_evaluate(program, &variables, values, results);
+
+	for (size_t i = 0; i < program->instructions_count; i++) {
+		const struct instruction *instruction = &program->instructions[i];
+
+		switch (instruction->type) {
+			case expression_type_constant: steps[i] = 0; break;
+			case expression_type_variable: steps[i] = instruction->variable == variable; break;
+			case expression_type_operation: {
+				const size_t *operands = instruction->operation.operands;
+				size_t arity = operation_type_arity(instruction->operation.type);
+
+				bool is_invariant[OPERATION_ARITY_MAXIMUM];
+				bool is_constant = true;
+				for (size_t j = 0; j < arity; j++) {
+					is_invariant[j] = fpclassify(steps[operands[j]]) == FP_ZERO;
+					is_constant = is_constant && is_invariant[j];
+				}
+
+				if (is_constant) {
+					steps[i] = 0;
+					break;
+				}
+
+				switch (instruction->operation.type) {
+					case operation_type_addition:
+						steps[i] = steps[operands[0]] + steps[operands[1]];
+						break;
+					case operation_type_subtraction:
+						steps[i] = steps[operands[0]] - steps[operands[1]];
+						break;
+					case operation_type_multiplication:
+						if (is_invariant[0]) {
+							steps[i] = values[operands[0]] * steps[operands[1]];
+						} else if (is_invariant[1]) {
+							steps[i] = steps[operands[0]] * values[operands[1]];
+						} else {
+							steps[i] = NAN;
+						}
+						break;
+					case operation_type_division:
+						steps[i] = is_invariant[1] ? steps[operands[0]] / values[operands[1]] : NAN;
+						break;
+					case operation_type_negation: steps[i] = -steps[operands[0]]; break;
+					default: steps[i] = NAN; break;
+				}
+
+				if (!isfinite(steps[i])) {
+					steps[i] = NAN;
+				}
+			} break;
+		}
+	}
+
+	free(results);
+	free(values);
+}
+
+/**
+ * @brief Checks whether a step is a small positive integer, which factorial-like functions can be
+ * advanced by.
+ */
+static bool step_is_count(double step) {
+	return step >= 1 && step <= PROGRAM_RECURRENCE_STEP_MAXIMUM &&
+		   fpclassify(step - nearbyint(step)) == FP_ZERO;
+}
+
+bool program_is_recurrence(const struct program *program, const double steps[], size_t instruction) {
+	assert(program != NULL && steps != NULL && instruction < program->instructions_count);
+
+	const struct instruction *recurrence = &program->instructions[instruction];
+	if (recurrence->type != expression_type_operation) {
+		return false;
+	}
+
+	const size_t *operands = recurrence->operation.operands;
+	switch (recurrence->operation.type) {
+		case operation_type_sine:
+		case operation_type_cosine:
+		case operation_type_exponential:
+			return isfinite(steps[operands[0]]) && fpclassify(steps[operands[0]]) != FP_ZERO;
+		case operation_type_exponentiation:
+			return fpclassify(steps[operands[0]]) == FP_ZERO && isfinite(steps[operands[1]]) &&
+				   fpclassify(steps[operands[1]]) != FP_ZERO;
+		case operation_type_factorial:
+		case operation_type_gamma:
+		case operation_type_log_gamma:
+		case operation_type_log_factorial: return step_is_count(steps[operands[0]]);
+		case operation_type_binomial:
+		case operation_type_log_binomial:
+			return (fpclassify(steps[operands[0]]) == FP_ZERO && step_is_count(steps[operands[1]])) ||
+				   (step_is_count(steps[operands[0]]) && fpclassify(steps[operands[1]]) == FP_ZERO);
+		default: return false;
+	}
+}
+
+void program_evaluate_recurrence(
+	const struct program *program,
+	const struct environment *environment,
+	char variable,
+	const double indices[],
+	size_t size,
+	const double steps[],
+	double values[]
+) {
+	assert(indices != NULL && steps != NULL);
+
+	program_evaluate_columns(
+		program,
+		environment,
+		1,
+		&variable,
+		&indices,
+		size,
+		steps,
+		NULL,
+		values
+	);
+}
@@ -0,0 +1,554 @@
+#include <rational.h>
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+
+/**
+ * @brief The maximum number of Newton steps approximating the largest root of a denominator.
+ */
+#define RATIONAL_NEWTON_STEPS 4096
+
+/**
+ * @brief The number of fractions of each denominator tried on either side of an approximate root.
+ *
+ * Newton's method converges slowly to multiple roots, and stops short of them where the rounding
+ * errors of the polynomial exceed its value.
+ */
+#define RATIONAL_CANDIDATES_COUNT 64
+
+/**
+ * @brief The number of terms of a partial fraction summed directly rather than in closed form.
+ */
+#define RATIONAL_DIRECT_COUNT 32
+
+/**
+ * @brief The smallest argument of the Euler-Maclaurin formula, plus twice the multiplicity.
+ *
+ * The terms of the formula shrink with the argument and grow with the multiplicity, so that 8 of
+ * them are within rounding errors of the sum from there.
+ */
+#define RATIONAL_SHIFT 16
+
+/**
+ * @brief The Bernoulli numbers `B_2`, `B_4`, ..., `B_16`, divided by the factorials of their
+ * indices.
+ */
+static const double rational_bernoulli[] = {
+	1.0 / 12,
+	-1.0 / 720,
+	1.0 / 30240,
+	-1.0 / 1209600,
+	1.0 / 47900160,
+	-691.0 / 1307674368000,
+	1.0 / 74724249600,
+	-3617.0 / 10670622842880000,
+};
+
+/**
+ * @brief Computes `x ^ -power - (x + count) ^ -power` for positive `x`, without cancellation.
+ */
+static double rational_power_difference(double power, double x, double count) {
+	assert(x > 0 && count >= 0);
+
+	return -pow(x, -power) * expm1(-power * log1p(count / x));
+}
+
+/**
+ * @brief Computes the sum of `(x + k) ^ -multiplicity` for `k` from 0 to `count - 1`.
+ *
+ * This is `zeta(multiplicity, x) - zeta(multiplicity, x + count)` for the Hurwitz zeta, or
+ * `digamma(x + count) - digamma(x)` for a multiplicity of 1.
+ */
+static double rational_zeta_difference(size_t multiplicity, double x, double count) {
+	assert(multiplicity >= 1 && x > 0);
+
+	double power = (double)multiplicity;
+	double shift = RATIONAL_SHIFT + 2 * power;
+
+	double sum = 0;
+	while (count >= 1 && (x < shift || count <= RATIONAL_DIRECT_COUNT)) {
+		sum += pow(x, -power);
+		x += 1;
+		count -= 1;
+	}
+
+	if (count < 1) {
+		return sum;
+	}
+
+	// the integral, the halves of the first and last terms, and the corrections of the derivatives
+	double tail = multiplicity == 1 ? log1p(count / x)
+									: rational_power_difference(power - 1, x, count) / (power - 1);
+	tail += rational_power_difference(power, x, count) / 2;
+
+	double factor = power;
+	for (size_t i = 0; i < sizeof(rational_bernoulli) / sizeof(rational_bernoulli[0]); i++) {
+		double order = power + (double)(2 * i);
+		tail += rational_bernoulli[i] * factor * rational_power_difference(order + 1, x, count);
+		factor *= (order + 1) * (order + 2);
+	}
+
+	return sum + tail;
+}
+
+double rational_fraction_sum(double root, size_t multiplicity, long lower_bound, long upper_bound) {
+	assert(multiplicity >= 1);
+
+	if (lower_bound > upper_bound) {
+		return 0;
+	}
+
+	double lower = (double)lower_bound;
+	double upper = (double)upper_bound;
+
+	// the indices above the root, and those below it, where the powers of odd multiplicities are
+	// negative
+	double first = fmax(lower, floor(root) + 1);
+	double last = fmin(upper, ceil(root) - 1);
+	double above = upper > root ? upper - first + 1 : 0;
+	double below = lower < root ? last - lower + 1 : 0;
+
+	// with odd multiplicities, the terms at the same distances on either side of the root cancel
+	// out exactly, while their sums would cancel out catastrophically
+	if (multiplicity % 2 == 1 && first - root >= root - last && first - root <= root - last) {
+		double mirrored = fmin(above, below);
+		first += mirrored;
+		above -= mirrored;
+		last -= mirrored;
+		below -= mirrored;
+	}
+
+	double sum = 0;
+	if (above > 0) {
+		sum += rational_zeta_difference(multiplicity, first - root, above);
+	}
+	if (below > 0) {
+		double terms = rational_zeta_difference(multiplicity, root - last, below);
+		sum += multiplicity % 2 == 0 ? terms : -terms;
+	}
+
+	return sum;
+}
+
+double rational_sum(const struct rational *rational) {
+	assert(rational != NULL);
+
+	double sum = 0;
+	for (size_t i = 0; i < rational->fractions_count; i++) {
+		sum += rational->coefficients[i] * rational_fraction_sum(
+											   rational->roots[i],
+											   rational->multiplicities[i],
+											   rational->lower_bound,
+											   rational->upper_bound
+										   );
+	}
+
+	return sum + polynomial_sum(&rational->quotient, rational->lower_bound, rational->upper_bound);
+}
+
+/**
+ * @brief Checks whether a value is a root of a polynomial, up to rounding errors.
+ */
+static bool rational_is_root(const struct polynomial *polynomial, double root) {
+	assert(polynomial != NULL);
+
+	// the magnitudes of the terms of the polynomial, to tell its roots from rounding errors
+	double value = 0;
+	double magnitude = 0;
+	for (size_t i = polynomial->degree + 1; i-- > 0;) {
+		value = value * root + polynomial->coefficients[i];
+		magnitude = magnitude * fabs(root) + fabs(polynomial->coefficients[i]);
+	}
+
+	return isfinite(magnitude) &&
+		   fabs(value) <= magnitude * (double)(4 * polynomial->degree) * DBL_EPSILON;
+}
+
+/**
+ * @brief Finds a rational root of a polynomial of real roots.
+ *
+ * Newton's method from above the roots converges to the largest one, and the fractions of small
+ * denominators nearest to where it stops are then tried, the integers first.
+ */
+static bool rational_root(const struct polynomial *polynomial, double *root) {
+	assert(polynomial != NULL && polynomial->degree > 0 && root != NULL);
+
+	const double *coefficients = polynomial->coefficients;
+	double bound = 0;
+	for (size_t i = 0; i < polynomial->degree; i++) {
+		bound = fmax(bound, fabs(coefficients[i] / coefficients[polynomial->degree]));
+	}
+
+	double x = 1 + bound;
+	for (size_t i = 0; i < RATIONAL_NEWTON_STEPS; i++) {
+		double value = 0;
+		double slope = 0;
+		for (size_t j = polynomial->degree + 1; j-- > 0;) {
+			slope = slope * x + value;
+			value = value * x + coefficients[j];
+		}
+
+		double next = x - value / slope;
+		if (!(next < x)) {
+			break;
+		}
+		x = next;
+	}
+
+	if (!isfinite(x)) {
+		return false;
+	}
+
+	for (long denominator = 1; denominator <= RATIONAL_DENOMINATOR_MAXIMUM; denominator++) {
+		double nearest = nearbyint(x * (double)denominator);
+		for (long i = 0; i <= 2 * RATIONAL_CANDIDATES_COUNT; i++) {
+			double numerator = nearest + (double)(i % 2 == 0 ? i / 2 : -(i + 1) / 2);
+			double candidate = numerator / (double)denominator;
+			if (rational_is_root(polynomial, candidate)) {
+				*root = candidate;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Divides a polynomial by the variable minus one of its roots.
+ */
+static void rational_deflate(struct polynomial *polynomial, double root) {
+	assert(polynomial != NULL && polynomial->degree > 0);
+
+	double carry = polynomial->coefficients[polynomial->degree];
+	for (size_t i = polynomial->degree; i-- > 0;) {
+		double coefficient = polynomial->coefficients[i];
+		polynomial->coefficients[i] = carry;
+		carry = coefficient + carry * root;
+	}
+
+	polynomial->coefficients[polynomial->degree] = 0;
+	--polynomial->degree;
+}
+
+/**
+ * @brief Factors a polynomial into its leading coefficient and powers of the variable minus its
+ * roots, which must all be fractions of small denominators.
+ */
+static bool rational_factor(
+	const struct polynomial *polynomial,
+	double roots[],
+	size_t multiplicities[],
+	size_t *roots_count
+) {
+	assert(polynomial != NULL && roots != NULL && multiplicities != NULL && roots_count != NULL);
+
+	*roots_count = 0;
+	struct polynomial remaining = *polynomial;
+	while (remaining.degree > 0) {
+		double root = 0;
+		if (!rational_root(&remaining, &root)) {
+			return false;
+		}
+
+		size_t multiplicity = 0;
+		while (remaining.degree > 0 && rational_is_root(&remaining, root)) {
+			rational_deflate(&remaining, root);
+			++multiplicity;
+		}
+
+		roots[*roots_count] = root;
+		multiplicities[(*roots_count)++] = multiplicity;
+	}
+
+	// the factors must multiply back into the polynomial, up to rounding errors
+	struct polynomial product = polynomial_constant(polynomial->coefficients[polynomial->degree]);
+	struct polynomial magnitudes = polynomial_constant(fabs(product.coefficients[0]));
+	for (size_t i = 0; i < *roots_count; i++) {
+		for (size_t j = 0; j < multiplicities[i]; j++) {
+			++product.degree;
+			++magnitudes.degree;
+			for (size_t k = product.degree + 1; k-- > 0;) {
+				double lower = k == 0 ? 0 : product.coefficients[k - 1];
+				double lower_magnitude = k == 0 ? 0 : magnitudes.coefficients[k - 1];
+				double coefficient = k == product.degree ? 0 : product.coefficients[k];
+				double magnitude = k == product.degree ? 0 : magnitudes.coefficients[k];
+				product.coefficients[k] = lower - roots[i] * coefficient;
+				magnitudes.coefficients[k] = lower_magnitude + fabs(roots[i]) * magnitude;
+			}
+		}
+	}
+
+	for (size_t i = 0; i <= polynomial->degree; i++) {
+		double error = fabs(product.coefficients[i] - polynomial->coefficients[i]);
+		double tolerance =
+			magnitudes.coefficients[i] * (double)(8 * polynomial->degree) * DBL_EPSILON;
+		if (!(error <= tolerance)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Adds a partial fraction to a rational summand, merging it with the fraction of the same
+ * root and multiplicity.
+ */
+static bool rational_push(
+	struct rational *rational,
+	double coefficient,
+	double root,
+	size_t multiplicity
+) {
+	assert(rational != NULL);
+
+	for (size_t i = 0; i < rational->fractions_count; i++) {
+		if (rational->roots[i] >= root && rational->roots[i] <= root &&
+			rational->multiplicities[i] == multiplicity) {
+			rational->coefficients[i] += coefficient;
+			return true;
+		}
+	}
+
+	if (rational->fractions_count == RATIONAL_FRACTIONS_MAXIMUM) {
+		return false;
+	}
+
+	rational->coefficients[rational->fractions_count] = coefficient;
+	rational->roots[rational->fractions_count] = root;
+	rational->multiplicities[rational->fractions_count] = multiplicity;
+	++rational->fractions_count;
+
+	return true;
+}
+
+/**
+ * @brief Adds a polynomial times a coefficient to the polynomial part of a rational summand.
+ */
+static void rational_push_quotient(
+	struct rational *rational,
+	double coefficient,
+	const struct polynomial *polynomial
+) {
+	assert(rational != NULL && polynomial != NULL);
+
+	// the coefficients past the degree are zeros
+	struct polynomial *quotient = &rational->quotient;
+	if (polynomial->degree > quotient->degree) {
+		quotient->degree = polynomial->degree;
+	}
+	for (size_t i = 0; i <= polynomial->degree; i++) {
+		quotient->coefficients[i] += coefficient * polynomial->coefficients[i];
+	}
+}
+
+/**
+ * @brief Decomposes a quotient of polynomials into partial fractions.
+ *
+ * Adds `coefficient` times the polynomial part of `numerator / denominator` and its partial
+ * fractions to `rational`. The coefficients of the fractions at a root `r` of multiplicity `m`
+ * are the first `m` coefficients of the Taylor series at `r` of the remainder of the numerator
+ * divided by the other factors of the denominator.
+ */
+static bool rational_push_fractions(
+	struct rational *rational,
+	double coefficient,
+	const struct polynomial *numerator,
+	const struct polynomial *denominator
+) {
+	assert(rational != NULL && numerator != NULL && denominator != NULL);
+
+	double leading = denominator->coefficients[denominator->degree];
+	if (denominator->degree == 0) {
+		if (fpclassify(leading) == FP_ZERO) {
+			return false;
+		}
+
+		rational_push_quotient(rational, coefficient / leading, numerator);
+		return true;
+	}
+
+	double roots[POLYNOMIAL_DEGREE_MAXIMUM];
+	size_t multiplicities[POLYNOMIAL_DEGREE_MAXIMUM];
+	size_t roots_count = 0;
+	if (!rational_factor(denominator, roots, multiplicities, &roots_count)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < roots_count; i++) {
+		bool is_pole = nearbyint(roots[i]) >= roots[i] && nearbyint(roots[i]) <= roots[i] &&
+					   roots[i] >= (double)rational->lower_bound &&
+					   roots[i] <= (double)rational->upper_bound;
+		if (is_pole) {
+			return false;
+		}
+	}
+
+	// the polynomial part, leaving the remainder
+	struct polynomial remainder = *numerator;
+	if (numerator->degree >= denominator->degree) {
+		struct polynomial quotient = { .degree = numerator->degree - denominator->degree };
+		for (size_t i = numerator->degree + 1; i-- > denominator->degree;) {
+			double factor = remainder.coefficients[i] / leading;
+			quotient.coefficients[i - denominator->degree] = factor;
+			for (size_t j = 0; j <= denominator->degree; j++) {
+				remainder.coefficients[i - denominator->degree + j] -=
+					factor * denominator->coefficients[j];
+			}
+		}
+		remainder.degree = denominator->degree - 1;
+		rational_push_quotient(rational, coefficient, &quotient);
+	}
+
+	for (size_t i = 0; i < roots_count; i++) {
+		// the remainder and the other factors, in powers of the variable minus the root
+		struct polynomial shifted = remainder;
+		for (size_t j = 0; j < shifted.degree; j++) {
+			for (size_t k = shifted.degree; k-- > j;) {
+				shifted.coefficients[k] += roots[i] * shifted.coefficients[k + 1];
+			}
+		}
+
+		struct polynomial others = polynomial_constant(leading);
+		for (size_t j = 0; j < roots_count; j++) {
+			for (size_t k = 0; k < multiplicities[j] && j != i; k++) {
+				++others.degree;
+				others.coefficients[others.degree] = 0;
+				for (size_t l = others.degree; l > 0; l--) {
+					others.coefficients[l] = others.coefficients[l - 1] +
+											 (roots[i] - roots[j]) * others.coefficients[l];
+				}
+				others.coefficients[0] *= roots[i] - roots[j];
+			}
+		}
+
+		double series[POLYNOMIAL_DEGREE_MAXIMUM];
+		for (size_t j = 0; j < multiplicities[i]; j++) {
+			series[j] = j <= shifted.degree ? shifted.coefficients[j] : 0;
+			for (size_t k = 1; k <= j && k <= others.degree; k++) {
+				series[j] -= others.coefficients[k] * series[j - k];
+			}
+			series[j] /= others.coefficients[0];
+
+			if (fpclassify(series[j]) != FP_ZERO &&
+				!rational_push(
+					rational,
+					coefficient * series[j],
+					roots[i],
+					multiplicities[i] - j
+				)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Splits the value of an instruction into polynomials and quotients of polynomials, and
+ * adds them to a rational summand.
+ *
+ * Splits along additions, subtractions, negations and multiplications and divisions by
+ * constants, and adds the terms, scaled by `coefficient`, to `rational`.
+ */
+static bool rational_split(
+	const struct program *program,
+	size_t instruction,
+	char variable,
+	double coefficient,
+	struct rational *rational
+) {
+	assert(program != NULL && rational != NULL);
+
+	const struct instruction *current = &program->instructions[instruction];
+	if (current->type == expression_type_operation) {
+		const size_t *operands = current->operation.operands;
+
+		switch (current->operation.type) {
+			case operation_type_addition:
+				return rational_split(program, operands[0], variable, coefficient, rational) &&
+					   rational_split(program, operands[1], variable, coefficient, rational);
+			case operation_type_subtraction:
+				return rational_split(program, operands[0], variable, coefficient, rational) &&
+					   rational_split(program, operands[1], variable, -coefficient, rational);
+			case operation_type_negation:
+				return rational_split(program, operands[0], variable, -coefficient, rational);
+			case operation_type_multiplication: {
+				for (size_t i = 0; i < 2; i++) {
+					const struct instruction *factor = &program->instructions[operands[i]];
+					if (factor->type == expression_type_constant) {
+						return rational_split(
+							program,
+							operands[1 - i],
+							variable,
+							coefficient * factor->constant,
+							rational
+						);
+					}
+				}
+			} break;
+			case operation_type_division: {
+				const struct instruction *divisor = &program->instructions[operands[1]];
+				if (divisor->type == expression_type_constant) {
+					return rational_split(
+						program,
+						operands[0],
+						variable,
+						coefficient / divisor->constant,
+						rational
+					);
+				}
+			} break;
+			default: break;
+		}
+	}
+
+	// the numerator and the denominator of a quotient, as if they were the outputs of the program
+	bool is_quotient = current->type == expression_type_operation &&
+					   current->operation.type == operation_type_division;
+	size_t outputs[] = { is_quotient ? current->operation.operands[0] : instruction,
+						 is_quotient ? current->operation.operands[1] : instruction };
+	struct program operands = *program;
+	operands.outputs = outputs;
+	operands.outputs_count = is_quotient ? 2 : 1;
+
+	struct polynomial polynomials[2] = { polynomial_constant(0), polynomial_constant(1) };
+	bool is_polynomial[2] = { false, true };
+	polynomial_from_program(&operands, variable, polynomials, is_polynomial);
+	if (!is_polynomial[0] || !is_polynomial[1] || !isfinite(coefficient)) {
+		return false;
+	}
+
+	return rational_push_fractions(rational, coefficient, &polynomials[0], &polynomials[1]);
+}
+
+void rational_from_program(
+	const struct program *program,
+	char variable,
+	long lower_bound,
+	long upper_bound,
+	struct rational rationals[],
+	bool is_rational[]
+) {
+	assert(program != NULL && lower_bound <= upper_bound);
+	assert(program->outputs_count == 0 || (rationals != NULL && is_rational != NULL));
+
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		rationals[i] = (struct rational){
+			.quotient = polynomial_constant(0),
+			.fractions_count = 0,
+			.lower_bound = lower_bound,
+			.upper_bound = upper_bound,
+		};
+
+		const struct polynomial *quotient = &rationals[i].quotient;
+		is_rational[i] = rational_split(program, program->outputs[i], variable, 1, &rationals[i]) &&
+						 polynomial_is_well_conditioned(quotient, lower_bound, upper_bound);
+		if (!is_rational[i]) {
+			rationals[i].fractions_count = 0;
+		}
+	}
+}
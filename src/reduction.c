@@ -0,0 +1,150 @@
+#include <reduction.h>
+
+#include <assert.h>
+#include <math.h>
+
+struct reduction reduction_new(void) {
+	return (struct reduction){
+		.count = 0,
+		.non_finite_count = 0,
+		.sum = 0,
+		.minimum = INFINITY,
+		.minimum_index = 0,
+		.maximum = -INFINITY,
+		.maximum_index = 0,
+		.mean = 0,
+		.squared_deviations = 0,
+		.absolute_sum = 0,
+		.scale = 0,
+		.scaled_squares = 0,
+	};
+}
+
+void reduction_add(
+	struct reduction *reduction,
+	long first_index,
+	size_t size,
+	const double terms[]
+) {
+	assert(reduction != NULL && (size == 0 || terms != NULL));
+
+	unsigned long finite_count = reduction->count - reduction->non_finite_count;
+	for (size_t i = 0; i < size; i++) {
+		double term = terms[i];
+
+		// the sum is the same as that of the summation, in the same order
+		reduction->sum += term;
+		if (!isfinite(term)) {
+			++reduction->non_finite_count;
+			continue;
+		}
+
+		long index = (long)((unsigned long)first_index + i);
+		if (term < reduction->minimum) {
+			reduction->minimum = term;
+			reduction->minimum_index = index;
+		}
+		if (term > reduction->maximum) {
+			reduction->maximum = term;
+			reduction->maximum_index = index;
+		}
+
+		++finite_count;
+		double deviation = term - reduction->mean;
+		reduction->mean += deviation / (double)finite_count;
+		reduction->squared_deviations += deviation * (term - reduction->mean);
+
+		double magnitude = fabs(term);
+		reduction->absolute_sum += magnitude;
+		if (magnitude > reduction->scale) {
+			double ratio = reduction->scale / magnitude;
+			reduction->scaled_squares = 1 + reduction->scaled_squares * ratio * ratio;
+			reduction->scale = magnitude;
+		} else if (magnitude > 0) {
+			double ratio = magnitude / reduction->scale;
+			reduction->scaled_squares += ratio * ratio;
+		}
+	}
+	reduction->count += size;
+}
+
+void reduction_merge(struct reduction *reduction, const struct reduction *other) {
+	assert(reduction != NULL && other != NULL);
+
+	unsigned long finite_count = reduction->count - reduction->non_finite_count;
+	unsigned long other_finite_count = other->count - other->non_finite_count;
+
+	reduction->count += other->count;
+	reduction->non_finite_count += other->non_finite_count;
+	reduction->sum += other->sum;
+
+	if (other->minimum < reduction->minimum) {
+		reduction->minimum = other->minimum;
+		reduction->minimum_index = other->minimum_index;
+	}
+	if (other->maximum > reduction->maximum) {
+		reduction->maximum = other->maximum;
+		reduction->maximum_index = other->maximum_index;
+	}
+
+	// the means and deviations of both parts are combined as by Chan et al.
+	if (other_finite_count != 0) {
+		double total = (double)(finite_count + other_finite_count);
+		double difference = other->mean - reduction->mean;
+		reduction->mean += difference * ((double)other_finite_count / total);
+		reduction->squared_deviations +=
+			other->squared_deviations +
+			difference * difference *
+				((double)finite_count * ((double)other_finite_count / total));
+	}
+
+	reduction->absolute_sum += other->absolute_sum;
+	if (other->scale > reduction->scale) {
+		double ratio = reduction->scale / other->scale;
+		reduction->scaled_squares =
+			other->scaled_squares + reduction->scaled_squares * ratio * ratio;
+		reduction->scale = other->scale;
+	} else if (other->scale > 0) {
+		double ratio = other->scale / reduction->scale;
+		reduction->scaled_squares += other->scaled_squares * ratio * ratio;
+	}
+}
+
+struct reduction reduction_combine(
+	const struct reduction reductions[],
+	size_t count,
+	size_t stride
+) {
+	assert(reductions != NULL || count == 0);
+
+	if (count == 0) {
+		return reduction_new();
+	}
+	if (count == 1) {
+		return reductions[0];
+	}
+
+	size_t half = count / 2;
+	struct reduction reduction = reduction_combine(reductions, half, stride);
+	struct reduction other = reduction_combine(reductions + half * stride, count - half, stride);
+	reduction_merge(&reduction, &other);
+
+	return reduction;
+}
+
+double reduction_variance(const struct reduction *reduction) {
+	assert(reduction != NULL);
+
+	unsigned long finite_count = reduction->count - reduction->non_finite_count;
+	if (finite_count == 0) {
+		return NAN;
+	}
+
+	return reduction->squared_deviations / (double)finite_count;
+}
+
+double reduction_l2_norm(const struct reduction *reduction) {
+	assert(reduction != NULL);
+
+	return reduction->scale * sqrt(reduction->scaled_squares);
+}
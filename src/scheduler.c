@@ -0,0 +1,321 @@
+#include <scheduler.h>
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NANOSECONDS_PER_SECOND 1000000000.0
+
+/**
+ * @brief A contiguous chunk of leaves, from `first` inclusive to `last` exclusive.
+ */
+struct chunk {
+	size_t first;
+	size_t last;
+};
+
+/**
+ * @brief A deque of chunks.
+ *
+ * The owner pushes and pops chunks at the back, while other threads steal them from the front.
+ */
+struct deque {
+	pthread_mutex_t mutex;
+	struct chunk *chunks;
+	size_t front;
+	size_t back;
+	size_t capacity;
+	atomic_size_t size; ///< Allows checking for stealable chunks without locking.
+};
+
+struct scheduler {
+	struct deque *deques;
+	size_t threads_count;
+	size_t leaves_count;
+	scheduler_function function;
+	void *context;
+	atomic_size_t idle_count;
+	atomic_size_t done_count;
+	atomic_size_t steals_count;
+	struct scheduler_statistics *statistics;
+};
+
+struct scheduler_thread {
+	struct scheduler *scheduler;
+	size_t thread;
+};
+
+static double seconds_now(void) {
+	struct timespec time;
+	(void)clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+static void deque_push(struct deque *deque, struct chunk chunk) {
+	assert(deque != NULL);
+
+	pthread_mutex_lock(&deque->mutex);
+
+	if (deque->back == deque->capacity) {
+		if (deque->front > 0) {
+			for (size_t i = deque->front; i < deque->back; i++) {
+				deque->chunks[i - deque->front] = deque->chunks[i];
+			}
+			deque->back -= deque->front;
+			deque->front = 0;
+		} else {
+			deque->capacity = deque->capacity == 0 ? 8 : 2 * deque->capacity;
+			deque->chunks = realloc(deque->chunks, deque->capacity * sizeof(*deque->chunks));
+		}
+	}
+
+	deque->chunks[deque->back++] = chunk;
+	atomic_fetch_add(&deque->size, 1);
+
+	pthread_mutex_unlock(&deque->mutex);
+}
+
+static bool deque_pop(struct deque *deque, struct chunk *chunk, bool is_stealing) {
+	assert(deque != NULL && chunk != NULL);
+
+	if (atomic_load(&deque->size) == 0) {
+		return false;
+	}
+
+	pthread_mutex_lock(&deque->mutex);
+
+	bool is_popped = deque->front < deque->back;
+	if (is_popped) {
+		*chunk = is_stealing ? deque->chunks[deque->front++] : deque->chunks[--deque->back];
+		atomic_fetch_sub(&deque->size, 1);
+	}
+	if (deque->front == deque->back) {
+		deque->front = 0;
+		deque->back = 0;
+	}
+
+	pthread_mutex_unlock(&deque->mutex);
+
+	return is_popped;
+}
+
+static void scheduler_process(struct scheduler *scheduler, size_t thread, struct chunk chunk) {
+	assert(scheduler != NULL);
+
+	struct deque *deque = &scheduler->deques[thread];
+
+	double start = scheduler->statistics != NULL ? seconds_now() : 0;
+
+	while (chunk.first < chunk.last) {
+		// only split when someone is waiting for work that can't be stolen from us already
+		if (chunk.last - chunk.first >= 2 && atomic_load(&scheduler->idle_count) > 0 &&
+			atomic_load(&deque->size) == 0) {
+			size_t middle = chunk.first + (chunk.last - chunk.first) / 2;
+			deque_push(deque, (struct chunk){ .first = middle, .last = chunk.last });
+			chunk.last = middle;
+		}
+
+		scheduler->function(scheduler->context, thread, chunk.first++);
+		atomic_fetch_add(&scheduler->done_count, 1);
+
+		if (scheduler->statistics != NULL) {
+			++scheduler->statistics->leaves_count[thread];
+		}
+	}
+
+	if (scheduler->statistics != NULL) {
+		scheduler->statistics->busy_seconds[thread] += seconds_now() - start;
+	}
+}
+
+static bool scheduler_steal(struct scheduler *scheduler, size_t thread, struct chunk *chunk) {
+	assert(scheduler != NULL && chunk != NULL);
+
+	for (size_t i = 1; i < scheduler->threads_count; i++) {
+		size_t victim = (thread + i) % scheduler->threads_count;
+		if (deque_pop(&scheduler->deques[victim], chunk, true)) {
+			atomic_fetch_add(&scheduler->steals_count, 1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void *scheduler_thread(void *argument) {
+	assert(argument != NULL);
+
+	struct scheduler_thread *scheduler_thread = argument;
+	struct scheduler *scheduler = scheduler_thread->scheduler;
+	size_t thread = scheduler_thread->thread;
+
+	struct chunk chunk;
+	while (true) {
+		if (deque_pop(&scheduler->deques[thread], &chunk, false)) {
+			scheduler_process(scheduler, thread, chunk);
+			continue;
+		}
+
+		atomic_fetch_add(&scheduler->idle_count, 1);
+
+		bool is_stolen = false;
+		while (atomic_load(&scheduler->done_count) < scheduler->leaves_count) {
+			is_stolen = scheduler_steal(scheduler, thread, &chunk);
+			if (is_stolen) {
+				break;
+			}
+			sched_yield();
+		}
+
+		atomic_fetch_sub(&scheduler->idle_count, 1);
+
+		if (!is_stolen) {
+			return NULL;
+		}
+
+		scheduler_process(scheduler, thread, chunk);
+	}
+}
+
+size_t scheduler_default_threads_count(void) {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (size_t)count : 1;
+}
+
+void scheduler_run(
+	size_t threads_count,
+	size_t leaves_count,
+	scheduler_function function,
+	void *context,
+	struct scheduler_statistics *statistics
+) {
+	assert(function != NULL);
+
+	if (threads_count == 0) {
+		threads_count = scheduler_default_threads_count();
+	}
+	if (threads_count > leaves_count) {
+		threads_count = leaves_count;
+	}
+
+	if (statistics != NULL) {
+		for (size_t i = 0; i < threads_count; i++) {
+			statistics->busy_seconds[i] = 0;
+			statistics->leaves_count[i] = 0;
+		}
+		statistics->steals_count = 0;
+	}
+
+	if (leaves_count == 0) {
+		return;
+	}
+
+	struct scheduler scheduler = {
+		.deques = malloc(threads_count * sizeof(*scheduler.deques)),
+		.threads_count = threads_count,
+		.leaves_count = leaves_count,
+		.function = function,
+		.context = context,
+		.statistics = statistics,
+	};
+	atomic_init(&scheduler.idle_count, 0);
+	atomic_init(&scheduler.done_count, 0);
+	atomic_init(&scheduler.steals_count, 0);
+
+	for (size_t i = 0; i < threads_count; i++) {
+		struct deque *deque = &scheduler.deques[i];
+		pthread_mutex_init(&deque->mutex, NULL);
+		deque->chunks = NULL;
+		deque->front = 0;
+		deque->back = 0;
+		deque->capacity = 0;
+		atomic_init(&deque->size, 0);
+
+		deque_push(
+			deque,
+			(struct chunk){
+				.first = i * leaves_count / threads_count,
+				.last = (i + 1) * leaves_count / threads_count,
+			}
+		);
+	}
+
+	struct scheduler_thread *threads = malloc(threads_count * sizeof(*threads));
+	pthread_t *handles = malloc(threads_count * sizeof(*handles));
+
+	for (size_t i = 0; i < threads_count; i++) {
+		threads[i] = (struct scheduler_thread){ .scheduler = &scheduler, .thread = i };
+	}
+
+	size_t started_count = 1;
+	while (started_count < threads_count &&
+		   pthread_create(
+			   &handles[started_count],
+			   NULL,
+			   scheduler_thread,
+			   &threads[started_count]
+		   ) == 0) {
+		++started_count;
+	}
+
+	// threads that failed to start are covered by stealing, as their deques are still full
+	(void)scheduler_thread(&threads[0]);
+
+	for (size_t i = 1; i < started_count; i++) {
+		pthread_join(handles[i], NULL);
+	}
+
+	if (statistics != NULL) {
+		statistics->steals_count = atomic_load(&scheduler.steals_count);
+	}
+
+	for (size_t i = 0; i < threads_count; i++) {
+		pthread_mutex_destroy(&scheduler.deques[i].mutex);
+		free(scheduler.deques[i].chunks);
+	}
+	free(handles);
+	free(threads);
+	free(scheduler.deques);
+}
+
+void scheduler_partition(
+	long lower_bound,
+	long upper_bound,
+	size_t parts_count,
+	size_t part,
+	long *part_lower_bound,
+	long *part_upper_bound
+) {
+	assert(lower_bound <= upper_bound && part < parts_count);
+	assert(part_lower_bound != NULL && part_upper_bound != NULL);
+
+	unsigned long range = (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+	unsigned long part_size = range / parts_count;
+	unsigned long remainder = range % parts_count;
+
+	unsigned long start = part * part_size + (part < remainder ? part : remainder);
+	unsigned long size = part_size + (part < remainder ? 1 : 0);
+
+	*part_lower_bound = (long)((unsigned long)lower_bound + start);
+	*part_upper_bound = (long)((unsigned long)*part_lower_bound + size - 1);
+}
+
+double scheduler_sum(const double values[], size_t count, size_t stride) {
+	assert(values != NULL || count == 0);
+
+	if (count == 0) {
+		return 0;
+	}
+	if (count == 1) {
+		return values[0];
+	}
+
+	size_t half = count / 2;
+	return scheduler_sum(values, half, stride) +
+		   scheduler_sum(values + half * stride, count - half, stride);
+}
@@ -0,0 +1,202 @@
+#include <segment_cache.h>
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SEGMENT_CACHE_MAGIC "SUMSEGM1"
+
+/**
+ * @brief The header of a segment cache's file.
+ *
+ * The header is followed by the entries.
+ */
+struct segment_cache_header {
+	char magic[8];
+	uint64_t entry_size; ///< Guards against caches written by an incompatible build.
+	uint64_t entries_count;
+	uint64_t clock; ///< Incremented at every use of an entry, to order them by recency.
+};
+
+/**
+ * @brief Converts an index to its offset from the smallest `long`, where segments are aligned.
+ */
+static uint64_t segment_cache_offset(long index) {
+	return (uint64_t)index ^ (UINT64_C(1) << 63);
+}
+
+size_t segment_cache_size(size_t entries_count) {
+	return sizeof(struct segment_cache_header) + entries_count * sizeof(struct segment_cache_entry);
+}
+
+/**
+ * @brief Checks whether an open file holds a segment cache, and gets its number of entries.
+ */
+static bool segment_cache_is_valid(int file, size_t *entries_count) {
+	assert(entries_count != NULL);
+
+	struct stat status;
+	struct segment_cache_header header;
+	if (fstat(file, &status) != 0 || (size_t)status.st_size < sizeof(header) ||
+		pread(file, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+		return false;
+	}
+
+	*entries_count = header.entries_count;
+	return memcmp(header.magic, SEGMENT_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+		   header.entry_size == sizeof(struct segment_cache_entry) &&
+		   header.entries_count <= (size_t)status.st_size &&
+		   segment_cache_size(header.entries_count) == (size_t)status.st_size;
+}
+
+int segment_cache_open(struct segment_cache *cache, const char *path, size_t size) {
+	assert(cache != NULL && path != NULL && size >= segment_cache_size(1));
+
+	int file = open(path, O_RDWR | O_CREAT, 0644);
+	if (file < 0) {
+		(void)fprintf(stderr, "Error: Failed to open \"%s\"\n", path);
+		return EXIT_FAILURE;
+	}
+
+	// other processes may be creating the same cache
+	if (flock(file, LOCK_EX) != 0) {
+		(void)fprintf(stderr, "Error: Failed to lock \"%s\"\n", path);
+		(void)close(file);
+		return EXIT_FAILURE;
+	}
+
+	size_t entries_count = 0;
+	if (!segment_cache_is_valid(file, &entries_count)) {
+		entries_count = (size - sizeof(struct segment_cache_header)) /
+						sizeof(struct segment_cache_entry);
+
+		// truncating the file to zeros empties all the entries
+		struct segment_cache_header header = {
+			.entry_size = sizeof(struct segment_cache_entry),
+			.entries_count = entries_count,
+			.clock = 0,
+		};
+		memcpy(header.magic, SEGMENT_CACHE_MAGIC, sizeof(header.magic));
+		if (ftruncate(file, 0) != 0 ||
+			ftruncate(file, (off_t)segment_cache_size(entries_count)) != 0 ||
+			pwrite(file, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+			(void)fprintf(stderr, "Error: Failed to write to \"%s\"\n", path);
+			(void)close(file);
+			return EXIT_FAILURE;
+		}
+	}
+
+	size_t mapping_size = segment_cache_size(entries_count);
+	void *mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	(void)flock(file, LOCK_UN);
+	if (mapping == MAP_FAILED) {
+		(void)fprintf(stderr, "Error: Failed to map \"%s\"\n", path);
+		(void)close(file);
+		return EXIT_FAILURE;
+	}
+
+	*cache = (struct segment_cache){
+		.file = file,
+		.mapping = mapping,
+		.mapping_size = mapping_size,
+		.entries = (struct segment_cache_entry *)((char *)mapping +
+												  sizeof(struct segment_cache_header)),
+		.entries_count = entries_count,
+	};
+
+	return EXIT_SUCCESS;
+}
+
+void segment_cache_close(struct segment_cache *cache) {
+	assert(cache != NULL);
+
+	munmap(cache->mapping, cache->mapping_size);
+	(void)close(cache->file);
+}
+
+/**
+ * @brief Gets the next value of the clock of a locked cache.
+ */
+static uint64_t segment_cache_tick(struct segment_cache *cache) {
+	assert(cache != NULL);
+
+	struct segment_cache_header *header = cache->mapping;
+	return ++header->clock;
+}
+
+bool segment_cache_get(struct segment_cache *cache, long start, size_t level, double *sum) {
+	assert(cache != NULL && sum != NULL);
+
+	bool is_cached = false;
+	(void)flock(cache->file, LOCK_EX);
+	for (size_t i = 0; i < cache->entries_count; i++) {
+		struct segment_cache_entry *entry = &cache->entries[i];
+		if (entry->level == level && entry->start == start) {
+			entry->last_used = segment_cache_tick(cache);
+			*sum = entry->sum;
+			is_cached = true;
+			break;
+		}
+	}
+	(void)flock(cache->file, LOCK_UN);
+
+	return is_cached;
+}
+
+bool segment_cache_has_inside(struct segment_cache *cache, long start, size_t level) {
+	assert(cache != NULL && level <= SEGMENT_CACHE_LEVEL_MAXIMUM);
+
+	uint64_t first = segment_cache_offset(start);
+	uint64_t last = first + ((UINT64_C(1) << level) - 1);
+
+	bool is_inside = false;
+	(void)flock(cache->file, LOCK_SH);
+	for (size_t i = 0; i < cache->entries_count && !is_inside; i++) {
+		const struct segment_cache_entry *entry = &cache->entries[i];
+		uint64_t offset = segment_cache_offset((long)entry->start);
+		is_inside = entry->level != 0 && entry->level < level && offset >= first && offset <= last;
+	}
+	(void)flock(cache->file, LOCK_UN);
+
+	return is_inside;
+}
+
+void segment_cache_put(struct segment_cache *cache, long start, size_t level, double sum) {
+	assert(cache != NULL && level >= 1 && level <= SEGMENT_CACHE_LEVEL_MAXIMUM);
+	assert(segment_cache_offset(start) % (UINT64_C(1) << level) == 0);
+
+	(void)flock(cache->file, LOCK_EX);
+
+	// the same segment if another process cached it meanwhile, or else an empty or the least
+	// recently used entry
+	struct segment_cache_entry *victim = NULL;
+	for (size_t i = 0; i < cache->entries_count; i++) {
+		struct segment_cache_entry *entry = &cache->entries[i];
+		if (entry->level == level && entry->start == start) {
+			victim = entry;
+			break;
+		}
+		if (victim == NULL || victim->level != 0) {
+			if (entry->level == 0 || victim == NULL || entry->last_used < victim->last_used) {
+				victim = entry;
+			}
+		}
+	}
+
+	if (victim != NULL) {
+		*victim = (struct segment_cache_entry){
+			.start = start,
+			.level = level,
+			.last_used = segment_cache_tick(cache),
+			.sum = sum,
+		};
+	}
+
+	(void)flock(cache->file, LOCK_UN);
+}
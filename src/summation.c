@@ -1,28 +1,1119 @@
 #include <summation.h>
 
 #include <assert.h>
+#include <cache.h>
+#include <cost_model.h>
+#include <math.h>
+#include <program.h>
+#include <scheduler.h>
+#include <segment_cache.h>
+#include <stdatomic.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 double summation(long lower_bound, long upper_bound, const char *summand) {
 	assert(summand != NULL);
 
-	if (lower_bound > upper_bound) {
-		return 0;
+	double sum = 0;
+	summation_fused(lower_bound, upper_bound, 1, &summand, &sum, NULL);
+
+	return sum;
+}
+
+/**
+ * @brief Compiles summands into a program
+ *
+ * Parses and simplifies the summands and compiles them into a single program. When a cache
+ * directory is given, a program compiled from the same summands by an earlier call, possibly in
+ * another process, is loaded from it instead, unless simplified differently by another version,
+ * and newly compiled programs are saved to it.
+ */
+static struct program summation_compile(
+	size_t count,
+	const char *const summands[],
+	const struct summation_options *options
+) {
+	assert(summands != NULL && options != NULL);
+
+	char *path = NULL;
+	char *key = NULL;
+	size_t key_size = 0;
+	if (options->cache_directory != NULL) {
+		// the version of the simplifications and the summands, each with its terminator to keep
+		// ("a", "bc") and ("ab", "c") apart, which are saved with the program and compared on load
+		const uint64_t header[] = { EXPRESSION_SIMPLIFY_VERSION, count };
+		key_size = sizeof(header);
+		for (size_t i = 0; i < count; i++) {
+			key_size += strlen(summands[i]) + 1;
+		}
+		key = malloc(key_size);
+		memcpy(key, header, sizeof(header));
+		for (size_t i = 0, offset = sizeof(header); i < count; i++) {
+			size_t length = strlen(summands[i]) + 1;
+			memcpy(key + offset, summands[i], length);
+			offset += length;
+		}
+
+		path = cache_path(
+			options->cache_directory,
+			cache_hash(CACHE_HASH_INITIAL, key, key_size),
+			"program"
+		);
+
+		struct program program;
+		if (path != NULL && program_load(&program, key, key_size, path) == EXIT_SUCCESS) {
+			if (program.outputs_count == count) {
+				free(key);
+				free(path);
+				return program;
+			}
+			program_drop(&program);
+		}
 	}
 
-	struct expression expression = expression_from_string(summand);
 	struct environment environment = environment_new();
 
-	expression_simplify(&expression, &environment);
+	struct expression *expressions = malloc(count * sizeof(*expressions));
+	for (size_t i = 0; i < count; i++) {
+		assert(summands[i] != NULL);
+
+		expressions[i] = expression_from_string(summands[i]);
+		expression_simplify(&expressions[i], &environment);
+	}
+
+	struct program program = program_new(count, expressions);
+
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+	free(expressions);
+
+	if (path != NULL) {
+		// the cache is only an optimization, so failing to save to it isn't fatal
+		(void)program_save(&program, key, key_size, path);
+		free(path);
+	}
+	free(key);
+
+	return program;
+}
+
+/**
+ * @brief The minimum number of indices in a leaf of a summation.
+ */
+#define SUMMATION_LEAF_SIZE_MINIMUM 1024
+/**
+ * @brief The maximum number of leaves of a summation.
+ */
+#define SUMMATION_LEAVES_MAXIMUM 4096
+
+#define NANOSECONDS_PER_SECOND 1000000000.0
+
+/**
+ * @brief The state of a summation shared by the threads evaluating it.
+ */
+struct summation_context {
+	const struct summation_plan *plan;
+	const struct program *program;
+	const double *steps; ///< Steps of the program's instructions, for the recurrence engine.
+	enum summation_engine engine;
+	long lower_bound;
+	long upper_bound;
+	size_t leaves_count;
+	double *values;	 ///< Scratch values of the program, one row of `values_count` per thread.
+	size_t values_count;
+	double *terms;	 ///< Terms of the summands, one row per thread.
+	double *results; ///< Sums of the summands over each leaf, one row per leaf.
+	/// Reductions of the summands over each leaf, one row per leaf, or `NULL` to only sum them.
+	struct reduction *reductions;
+	struct summation_monitor *monitor; ///< The monitor of the execution, or `NULL`.
+	atomic_bool *is_leaf_done;		   ///< Whether each leaf is done, if monitored.
+	atomic_ulong terms_done;		   ///< Number of indices done, if monitored.
+	double start_seconds;			   ///< When the execution started, if monitored.
+	double report_seconds;			   ///< When to report the progress next, if monitored.
+	double *sums; ///< Totals of the summations, partial ones while reporting progress.
+};
+
+static double seconds_now(void) {
+	struct timespec time;
+	(void)clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+/**
+ * @brief Reports the progress of a monitored summation.
+ */
+static void summation_report(const struct summation_context *context, unsigned long terms_done) {
+	assert(context != NULL && context->monitor != NULL);
+
+	unsigned long terms_count =
+		context->lower_bound > context->upper_bound
+			? 0
+			: (unsigned long)context->upper_bound - (unsigned long)context->lower_bound + 1;
+	double seconds = seconds_now() - context->start_seconds;
+
+	const struct summation_progress progress = {
+		.terms_done = terms_done,
+		.terms_count = terms_count,
+		.terms_per_second = seconds > 0 ? (double)terms_done / seconds : 0,
+		.sums = context->sums,
+		.count = context->plan->count,
+	};
+	context->monitor->function(context->monitor->context, &progress);
+}
+
+/**
+ * @brief Accounts for a block of indices being done in a monitored summation.
+ *
+ * Reports the progress when it's time to, from the calling thread only so that reports never
+ * overlap, with the partial sums of the leaves done so far.
+ *
+ * @return Whether to carry on, as the summation wasn't cancelled.
+ */
+static bool summation_checkpoint(struct summation_context *context, size_t thread, size_t size) {
+	assert(context != NULL);
+
+	struct summation_monitor *monitor = context->monitor;
+	if (monitor == NULL) {
+		return true;
+	}
+
+	unsigned long terms_done =
+		atomic_fetch_add_explicit(&context->terms_done, size, memory_order_relaxed) + size;
+
+	if (thread == 0 && monitor->function != NULL && seconds_now() >= context->report_seconds) {
+		const struct summation_plan *plan = context->plan;
+
+		// the program computes the summands not summed in closed form, in order
+		size_t output = 0;
+		for (size_t i = 0; i < plan->count; i++) {
+			if (plan->is_closed_form[i]) {
+				continue;
+			}
+
+			size_t outputs_count = context->program->outputs_count;
+			context->sums[i] = 0;
+			for (size_t j = 0; j < context->leaves_count; j++) {
+				if (atomic_load_explicit(&context->is_leaf_done[j], memory_order_acquire)) {
+					context->sums[i] += context->results[j * outputs_count + output];
+				}
+			}
+			++output;
+		}
+
+		summation_report(context, terms_done);
+		context->report_seconds = seconds_now() + monitor->interval_seconds;
+	}
+
+	return !atomic_load_explicit(&monitor->is_cancelled, memory_order_relaxed);
+}
+
+/**
+ * @brief Adds up the terms of a leaf one index at a time, or reduces them if `reductions` isn't
+ * `NULL`.
+ *
+ * @return Whether the leaf is done, as the summation wasn't cancelled.
+ */
+static bool summation_leaf_scalar(
+	struct summation_context *context,
+	size_t thread,
+	long lower_bound,
+	long upper_bound,
+	double values[],
+	double terms[],
+	double sums[],
+	struct reduction reductions[]
+) {
+	assert(context != NULL && values != NULL && terms != NULL && sums != NULL);
+
+	const struct program *program = context->program;
+	struct environment environment = environment_new();
+
+	size_t length = (size_t)((unsigned long)upper_bound - (unsigned long)lower_bound + 1);
+	for (size_t offset = 0; offset < length; offset += PROGRAM_BLOCK_SIZE) {
+		size_t size = length - offset < PROGRAM_BLOCK_SIZE ? length - offset : PROGRAM_BLOCK_SIZE;
+		for (size_t i = 0; i < size; i++) {
+			long index = lower_bound + (long)(offset + i);
+			environment_set_variable(&environment, 'i', (double)index);
+
+			program_evaluate(program, &environment, values, terms);
+			for (size_t j = 0; j < program->outputs_count; j++) {
+				if (reductions != NULL) {
+					reduction_add(&reductions[j], index, 1, &terms[j]);
+					continue;
+				}
+				sums[j] += terms[j];
+			}
+		}
+
+		if (!summation_checkpoint(context, thread, size)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Adds up the terms of a leaf one block of indices at a time, using recurrences if `steps`
+ * isn't `NULL`, or reduces them if `reductions` isn't `NULL`.
+ *
+ * @return Whether the leaf is done, as the summation wasn't cancelled.
+ */
+static bool summation_leaf_block(
+	struct summation_context *context,
+	size_t thread,
+	long lower_bound,
+	long upper_bound,
+	const double steps[],
+	double values[],
+	double sums[],
+	struct reduction reductions[]
+) {
+	assert(context != NULL && values != NULL && sums != NULL);
+
+	const struct program *program = context->program;
+	double indices[PROGRAM_BLOCK_SIZE];
+	struct environment environment = environment_new();
+
+	size_t length = (size_t)((unsigned long)upper_bound - (unsigned long)lower_bound + 1);
+	for (size_t offset = 0; offset < length; offset += PROGRAM_BLOCK_SIZE) {
+		size_t size = length - offset < PROGRAM_BLOCK_SIZE ? length - offset : PROGRAM_BLOCK_SIZE;
+		for (size_t i = 0; i < size; i++) {
+			indices[i] = (double)(lower_bound + (long)(offset + i));
+		}
+
+		if (steps != NULL) {
+			program_evaluate_recurrence(program, &environment, 'i', indices, size, steps, values);
+		} else {
+			program_evaluate_block(program, &environment, 'i', indices, size, values);
+		}
+		for (size_t i = 0; i < program->outputs_count; i++) {
+			const double *terms = &values[program->outputs[i] * size];
+			if (reductions != NULL) {
+				reduction_add(&reductions[i], lower_bound + (long)offset, size, terms);
+				continue;
+			}
+			for (size_t j = 0; j < size; j++) {
+				sums[i] += terms[j];
+			}
+		}
+
+		if (!summation_checkpoint(context, thread, size)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Adds up the terms of a leaf with the plan's kernel, one block of indices at a time.
+ *
+ * @return Whether the leaf is done, as the summation wasn't cancelled.
+ */
+static bool summation_leaf_native(
+	struct summation_context *context,
+	size_t thread,
+	long lower_bound,
+	long upper_bound,
+	double sums[]
+) {
+	assert(context != NULL && sums != NULL);
+
+	size_t length = (size_t)((unsigned long)upper_bound - (unsigned long)lower_bound + 1);
+	for (size_t offset = 0; offset < length; offset += PROGRAM_BLOCK_SIZE) {
+		size_t size = length - offset < PROGRAM_BLOCK_SIZE ? length - offset : PROGRAM_BLOCK_SIZE;
+		long first = lower_bound + (long)offset;
+		kernel_run(&context->plan->kernel, first, first + (long)(size - 1), sums);
+
+		if (!summation_checkpoint(context, thread, size)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void summation_leaf(void *context_, size_t thread, size_t leaf) {
+	assert(context_ != NULL);
+
+	struct summation_context *context = context_;
+	const struct program *program = context->program;
+
+	// the leaves left when cancelled are skipped quickly
+	if (context->monitor != NULL &&
+		atomic_load_explicit(&context->monitor->is_cancelled, memory_order_relaxed)) {
+		return;
+	}
+
+	long lower_bound = 0;
+	long upper_bound = 0;
+	scheduler_partition(
+		context->lower_bound,
+		context->upper_bound,
+		context->leaves_count,
+		leaf,
+		&lower_bound,
+		&upper_bound
+	);
+
+	double *values = &context->values[thread * context->values_count];
+	double *terms = &context->terms[thread * program->outputs_count];
+	double *sums = &context->results[leaf * program->outputs_count];
+	struct reduction *reductions = NULL;
+	if (context->reductions != NULL) {
+		reductions = &context->reductions[leaf * program->outputs_count];
+	}
+
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		sums[i] = 0;
+		if (reductions != NULL) {
+			reductions[i] = reduction_new();
+		}
+	}
+
+	bool is_done = false;
+	switch (context->engine) {
+		case summation_engine_automatic: assert(false); break;
+		case summation_engine_scalar:
+			is_done = summation_leaf_scalar(
+				context,
+				thread,
+				lower_bound,
+				upper_bound,
+				values,
+				terms,
+				sums,
+				reductions
+			);
+			break;
+		case summation_engine_block:
+			is_done = summation_leaf_block(
+				context,
+				thread,
+				lower_bound,
+				upper_bound,
+				NULL,
+				values,
+				sums,
+				reductions
+			);
+			break;
+		case summation_engine_recurrence:
+			is_done = summation_leaf_block(
+				context,
+				thread,
+				lower_bound,
+				upper_bound,
+				context->steps,
+				values,
+				sums,
+				reductions
+			);
+			break;
+		case summation_engine_native:
+			assert(reductions == NULL);
+			is_done = summation_leaf_native(context, thread, lower_bound, upper_bound, sums);
+			break;
+	}
+
+	if (context->is_leaf_done != NULL) {
+		atomic_store_explicit(&context->is_leaf_done[leaf], is_done, memory_order_release);
+	}
+}
+
+/**
+ * @brief Chooses the number of threads with the lowest estimated time.
+ *
+ * Every thread but the calling one takes some time to start, which isn't worth it for small
+ * summations.
+ */
+static size_t summation_plan_threads(
+	const struct summation_plan *plan,
+	const struct cost_model *cost_model,
+	double work_seconds
+) {
+	assert(plan != NULL && cost_model != NULL);
+
+	size_t maximum = scheduler_default_threads_count();
+	if (maximum > plan->leaves_count) {
+		maximum = plan->leaves_count;
+	}
+
+	size_t threads_count = 1;
+	double seconds = work_seconds;
+	for (size_t i = 2; i <= maximum; i++) {
+		double estimate = work_seconds / (double)i + (double)(i - 1) * cost_model->thread_seconds;
+		if (estimate < seconds) {
+			threads_count = i;
+			seconds = estimate;
+		}
+	}
+
+	return threads_count;
+}
+
+struct summation_plan summation_plan_new(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	const struct summation_options *options
+) {
+	assert(count == 0 || summands != NULL);
+
+	struct summation_options default_options = summation_options_default();
+	if (options == NULL) {
+		options = &default_options;
+	}
+
+	struct summation_plan plan = {
+		.lower_bound = lower_bound,
+		.upper_bound = upper_bound,
+		.count = count,
+		.is_closed_form = calloc(count, sizeof(*plan.is_closed_form)),
+		.polynomials = calloc(count, sizeof(*plan.polynomials)),
+		.is_telescoping = calloc(count, sizeof(*plan.is_telescoping)),
+		.telescopings = calloc(count, sizeof(*plan.telescopings)),
+		.is_periodic = calloc(count, sizeof(*plan.is_periodic)),
+		.periodicities = calloc(count, sizeof(*plan.periodicities)),
+		.is_rational = calloc(count, sizeof(*plan.is_rational)),
+		.rationals = calloc(count, sizeof(*plan.rationals)),
+		.steps = NULL,
+		.kernel = { .handle = NULL, .function = NULL },
+		.engine = options->engine == summation_engine_automatic ? summation_engine_block
+																: options->engine,
+		.term_seconds = { 0 },
+		.leaves_count = 0,
+		.threads_count = 0,
+		.estimated_seconds = 0,
+	};
+
+	if (lower_bound > upper_bound || count == 0) {
+		plan.program = program_new(0, NULL);
+		return plan;
+	}
+
+	struct program program = summation_compile(count, summands, options);
+
+	// closed forms compute the totals differently, so they're only used when allowed to
+	if (options->engine == summation_engine_automatic) {
+		piecewise_polynomial_from_program(
+			&program,
+			'i',
+			lower_bound,
+			upper_bound,
+			plan.polynomials,
+			plan.is_closed_form
+		);
+		for (size_t i = 0; i < count; i++) {
+			plan.is_closed_form[i] = plan.is_closed_form[i] &&
+									 piecewise_polynomial_is_well_conditioned(&plan.polynomials[i]);
+		}
+
+		telescoping_from_program(
+			&program,
+			'i',
+			lower_bound,
+			upper_bound,
+			plan.telescopings,
+			plan.is_telescoping
+		);
+
+		periodicity_from_program(
+			&program,
+			'i',
+			lower_bound,
+			upper_bound,
+			plan.periodicities,
+			plan.is_periodic
+		);
+
+		rational_from_program(
+			&program,
+			'i',
+			lower_bound,
+			upper_bound,
+			plan.rationals,
+			plan.is_rational
+		);
+
+		// polynomials are summed exactly, so they're preferred, and then the shortest sums
+		for (size_t i = 0; i < count; i++) {
+			if (plan.is_closed_form[i] && plan.is_telescoping[i]) {
+				telescoping_drop(&plan.telescopings[i]);
+				plan.is_telescoping[i] = false;
+			}
+			plan.is_closed_form[i] = plan.is_closed_form[i] || plan.is_telescoping[i];
+
+			if (plan.is_closed_form[i] && plan.is_periodic[i]) {
+				periodicity_drop(&plan.periodicities[i]);
+				plan.is_periodic[i] = false;
+			}
+			plan.is_closed_form[i] = plan.is_closed_form[i] || plan.is_periodic[i];
+
+			plan.is_rational[i] = !plan.is_closed_form[i] && plan.is_rational[i];
+			plan.is_closed_form[i] = plan.is_closed_form[i] || plan.is_rational[i];
+		}
+
+		// the polynomials in disguise only show in the values of the summands
+		struct polynomial *polynomials = malloc(count * sizeof(*polynomials));
+		bool *is_polynomial = malloc(count * sizeof(*is_polynomial));
+		polynomial_from_samples(
+			&program,
+			'i',
+			lower_bound,
+			upper_bound,
+			polynomials,
+			is_polynomial
+		);
+		for (size_t i = 0; i < count; i++) {
+			if (!plan.is_closed_form[i] && is_polynomial[i]) {
+				piecewise_polynomial_drop(&plan.polynomials[i]);
+				plan.polynomials[i] =
+					piecewise_polynomial_from_polynomial(&polynomials[i], lower_bound, upper_bound);
+				plan.is_closed_form[i] =
+					piecewise_polynomial_is_well_conditioned(&plan.polynomials[i]);
+			}
+		}
+		free(is_polynomial);
+		free(polynomials);
+	}
+
+	size_t *outputs = malloc(count * sizeof(*outputs));
+	size_t outputs_count = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (!plan.is_closed_form[i]) {
+			outputs[outputs_count++] = i;
+		}
+	}
+
+	plan.program = program_select(&program, outputs_count, outputs);
+
+	free(outputs);
+	program_drop(&program);
+
+	if (outputs_count == 0) {
+		return plan;
+	}
+
+	plan.steps = malloc(plan.program.instructions_count * sizeof(*plan.steps));
+	program_steps(&plan.program, NULL, 'i', plan.steps);
+
+	const struct cost_model *cost_model = cost_model_get(options->cache_directory);
+	plan.term_seconds[summation_engine_scalar] =
+		cost_model_estimate(cost_model, &plan.program, false, NULL);
+	plan.term_seconds[summation_engine_block] =
+		cost_model_estimate(cost_model, &plan.program, true, NULL);
+	plan.term_seconds[summation_engine_recurrence] =
+		cost_model_estimate(cost_model, &plan.program, true, plan.steps);
+	// the cost model isn't calibrated for kernels, which are at most as slow as blocks
+	plan.term_seconds[summation_engine_native] = plan.term_seconds[summation_engine_block];
+
+	// only strictly faster engines are chosen over the block engine, as it computes exact terms
+	if (options->engine == summation_engine_automatic) {
+		for (size_t i = 0; i < SUMMATION_ENGINES_COUNT; i++) {
+			if (i != summation_engine_automatic && i != summation_engine_native &&
+				plan.term_seconds[i] < plan.term_seconds[plan.engine]) {
+				plan.engine = (enum summation_engine)i;
+			}
+		}
+	}
+
+	if (plan.engine == summation_engine_native &&
+		kernel_new(&plan.kernel, &plan.program, options->cache_directory) == EXIT_FAILURE) {
+		plan.engine = summation_engine_block;
+	}
+
+	unsigned long range = (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+	plan.leaves_count = (range + SUMMATION_LEAF_SIZE_MINIMUM - 1) / SUMMATION_LEAF_SIZE_MINIMUM;
+	if (plan.leaves_count > SUMMATION_LEAVES_MAXIMUM) {
+		plan.leaves_count = SUMMATION_LEAVES_MAXIMUM;
+	}
+
+	double work_seconds = (double)range * plan.term_seconds[plan.engine];
+	if (options->threads_count != 0) {
+		plan.threads_count = options->threads_count < plan.leaves_count ? options->threads_count
+																		: plan.leaves_count;
+	} else {
+		plan.threads_count = summation_plan_threads(&plan, cost_model, work_seconds);
+	}
+
+	plan.estimated_seconds = work_seconds / (double)plan.threads_count +
+							 (double)(plan.threads_count - 1) * cost_model->thread_seconds;
+
+	return plan;
+}
+
+void summation_plan_drop(struct summation_plan *plan) {
+	assert(plan != NULL);
+
+	if (plan->kernel.handle != NULL) {
+		kernel_drop(&plan->kernel);
+	}
+	free(plan->steps);
+	program_drop(&plan->program);
+	for (size_t i = 0; i < plan->count; i++) {
+		piecewise_polynomial_drop(&plan->polynomials[i]);
+		if (plan->is_telescoping[i]) {
+			telescoping_drop(&plan->telescopings[i]);
+		}
+		if (plan->is_periodic[i]) {
+			periodicity_drop(&plan->periodicities[i]);
+		}
+	}
+	free(plan->rationals);
+	free(plan->is_rational);
+	free(plan->periodicities);
+	free(plan->is_periodic);
+	free(plan->telescopings);
+	free(plan->is_telescoping);
+	free(plan->polynomials);
+	free(plan->is_closed_form);
+}
+
+/**
+ * @brief Executes a summation plan, reducing the terms of the summands instead of only summing
+ * them if `reductions` isn't `NULL`.
+ */
+static int summation_plan_run(
+	const struct summation_plan *plan,
+	double sums[],
+	struct reduction reductions[],
+	struct summation_monitor *monitor
+) {
+	assert(plan != NULL && (plan->count == 0 || sums != NULL || reductions != NULL));
+
+	for (size_t i = 0; reductions != NULL && i < plan->count; i++) {
+		assert(!plan->is_closed_form[i]);
+
+		reductions[i] = reduction_new();
+	}
+
+	for (size_t i = 0; reductions == NULL && i < plan->count; i++) {
+		if (plan->is_telescoping[i]) {
+			sums[i] = telescoping_sum(&plan->telescopings[i]);
+		} else if (plan->is_periodic[i]) {
+			sums[i] = periodicity_sum(&plan->periodicities[i]);
+		} else if (plan->is_rational[i]) {
+			sums[i] = rational_sum(&plan->rationals[i]);
+		} else if (plan->is_closed_form[i]) {
+			sums[i] = piecewise_polynomial_sum(&plan->polynomials[i]);
+		} else {
+			sums[i] = 0;
+		}
+	}
+
+	const struct program *program = &plan->program;
+
+	size_t values_count = program->instructions_count;
+	if (plan->engine != summation_engine_scalar && plan->engine != summation_engine_native) {
+		values_count *= PROGRAM_BLOCK_SIZE;
+	}
+
+	struct summation_context context = {
+		.plan = plan,
+		.program = program,
+		.steps = plan->steps,
+		.engine = plan->engine,
+		.lower_bound = plan->lower_bound,
+		.upper_bound = plan->upper_bound,
+		.leaves_count = plan->leaves_count,
+		.values = NULL,
+		.values_count = values_count,
+		.terms = NULL,
+		.results = NULL,
+		.reductions = NULL,
+		.monitor = monitor,
+		.is_leaf_done = NULL,
+		.start_seconds = monitor != NULL ? seconds_now() : 0,
+		.report_seconds = monitor != NULL ? seconds_now() + monitor->interval_seconds : 0,
+		.sums = sums,
+	};
+	atomic_init(&context.terms_done, 0);
+
+	bool is_done = true;
+	if (program->outputs_count != 0) {
+		context.values = malloc(plan->threads_count * values_count * sizeof(*context.values));
+		context.terms = malloc(plan->threads_count * program->outputs_count * sizeof(*context.terms));
+		context.results =
+			malloc(plan->leaves_count * program->outputs_count * sizeof(*context.results));
+		if (reductions != NULL) {
+			context.reductions =
+				malloc(plan->leaves_count * program->outputs_count * sizeof(*context.reductions));
+		}
+
+		if (monitor != NULL) {
+			context.is_leaf_done = malloc(plan->leaves_count * sizeof(*context.is_leaf_done));
+			for (size_t i = 0; i < plan->leaves_count; i++) {
+				atomic_init(&context.is_leaf_done[i], false);
+			}
+		}
+
+		scheduler_run(plan->threads_count, plan->leaves_count, summation_leaf, &context, NULL);
+
+		for (size_t i = 0; context.is_leaf_done != NULL && i < plan->leaves_count; i++) {
+			is_done = is_done && atomic_load(&context.is_leaf_done[i]);
+		}
+
+		// the program computes the summands not summed in closed form, in order
+		size_t output = 0;
+		for (size_t i = 0; is_done && reductions == NULL && i < plan->count; i++) {
+			if (!plan->is_closed_form[i]) {
+				sums[i] = scheduler_sum(
+					&context.results[output++],
+					plan->leaves_count,
+					program->outputs_count
+				);
+			}
+		}
+		for (size_t i = 0; is_done && reductions != NULL && i < plan->count; i++) {
+			reductions[i] = reduction_combine(
+				&context.reductions[i],
+				plan->leaves_count,
+				program->outputs_count
+			);
+		}
+
+		free(context.is_leaf_done);
+		free(context.reductions);
+		free(context.results);
+		free(context.terms);
+		free(context.values);
+	}
+
+	if (!is_done) {
+		return EXIT_FAILURE;
+	}
+
+	if (monitor != NULL && monitor->function != NULL) {
+		unsigned long terms_count =
+			plan->lower_bound > plan->upper_bound
+				? 0
+				: (unsigned long)plan->upper_bound - (unsigned long)plan->lower_bound + 1;
+		summation_report(&context, terms_count);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int summation_plan_execute_monitored(
+	const struct summation_plan *plan,
+	double sums[],
+	struct summation_monitor *monitor
+) {
+	assert(plan != NULL && (plan->count == 0 || sums != NULL));
+
+	return summation_plan_run(plan, sums, NULL, monitor);
+}
+
+void summation_plan_execute(const struct summation_plan *plan, double sums[]) {
+	(void)summation_plan_execute_monitored(plan, sums, NULL);
+}
+
+void summation_plan_execute_reduced(
+	const struct summation_plan *plan,
+	struct reduction reductions[]
+) {
+	assert(plan != NULL && (plan->count == 0 || reductions != NULL));
+	assert(plan->engine != summation_engine_native);
+
+	(void)summation_plan_run(plan, NULL, reductions, NULL);
+}
+
+void summation_plan_explain(
+	const struct summation_plan *plan,
+	const char *const summands[],
+	FILE *file
+) {
+	assert(plan != NULL && (plan->count == 0 || summands != NULL) && file != NULL);
+
+	if (plan->lower_bound > plan->upper_bound) {
+		(void)fprintf(file, "Empty range from %ld to %ld\n", plan->lower_bound, plan->upper_bound);
+		return;
+	}
+
+	unsigned long range = (unsigned long)plan->upper_bound - (unsigned long)plan->lower_bound + 1;
+	(void)fprintf(
+		file,
+		"Range: %ld to %ld (%lu terms)\n",
+		plan->lower_bound,
+		plan->upper_bound,
+		range
+	);
+
+	for (size_t i = 0; i < plan->count; i++) {
+		if (plan->is_telescoping[i]) {
+			(void)fprintf(
+				file,
+				"Summand \"%s\": closed form, telescoping over %zu shifted terms\n",
+				summands[i],
+				plan->telescopings[i].terms_count
+			);
+		} else if (plan->is_periodic[i]) {
+			(void)fprintf(
+				file,
+				"Summand \"%s\": closed form, periodic with period %zu\n",
+				summands[i],
+				plan->periodicities[i].period
+			);
+		} else if (plan->is_rational[i]) {
+			(void)fprintf(
+				file,
+				"Summand \"%s\": closed form, rational over %zu partial fractions\n",
+				summands[i],
+				plan->rationals[i].fractions_count
+			);
+		} else if (plan->is_closed_form[i] && plan->polynomials[i].pieces_count == 1) {
+			(void)fprintf(
+				file,
+				"Summand \"%s\": closed form, polynomial of degree %zu\n",
+				summands[i],
+				plan->polynomials[i].pieces[0].degree
+			);
+		} else if (plan->is_closed_form[i]) {
+			size_t degree = 0;
+			for (size_t j = 0; j < plan->polynomials[i].pieces_count; j++) {
+				if (plan->polynomials[i].pieces[j].degree > degree) {
+					degree = plan->polynomials[i].pieces[j].degree;
+				}
+			}
+
+			(void)fprintf(
+				file,
+				"Summand \"%s\": closed form, %zu polynomial pieces of degree at most %zu\n",
+				summands[i],
+				plan->polynomials[i].pieces_count,
+				degree
+			);
+		} else {
+			(void)fprintf(file, "Summand \"%s\": iterated\n", summands[i]);
+		}
+	}
+
+	if (plan->program.outputs_count == 0) {
+		return;
+	}
+
+	(void)fprintf(
+		file,
+		"Program: %zu instructions\n"
+		"Engine: %s\n",
+		plan->program.instructions_count,
+		summation_engine_name(plan->engine)
+	);
+	for (size_t i = 0; i < SUMMATION_ENGINES_COUNT; i++) {
+		if (i != summation_engine_automatic) {
+			(void)fprintf(
+				file,
+				"  %-10s %10.2f ns per term\n",
+				summation_engine_name((enum summation_engine)i),
+				plan->term_seconds[i] * NANOSECONDS_PER_SECOND
+			);
+		}
+	}
+	(void)fprintf(
+		file,
+		"Threads: %zu, over %zu leaves\n"
+		"Estimated time: %.3g s\n",
+		plan->threads_count,
+		plan->leaves_count,
+		plan->estimated_seconds
+	);
+}
+
+/**
+ * @brief The state of a summation over cached segments.
+ */
+struct summation_segments {
+	struct segment_cache cache;
+	const char *summand;
+	const struct summation_options *options; ///< The options of the segments, without the cache.
+};
+
+/**
+ * @brief Sums a summand over an aligned segment of `2^level` indices starting at `start`.
+ *
+ * Segments are looked up in the cache, or else assembled from their halves if smaller segments
+ * inside them are cached, or else summed at once, and then cached.
+ */
+static double summation_segment(struct summation_segments *segments, long start, size_t level) {
+	assert(segments != NULL && level >= SEGMENT_CACHE_LEVEL_MINIMUM);
 
 	double sum = 0;
-	for (long index = lower_bound; index <= upper_bound; ++index) {
-		environment_set_variable(&environment, 'i', (double)index);
+	if (segment_cache_get(&segments->cache, start, level, &sum)) {
+		return sum;
+	}
 
-		sum += expression_evaluate(&expression, &environment);
+	unsigned long half = UINT64_C(1) << (level - 1);
+	if (level > SEGMENT_CACHE_LEVEL_MINIMUM &&
+		segment_cache_has_inside(&segments->cache, start, level)) {
+		sum = summation_segment(segments, start, level - 1) +
+			  summation_segment(segments, (long)((unsigned long)start + half), level - 1);
+	} else {
+		long end = (long)((unsigned long)start + (half - 1) + half);
+		summation_fused(start, end, 1, &segments->summand, &sum, segments->options);
 	}
 
-	expression_drop(&expression);
+	segment_cache_put(&segments->cache, start, level, sum);
 
 	return sum;
 }
+
+/**
+ * @brief Sums a summand over cached segments of the range, and over its edges.
+ *
+ * @return EXIT_SUCCESS on success, and EXIT_FAILURE if the range holds no segment or the cache
+ * can't be opened, in which case `sum` isn't set.
+ */
+static int summation_segmented(
+	long lower_bound,
+	long upper_bound,
+	const char *summand,
+	const struct summation_options *options,
+	double *sum
+) {
+	assert(summand != NULL && options != NULL && sum != NULL && lower_bound <= upper_bound);
+
+	// the segments are aligned from the smallest long, which is 0 in unsigned arithmetic
+	uint64_t sign = UINT64_C(1) << 63;
+	uint64_t mask = (UINT64_C(1) << SEGMENT_CACHE_LEVEL_MINIMUM) - 1;
+	uint64_t first = (uint64_t)lower_bound ^ sign;
+	uint64_t last = (uint64_t)upper_bound ^ sign;
+	uint64_t segments_first = (first + mask) & ~mask;
+	uint64_t segments_end = (last & mask) == mask ? (last & ~mask) + mask + 1 : last & ~mask;
+	if (first > UINT64_MAX - mask || segments_end <= segments_first) {
+		return EXIT_FAILURE;
+	}
+
+	struct environment environment = environment_new();
+	struct expression expression = expression_from_string(summand);
+	expression_simplify(&expression, &environment);
+	char *canonical = expression_to_string(&expression);
+	expression_drop(&expression);
+
+	uint64_t key = cache_hash(CACHE_HASH_INITIAL, "segments", sizeof("segments"));
+	key = cache_hash(key, canonical, strlen(canonical) + 1);
+	free(canonical);
+
+	char *path = cache_path(options->cache_directory, key, "segments");
+	struct summation_options segment_options = *options;
+	segment_options.segment_cache_size = 0;
+
+	struct summation_segments segments = {
+		.summand = summand,
+		.options = &segment_options,
+	};
+	size_t size = options->segment_cache_size > segment_cache_size(1) ? options->segment_cache_size
+																		: segment_cache_size(1);
+	if (path == NULL || segment_cache_open(&segments.cache, path, size) == EXIT_FAILURE) {
+		free(path);
+		return EXIT_FAILURE;
+	}
+	free(path);
+
+	double edges[2] = { 0, 0 };
+	if (first < segments_first) {
+		long end = (long)((segments_first - 1) ^ sign);
+		summation_fused(lower_bound, end, 1, &summand, &edges[0], &segment_options);
+	}
+	if (segments_end - 1 < last) {
+		long start = (long)(segments_end ^ sign);
+		summation_fused(start, upper_bound, 1, &summand, &edges[1], &segment_options);
+	}
+
+	// the largest aligned segments covering the rest of the range, as in a segment tree
+	*sum = edges[0];
+	uint64_t offset = segments_first;
+	while (offset != segments_end) {
+		size_t level = SEGMENT_CACHE_LEVEL_MAXIMUM;
+		while (offset % (UINT64_C(1) << level) != 0 || (segments_end - offset) >> level == 0) {
+			--level;
+		}
+
+		*sum += summation_segment(&segments, (long)(offset ^ sign), level);
+		offset += UINT64_C(1) << level;
+	}
+	*sum += edges[1];
+
+	segment_cache_close(&segments.cache);
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Evaluates summations, reusing the partial sums of the segment cache.
+ */
+static void summation_fused_segmented(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	double sums[],
+	const struct summation_options *options
+) {
+	assert(options != NULL);
+
+	for (size_t i = 0; i < count; i++) {
+		struct summation_options summand_options = *options;
+		summand_options.segment_cache_size = 0;
+
+		struct summation_plan plan =
+			summation_plan_new(lower_bound, upper_bound, 1, &summands[i], &summand_options);
+		if (plan.is_closed_form[0] || lower_bound > upper_bound ||
+			summation_segmented(lower_bound, upper_bound, summands[i], options, &sums[i]) ==
+				EXIT_FAILURE) {
+			summation_plan_execute(&plan, &sums[i]);
+		}
+		summation_plan_drop(&plan);
+	}
+}
+
+void summation_fused(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	double sums[],
+	const struct summation_options *options
+) {
+	assert((count == 0 || summands != NULL) && (count == 0 || sums != NULL));
+
+	if (options != NULL && options->cache_directory != NULL && options->segment_cache_size != 0) {
+		summation_fused_segmented(lower_bound, upper_bound, count, summands, sums, options);
+		return;
+	}
+
+	struct summation_plan plan = summation_plan_new(lower_bound, upper_bound, count, summands, options);
+	summation_plan_execute(&plan, sums);
+	summation_plan_drop(&plan);
+}
+
+void summation_reduce_fused(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	struct reduction reductions[],
+	const struct summation_options *options
+) {
+	assert((count == 0 || summands != NULL) && (count == 0 || reductions != NULL));
+
+	// closed forms and kernels only give the sums, so every term is evaluated by the program
+	struct summation_options reduce_options = summation_options_default();
+	if (options != NULL) {
+		reduce_options = *options;
+	}
+	if (reduce_options.engine == summation_engine_automatic ||
+		reduce_options.engine == summation_engine_native) {
+		reduce_options.engine = summation_engine_block;
+	}
+
+	struct summation_plan plan =
+		summation_plan_new(lower_bound, upper_bound, count, summands, &reduce_options);
+	summation_plan_execute_reduced(&plan, reductions);
+	summation_plan_drop(&plan);
+}
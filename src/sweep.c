@@ -0,0 +1,385 @@
+#include <sweep.h>
+
+#include <assert.h>
+#include <ctype.h>
+#include <environment.h>
+#include <math.h>
+#include <program.h>
+#include <scheduler.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief The minimum number of indices in a leaf of a sweep.
+ */
+#define SWEEP_LEAF_SIZE_MINIMUM 1024
+/**
+ * @brief The maximum number of leaves of a sweep, over both the parameter and the indices.
+ */
+#define SWEEP_LEAVES_MAXIMUM 4096
+
+/**
+ * @brief Parses a number of a sweep, up to the next delimiter or the end of the string.
+ *
+ * @return The character after the number, or `NULL` if there's no number there.
+ */
+static const char *sweep_parse_number(const char *string, double *value) {
+	assert(string != NULL && value != NULL);
+
+	char *end = NULL;
+	*value = strtod(string, &end);
+	if (end == string || !isfinite(*value)) {
+		return NULL;
+	}
+
+	return end;
+}
+
+int sweep_parse(struct sweep *sweep, const char *string) {
+	assert(sweep != NULL && string != NULL);
+
+	*sweep = (struct sweep){ .variable = string[0], .values = NULL, .values_count = 0 };
+	if (!isalpha((unsigned char)string[0]) || string[0] == 'i' || string[1] != '=') {
+		(void)fprintf(stderr, "Error: Invalid sweep \"%s\"\n", string);
+		return EXIT_FAILURE;
+	}
+
+	// a grid, of COUNT values from START to STOP
+	double start = 0;
+	double stop = 0;
+	double count = 0;
+	const char *end = sweep_parse_number(&string[2], &start);
+	if (end != NULL && *end == ':') {
+		end = sweep_parse_number(end + 1, &stop);
+		end = end != NULL && *end == ':' ? sweep_parse_number(end + 1, &count) : NULL;
+		if (end == NULL || *end != '\0' || count < 1 || nearbyint(count) < count ||
+			nearbyint(count) > count) {
+			(void)fprintf(stderr, "Error: Invalid sweep \"%s\"\n", string);
+			return EXIT_FAILURE;
+		}
+
+		sweep->values_count = (size_t)count;
+		sweep->values = malloc(sweep->values_count * sizeof(*sweep->values));
+		for (size_t i = 0; i < sweep->values_count; i++) {
+			// the last value is the stop exactly, without rounding errors
+			sweep->values[i] = i + 1 == sweep->values_count && i != 0
+								   ? stop
+								   : start + (stop - start) * (double)i / (count - 1);
+		}
+		if (sweep->values_count == 1) {
+			sweep->values[0] = start;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	// a list of values
+	end = &string[1];
+	do {
+		double value = 0;
+		end = sweep_parse_number(end + 1, &value);
+		if (end == NULL || (*end != ',' && *end != '\0')) {
+			(void)fprintf(stderr, "Error: Invalid sweep \"%s\"\n", string);
+			sweep_drop(sweep);
+			return EXIT_FAILURE;
+		}
+
+		sweep->values =
+			realloc(sweep->values, (sweep->values_count + 1) * sizeof(*sweep->values));
+		sweep->values[sweep->values_count++] = value;
+	} while (*end == ',');
+
+	return EXIT_SUCCESS;
+}
+
+void sweep_drop(struct sweep *sweep) {
+	assert(sweep != NULL);
+
+	free(sweep->values);
+	sweep->values = NULL;
+	sweep->values_count = 0;
+}
+
+/**
+ * @brief the context of a sweep's leaves.
+ *
+ * Each leaf is a block of values of the parameter, summed over one of the parts of the range.
+ */
+struct sweep_context {
+	const struct program *program; ///< The compiled summands.
+	const struct sweep *sweep;	   ///< The sweep of the parameter.
+	long lower_bound;			   ///< The lower bound of the summations.
+	long upper_bound;			   ///< The upper bound of the summations.
+	size_t parts_count;			   ///< The number of parts the range is split into.
+	/// Flags of the instructions not depending on i, evaluated once per leaf.
+	const bool *is_parameter_only;
+	/// Flags of the instructions not depending on the parameter, evaluated once per block of
+	/// indices.
+	const bool *is_index_only;
+	/// Flags of the instructions depending on both, evaluated at every index.
+	const bool *is_mixed;
+	/// Indices of the instructions only depending on i which others depending on both, or the
+	/// outputs, read.
+	const size_t *broadcasts;
+	size_t broadcasts_count; ///< The number of instructions in `broadcasts`.
+	size_t values_count;	 ///< The number of values of each thread's scratch arrays.
+	double *values;			 ///< Scratch arrays of the values over blocks of the parameter.
+	double *index_values;	 ///< Scratch arrays of the values over blocks of indices.
+	double *terms;			 ///< Scratch arrays of the totals of each summand over each block.
+	/// The totals of each summand over each part of the range, for each value of the parameter.
+	double *results;
+};
+
+static void sweep_leaf(void *context_, size_t thread, size_t leaf) {
+	assert(context_ != NULL);
+
+	struct sweep_context *context = context_;
+	const struct program *program = context->program;
+	const struct sweep *sweep = context->sweep;
+
+	size_t part = leaf % context->parts_count;
+	size_t first = leaf / context->parts_count * PROGRAM_BLOCK_SIZE;
+	size_t size = sweep->values_count - first < PROGRAM_BLOCK_SIZE ? sweep->values_count - first
+																	: PROGRAM_BLOCK_SIZE;
+	const double *parameters = &sweep->values[first];
+
+	double *values = &context->values[thread * context->values_count];
+	double *index_values = &context->index_values[thread * context->values_count];
+	double *terms = &context->terms[thread * program->outputs_count * PROGRAM_BLOCK_SIZE];
+	for (size_t i = 0; i < program->outputs_count * size; i++) {
+		terms[i] = 0;
+	}
+
+	struct environment environment = environment_new();
+	program_evaluate_selected(
+		program,
+		&environment,
+		1,
+		&sweep->variable,
+		&parameters,
+		size,
+		context->is_parameter_only,
+		values
+	);
+
+	char index_variable = 'i';
+	double indices[PROGRAM_BLOCK_SIZE];
+	const double *index_column = indices;
+	long lower_bound = 0;
+	long upper_bound = 0;
+	scheduler_partition(
+		context->lower_bound,
+		context->upper_bound,
+		context->parts_count,
+		part,
+		&lower_bound,
+		&upper_bound
+	);
+	unsigned long length = (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+	for (unsigned long offset = 0; offset < length; offset += PROGRAM_BLOCK_SIZE) {
+		size_t block = length - offset < PROGRAM_BLOCK_SIZE ? (size_t)(length - offset)
+															: PROGRAM_BLOCK_SIZE;
+		for (size_t i = 0; i < block; i++) {
+			indices[i] = (double)(long)((unsigned long)lower_bound + offset + i);
+		}
+
+		program_evaluate_selected(
+			program,
+			&environment,
+			1,
+			&index_variable,
+			&index_column,
+			block,
+			context->is_index_only,
+			index_values
+		);
+
+		for (size_t i = 0; i < block; i++) {
+			// the values only depending on i are the same for every value of the parameter
+			for (size_t j = 0; j < context->broadcasts_count; j++) {
+				size_t instruction = context->broadcasts[j];
+				double value = index_values[instruction * block + i];
+				for (size_t k = 0; k < size; k++) {
+					values[instruction * size + k] = value;
+				}
+			}
+
+			program_evaluate_selected(
+				program,
+				&environment,
+				0,
+				NULL,
+				NULL,
+				size,
+				context->is_mixed,
+				values
+			);
+
+			for (size_t j = 0; j < program->outputs_count; j++) {
+				const double *outputs = &values[program->outputs[j] * size];
+				for (size_t k = 0; k < size; k++) {
+					terms[j * size + k] += outputs[k];
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < size; i++) {
+		double *results =
+			&context->results[((first + i) * context->parts_count + part) * program->outputs_count];
+		for (size_t j = 0; j < program->outputs_count; j++) {
+			results[j] = terms[j * size + i];
+		}
+	}
+}
+
+void sweep_summation_fused(
+	long lower_bound,
+	long upper_bound,
+	const struct sweep *sweep,
+	size_t count,
+	const char *const summands[],
+	double sums[],
+	const struct summation_options *options
+) {
+	assert(sweep != NULL && (count == 0 || (summands != NULL && sums != NULL)));
+
+	struct summation_options default_options = summation_options_default();
+	if (options == NULL) {
+		options = &default_options;
+	}
+
+	for (size_t i = 0; i < sweep->values_count * count; i++) {
+		sums[i] = 0;
+	}
+	if (lower_bound > upper_bound || sweep->values_count == 0 || count == 0) {
+		return;
+	}
+
+	struct environment environment = environment_new();
+	struct expression *expressions = malloc(count * sizeof(*expressions));
+	for (size_t i = 0; i < count; i++) {
+		assert(summands[i] != NULL);
+
+		expressions[i] = expression_from_string(summands[i]);
+		expression_simplify(&expressions[i], &environment);
+	}
+
+	struct program program = program_new(count, expressions);
+
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+	free(expressions);
+
+	// which of i and the parameter each instruction depends on
+	size_t instructions_count = program.instructions_count;
+	bool *is_index = calloc(instructions_count, sizeof(*is_index));
+	bool *is_parameter = calloc(instructions_count, sizeof(*is_parameter));
+	for (size_t i = 0; i < instructions_count; i++) {
+		const struct instruction *instruction = &program.instructions[i];
+		if (instruction->type == expression_type_variable) {
+			is_index[i] = instruction->variable == 'i';
+			is_parameter[i] = instruction->variable == sweep->variable;
+		} else if (instruction->type == expression_type_operation) {
+			size_t arity = operation_type_arity(instruction->operation.type);
+			for (size_t j = 0; j < arity; j++) {
+				is_index[i] = is_index[i] || is_index[instruction->operation.operands[j]];
+				is_parameter[i] =
+					is_parameter[i] || is_parameter[instruction->operation.operands[j]];
+			}
+		}
+	}
+
+	bool *is_parameter_only = malloc(instructions_count * sizeof(*is_parameter_only));
+	bool *is_index_only = malloc(instructions_count * sizeof(*is_index_only));
+	bool *is_mixed = malloc(instructions_count * sizeof(*is_mixed));
+	// the constants are evaluated in both passes, as operands of instructions of either
+	for (size_t i = 0; i < instructions_count; i++) {
+		is_parameter_only[i] = !is_index[i];
+		is_index_only[i] = !is_parameter[i];
+		is_mixed[i] = is_index[i] && is_parameter[i];
+	}
+
+	// only the values read over blocks of the parameter need to be spread over them
+	bool *is_read = calloc(instructions_count, sizeof(*is_read));
+	for (size_t i = 0; i < instructions_count; i++) {
+		const struct instruction *instruction = &program.instructions[i];
+		if (is_mixed[i]) {
+			size_t arity = operation_type_arity(instruction->operation.type);
+			for (size_t j = 0; j < arity; j++) {
+				is_read[instruction->operation.operands[j]] = true;
+			}
+		}
+	}
+	for (size_t i = 0; i < count; i++) {
+		is_read[program.outputs[i]] = true;
+	}
+
+	size_t *broadcasts = malloc(instructions_count * sizeof(*broadcasts));
+	size_t broadcasts_count = 0;
+	for (size_t i = 0; i < instructions_count; i++) {
+		if (is_index[i] && !is_parameter[i] && is_read[i]) {
+			broadcasts[broadcasts_count++] = i;
+		}
+	}
+
+	// the range is split too when there are too few blocks of the parameter to share
+	size_t blocks_count = (sweep->values_count + PROGRAM_BLOCK_SIZE - 1) / PROGRAM_BLOCK_SIZE;
+	unsigned long range = (unsigned long)upper_bound - (unsigned long)lower_bound + 1;
+	size_t parts_count = range / SWEEP_LEAF_SIZE_MINIMUM + 1;
+	if (parts_count > SWEEP_LEAVES_MAXIMUM / blocks_count) {
+		parts_count = SWEEP_LEAVES_MAXIMUM / blocks_count;
+	}
+	if (parts_count == 0) {
+		parts_count = 1;
+	}
+	size_t leaves_count = blocks_count * parts_count;
+	size_t threads_count = options->threads_count != 0 ? options->threads_count
+														: scheduler_default_threads_count();
+	if (threads_count > leaves_count) {
+		threads_count = leaves_count;
+	}
+
+	struct sweep_context context = {
+		.program = &program,
+		.sweep = sweep,
+		.lower_bound = lower_bound,
+		.upper_bound = upper_bound,
+		.parts_count = parts_count,
+		.is_parameter_only = is_parameter_only,
+		.is_index_only = is_index_only,
+		.is_mixed = is_mixed,
+		.broadcasts = broadcasts,
+		.broadcasts_count = broadcasts_count,
+		.values_count = instructions_count * PROGRAM_BLOCK_SIZE,
+	};
+	context.values = malloc(threads_count * context.values_count * sizeof(*context.values));
+	context.index_values =
+		malloc(threads_count * context.values_count * sizeof(*context.index_values));
+	context.terms = malloc(threads_count * count * PROGRAM_BLOCK_SIZE * sizeof(*context.terms));
+	context.results =
+		malloc(sweep->values_count * parts_count * count * sizeof(*context.results));
+
+	scheduler_run(threads_count, leaves_count, sweep_leaf, &context, NULL);
+
+	for (size_t i = 0; i < sweep->values_count; i++) {
+		for (size_t j = 0; j < count; j++) {
+			sums[i * count + j] =
+				scheduler_sum(&context.results[i * parts_count * count + j], parts_count, count);
+		}
+	}
+
+	free(context.results);
+	free(context.terms);
+	free(context.index_values);
+	free(context.values);
+	free(broadcasts);
+	free(is_read);
+	free(is_mixed);
+	free(is_index_only);
+	free(is_parameter_only);
+	free(is_parameter);
+	free(is_index);
+	program_drop(&program);
+}
@@ -0,0 +1,269 @@
+#include <task.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NANOSECONDS_PER_SECOND 1000000000L
+
+struct task {
+	long lower_bound;
+	long upper_bound;
+	size_t count;
+	char **summands;
+	char *cache_directory; ///< The copy of the cache directory `options` points to.
+	struct summation_options options;
+	struct summation_monitor monitor;
+	pthread_mutex_t mutex;
+	pthread_cond_t condition; ///< Signaled when the task finishes.
+	enum task_status status;
+	double *sums;
+	struct task *next; ///< The next task in the queue.
+};
+
+/**
+ * @brief The pool of threads running the tasks of the process, and its queue of tasks.
+ */
+static struct {
+	pthread_once_t once;
+	pthread_mutex_t mutex;
+	pthread_cond_t condition; ///< Signaled when a task is queued.
+	struct task *first;
+	struct task *last;
+} pool = {
+	.once = PTHREAD_ONCE_INIT,
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.condition = PTHREAD_COND_INITIALIZER,
+	.first = NULL,
+	.last = NULL,
+};
+
+static void task_finish(struct task *task, enum task_status status) {
+	assert(task != NULL);
+
+	pthread_mutex_lock(&task->mutex);
+	task->status = status;
+	pthread_cond_broadcast(&task->condition);
+	pthread_mutex_unlock(&task->mutex);
+}
+
+static void *task_pool_thread(void *argument) {
+	(void)argument;
+
+	while (true) {
+		pthread_mutex_lock(&pool.mutex);
+		while (pool.first == NULL) {
+			pthread_cond_wait(&pool.condition, &pool.mutex);
+		}
+
+		struct task *task = pool.first;
+		pool.first = task->next;
+		if (pool.first == NULL) {
+			pool.last = NULL;
+		}
+
+		// while the pool is locked, so that cancelling sees the task either queued or running
+		pthread_mutex_lock(&task->mutex);
+		task->status = task_status_running;
+		pthread_mutex_unlock(&task->mutex);
+
+		pthread_mutex_unlock(&pool.mutex);
+
+		struct summation_plan plan = summation_plan_new(
+			task->lower_bound,
+			task->upper_bound,
+			task->count,
+			(const char *const *)task->summands,
+			&task->options
+		);
+		int status = summation_plan_execute_monitored(&plan, task->sums, &task->monitor);
+		summation_plan_drop(&plan);
+
+		task_finish(task, status == EXIT_SUCCESS ? task_status_done : task_status_cancelled);
+	}
+}
+
+static void task_pool_start(void) {
+	size_t started_count = 0;
+	for (size_t i = 0; i < TASK_POOL_THREADS_COUNT; i++) {
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, task_pool_thread, NULL) == 0) {
+			pthread_detach(thread);
+			++started_count;
+		}
+	}
+
+	if (started_count == 0) {
+		(void)fprintf(stderr, "Error: Failed to start the threads running tasks\n");
+	}
+}
+
+struct task *task_submit(
+	long lower_bound,
+	long upper_bound,
+	size_t count,
+	const char *const summands[],
+	const struct summation_options *options,
+	summation_progress_function progress,
+	void *context
+) {
+	assert(count == 0 || summands != NULL);
+
+	struct task *task = malloc(sizeof(*task));
+
+	*task = (struct task){
+		.lower_bound = lower_bound,
+		.upper_bound = upper_bound,
+		.count = count,
+		.summands = malloc(count * sizeof(*task->summands)),
+		.cache_directory = NULL,
+		.options = options != NULL ? *options : summation_options_default(),
+		.monitor = {
+			.function = progress,
+			.context = context,
+			.interval_seconds = TASK_PROGRESS_INTERVAL_SECONDS,
+		},
+		.status = task_status_queued,
+		.sums = calloc(count, sizeof(*task->sums)),
+		.next = NULL,
+	};
+	atomic_init(&task->monitor.is_cancelled, false);
+
+	for (size_t i = 0; i < count; i++) {
+		assert(summands[i] != NULL);
+		task->summands[i] = strdup(summands[i]);
+	}
+	if (task->options.cache_directory != NULL) {
+		task->cache_directory = strdup(task->options.cache_directory);
+		task->options.cache_directory = task->cache_directory;
+	}
+
+	pthread_mutex_init(&task->mutex, NULL);
+
+	pthread_condattr_t attributes;
+	pthread_condattr_init(&attributes);
+	pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+	pthread_cond_init(&task->condition, &attributes);
+	pthread_condattr_destroy(&attributes);
+
+	(void)pthread_once(&pool.once, task_pool_start);
+
+	pthread_mutex_lock(&pool.mutex);
+	if (pool.last != NULL) {
+		pool.last->next = task;
+	} else {
+		pool.first = task;
+	}
+	pool.last = task;
+	pthread_cond_signal(&pool.condition);
+	pthread_mutex_unlock(&pool.mutex);
+
+	return task;
+}
+
+enum task_status task_status(struct task *task) {
+	assert(task != NULL);
+
+	pthread_mutex_lock(&task->mutex);
+	enum task_status status = task->status;
+	pthread_mutex_unlock(&task->mutex);
+
+	return status;
+}
+
+bool task_wait(struct task *task, double timeout_seconds) {
+	assert(task != NULL);
+
+	struct timespec deadline;
+	(void)clock_gettime(CLOCK_MONOTONIC, &deadline);
+	if (timeout_seconds >= 0) {
+		double seconds = floor(timeout_seconds);
+		deadline.tv_sec += (time_t)seconds;
+		deadline.tv_nsec += (long)((timeout_seconds - seconds) * NANOSECONDS_PER_SECOND);
+		if (deadline.tv_nsec >= NANOSECONDS_PER_SECOND) {
+			++deadline.tv_sec;
+			deadline.tv_nsec -= NANOSECONDS_PER_SECOND;
+		}
+	}
+
+	pthread_mutex_lock(&task->mutex);
+	while (task->status == task_status_queued || task->status == task_status_running) {
+		if (timeout_seconds < 0) {
+			pthread_cond_wait(&task->condition, &task->mutex);
+		} else if (pthread_cond_timedwait(&task->condition, &task->mutex, &deadline) == ETIMEDOUT) {
+			break;
+		}
+	}
+	bool is_finished = task->status == task_status_done || task->status == task_status_cancelled;
+	pthread_mutex_unlock(&task->mutex);
+
+	return is_finished;
+}
+
+void task_cancel(struct task *task) {
+	assert(task != NULL);
+
+	atomic_store(&task->monitor.is_cancelled, true);
+
+	pthread_mutex_lock(&pool.mutex);
+
+	pthread_mutex_lock(&task->mutex);
+	bool is_queued = task->status == task_status_queued;
+	pthread_mutex_unlock(&task->mutex);
+
+	if (is_queued) {
+		struct task *previous = NULL;
+		for (struct task *queued = pool.first; queued != task; queued = queued->next) {
+			previous = queued;
+		}
+
+		if (previous != NULL) {
+			previous->next = task->next;
+		} else {
+			pool.first = task->next;
+		}
+		if (pool.last == task) {
+			pool.last = previous;
+		}
+
+		task_finish(task, task_status_cancelled);
+	}
+
+	pthread_mutex_unlock(&pool.mutex);
+}
+
+int task_result(struct task *task, double sums[]) {
+	assert(task != NULL && (task->count == 0 || sums != NULL));
+
+	pthread_mutex_lock(&task->mutex);
+	bool is_done = task->status == task_status_done;
+	if (is_done && task->count > 0) {
+		memcpy(sums, task->sums, task->count * sizeof(*sums));
+	}
+	pthread_mutex_unlock(&task->mutex);
+
+	return is_done ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void task_drop(struct task *task) {
+	assert(task != NULL);
+
+	task_cancel(task);
+	(void)task_wait(task, -1);
+
+	pthread_cond_destroy(&task->condition);
+	pthread_mutex_destroy(&task->mutex);
+
+	for (size_t i = 0; i < task->count; i++) {
+		free(task->summands[i]);
+	}
+	free(task->summands);
+	free(task->cache_directory);
+	free(task->sums);
+	free(task);
+}
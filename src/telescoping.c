@@ -0,0 +1,660 @@
+#include <telescoping.h>
+
+#include <assert.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <polynomial.h>
+#include <stdlib.h>
+
+/**
+ * @brief A term of a summand, the value of an instruction times a coefficient.
+ */
+struct telescoping_term {
+	double coefficient;
+	size_t instruction;
+};
+
+/**
+ * @brief The largest offset of the variable, small enough for offsets to be added up exactly.
+ */
+#define TELESCOPING_OFFSET_MAXIMUM 4503599627370496L
+
+/**
+ * @brief The most indices a shifted function is evaluated at to check that it's defined there,
+ * beyond which its operations are checked instead.
+ */
+#define TELESCOPING_CHECKED_MAXIMUM 4096
+
+static bool telescoping_is_offset(double value) {
+	return value >= -TELESCOPING_OFFSET_MAXIMUM && value <= TELESCOPING_OFFSET_MAXIMUM &&
+		   nearbyint(value) >= value && nearbyint(value) <= value;
+}
+
+/**
+ * @brief Splits the value of an instruction into terms.
+ *
+ * Splits along additions, subtractions, negations and multiplications and divisions by
+ * constants, and appends the terms, scaled by `coefficient`, to `terms`.
+ */
+static bool telescoping_split(
+	const struct program *program,
+	size_t instruction,
+	double coefficient,
+	struct telescoping_term terms[],
+	size_t *terms_count
+) {
+	assert(program != NULL && terms != NULL && terms_count != NULL);
+
+	const struct instruction *current = &program->instructions[instruction];
+	if (current->type == expression_type_operation) {
+		const size_t *operands = current->operation.operands;
+
+		switch (current->operation.type) {
+			case operation_type_addition:
+				return telescoping_split(program, operands[0], coefficient, terms, terms_count) &&
+					   telescoping_split(program, operands[1], coefficient, terms, terms_count);
+			case operation_type_subtraction:
+				return telescoping_split(program, operands[0], coefficient, terms, terms_count) &&
+					   telescoping_split(program, operands[1], -coefficient, terms, terms_count);
+			case operation_type_negation:
+				return telescoping_split(program, operands[0], -coefficient, terms, terms_count);
+			case operation_type_multiplication: {
+				for (size_t i = 0; i < 2; i++) {
+					const struct instruction *factor = &program->instructions[operands[i]];
+					if (factor->type == expression_type_constant) {
+						return telescoping_split(
+							program,
+							operands[1 - i],
+							coefficient * factor->constant,
+							terms,
+							terms_count
+						);
+					}
+				}
+			} break;
+			case operation_type_division: {
+				const struct instruction *divisor = &program->instructions[operands[1]];
+				if (divisor->type == expression_type_constant) {
+					return telescoping_split(
+						program,
+						operands[0],
+						coefficient / divisor->constant,
+						terms,
+						terms_count
+					);
+				}
+			} break;
+			default: break;
+		}
+	}
+
+	if (*terms_count == TELESCOPING_TERMS_MAXIMUM) {
+		return false;
+	}
+
+	terms[(*terms_count)++] = (struct telescoping_term){
+		.coefficient = coefficient,
+		.instruction = instruction,
+	};
+
+	return true;
+}
+
+/**
+ * @brief Checks whether an instruction computes the variable plus an integer, and gets it.
+ */
+static bool telescoping_offset(
+	const struct program *program,
+	size_t instruction,
+	char variable,
+	long *offset
+) {
+	assert(program != NULL && offset != NULL);
+
+	const struct instruction *current = &program->instructions[instruction];
+	switch (current->type) {
+		case expression_type_constant: return false;
+		case expression_type_variable: {
+			*offset = 0;
+			return current->variable == variable;
+		}
+		case expression_type_operation: {
+			enum operation_type type = current->operation.type;
+			if (type != operation_type_addition && type != operation_type_subtraction) {
+				return false;
+			}
+
+			const size_t *operands = current->operation.operands;
+			size_t index = program->instructions[operands[1]].type == expression_type_constant;
+			const struct instruction *constant = &program->instructions[operands[index]];
+			if ((type == operation_type_subtraction && index != 1) ||
+				constant->type != expression_type_constant ||
+				!telescoping_is_offset(constant->constant) ||
+				!telescoping_offset(program, operands[1 - index], variable, offset)) {
+				return false;
+			}
+
+			*offset += type == operation_type_subtraction ? -(long)constant->constant
+														  : (long)constant->constant;
+			return *offset >= -TELESCOPING_OFFSET_MAXIMUM && *offset <= TELESCOPING_OFFSET_MAXIMUM;
+		}
+	}
+}
+
+/**
+ * @brief Checks whether an instruction computes another one with the variable shifted.
+ *
+ * Checks whether `instruction_1` computes `instruction_2` with the variable replaced by the
+ * variable plus `*shift`, which is set where the variable first occurs unless `*is_shift_known`.
+ * Programs are compiled from expressions written out in full, so walking their instructions as
+ * trees takes at most as long as reading those expressions.
+ */
+static bool telescoping_is_shift(
+	const struct program *program,
+	size_t instruction_1,
+	size_t instruction_2,
+	char variable,
+	long *shift,
+	bool *is_shift_known
+) {
+	assert(program != NULL && shift != NULL && is_shift_known != NULL);
+
+	long offset_1 = 0;
+	long offset_2 = 0;
+	if (telescoping_offset(program, instruction_1, variable, &offset_1) &&
+		telescoping_offset(program, instruction_2, variable, &offset_2)) {
+		if (!*is_shift_known) {
+			*shift = offset_1 - offset_2;
+			*is_shift_known = true;
+		}
+		return *shift == offset_1 - offset_2 && *shift >= -TELESCOPING_SHIFT_MAXIMUM &&
+			   *shift <= TELESCOPING_SHIFT_MAXIMUM;
+	}
+
+	const struct instruction *current_1 = &program->instructions[instruction_1];
+	const struct instruction *current_2 = &program->instructions[instruction_2];
+	if (current_1->type != current_2->type) {
+		return false;
+	}
+
+	switch (current_1->type) {
+		case expression_type_constant:
+			return current_1->constant >= current_2->constant &&
+				   current_1->constant <= current_2->constant;
+		case expression_type_variable: return current_1->variable == current_2->variable;
+		case expression_type_operation: {
+			if (current_1->operation.type != current_2->operation.type) {
+				return false;
+			}
+
+			size_t arity = operation_type_arity(current_1->operation.type);
+			for (size_t i = 0; i < arity; i++) {
+				if (!telescoping_is_shift(
+						program,
+						current_1->operation.operands[i],
+						current_2->operation.operands[i],
+						variable,
+						shift,
+						is_shift_known
+					)) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+	}
+}
+
+/**
+ * @brief Adds a term to a telescoping summand, merging it with the term of the same shift.
+ */
+static bool telescoping_push(struct telescoping *telescoping, double coefficient, long shift) {
+	assert(telescoping != NULL);
+
+	for (size_t i = 0; i < telescoping->terms_count; i++) {
+		if (telescoping->shifts[i] == shift) {
+			telescoping->coefficients[i] += coefficient;
+			return true;
+		}
+	}
+
+	if (telescoping->terms_count == TELESCOPING_TERMS_MAXIMUM) {
+		return false;
+	}
+
+	telescoping->coefficients[telescoping->terms_count] = coefficient;
+	telescoping->shifts[telescoping->terms_count] = shift;
+	++telescoping->terms_count;
+
+	return true;
+}
+
+/**
+ * @brief Decomposes a rational function of the variable into partial fractions.
+ *
+ * Checks whether `instruction` computes `p(i) / q(i)` for polynomials `p` and `q` of lower and
+ * higher degrees, `q` having distinct integer roots outside of the range, and adds `coefficient`
+ * times the partial fractions `p(r) / q'(r) / (i - r)` at each root `r` of `q` to `telescoping`.
+ */
+static bool telescoping_push_fractions(
+	const struct program *program,
+	size_t instruction,
+	double coefficient,
+	struct telescoping *telescoping
+) {
+	assert(program != NULL && telescoping != NULL);
+
+	const struct instruction *current = &program->instructions[instruction];
+	if (current->type != expression_type_operation ||
+		current->operation.type != operation_type_division) {
+		return false;
+	}
+
+	// the numerator and the denominator, as if they were the outputs of the program
+	size_t outputs[] = { current->operation.operands[0], current->operation.operands[1] };
+	struct program operands = *program;
+	operands.outputs = outputs;
+	operands.outputs_count = 2;
+
+	struct polynomial polynomials[2];
+	bool is_polynomial[2];
+	polynomial_from_program(&operands, telescoping->variable, polynomials, is_polynomial);
+
+	const struct polynomial *numerator = &polynomials[0];
+	const struct polynomial *denominator = &polynomials[1];
+	if (!is_polynomial[0] || !is_polynomial[1] || numerator->degree >= denominator->degree) {
+		return false;
+	}
+
+	// the magnitudes of the terms of the denominator, to tell its roots from rounding errors
+	struct polynomial magnitudes = *denominator;
+	for (size_t i = 0; i <= magnitudes.degree; i++) {
+		magnitudes.coefficients[i] = fabs(magnitudes.coefficients[i]);
+	}
+
+	long roots[POLYNOMIAL_DEGREE_MAXIMUM];
+	size_t roots_count = 0;
+	for (long root = -TELESCOPING_SHIFT_MAXIMUM;
+		 root <= TELESCOPING_SHIFT_MAXIMUM && roots_count < denominator->degree;
+		 root++) {
+		double value = polynomial_evaluate(denominator, (double)root);
+		double magnitude = polynomial_evaluate(&magnitudes, fabs((double)root));
+		if (fabs(value) <= magnitude * (double)denominator->degree * DBL_EPSILON) {
+			roots[roots_count++] = root;
+		}
+	}
+
+	if (roots_count < denominator->degree) {
+		return false;
+	}
+
+	for (size_t i = 0; i < roots_count; i++) {
+		if (roots[i] >= telescoping->lower_bound && roots[i] <= telescoping->upper_bound) {
+			return false;
+		}
+
+		// q'(r) is the leading coefficient times the differences between r and the other roots
+		double derivative = denominator->coefficients[denominator->degree];
+		for (size_t j = 0; j < roots_count; j++) {
+			if (j != i) {
+				derivative *= (double)(roots[i] - roots[j]);
+			}
+		}
+
+		double fraction = polynomial_evaluate(numerator, (double)roots[i]) / derivative;
+		if (!telescoping_push(telescoping, coefficient * fraction, -roots[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Checks whether the coefficients of a telescoping summand cancel out.
+ */
+static bool telescoping_cancels(const struct telescoping *telescoping) {
+	assert(telescoping != NULL);
+
+	double sum = 0;
+	double magnitude = 0;
+	long minimum = 0;
+	long maximum = 0;
+	for (size_t i = 0; i < telescoping->terms_count; i++) {
+		sum += telescoping->coefficients[i];
+		magnitude += fabs(telescoping->coefficients[i]);
+		minimum = i == 0 || telescoping->shifts[i] < minimum ? telescoping->shifts[i] : minimum;
+		maximum = i == 0 || telescoping->shifts[i] > maximum ? telescoping->shifts[i] : maximum;
+	}
+
+	// up to rounding errors
+	return isfinite(magnitude) &&
+		   fabs(sum) <= magnitude * (double)telescoping->terms_count * DBL_EPSILON &&
+		   maximum - minimum <= TELESCOPING_SHIFT_MAXIMUM;
+}
+
+/**
+ * @brief Checks whether an affine polynomial is nonzero, or positive, at every integer of a range.
+ */
+static bool telescoping_has_sign(
+	const struct polynomial *polynomial,
+	long lower_bound,
+	long upper_bound,
+	bool is_positive
+) {
+	assert(polynomial != NULL);
+
+	if (polynomial->degree > 1) {
+		return false;
+	}
+
+	double lower = polynomial_evaluate(polynomial, (double)lower_bound);
+	double upper = polynomial_evaluate(polynomial, (double)upper_bound);
+	if (is_positive) {
+		return lower > 0 && upper > 0;
+	}
+	if (polynomial->degree == 0) {
+		return fpclassify(lower) != FP_ZERO;
+	}
+
+	// the root isn't an integer of the range
+	double root = -polynomial->coefficients[0] / polynomial->coefficients[1];
+	return !(root >= (double)lower_bound && root <= (double)upper_bound &&
+			 nearbyint(root) >= root && nearbyint(root) <= root);
+}
+
+/**
+ * @brief Checks whether the function computed by an instruction is finite over a range.
+ *
+ * Short ranges are checked by evaluating the function at each of their indices. Otherwise, the
+ * divisors of the function must be affine without roots at the integers of the range and the
+ * operands of its logarithms affine and positive there, while operations with other poles, or
+ * with domains, can't depend on the variable.
+ */
+static bool telescoping_is_defined(
+	const struct program *program,
+	size_t instruction,
+	char variable,
+	long lower_bound,
+	long upper_bound
+) {
+	assert(program != NULL && lower_bound <= upper_bound);
+
+	struct program function = *program;
+	function.outputs = &instruction;
+	function.outputs_count = 1;
+	size_t output = 0;
+	struct program selected = program_select(&function, 1, &output);
+
+	bool is_defined = true;
+	if ((unsigned long)upper_bound - (unsigned long)lower_bound < TELESCOPING_CHECKED_MAXIMUM) {
+		double *values = malloc(selected.instructions_count * sizeof(*values));
+		struct environment environment = environment_new();
+		for (long i = lower_bound; i <= upper_bound && is_defined; i++) {
+			double value = 0;
+			environment_set_variable(&environment, variable, (double)i);
+			program_evaluate(&selected, &environment, values, &value);
+			is_defined = isfinite(value);
+		}
+		free(values);
+		program_drop(&selected);
+
+		return is_defined;
+	}
+
+	size_t count = selected.instructions_count;
+	if (count == 0) {
+		program_drop(&selected);
+		return true;
+	}
+
+	// the polynomials of all the instructions, as if they were the outputs of the program
+	size_t *outputs = malloc(count * sizeof(*outputs));
+	for (size_t i = 0; i < count; i++) {
+		outputs[i] = i;
+	}
+	struct program instructions = selected;
+	instructions.outputs = outputs;
+	instructions.outputs_count = count;
+
+	struct polynomial *polynomials = malloc(count * sizeof(*polynomials));
+	bool *is_polynomial = malloc(count * sizeof(*is_polynomial));
+	polynomial_from_program(&instructions, variable, polynomials, is_polynomial);
+
+	for (size_t i = 0; i < count && is_defined; i++) {
+		const struct instruction *current = &selected.instructions[i];
+		if (current->type != expression_type_operation ||
+			(is_polynomial[i] && polynomials[i].degree == 0)) {
+			continue;
+		}
+
+		const size_t *operands = current->operation.operands;
+		const struct polynomial *first = &polynomials[operands[0]];
+		bool is_first_constant = is_polynomial[operands[0]] && first->degree == 0;
+		switch (current->operation.type) {
+			case operation_type_addition:
+			case operation_type_subtraction:
+			case operation_type_multiplication:
+			case operation_type_negation:
+			case operation_type_sine:
+			case operation_type_cosine:
+			case operation_type_exponential:
+			case operation_type_absolute_value:
+			case operation_type_floor:
+			case operation_type_ceiling:
+			case operation_type_minimum:
+			case operation_type_maximum:
+			case operation_type_less:
+			case operation_type_less_equal:
+			case operation_type_greater:
+			case operation_type_greater_equal:
+			case operation_type_equal:
+			case operation_type_not_equal:
+			case operation_type_conditional: break;
+			case operation_type_division:
+				is_defined = is_polynomial[operands[1]] &&
+							 telescoping_has_sign(
+								 &polynomials[operands[1]],
+								 lower_bound,
+								 upper_bound,
+								 false
+							 );
+				break;
+			case operation_type_logarithm:
+				is_defined = is_polynomial[operands[0]] &&
+							 telescoping_has_sign(first, lower_bound, upper_bound, true);
+				break;
+			case operation_type_exponentiation: {
+				// powers of positive constants, or natural powers
+				const struct polynomial *second = &polynomials[operands[1]];
+				bool is_natural = is_polynomial[operands[1]] && second->degree == 0 &&
+								  second->coefficients[0] >= 0 &&
+								  nearbyint(second->coefficients[0]) >= second->coefficients[0] &&
+								  nearbyint(second->coefficients[0]) <= second->coefficients[0];
+				is_defined = (is_first_constant && first->coefficients[0] > 0) || is_natural;
+				break;
+			}
+			default: is_defined = false; break;
+		}
+	}
+
+	free(is_polynomial);
+	free(polynomials);
+	free(outputs);
+	program_drop(&selected);
+
+	return is_defined;
+}
+
+/**
+ * @brief Gets the telescoping summand computed by an instruction.
+ */
+static bool telescoping_from_instruction(
+	const struct program *program,
+	size_t instruction,
+	struct telescoping *telescoping
+) {
+	assert(program != NULL && telescoping != NULL);
+
+	struct telescoping_term terms[TELESCOPING_TERMS_MAXIMUM];
+	size_t terms_count = 0;
+	if (!telescoping_split(program, instruction, 1, terms, &terms_count)) {
+		return false;
+	}
+
+	// either every term is the first one shifted
+	bool is_shifted = true;
+	for (size_t i = 0; i < terms_count && is_shifted; i++) {
+		long shift = 0;
+		bool is_shift_known = false;
+		is_shifted = telescoping_is_shift(
+						 program,
+						 terms[i].instruction,
+						 terms[0].instruction,
+						 telescoping->variable,
+						 &shift,
+						 &is_shift_known
+					 ) &&
+					 telescoping_push(telescoping, terms[i].coefficient, shift);
+	}
+
+	if (is_shifted && telescoping_cancels(telescoping)) {
+		long minimum = telescoping->shifts[0];
+		long maximum = telescoping->shifts[0];
+		for (size_t i = 1; i < telescoping->terms_count; i++) {
+			minimum = telescoping->shifts[i] < minimum ? telescoping->shifts[i] : minimum;
+			maximum = telescoping->shifts[i] > maximum ? telescoping->shifts[i] : maximum;
+		}
+
+		// the poles of the function wouldn't cancel out
+		if (telescoping_is_defined(
+				program,
+				terms[0].instruction,
+				telescoping->variable,
+				telescoping->lower_bound + minimum,
+				telescoping->upper_bound + maximum
+			)) {
+			struct program function = *program;
+			function.outputs = &terms[0].instruction;
+			function.outputs_count = 1;
+
+			size_t output = 0;
+			telescoping->function = program_select(&function, 1, &output);
+			return true;
+		}
+	}
+
+	// or every term is a sum of partial fractions
+	telescoping->terms_count = 0;
+	for (size_t i = 0; i < terms_count; i++) {
+		if (!telescoping_push_fractions(
+				program,
+				terms[i].instruction,
+				terms[i].coefficient,
+				telescoping
+			)) {
+			return false;
+		}
+	}
+
+	if (!telescoping_cancels(telescoping)) {
+		return false;
+	}
+
+	struct expression reciprocal = expression_operation(
+		operation_type_division,
+		expression_constant(1),
+		expression_variable(telescoping->variable)
+	);
+	telescoping->function = program_new(1, &reciprocal);
+	expression_drop(&reciprocal);
+
+	return true;
+}
+
+void telescoping_from_program(
+	const struct program *program,
+	char variable,
+	long lower_bound,
+	long upper_bound,
+	struct telescoping telescopings[],
+	bool is_telescoping[]
+) {
+	assert(program != NULL && lower_bound <= upper_bound);
+	assert(program->outputs_count == 0 || (telescopings != NULL && is_telescoping != NULL));
+
+	for (size_t i = 0; i < program->outputs_count; i++) {
+		telescopings[i] = (struct telescoping){
+			.function = { .instructions = NULL, .outputs = NULL },
+			.variable = variable,
+			.terms_count = 0,
+			.lower_bound = lower_bound,
+			.upper_bound = upper_bound,
+		};
+
+		// the function is evaluated a little past the bounds
+		is_telescoping[i] =
+			lower_bound >= LONG_MIN / 2 && upper_bound <= LONG_MAX / 2 &&
+			telescoping_from_instruction(program, program->outputs[i], &telescopings[i]);
+		if (!is_telescoping[i]) {
+			telescoping_drop(&telescopings[i]);
+		}
+	}
+}
+
+void telescoping_drop(struct telescoping *telescoping) {
+	assert(telescoping != NULL);
+
+	if (telescoping->function.instructions != NULL) {
+		program_drop(&telescoping->function);
+	}
+	telescoping->function = (struct program){ .instructions = NULL, .outputs = NULL };
+	telescoping->terms_count = 0;
+}
+
+double telescoping_sum(const struct telescoping *telescoping) {
+	assert(telescoping != NULL);
+
+	if (telescoping->terms_count == 0) {
+		return 0;
+	}
+
+	long minimum = telescoping->shifts[0];
+	long maximum = telescoping->shifts[0];
+	for (size_t i = 1; i < telescoping->terms_count; i++) {
+		minimum = telescoping->shifts[i] < minimum ? telescoping->shifts[i] : minimum;
+		maximum = telescoping->shifts[i] > maximum ? telescoping->shifts[i] : maximum;
+	}
+
+	// g(U + a + 1) - g(L + a) for each shift a from the smallest one
+	double differences[TELESCOPING_SHIFT_MAXIMUM];
+	double *values = malloc(telescoping->function.instructions_count * sizeof(*values));
+	struct environment environment = environment_new();
+
+	for (long shift = minimum; shift < maximum; shift++) {
+		double upper = 0;
+		double lower = 0;
+
+		long index = telescoping->upper_bound + shift + 1;
+		environment_set_variable(&environment, telescoping->variable, (double)index);
+		program_evaluate(&telescoping->function, &environment, values, &upper);
+		index = telescoping->lower_bound + shift;
+		environment_set_variable(&environment, telescoping->variable, (double)index);
+		program_evaluate(&telescoping->function, &environment, values, &lower);
+
+		differences[shift - minimum] = upper - lower;
+	}
+
+	free(values);
+
+	double sum = 0;
+	for (size_t i = 0; i < telescoping->terms_count; i++) {
+		for (long shift = minimum; shift < telescoping->shifts[i]; shift++) {
+			sum += telescoping->coefficients[i] * differences[shift - minimum];
+		}
+	}
+
+	return sum;
+}
@@ -0,0 +1,60 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <cache.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void test_cache_hash(void **state) {
+	(void)state;
+
+	assert_true(cache_hash(CACHE_HASH_INITIAL, "", 0) == CACHE_HASH_INITIAL);
+	assert_true(cache_hash(CACHE_HASH_INITIAL, "a", 1) == UINT64_C(0xaf63dc4c8601ec8c));
+	assert_true(cache_hash(CACHE_HASH_INITIAL, "foobar", 6) == UINT64_C(0x85944171f73967e8));
+
+	// hashing can be continued piece by piece
+	assert_true(
+		cache_hash(cache_hash(CACHE_HASH_INITIAL, "foo", 3), "bar", 3) ==
+		cache_hash(CACHE_HASH_INITIAL, "foobar", 6)
+	);
+}
+
+static void test_cache_path(void **state) {
+	(void)state;
+
+	char directory[] = "/tmp/test_cache_XXXXXX";
+	assert_non_null(mkdtemp(directory));
+
+	char nested[sizeof(directory) + 8];
+	(void)snprintf(nested, sizeof(nested), "%s/nested", directory);
+
+	char *path = cache_path(nested, UINT64_C(0xaf63dc4c8601ec8c), "program");
+	assert_non_null(path);
+
+	char expected[sizeof(nested) + 32];
+	(void)snprintf(expected, sizeof(expected), "%s/af63dc4c8601ec8c.program", nested);
+	assert_string_equal(path, expected);
+
+	struct stat status;
+	assert_int_equal(stat(nested, &status), 0);
+	assert_true(S_ISDIR(status.st_mode));
+
+	free(path);
+	rmdir(nested);
+	rmdir(directory);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_cache_hash),
+		cmocka_unit_test(test_cache_path),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,153 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <column.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define EPSILON (0.000000001)
+
+static void write_column(const char *path, const double values[], size_t count) {
+	FILE *file = fopen(path, "wb");
+	assert_non_null(file);
+	assert_int_equal(fwrite(values, sizeof(*values), count, file), count);
+	assert_int_equal(fclose(file), 0);
+}
+
+static void test_column_summation_fused(void **state) {
+	(void)state;
+
+	char directory[] = "/tmp/test_column_XXXXXX";
+	assert_non_null(mkdtemp(directory));
+
+	char paths[3][sizeof(directory) + 16];
+	for (size_t i = 0; i < 3; i++) {
+		(void)snprintf(paths[i], sizeof(paths[i]), "%s/%zu.column", directory, i);
+	}
+
+	// enough rows for several leaves and a partial block
+	size_t rows_count = 100003;
+	double *x = malloc(rows_count * sizeof(*x));
+	double *w = malloc(rows_count * sizeof(*w));
+	for (size_t i = 0; i < rows_count; i++) {
+		x[i] = sin((double)i);
+		w[i] = (double)(i % 7);
+	}
+	write_column(paths[0], x, rows_count);
+	write_column(paths[1], w, rows_count);
+	write_column(paths[2], w, rows_count - 1);
+
+	struct column columns[3];
+	assert_int_equal(column_map(&columns[0], 'x', paths[0]), EXIT_SUCCESS);
+	assert_int_equal(column_map(&columns[1], 'w', paths[1]), EXIT_SUCCESS);
+	assert_int_equal(column_map(&columns[2], 'v', paths[2]), EXIT_SUCCESS);
+	assert_int_equal(columns[0].rows_count, rows_count);
+
+	const char *const summands[] = { "w * x^2", "i * x", "w" };
+	double expected[3] = { 0, 0, 0 };
+	for (size_t i = 0; i < rows_count; i++) {
+		expected[0] += w[i] * x[i] * x[i];
+		expected[1] += (double)i * x[i];
+		expected[2] += w[i];
+	}
+
+	double sums[3];
+	struct summation_options options = summation_options_default();
+	for (size_t threads_count = 1; threads_count <= 4; threads_count *= 2) {
+		options.threads_count = threads_count;
+		assert_int_equal(
+			column_summation_fused(2, columns, 3, summands, sums, &options),
+			EXIT_SUCCESS
+		);
+		for (size_t i = 0; i < 3; i++) {
+			assert_float_equal(sums[i], expected[i], fabs(expected[i]) * EPSILON);
+		}
+	}
+
+	// a column bound to i hides the index of the row
+	columns[1].variable = 'i';
+	const char *summand = "i";
+	assert_int_equal(column_summation_fused(2, columns, 1, &summand, sums, NULL), EXIT_SUCCESS);
+	assert_float_equal(sums[0], expected[2], EPSILON);
+
+	assert_int_equal(column_summation_fused(3, columns, 1, &summand, sums, NULL), EXIT_FAILURE);
+
+	for (size_t i = 0; i < 3; i++) {
+		column_unmap(&columns[i]);
+		unlink(paths[i]);
+	}
+	free(w);
+	free(x);
+	rmdir(directory);
+}
+
+static void test_column_from_csv(void **state) {
+	(void)state;
+
+	char path[] = "/tmp/test_column_XXXXXX";
+	int file = mkstemp(path);
+	assert_true(file >= 0);
+	close(file);
+
+	char csv[] = "name,weight,value\n"
+				 "a,1.5,2\n"
+				 "b,2,-3e2\r\n"
+				 "c,,4\n"
+				 "\n"
+				 "d,0.25\n";
+	FILE *input = fmemopen(csv, sizeof(csv) - 1, "r");
+	assert_non_null(input);
+	assert_int_equal(column_from_csv(input, 1, true, path), EXIT_SUCCESS);
+	fclose(input);
+
+	// a row for each line but the header and blank ones, missing values being NaN
+	struct column column;
+	assert_int_equal(column_map(&column, 'w', path), EXIT_SUCCESS);
+	assert_int_equal(column.rows_count, 4);
+	assert_float_equal(column.values[0], 1.5, EPSILON);
+	assert_float_equal(column.values[1], 2, EPSILON);
+	assert_true(isnan(column.values[2]));
+	assert_float_equal(column.values[3], 0.25, EPSILON);
+	column_unmap(&column);
+
+	input = fmemopen(csv, sizeof(csv) - 1, "r");
+	assert_non_null(input);
+	assert_int_equal(column_from_csv(input, 2, true, path), EXIT_SUCCESS);
+	fclose(input);
+
+	assert_int_equal(column_map(&column, 'v', path), EXIT_SUCCESS);
+	assert_int_equal(column.rows_count, 4);
+	assert_float_equal(column.values[1], -300, EPSILON);
+	assert_float_equal(column.values[2], 4, EPSILON);
+	assert_true(isnan(column.values[3]));
+	column_unmap(&column);
+
+	// fields which aren't numbers, like the header's
+	input = fmemopen(csv, sizeof(csv) - 1, "r");
+	assert_non_null(input);
+	assert_int_equal(column_from_csv(input, 1, false, path), EXIT_FAILURE);
+	fclose(input);
+
+	char invalid[] = "1,2\n3,x4\n";
+	input = fmemopen(invalid, sizeof(invalid) - 1, "r");
+	assert_non_null(input);
+	assert_int_equal(column_from_csv(input, 1, false, path), EXIT_FAILURE);
+	fclose(input);
+
+	unlink(path);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_column_summation_fused),
+		cmocka_unit_test(test_column_from_csv),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
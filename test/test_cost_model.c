@@ -0,0 +1,94 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <cost_model.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static void test_cost_model_calibrate(void **state) {
+	(void)state;
+
+	struct cost_model cost_model = cost_model_calibrate();
+
+	for (size_t i = 0; i < OPERATION_TYPES_COUNT; i++) {
+		assert_true(isfinite(cost_model.operation_seconds[i]));
+		assert_true(cost_model.operation_seconds[i] >= 0);
+	}
+	assert_true(isfinite(cost_model.load_seconds) && cost_model.load_seconds >= 0);
+	assert_true(isfinite(cost_model.dispatch_seconds) && cost_model.dispatch_seconds >= 0);
+	assert_true(isfinite(cost_model.recurrence_seconds) && cost_model.recurrence_seconds >= 0);
+	assert_true(isfinite(cost_model.thread_seconds) && cost_model.thread_seconds > 0);
+}
+
+static void test_cost_model_estimate(void **state) {
+	(void)state;
+
+	struct cost_model cost_model = {
+		.load_seconds = 1,
+		.dispatch_seconds = 10,
+		.recurrence_seconds = 100,
+		.thread_seconds = 0,
+	};
+	for (size_t i = 0; i < OPERATION_TYPES_COUNT; i++) {
+		cost_model.operation_seconds[i] = 1000;
+	}
+
+	// i, 2, i * 2, sin(i * 2), i * i, sin(i * i), sin(i * 2) + sin(i * i)
+	struct expression expression = expression_from_string("sin(i * 2) + sin(i * i)");
+	struct program program = program_new(1, &expression);
+	assert_int_equal(program.instructions_count, 7);
+
+	double steps[7];
+	program_steps(&program, NULL, 'i', steps);
+
+	assert_float_equal(cost_model_estimate(&cost_model, &program, true, NULL), 5002, 0);
+	assert_float_equal(cost_model_estimate(&cost_model, &program, false, NULL), 5072, 0);
+	// only sin(i * 2) is a recurrence
+	assert_float_equal(cost_model_estimate(&cost_model, &program, true, steps), 4102, 0);
+
+	program_drop(&program);
+	expression_drop(&expression);
+}
+
+static void test_cost_model_save_load(void **state) {
+	(void)state;
+
+	struct cost_model cost_model = cost_model_calibrate();
+
+	char path[] = "/tmp/test_cost_model_XXXXXX";
+	int file = mkstemp(path);
+	assert_true(file >= 0);
+	close(file);
+
+	assert_int_equal(cost_model_save(&cost_model, path), EXIT_SUCCESS);
+
+	struct cost_model loaded;
+	assert_int_equal(cost_model_load(&loaded, path), EXIT_SUCCESS);
+	assert_memory_equal(&loaded, &cost_model, sizeof(loaded));
+
+	// anything else is rejected
+	file = open(path, O_WRONLY | O_TRUNC);
+	assert_true(file >= 0);
+	assert_int_equal(write(file, "not a cost model", 16), 16);
+	close(file);
+	assert_int_equal(cost_model_load(&loaded, path), EXIT_FAILURE);
+
+	unlink(path);
+	assert_int_equal(cost_model_load(&loaded, path), EXIT_FAILURE);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_cost_model_calibrate),
+		cmocka_unit_test(test_cost_model_estimate),
+		cmocka_unit_test(test_cost_model_save_load),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,772 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <dirent.h>
+#include <environment.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <summation.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief The seed of the random summands, unless overridden by `$DIFFERENTIAL_SEED`.
+ */
+#define DIFFERENTIAL_SEED UINT64_C(0x5eed)
+/**
+ * @brief The number of random summands, summed together in a single pass by each engine.
+ */
+#define DIFFERENTIAL_SUMMANDS_COUNT 96
+/**
+ * @brief The maximum depth of the random summands.
+ */
+#define DIFFERENTIAL_DEPTH_MAXIMUM 4
+/**
+ * @brief The error of the engines allowed to round differently, relative to the sum of the
+ * magnitudes of the terms.
+ */
+#define DIFFERENTIAL_RELATIVE_ERROR 1e-9
+/**
+ * @brief The relative perturbation of inexact intermediate results, to measure the conditioning
+ * of the summations.
+ */
+#define DIFFERENTIAL_PERTURBATION 1e-12
+/**
+ * @brief The fraction of the allowed error that perturbing intermediate results may cause, for
+ * the summation to be considered well conditioned.
+ */
+#define DIFFERENTIAL_CONDITION_MARGIN 0.1
+
+#define NANOSECONDS_PER_SECOND 1000000000.0
+
+static double seconds_now(void) {
+	struct timespec time;
+	(void)clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec / NANOSECONDS_PER_SECOND;
+}
+
+static uint64_t random_next(uint64_t *state) {
+	uint64_t value = (*state += UINT64_C(0x9e3779b97f4a7c15));
+	value = (value ^ (value >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	value = (value ^ (value >> 27)) * UINT64_C(0x94d049bb133111eb);
+	return value ^ (value >> 31);
+}
+
+static size_t random_below(uint64_t *state, size_t count) {
+	return (size_t)(random_next(state) % count);
+}
+
+/**
+ * @brief Generates a small constant, exactly printed by `expression_to_string()`.
+ */
+static struct expression generate_constant(uint64_t *state) {
+	return expression_constant((double)random_below(state, 40) / 4);
+}
+
+/**
+ * @brief Generates an integer-valued expression of i.
+ *
+ * Discontinuous operations only take integer-valued operands, which every engine computes exactly,
+ * so that rounding differences can't move their discontinuities.
+ */
+static struct expression generate_integer(uint64_t *state, size_t depth) {
+	if (depth == 0 || random_below(state, 3) == 0) {
+		return random_below(state, 2) == 0 ? expression_variable('i')
+										   : expression_constant((double)random_below(state, 7));
+	}
+
+	const enum operation_type types[] = {
+		operation_type_addition,
+		operation_type_subtraction,
+		operation_type_multiplication,
+		operation_type_negation,
+		operation_type_absolute_value,
+		operation_type_minimum,
+		operation_type_maximum,
+	};
+	enum operation_type type = types[random_below(state, sizeof(types) / sizeof(types[0]))];
+
+	switch (random_below(state, 3)) {
+		case 0:
+			return expression_operation(
+				operation_type_floor,
+				expression_operation(
+					operation_type_division,
+					generate_integer(state, depth - 1),
+					expression_constant((double)(2 + random_below(state, 5)))
+				)
+			);
+		case 1:
+			return expression_operation(
+				operation_type_modulo,
+				generate_integer(state, depth - 1),
+				expression_constant((double)(2 + random_below(state, 5)))
+			);
+		default: {
+			struct expression operands[OPERATION_ARITY_MAXIMUM];
+			size_t arity = operation_type_arity(type);
+			for (size_t i = 0; i < arity; i++) {
+				operands[i] = generate_integer(state, depth - 1);
+			}
+			return expression_operation(type, operands[0], operands[1], operands[2]);
+		}
+	}
+}
+
+/**
+ * @brief Generates an integer-valued expression of i between 0 and 12.
+ *
+ * Factorials of larger integers round differently when computed by products rather than by
+ * `tgamma()`, which other functions of them could amplify into any error at all.
+ */
+static struct expression generate_count(uint64_t *state, size_t depth) {
+	return expression_operation(
+		operation_type_modulo,
+		expression_operation(operation_type_absolute_value, generate_integer(state, depth)),
+		expression_constant(13)
+	);
+}
+
+/**
+ * @brief Generates an expression of i over the whole grammar.
+ */
+static struct expression generate(uint64_t *state, size_t depth) {
+	if (depth == 0 || random_below(state, 4) == 0) {
+		switch (random_below(state, 3)) {
+			case 0: return generate_constant(state);
+			case 1: return expression_variable('i');
+			default: return generate_integer(state, depth);
+		}
+	}
+
+	enum operation_type type = (enum operation_type)random_below(state, OPERATION_TYPES_COUNT);
+	switch (type) {
+		// the discontinuous operations
+		case operation_type_floor:
+		case operation_type_ceiling:
+		case operation_type_log_factorial:
+			return expression_operation(type, generate_integer(state, depth - 1));
+		case operation_type_factorial:
+			return expression_operation(type, generate_count(state, depth - 1));
+		case operation_type_binomial:
+			return expression_operation(
+				type,
+				generate_count(state, depth - 1),
+				generate_count(state, depth - 1)
+			);
+		case operation_type_modulo:
+		case operation_type_less:
+		case operation_type_less_equal:
+		case operation_type_greater:
+		case operation_type_greater_equal:
+		case operation_type_equal:
+		case operation_type_not_equal:
+		case operation_type_log_binomial:
+			return expression_operation(
+				type,
+				generate_integer(state, depth - 1),
+				generate_integer(state, depth - 1)
+			);
+		case operation_type_conditional:
+			return expression_operation(
+				type,
+				generate_integer(state, depth - 1),
+				generate(state, depth - 1),
+				generate(state, depth - 1)
+			);
+		// the periodic functions amplify any rounding of large operands, so theirs are exact
+		case operation_type_sine:
+		case operation_type_cosine:
+		case operation_type_tangent:
+			return expression_operation(
+				type,
+				expression_operation(
+					operation_type_division,
+					generate_integer(state, depth - 1),
+					expression_constant((double)(1 + random_below(state, 64)))
+				)
+			);
+		// the others, with their operands scaled down to keep the terms within range
+		case operation_type_exponentiation:
+			return expression_operation(
+				type,
+				generate(state, depth - 1),
+				expression_constant((double)random_below(state, 4))
+			);
+		case operation_type_exponential:
+		case operation_type_gamma:
+		case operation_type_log_gamma:
+			return expression_operation(
+				type,
+				expression_operation(
+					operation_type_division,
+					generate(state, depth - 1),
+					expression_constant(64)
+				)
+			);
+		default: {
+			struct expression operands[OPERATION_ARITY_MAXIMUM];
+			size_t arity = operation_type_arity(type);
+			for (size_t i = 0; i < arity; i++) {
+				operands[i] = generate(state, depth - 1);
+			}
+			return expression_operation(type, operands[0], operands[1], operands[2]);
+		}
+	}
+}
+
+/**
+ * @brief a reference total of a summation.
+ */
+struct differential_reference {
+	double sum;		  ///< The total, added up in order.
+	double magnitude; ///< The sum of the magnitudes of the terms.
+	double deviation; ///< The largest deviation of the totals with perturbed intermediate results.
+};
+
+static bool double_is_integer(double value) {
+	return value >= nearbyint(value) && value <= nearbyint(value);
+}
+
+/**
+ * @brief Checks whether an operation may round differently in another engine.
+ *
+ * The engines compute the arithmetic of integers exactly, and divisions of integers correctly
+ * rounded, but may compute the functions differently, by recurrences or other formulas.
+ */
+static bool operation_type_is_inexact(enum operation_type type, const double operands[]) {
+	switch (type) {
+		case operation_type_division:
+			return !(double_is_integer(operands[0]) && double_is_integer(operands[1]));
+		case operation_type_exponentiation:
+		case operation_type_sine:
+		case operation_type_cosine:
+		case operation_type_tangent:
+		case operation_type_exponential:
+		case operation_type_logarithm:
+		case operation_type_factorial:
+		case operation_type_gamma:
+		case operation_type_log_gamma:
+		case operation_type_log_factorial:
+		case operation_type_binomial:
+		case operation_type_log_binomial: return true;
+		default: return false;
+	}
+}
+
+/**
+ * @brief Evaluates an expression of i, with the inexact intermediate results perturbed.
+ *
+ * Alternately adds and subtracts `perturbation` times their magnitude, or at least `perturbation`,
+ * to the results of the inexact operations, so that even exact zeros move off the poles.
+ */
+static double differential_evaluate(
+	const struct expression *expression,
+	double index,
+	double perturbation,
+	size_t *count
+) {
+	switch (expression->type) {
+		case expression_type_constant: return expression->constant.value;
+		case expression_type_variable: return expression->variable.name == 'i' ? index : NAN;
+		case expression_type_operation: break;
+	}
+
+	double operands[OPERATION_ARITY_MAXIMUM];
+	size_t arity = operation_type_arity(expression->operation.type);
+	for (size_t i = 0; i < arity; i++) {
+		operands[i] =
+			differential_evaluate(&expression->operation.operands[i], index, perturbation, count);
+	}
+
+	double value = operation_type_evaluate(expression->operation.type, operands);
+	if (operation_type_is_inexact(expression->operation.type, operands)) {
+		value += ((*count)++ % 2 == 0 ? perturbation : -perturbation) * fmax(fabs(value), 1);
+	}
+
+	return value;
+}
+
+/**
+ * @brief Computes the reference total of a summation.
+ *
+ * The terms are evaluated by `expression_evaluate()` on the simplified summand, which is what the
+ * engines compile, and added up in order. Evaluating them again with their inexact intermediate
+ * results perturbed tells how much rounding differently can change the total.
+ */
+static struct differential_reference differential_reference_new(
+	const char *summand,
+	long lower_bound,
+	long upper_bound
+) {
+	struct environment environment = environment_new();
+	struct expression expression = expression_from_string(summand);
+	expression_simplify(&expression, &environment);
+
+	struct differential_reference reference = { 0, 0, 0 };
+	double perturbed_sums[2] = { 0, 0 };
+	size_t counts[2] = { 0, 1 };
+	for (long i = lower_bound; i <= upper_bound; i++) {
+		environment_set_variable(&environment, 'i', (double)i);
+		double term = expression_evaluate(&expression, &environment);
+		reference.sum += term;
+		reference.magnitude += fabs(term);
+
+		for (size_t j = 0; j < 2; j++) {
+			perturbed_sums[j] += differential_evaluate(
+				&expression,
+				(double)i,
+				DIFFERENTIAL_PERTURBATION,
+				&counts[j]
+			);
+		}
+	}
+	for (size_t j = 0; j < 2; j++) {
+		reference.deviation = fmax(reference.deviation, fabs(perturbed_sums[j] - reference.sum));
+	}
+	if (isnan(perturbed_sums[0]) || isnan(perturbed_sums[1])) {
+		reference.deviation = INFINITY;
+	}
+
+	expression_drop(&expression);
+
+	return reference;
+}
+
+/**
+ * @brief Checks whether an engine's total of a summation agrees with the reference.
+ *
+ * The scalar, block and native engines must compute the very same totals, within the rounding of
+ * adding up the terms in another order than the reference. The others may round differently, so
+ * they're only checked on summations which don't amplify that too much.
+ */
+static bool differential_agrees(
+	enum summation_engine engine,
+	double sum,
+	double scalar_sum,
+	const struct differential_reference *reference,
+	long lower_bound,
+	long upper_bound
+) {
+	// the reference itself is meaningless then
+	if (!isfinite(reference->sum) || !isfinite(reference->magnitude)) {
+		return true;
+	}
+
+	double terms_count = (double)(upper_bound - lower_bound + 1);
+	switch (engine) {
+		case summation_engine_scalar:
+		case summation_engine_block:
+		case summation_engine_native:
+			return memcmp(&sum, &scalar_sum, sizeof(sum)) == 0 &&
+				   fabs(sum - reference->sum) <= terms_count * DBL_EPSILON * reference->magnitude;
+		default: {
+			double error = DIFFERENTIAL_RELATIVE_ERROR * reference->magnitude;
+			return !(reference->deviation <= error * DIFFERENTIAL_CONDITION_MARGIN) ||
+				   fabs(sum - reference->sum) <= error;
+		}
+	}
+}
+
+static double differential_sum(
+	const char *summand,
+	long lower_bound,
+	long upper_bound,
+	enum summation_engine engine,
+	const char *cache_directory
+) {
+	struct summation_options options = summation_options_default();
+	options.engine = engine;
+	options.cache_directory = cache_directory;
+
+	double sum = 0;
+	summation_fused(lower_bound, upper_bound, 1, &summand, &sum, &options);
+
+	return sum;
+}
+
+/**
+ * @brief Checks whether an engine disagrees with the reference on a single summation.
+ */
+static bool differential_fails(
+	const struct expression *summand,
+	long lower_bound,
+	long upper_bound,
+	enum summation_engine engine,
+	const char *cache_directory
+) {
+	char *string = expression_to_string(summand);
+
+	struct differential_reference reference =
+		differential_reference_new(string, lower_bound, upper_bound);
+
+	double sum = differential_sum(string, lower_bound, upper_bound, engine, cache_directory);
+	double scalar_sum = differential_sum(
+		string,
+		lower_bound,
+		upper_bound,
+		summation_engine_scalar,
+		cache_directory
+	);
+	free(string);
+
+	return !differential_agrees(
+		engine,
+		sum,
+		scalar_sum,
+		&reference,
+		lower_bound,
+		upper_bound
+	);
+}
+
+static size_t expression_size(const struct expression *expression) {
+	size_t size = 1;
+	if (expression->type == expression_type_operation) {
+		size_t arity = operation_type_arity(expression->operation.type);
+		for (size_t i = 0; i < arity; i++) {
+			size += expression_size(&expression->operation.operands[i]);
+		}
+	}
+	return size;
+}
+
+/**
+ * @brief Replaces the `*position`-th sub-expression of an expression, in pre-order.
+ */
+static struct expression expression_replace(
+	const struct expression *expression,
+	size_t *position,
+	const struct expression *replacement
+) {
+	if ((*position)-- == 0) {
+		return expression_clone(replacement);
+	}
+
+	if (expression->type != expression_type_operation) {
+		return expression_clone(expression);
+	}
+
+	struct expression operands[OPERATION_ARITY_MAXIMUM];
+	size_t arity = operation_type_arity(expression->operation.type);
+	for (size_t i = 0; i < arity; i++) {
+		operands[i] = expression_replace(&expression->operation.operands[i], position, replacement);
+	}
+
+	return expression_operation(expression->operation.type, operands[0], operands[1], operands[2]);
+}
+
+/**
+ * @brief Gets the `*position`-th sub-expression of an expression, in pre-order.
+ */
+static const struct expression *expression_at(
+	const struct expression *expression,
+	size_t *position
+) {
+	if ((*position)-- == 0) {
+		return expression;
+	}
+
+	if (expression->type == expression_type_operation) {
+		size_t arity = operation_type_arity(expression->operation.type);
+		for (size_t i = 0; i < arity; i++) {
+			const struct expression *found =
+				expression_at(&expression->operation.operands[i], position);
+			if (found != NULL) {
+				return found;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Shrinks a summation an engine disagrees on, and fails with it.
+ *
+ * Halves the range, and replaces sub-expressions of the summand by their operands, by 1 or by i,
+ * for as long as the engine still disagrees.
+ */
+static void differential_minimize(
+	struct expression summand,
+	long lower_bound,
+	long upper_bound,
+	enum summation_engine engine,
+	const char *cache_directory
+) {
+	bool is_shrunk = true;
+	while (is_shrunk) {
+		is_shrunk = false;
+
+		long middle = lower_bound + (upper_bound - lower_bound) / 2;
+		if (lower_bound < upper_bound &&
+			differential_fails(&summand, lower_bound, middle, engine, cache_directory)) {
+			upper_bound = middle;
+			is_shrunk = true;
+			continue;
+		}
+		if (lower_bound < upper_bound &&
+			differential_fails(&summand, middle + 1, upper_bound, engine, cache_directory)) {
+			lower_bound = middle + 1;
+			is_shrunk = true;
+			continue;
+		}
+
+		size_t size = expression_size(&summand);
+		for (size_t i = 0; i < size && !is_shrunk; i++) {
+			size_t position = i;
+			const struct expression *node = expression_at(&summand, &position);
+
+			struct expression replacements[OPERATION_ARITY_MAXIMUM + 2] = {
+				expression_constant(1),
+				expression_variable('i'),
+			};
+			size_t replacements_count = 2;
+			if (node->type == expression_type_operation) {
+				size_t arity = operation_type_arity(node->operation.type);
+				for (size_t j = 0; j < arity; j++) {
+					replacements[replacements_count++] = node->operation.operands[j];
+				}
+			}
+
+			for (size_t j = 0; j < replacements_count && !is_shrunk; j++) {
+				position = i;
+				struct expression candidate =
+					expression_replace(&summand, &position, &replacements[j]);
+				is_shrunk = expression_size(&candidate) < size &&
+							differential_fails(
+								&candidate,
+								lower_bound,
+								upper_bound,
+								engine,
+								cache_directory
+							);
+				if (is_shrunk) {
+					expression_drop(&summand);
+					summand = candidate;
+				} else {
+					expression_drop(&candidate);
+				}
+			}
+		}
+	}
+
+	char *string = expression_to_string(&summand);
+	struct differential_reference reference =
+		differential_reference_new(string, lower_bound, upper_bound);
+	double sum = differential_sum(string, lower_bound, upper_bound, engine, cache_directory);
+
+	print_error(
+		"The %s engine sums \"%s\" from %ld to %ld to %.17g instead of %.17g\n",
+		summation_engine_name(engine),
+		string,
+		lower_bound,
+		upper_bound,
+		sum,
+		reference.sum
+	);
+	free(string);
+	expression_drop(&summand);
+
+	fail();
+}
+
+/**
+ * @brief Removes a cache directory and its entries.
+ */
+static void remove_directory(const char *directory) {
+	DIR *entries = opendir(directory);
+	assert_non_null(entries);
+
+	struct dirent *entry = NULL;
+	while ((entry = readdir(entries)) != NULL) {
+		if (entry->d_name[0] != '.') {
+			char file[PATH_MAX];
+			(void)snprintf(file, sizeof(file), "%s/%s", directory, entry->d_name);
+			unlink(file);
+		}
+	}
+	closedir(entries);
+
+	rmdir(directory);
+}
+
+static void test_differential_random(void **state) {
+	(void)state;
+
+	char directory[] = "/tmp/test_differential_XXXXXX";
+	assert_non_null(mkdtemp(directory));
+
+	uint64_t seed = DIFFERENTIAL_SEED;
+	const char *seed_string = getenv("DIFFERENTIAL_SEED");
+	if (seed_string != NULL) {
+		seed = strtoull(seed_string, NULL, 0);
+	}
+
+	struct expression expressions[DIFFERENTIAL_SUMMANDS_COUNT];
+	char *summands[DIFFERENTIAL_SUMMANDS_COUNT];
+	for (size_t i = 0; i < DIFFERENTIAL_SUMMANDS_COUNT; i++) {
+		expressions[i] = generate(&seed, DIFFERENTIAL_DEPTH_MAXIMUM);
+		summands[i] = expression_to_string(&expressions[i]);
+
+		// the summands are printed exactly, so they parse back to themselves
+		struct expression parsed = expression_from_string(summands[i]);
+		assert_true(expression_equals(&parsed, &expressions[i]));
+		expression_drop(&parsed);
+	}
+
+	// within a leaf, across leaves, and around 0 where functions have their poles
+	const long bounds[][2] = { { 1, 100 }, { -40, 60 }, { -1500, 3000 } };
+	for (size_t i = 0; i < sizeof(bounds) / sizeof(bounds[0]); i++) {
+		struct differential_reference references[DIFFERENTIAL_SUMMANDS_COUNT];
+		for (size_t j = 0; j < DIFFERENTIAL_SUMMANDS_COUNT; j++) {
+			references[j] = differential_reference_new(summands[j], bounds[i][0], bounds[i][1]);
+		}
+
+		double sums[SUMMATION_ENGINES_COUNT][DIFFERENTIAL_SUMMANDS_COUNT];
+		for (size_t j = 0; j < SUMMATION_ENGINES_COUNT; j++) {
+			struct summation_options options = summation_options_default();
+			options.engine = (enum summation_engine)j;
+			options.cache_directory = directory;
+			summation_fused(
+				bounds[i][0],
+				bounds[i][1],
+				DIFFERENTIAL_SUMMANDS_COUNT,
+				(const char *const *)summands,
+				sums[j],
+				&options
+			);
+		}
+
+		for (size_t j = 0; j < SUMMATION_ENGINES_COUNT; j++) {
+			for (size_t k = 0; k < DIFFERENTIAL_SUMMANDS_COUNT; k++) {
+				if (!differential_agrees(
+						(enum summation_engine)j,
+						sums[j][k],
+						sums[summation_engine_scalar][k],
+						&references[k],
+						bounds[i][0],
+						bounds[i][1]
+					)) {
+					differential_minimize(
+						expression_clone(&expressions[k]),
+						bounds[i][0],
+						bounds[i][1],
+						(enum summation_engine)j,
+						directory
+					);
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < DIFFERENTIAL_SUMMANDS_COUNT; i++) {
+		free(summands[i]);
+		expression_drop(&expressions[i]);
+	}
+	remove_directory(directory);
+}
+
+static void test_differential_corpus(void **state) {
+	(void)state;
+
+	char directory[] = "/tmp/test_differential_XXXXXX";
+	assert_non_null(mkdtemp(directory));
+
+	// summands as they're actually used, over ranges long enough to time
+	const struct {
+		long lower_bound;
+		long upper_bound;
+		const char *summand;
+	} corpus[] = {
+		{ 1, 200000, "1 / i^2" },
+		{ 1, 200000, "sin(i) / i" },
+		{ 1, 200000, "(-1)^i / (2 * i + 1)" },
+		{ 0, 200000, "exp(-i / 50000) * cos(i / 100)" },
+		{ 1, 200000, "log(i) / (i * i + 1)" },
+		{ 0, 200000, "i^3 - 2 * i^2 + 7" },
+		{ 1, 200000, "1 / (i * (i + 1))" },
+		{ 1, 200000, "i % 7 * floor(i / 3)" },
+		{ -100000, 100000, "if(i % 2, abs(i), -i / 3) / (i * i + 1)" },
+		{ 0, 2000, "lbinom(2000, i) - lfact(i) / 1000" },
+		{ 1, 200000, "min(sin(i), cos(i)) + max(i % 5, 2)" },
+		{ 1, 200000, "sin(3 * i + 1) * exp(-i / 100000)" },
+	};
+	size_t count = sizeof(corpus) / sizeof(corpus[0]);
+
+	print_message("%-44s", "summand, nanoseconds per term");
+	for (size_t i = 0; i < SUMMATION_ENGINES_COUNT; i++) {
+		print_message(" %10s", summation_engine_name((enum summation_engine)i));
+	}
+	print_message("\n");
+
+	for (size_t i = 0; i < count; i++) {
+		long lower_bound = corpus[i].lower_bound;
+		long upper_bound = corpus[i].upper_bound;
+
+		struct differential_reference reference =
+			differential_reference_new(corpus[i].summand, lower_bound, upper_bound);
+
+		double sums[SUMMATION_ENGINES_COUNT];
+		double nanoseconds[SUMMATION_ENGINES_COUNT];
+		for (size_t j = 0; j < SUMMATION_ENGINES_COUNT; j++) {
+			struct summation_options options = summation_options_default();
+			options.engine = (enum summation_engine)j;
+			options.cache_directory = directory;
+			options.threads_count = 1;
+
+			// only the execution is timed, not the planning or the compilation
+			struct summation_plan plan =
+				summation_plan_new(lower_bound, upper_bound, 1, &corpus[i].summand, &options);
+			double start = seconds_now();
+			summation_plan_execute(&plan, &sums[j]);
+			nanoseconds[j] = (seconds_now() - start) * NANOSECONDS_PER_SECOND /
+							 (double)(upper_bound - lower_bound + 1);
+			summation_plan_drop(&plan);
+		}
+
+		print_message("%-44s", corpus[i].summand);
+		for (size_t j = 0; j < SUMMATION_ENGINES_COUNT; j++) {
+			print_message(" %10.2f", nanoseconds[j]);
+		}
+		print_message("\n");
+
+		for (size_t j = 0; j < SUMMATION_ENGINES_COUNT; j++) {
+			if (!differential_agrees(
+					(enum summation_engine)j,
+					sums[j],
+					sums[summation_engine_scalar],
+					&reference,
+					lower_bound,
+					upper_bound
+				)) {
+				differential_minimize(
+					expression_from_string(corpus[i].summand),
+					lower_bound,
+					upper_bound,
+					(enum summation_engine)j,
+					directory
+				);
+			}
+		}
+	}
+
+	remove_directory(directory);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_differential_random),
+		cmocka_unit_test(test_differential_corpus),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
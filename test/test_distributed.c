@@ -0,0 +1,174 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <arpa/inet.h>
+#include <distributed.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define EPSILON (0.000000001)
+
+static const char *const summands[] = {
+	"i",
+	"1 / i ^ 2",
+	"sin(i) * i",
+};
+#define SUMMANDS_COUNT (sizeof(summands) / sizeof(summands[0]))
+
+static void spawn_workers(const struct coordinator *coordinator, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		pid_t worker = fork();
+		assert_true(worker >= 0);
+		if (worker == 0) {
+			_exit(worker_run("127.0.0.1", coordinator->port, NULL));
+		}
+	}
+}
+
+/**
+ * @brief Spawns a worker that dies right after being handed its first shard, or that stalls on it
+ * until the coordinator drops it.
+ */
+static void spawn_failing_worker(const struct coordinator *coordinator, bool is_stalling) {
+	pid_t worker = fork();
+	assert_true(worker >= 0);
+	if (worker == 0) {
+		int connection = socket(AF_INET, SOCK_STREAM, 0);
+		struct sockaddr_in address = {
+			.sin_family = AF_INET,
+			.sin_port = htons(coordinator->port),
+			.sin_addr = { .s_addr = htonl(INADDR_LOOPBACK) },
+		};
+		if (connect(connection, (struct sockaddr *)&address, sizeof(address)) != 0) {
+			_exit(EXIT_FAILURE);
+		}
+
+		FILE *input = fdopen(connection, "r");
+		char line[BUFSIZ];
+		while (fgets(line, sizeof(line), input) != NULL) {
+			if (strncmp(line, "SHARD", strlen("SHARD")) == 0 && !is_stalling) {
+				_exit(EXIT_SUCCESS);
+			}
+		}
+		_exit(is_stalling ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+}
+
+static void test_distributed(void **state) {
+	(void)state;
+
+	double expected[SUMMANDS_COUNT];
+	summation_fused(1, 100000, SUMMANDS_COUNT, summands, expected, NULL);
+
+	double previous[SUMMANDS_COUNT];
+	for (size_t workers = 1; workers <= 4; workers++) {
+		struct coordinator coordinator;
+		assert_int_equal(coordinator_open(&coordinator, NULL, 0), EXIT_SUCCESS);
+
+		spawn_failing_worker(&coordinator, false);
+		spawn_workers(&coordinator, workers);
+
+		double sums[SUMMANDS_COUNT];
+		assert_int_equal(
+			coordinator_run(&coordinator, 1, 100000, SUMMANDS_COUNT, summands, 37, sums, NULL),
+			EXIT_SUCCESS
+		);
+
+		coordinator_close(&coordinator);
+		while (wait(NULL) > 0) {
+		}
+
+		for (size_t i = 0; i < SUMMANDS_COUNT; i++) {
+			assert_float_equal(sums[i], expected[i], EPSILON);
+		}
+
+		// the total doesn't depend on which worker evaluated which shard
+		if (workers > 1) {
+			assert_memory_equal(sums, previous, sizeof(sums));
+		}
+		memcpy(previous, sums, sizeof(sums));
+	}
+}
+
+static void test_distributed_address(void **state) {
+	(void)state;
+
+	struct coordinator coordinator;
+	assert_int_equal(coordinator_open(&coordinator, "127.0.0.1", 0), EXIT_SUCCESS);
+	coordinator_close(&coordinator);
+
+	assert_int_equal(coordinator_open(&coordinator, "localhost", 0), EXIT_FAILURE);
+	assert_int_equal(coordinator_open(&coordinator, "127.0.0.256", 0), EXIT_FAILURE);
+}
+
+static void test_distributed_empty(void **state) {
+	(void)state;
+
+	struct coordinator coordinator;
+	assert_int_equal(coordinator_open(&coordinator, NULL, 0), EXIT_SUCCESS);
+
+	double sums[SUMMANDS_COUNT] = { 1, 1, 1 };
+	assert_int_equal(
+		coordinator_run(&coordinator, 10, 1, SUMMANDS_COUNT, summands, 4, sums, NULL),
+		EXIT_SUCCESS
+	);
+	for (size_t i = 0; i < SUMMANDS_COUNT; i++) {
+		assert_float_equal(sums[i], 0, EPSILON);
+	}
+
+	coordinator_close(&coordinator);
+}
+
+static void test_distributed_timeout(void **state) {
+	(void)state;
+
+	double expected[SUMMANDS_COUNT];
+	summation_fused(1, 100000, SUMMANDS_COUNT, summands, expected, NULL);
+
+	// without any worker, once the only one died, and once it stalled
+	for (size_t failing = 0; failing <= 2; failing++) {
+		struct coordinator coordinator;
+		assert_int_equal(coordinator_open(&coordinator, NULL, 0), EXIT_SUCCESS);
+		coordinator.timeout = 100;
+		coordinator.shard_timeout = 200;
+
+		if (failing != 0) {
+			spawn_failing_worker(&coordinator, failing == 2);
+		}
+
+		double sums[SUMMANDS_COUNT];
+		assert_int_equal(
+			coordinator_run(&coordinator, 1, 100000, SUMMANDS_COUNT, summands, 37, sums, NULL),
+			EXIT_SUCCESS
+		);
+
+		coordinator_close(&coordinator);
+		while (wait(NULL) > 0) {
+		}
+
+		for (size_t i = 0; i < SUMMANDS_COUNT; i++) {
+			assert_true(fabs(sums[i] - expected[i]) <= EPSILON * fabs(expected[i]));
+		}
+	}
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_distributed),
+		cmocka_unit_test(test_distributed_address),
+		cmocka_unit_test(test_distributed_empty),
+		cmocka_unit_test(test_distributed_timeout),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,96 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <estimate.h>
+#include <math.h>
+
+#define EPSILON (0.000000001)
+
+static void test_estimate_fused(void **state) {
+	(void)state;
+
+	const char *const summands[] = { "1 + sin(i)", "i", "exp(-i / 1000000000000)", "1 / i" };
+	double upper_bound = 1000000000000;
+	const double sums[] = {
+		// the sum of sines, from the product of sines of half the bounds
+		upper_bound + sin(upper_bound / 2) * sin((upper_bound + 1) / 2) / sin(0.5),
+		upper_bound * (upper_bound + 1) / 2,
+		expm1(-1) / expm1(-1 / upper_bound) - 1 + exp(-1),
+		// the harmonic number, mostly from the first indices
+		log(upper_bound) + 0.5772156649015329 + 1 / (2 * upper_bound),
+	};
+	size_t count = sizeof(summands) / sizeof(summands[0]);
+
+	struct estimate_options options = estimate_options_default();
+	options.seconds = 0;
+	options.seed = 1;
+
+	struct estimate estimates[sizeof(summands) / sizeof(summands[0])];
+	estimate_fused(1, (long)upper_bound, count, summands, estimates, &options);
+
+	for (size_t i = 0; i < count; i++) {
+		assert_false(estimates[i].is_exact);
+		assert_true(estimates[i].error > 0);
+		assert_true(estimates[i].error <= options.relative_error * fabs(estimates[i].sum));
+		assert_true(fabs(estimates[i].sum - sums[i]) <= estimates[i].error);
+		assert_true(estimates[i].terms_count < 100000000);
+	}
+
+	// the same seed gives the same estimates
+	struct estimate again[sizeof(summands) / sizeof(summands[0])];
+	estimate_fused(1, (long)upper_bound, count, summands, again, &options);
+	for (size_t i = 0; i < count; i++) {
+		assert_float_equal(again[i].sum, estimates[i].sum, 0);
+		assert_float_equal(again[i].error, estimates[i].error, 0);
+	}
+
+	// an unreachable error budget is cut short by the time budget
+	options.seconds = 0.01;
+	options.relative_error = 0.000000000001;
+	estimate_fused(1, (long)upper_bound, count, summands, estimates, &options);
+	for (size_t i = 0; i < count; i++) {
+		assert_false(estimates[i].is_exact);
+		assert_true(fabs(estimates[i].sum - sums[i]) <= 2 * estimates[i].error);
+	}
+}
+
+static void test_estimate_fused_exact(void **state) {
+	(void)state;
+
+	const char *const summands[] = { "i * i", "1 / i" };
+	struct estimate estimates[2];
+
+	// small ranges aren't worth sampling
+	estimate_fused(1, 1000, 2, summands, estimates, NULL);
+	assert_true(estimates[0].is_exact);
+	assert_float_equal(estimates[0].sum, 333833500, EPSILON);
+	assert_float_equal(estimates[0].error, 0, 0);
+	assert_int_equal(estimates[0].terms_count, 1000);
+
+	// without budgets, sampling is eventually given up for the exact totals
+	struct estimate_options options = estimate_options_default();
+	options.seconds = 0;
+	options.relative_error = 0;
+	estimate_fused(1, 100000, 2, summands, estimates, &options);
+	assert_true(estimates[0].is_exact && estimates[1].is_exact);
+	assert_float_equal(estimates[0].sum, 333338333350000, 0.1);
+	assert_int_equal(estimates[1].terms_count, 100000);
+
+	estimate_fused(5, 4, 2, summands, estimates, NULL);
+	assert_true(estimates[0].is_exact);
+	assert_float_equal(estimates[0].sum, 0, 0);
+	assert_int_equal(estimates[0].terms_count, 0);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_estimate_fused),
+		cmocka_unit_test(test_estimate_fused_exact),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -5,7 +5,9 @@
 
 #include <cmocka.h>
 
+#include <environment.h>
 #include <expression.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -132,6 +134,107 @@ static int setup(void **state_) {
 				  expression_operation(operation_type_sine, expression_constant(3.9))
 			  )
 		  ) },
+		{ "-x! + binom(n, 3)",
+		  expression_operation(
+			  operation_type_addition,
+			  expression_operation(
+				  operation_type_negation,
+				  expression_operation(operation_type_factorial, expression_variable('x'))
+			  ),
+			  expression_operation(
+				  operation_type_binomial,
+				  expression_variable('n'),
+				  expression_constant(3)
+			  )
+		  ) },
+		{ "(x + 1)! / lfact(x) ^ lbinom(2 * x, x)",
+		  expression_operation(
+			  operation_type_division,
+			  expression_operation(
+				  operation_type_factorial,
+				  expression_operation(
+					  operation_type_addition,
+					  expression_variable('x'),
+					  expression_constant(1)
+				  )
+			  ),
+			  expression_operation(
+				  operation_type_exponentiation,
+				  expression_operation(operation_type_log_factorial, expression_variable('x')),
+				  expression_operation(
+					  operation_type_log_binomial,
+					  expression_operation(
+						  operation_type_multiplication,
+						  expression_constant(2),
+						  expression_variable('x')
+					  ),
+					  expression_variable('x')
+				  )
+			  )
+		  ) },
+		{ "gamma(s) * lgamma(e)",
+		  expression_operation(
+			  operation_type_multiplication,
+			  expression_operation(operation_type_gamma, expression_variable('s')),
+			  expression_operation(operation_type_log_gamma, expression_variable('e'))
+		  ) },
+		{ "s * e",
+		  expression_operation(
+			  operation_type_multiplication,
+			  expression_variable('s'),
+			  expression_variable('e')
+		  ) },
+		{ "max(0, x - 1) % 3 <= abs(y) + 1",
+		  expression_operation(
+			  operation_type_less_equal,
+			  expression_operation(
+				  operation_type_modulo,
+				  expression_operation(
+					  operation_type_maximum,
+					  expression_constant(0),
+					  expression_operation(
+						  operation_type_subtraction,
+						  expression_variable('x'),
+						  expression_constant(1)
+					  )
+				  ),
+				  expression_constant(3)
+			  ),
+			  expression_operation(
+				  operation_type_addition,
+				  expression_operation(operation_type_absolute_value, expression_variable('y')),
+				  expression_constant(1)
+			  )
+		  ) },
+		{ "if(x! != 2, floor(x / 3), ceil(-x)) == (x > 1)",
+		  expression_operation(
+			  operation_type_equal,
+			  expression_operation(
+				  operation_type_conditional,
+				  expression_operation(
+					  operation_type_not_equal,
+					  expression_operation(operation_type_factorial, expression_variable('x')),
+					  expression_constant(2)
+				  ),
+				  expression_operation(
+					  operation_type_floor,
+					  expression_operation(
+						  operation_type_division,
+						  expression_variable('x'),
+						  expression_constant(3)
+					  )
+				  ),
+				  expression_operation(
+					  operation_type_ceiling,
+					  expression_operation(operation_type_negation, expression_variable('x'))
+				  )
+			  ),
+			  expression_operation(
+				  operation_type_greater,
+				  expression_variable('x'),
+				  expression_constant(1)
+			  )
+		  ) },
 	};
 
 	struct test_state *state = malloc(sizeof(struct test_state) + sizeof(test_cases));
@@ -177,6 +280,19 @@ static void test_expression_clone(void **state_) {
 
 		expression_drop(&clone);
 	}
+
+	// clones share their operands, which outlive the expression they were cloned from
+	struct expression expression = expression_from_string("sin(x) * 2 + y");
+	struct expression clone = expression_clone(&expression);
+	assert_true(clone.operation.operands == expression.operation.operands);
+
+	expression_drop(&expression);
+
+	char *string = expression_to_string(&clone);
+	assert_string_equal(string, "sin(x) * 2 + y");
+	free(string);
+
+	expression_drop(&clone);
 }
 
 static void test_expression_from_string(void **state_) {
@@ -203,12 +319,150 @@ static void test_expression_to_string(void **state_) {
 	}
 }
 
+static void test_expression_evaluate_combinatorics(void **state) {
+	(void)state;
+
+	const struct {
+		const char *string;
+		double value;
+	} test_cases[] = {
+		{ "5!", 120 },
+		{ "0!", 1 },
+		{ "3!!", 720 },
+		{ "binom(10, 3)", 120 },
+		{ "binom(10, 7)", 120 },
+		{ "binom(5, 7)", 0 },
+		{ "binom(5, -1)", 0 },
+		{ "binom(-2, 3)", -4 },
+		{ "binom(0.5, 2)", -0.125 },
+		{ "binom(100, 50)", 100891344545564193334812497256.0 },
+		{ "gamma(0.5) ^ 2", 3.14159265358979323846 },
+		{ "lgamma(10)", 12.801827480081469611 },
+		{ "lfact(9)", 12.801827480081469611 },
+		{ "lbinom(10, 3)", 4.7874917427820459942 },
+		// the coefficient itself overflows
+		{ "lbinom(2000, 1000)", 1382.26799353748 },
+	};
+
+	for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+		struct expression expression = expression_from_string(test_cases[i].string);
+
+		double value = expression_evaluate(&expression, NULL);
+		assert_float_equal(value, test_cases[i].value, 1e-12 * fmax(1, fabs(test_cases[i].value)));
+
+		expression_drop(&expression);
+	}
+}
+
+static void test_expression_evaluate_piecewise(void **state) {
+	(void)state;
+
+	const struct {
+		const char *string;
+		double value;
+	} test_cases[] = {
+		{ "7 % 3", 1 },
+		{ "-7 % 3", 2 },
+		{ "7 % -3", -2 },
+		{ "6 % 3", 0 },
+		{ "abs(-2.5)", 2.5 },
+		{ "floor(-2.5)", -3 },
+		{ "ceil(-2.5)", -2 },
+		{ "min(2, -3) + max(2, -3)", -1 },
+		{ "1 < 2", 1 },
+		{ "2 <= 2", 1 },
+		{ "1 > 2", 0 },
+		{ "1 + 2 >= 3", 1 },
+		{ "2 * 3 == 3!", 1 },
+		{ "3! != 6", 0 },
+		{ "if(0, 1, 2)", 2 },
+		{ "if(-0.5, 1, 2)", 1 },
+		{ "if(2 < 1, 1 / 0, 3)", 3 },
+	};
+
+	for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+		struct expression expression = expression_from_string(test_cases[i].string);
+
+		double value = expression_evaluate(&expression, NULL);
+		assert_float_equal(value, test_cases[i].value, 0);
+
+		expression_drop(&expression);
+	}
+}
+
+static void test_expression_simplify(void **state) {
+	(void)state;
+
+	const struct {
+		const char *string;
+		const char *simplified;
+	} test_cases[] = {
+		{ "3 * i^3 + i^2 - 2", "(3 * i + 1) * i * i - 2" },
+		{ "i * (i - 1) / 2", "i * (i - 1) / 2" },
+		{ "sin(x^2 + x) + x^2", "sin((x + 1) * x) + x * x" },
+		{ "i^2 * j", "i * i * j" },
+		{ "-(i^4) + 2 * 3 * i", "(-i * i * i + 6) * i" },
+		// products and powers of sums, which would cancel out far from the origin
+		{ "(i + 1) * (i + 2)", "(i + 1) * (i + 2)" },
+		{ "(i - 100000) ^ 4 + i ^ 2", "(i - 100000) ^ 4 + i * i" },
+		// linear
+
+		{ "2 * i + 1", "2 * i + 1" },
+	};
+
+	for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+		struct environment environment = environment_new();
+		struct expression expression = expression_from_string(test_cases[i].string);
+		struct expression simplified = expression_clone(&expression);
+		expression_simplify(&simplified, &environment);
+
+		char *string = expression_to_string(&simplified);
+		assert_string_equal(string, test_cases[i].simplified);
+		free(string);
+
+		for (double x = -3; x <= 3; x += 0.75) {
+			environment_set_variable(&environment, 'i', x);
+			environment_set_variable(&environment, 'j', x + 1);
+			environment_set_variable(&environment, 'x', x);
+			double expected = expression_evaluate(&expression, &environment);
+			double value = expression_evaluate(&simplified, &environment);
+			assert_float_equal(value, expected, 1e-12 * fmax(1, fabs(expected)));
+		}
+
+		expression_drop(&simplified);
+		expression_drop(&expression);
+	}
+
+	// simplifying leaves the original as it is, and shares the sub-expressions left as they are
+	struct environment environment = environment_new();
+	environment_set_variable(&environment, 'x', 2);
+	struct expression expression = expression_from_string("sin(i) / i + x^2 * i");
+	struct expression simplified = expression_simplified(&expression, &environment);
+
+	const struct expression *quotient = &expression.operation.operands[0];
+	assert_true(simplified.operation.operands[0].operation.operands == quotient->operation.operands);
+	assert_true(simplified.operation.operands != expression.operation.operands);
+
+	char *string = expression_to_string(&expression);
+	assert_string_equal(string, "sin(i) / i + x ^ 2 * i");
+	free(string);
+	string = expression_to_string(&simplified);
+	assert_string_equal(string, "sin(i) / i + 4 * i");
+	free(string);
+
+	expression_drop(&expression);
+	expression_drop(&simplified);
+}
+
 int main(void) {
 	const struct CMUnitTest tests[] = {
 		cmocka_unit_test(test_expression_equals),
 		cmocka_unit_test(test_expression_clone),
 		cmocka_unit_test(test_expression_from_string),
 		cmocka_unit_test(test_expression_to_string),
+		cmocka_unit_test(test_expression_evaluate_combinatorics),
+		cmocka_unit_test(test_expression_evaluate_piecewise),
+		cmocka_unit_test(test_expression_simplify),
 	};
 
 	return cmocka_run_group_tests(tests, setup, teardown);
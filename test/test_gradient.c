@@ -0,0 +1,143 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <environment.h>
+#include <expression.h>
+#include <gradient.h>
+#include <math.h>
+
+#define EPSILON (0.000000001)
+#define STEP (0.000001)
+
+static void test_gradient_summation_fused(void **state) {
+	(void)state;
+
+	// every operation, away from the points where the piecewise ones jump
+	const char *const summands[] = {
+		"x ^ i / i! + (i / 1000) ^ x - x ^ (y / i)",
+		"sin(i * x) / i ^ 2 + cos(x - i) * tan(x / i)",
+		"exp(-y * i / 1000) - log(x + i) / (i + y) - x * i",
+		"(x + i / 1000)! + gamma(y + 1 / i) + lgamma(i * y) - lfact(x * i) + gamma(x - 3.2)",
+		"binom(x + 10, y + i % 5) + lbinom(i + x, y)",
+		"(i + y) % 2.5 + abs(x - i / 99) + floor(x + i / 7) * y - ceil(y * i + 0.05) / i",
+		"min(x * i, y * 900) + max(sin(x + i), cos(y + i))",
+		"if(i < 1000 * x + 0.5, x * i, y ^ 2) + (x * i > 100) * i + (y * i == 13) * x",
+		"i * y",
+		"i",
+	};
+	size_t count = sizeof(summands) / sizeof(summands[0]);
+	const char variables[] = { 'x', 'y', 'z' };
+	size_t variables_count = sizeof(variables) / sizeof(variables[0]);
+	const long lower_bound = 1;
+	const long upper_bound = 3000;
+
+	struct environment environment = environment_new();
+	environment_set_variable(&environment, 'x', 0.7);
+	environment_set_variable(&environment, 'y', 1.3);
+	environment_set_variable(&environment, 'z', 2);
+
+	// sums and central differences of the terms
+	double expected_sums[sizeof(summands) / sizeof(summands[0])];
+	double expected_gradients[sizeof(summands) / sizeof(summands[0])][3];
+	double magnitudes[sizeof(summands) / sizeof(summands[0])][3];
+	for (size_t i = 0; i < count; i++) {
+		struct expression expression = expression_from_string(summands[i]);
+		expected_sums[i] = 0;
+		for (size_t j = 0; j < variables_count; j++) {
+			expected_gradients[i][j] = 0;
+			magnitudes[i][j] = 0;
+		}
+
+		for (long k = lower_bound; k <= upper_bound; k++) {
+			struct environment point = environment;
+			environment_set_variable(&point, 'i', (double)k);
+			double term = expression_evaluate(&expression, &point);
+			expected_sums[i] += term;
+
+			for (size_t j = 0; j < variables_count; j++) {
+				double value = environment_get_variable(&environment, variables[j]);
+				environment_set_variable(&point, variables[j], value + STEP);
+				double above = expression_evaluate(&expression, &point);
+				environment_set_variable(&point, variables[j], value - STEP);
+				double below = expression_evaluate(&expression, &point);
+				environment_set_variable(&point, variables[j], value);
+
+				double derivative = (above - below) / (2 * STEP);
+				expected_gradients[i][j] += derivative;
+				magnitudes[i][j] += fabs(derivative) + fabs(term) + 1;
+			}
+		}
+
+		expression_drop(&expression);
+	}
+
+	struct summation_options options = summation_options_default();
+	double sums[sizeof(summands) / sizeof(summands[0])];
+	double gradients[sizeof(summands) / sizeof(summands[0]) * 3];
+	for (size_t threads_count = 1; threads_count <= 2; threads_count++) {
+		options.threads_count = threads_count;
+		gradient_summation_fused(
+			lower_bound,
+			upper_bound,
+			&environment,
+			variables_count,
+			variables,
+			count,
+			summands,
+			sums,
+			gradients,
+			&options
+		);
+
+		for (size_t i = 0; i < count; i++) {
+			double tolerance = fmax(fabs(expected_sums[i]), 1) * EPSILON;
+			assert_float_equal(sums[i], expected_sums[i], tolerance);
+			for (size_t j = 0; j < variables_count; j++) {
+				assert_float_equal(
+					gradients[i * variables_count + j],
+					expected_gradients[i][j],
+					magnitudes[i][j] * 0.00001
+				);
+			}
+		}
+	}
+
+	// exactly, without the rounding errors of the differences
+	assert_float_equal(gradients[8 * variables_count], 0, EPSILON);
+	assert_float_equal(gradients[8 * variables_count + 1], 3000.0 * 3001 / 2, EPSILON);
+	for (size_t i = 0; i < count; i++) {
+		assert_float_equal(gradients[i * variables_count + 2], 0, EPSILON);
+	}
+
+	// empty ranges sum to 0
+	gradient_summation_fused(
+		2,
+		1,
+		&environment,
+		variables_count,
+		variables,
+		count,
+		summands,
+		sums,
+		gradients,
+		NULL
+	);
+	for (size_t i = 0; i < count; i++) {
+		assert_float_equal(sums[i], 0, EPSILON);
+		for (size_t j = 0; j < variables_count; j++) {
+			assert_float_equal(gradients[i * variables_count + j], 0, EPSILON);
+		}
+	}
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_gradient_summation_fused),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,164 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <dirent.h>
+#include <environment.h>
+#include <kernel.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <summation.h>
+#include <unistd.h>
+
+static struct program compile(size_t count, const char *const summands[]) {
+	struct environment environment = environment_new();
+	struct expression expressions[16];
+	for (size_t i = 0; i < count; i++) {
+		expressions[i] = expression_from_string(summands[i]);
+		expression_simplify(&expressions[i], &environment);
+	}
+
+	struct program program = program_new(count, expressions);
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+
+	return program;
+}
+
+static void test_kernel_run(void **state) {
+	(void)state;
+
+	// every type of operation, some evaluated by the caller
+	const char *const summands[] = {
+		"(i + 1) * (i - 1) / (i * i + 3)",
+		"sin(i) / i + cos(i) ^ 2 - tan(-i)",
+		"exp(-i / 100) * log(i) + abs(i - 500)",
+		"floor(i / 7) - ceil(i / 3) + min(i, 300) - max(i, 700)",
+		"(i < 200) + (i <= 300) * 2 + (i > 400) * 3 + (i >= 500) * 4 + (i == 600) + (i != 700)",
+		"if(i % 3, i, -1) + binom(i, 2) - lbinom(i, 3) + lgamma(i) - lfact(i)",
+		"gamma(i / 100) + (i / 500)! + x",
+		"2.5",
+	};
+	size_t count = sizeof(summands) / sizeof(summands[0]);
+
+	struct program program = compile(count, summands);
+
+	struct kernel kernel;
+	if (kernel_new(&kernel, &program, NULL) == EXIT_FAILURE) {
+		// no C compiler
+		program_drop(&program);
+		skip();
+	}
+
+	const long bounds[][2] = { { 1, 1000 }, { -5, 5 }, { 3, 2 } };
+	for (size_t i = 0; i < sizeof(bounds) / sizeof(bounds[0]); i++) {
+		double sums[sizeof(summands) / sizeof(summands[0])];
+		double expected[sizeof(summands) / sizeof(summands[0])];
+		for (size_t j = 0; j < count; j++) {
+			sums[j] = 1;
+			expected[j] = 1;
+		}
+
+		kernel_run(&kernel, bounds[i][0], bounds[i][1], sums);
+
+		// the terms are the same as the block engine's, added up in the same order
+		struct environment environment = environment_new();
+		double *values = malloc(program.instructions_count * sizeof(*values));
+		for (long k = bounds[i][0]; k <= bounds[i][1]; k++) {
+			double index = (double)k;
+			program_evaluate_block(&program, &environment, 'i', &index, 1, values);
+			for (size_t j = 0; j < count; j++) {
+				expected[j] += values[program.outputs[j]];
+			}
+		}
+		free(values);
+
+		assert_memory_equal(sums, expected, sizeof(sums));
+	}
+
+	kernel_drop(&kernel);
+	program_drop(&program);
+}
+
+static void test_kernel_summation(void **state) {
+	(void)state;
+
+	char directory[] = "/tmp/test_kernel_XXXXXX";
+	assert_non_null(mkdtemp(directory));
+
+	const char *const summands[] = { "sin(i) / i", "i^2 % 7", "lfact(i) - i" };
+
+	struct summation_options options = summation_options_default();
+	options.engine = summation_engine_block;
+	double expected[3];
+	summation_fused(-100000, 2000000, 3, summands, expected, &options);
+
+	options.engine = summation_engine_native;
+	options.cache_directory = directory;
+	bool is_compiled = true;
+	for (size_t i = 0; i < 2 && is_compiled; i++) {
+		struct summation_plan plan = summation_plan_new(-100000, 2000000, 3, summands, &options);
+		if (plan.engine != summation_engine_native) {
+			// no C compiler
+			is_compiled = false;
+		} else {
+			double sums[3];
+			summation_plan_execute(&plan, sums);
+			assert_memory_equal(sums, expected, sizeof(sums));
+		}
+
+		summation_plan_drop(&plan);
+	}
+
+	// kernels compiled by another compiler aren't loaded from the cache
+	if (is_compiled) {
+		const char *compiler = getenv("CC");
+		char *saved_compiler = compiler != NULL ? strdup(compiler) : NULL;
+		setenv("CC", "false", 1);
+
+		struct summation_plan plan = summation_plan_new(-100000, 2000000, 3, summands, &options);
+		assert_int_not_equal(plan.engine, summation_engine_native);
+		summation_plan_drop(&plan);
+
+		if (saved_compiler != NULL) {
+			setenv("CC", saved_compiler, 1);
+		} else {
+			unsetenv("CC");
+		}
+		free(saved_compiler);
+	}
+
+	// the kernel is compiled once, and loaded from the cache the second time
+	DIR *entries = opendir(directory);
+	assert_non_null(entries);
+	size_t kernels_count = 0;
+	struct dirent *entry = NULL;
+	while ((entry = readdir(entries)) != NULL) {
+		if (strstr(entry->d_name, ".so") != NULL) {
+			++kernels_count;
+		}
+		if (entry->d_name[0] != '.') {
+			char file[sizeof(directory) + 256];
+			(void)snprintf(file, sizeof(file), "%s/%s", directory, entry->d_name);
+			unlink(file);
+		}
+	}
+	closedir(entries);
+	assert_int_equal(kernels_count, is_compiled ? 1 : 0);
+
+	rmdir(directory);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_kernel_run),
+		cmocka_unit_test(test_kernel_summation),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,134 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <math.h>
+#include <periodicity.h>
+
+#define EPSILON (0.000000001)
+
+static void test_periodicity_from_program(void **state) {
+	(void)state;
+
+	const struct {
+		const char *expression;
+		size_t period;
+	} test_cases[] = {
+		{ "sin(i * 3.141592653589793 / 2)", 4 },
+		{ "cos(2 * 3.141592653589793 * i / 6 + 1) ^ 2", 6 },
+		{ "tan(3.141592653589793 * i / 5 + 0.5)", 5 },
+		{ "i % 7", 7 },
+		{ "(3 * i + 1) % 12", 4 },
+		{ "(-1) ^ i", 2 },
+		{ "(-1) ^ (2 * i)", 0 },
+		{ "floor((i % 10) / 3) + (-1) ^ i * (i % 3 == 0)", 30 },
+		{ "if(i % 4 < 2, sin(3.141592653589793 * i / 3), exp(i % 5))", 60 },
+		{ "2 ^ (i % 3)", 3 },
+		{ "floor(i / 3) % 2", 6 },
+		{ "ceil((2 * i + 1) / 6) % 4", 12 },
+		{ "cos(3.141592653589793 * floor(i / 3))", 6 },
+		{ "(-1) ^ floor(i / 2)", 4 },
+		{ "i - 3 * floor(i / 3)", 3 },
+		{ "floor(i / 3) % 2 + floor(-i / 4) % 3", 12 },
+		{ "sin(i)", 0 },
+		{ "sin(i * 3.14159 / 2)", 0 },
+		{ "sin(i * 3.14159265358979 / 2)", 0 },
+		{ "i % 7 + i", 0 },
+		{ "i % 2.5", 0 },
+		{ "(i / 2) % 3", 0 },
+		{ "floor(i / 3)", 0 },
+		{ "floor(i / 2.5) % 2", 0 },
+		{ "floor(i / 3) % 2.5", 0 },
+		{ "sin(floor(i / 3))", 0 },
+		{ "i % 5000", 0 },
+		{ "x % 7", 0 },
+		{ "5", 0 },
+	};
+	size_t count = sizeof(test_cases) / sizeof(test_cases[0]);
+
+	struct expression expressions[sizeof(test_cases) / sizeof(test_cases[0])];
+	struct environment environment = environment_new();
+	for (size_t i = 0; i < count; i++) {
+		expressions[i] = expression_from_string(test_cases[i].expression);
+		expression_simplify(&expressions[i], &environment);
+	}
+
+	struct program program = program_new(count, expressions);
+
+	struct periodicity periodicities[sizeof(test_cases) / sizeof(test_cases[0])];
+	bool is_periodic[sizeof(test_cases) / sizeof(test_cases[0])];
+	periodicity_from_program(&program, 'i', -123, 9876, periodicities, is_periodic);
+
+	for (size_t i = 0; i < count; i++) {
+		assert_int_equal(is_periodic[i], test_cases[i].period != 0);
+		if (!is_periodic[i]) {
+			continue;
+		}
+
+		assert_int_equal(periodicities[i].period, test_cases[i].period);
+
+		double expected = 0;
+		for (long j = -123; j <= 9876; j++) {
+			environment_set_variable(&environment, 'i', (double)j);
+			expected += expression_evaluate(&expressions[i], &environment);
+		}
+
+		assert_float_equal(periodicity_sum(&periodicities[i]), expected, 0.000001);
+		periodicity_drop(&periodicities[i]);
+	}
+
+	// ranges shorter than two periods aren't worth it
+	periodicity_from_program(&program, 'i', 1, 10, periodicities, is_periodic);
+	assert_true(is_periodic[0]);
+	assert_false(is_periodic[3]);
+	for (size_t i = 0; i < count; i++) {
+		if (is_periodic[i]) {
+			periodicity_drop(&periodicities[i]);
+		}
+		expression_drop(&expressions[i]);
+	}
+
+	program_drop(&program);
+}
+
+static void test_periodicity_sum(void **state) {
+	(void)state;
+
+	struct expression expression = expression_from_string("(i % 3 == 1) - (i % 3 == 2)");
+	struct program program = program_new(1, &expression);
+
+	// only whole periods, and one more index
+	const long bounds[][2] = { { 0, 999999999999 }, { 2, 1000000000001 }, { -6, 8 } };
+	const double sums[] = { 0, -1, 0 };
+	for (size_t i = 0; i < sizeof(bounds) / sizeof(bounds[0]); i++) {
+		struct periodicity periodicity;
+		bool is_periodic = false;
+		periodicity_from_program(
+			&program,
+			'i',
+			bounds[i][0],
+			bounds[i][1],
+			&periodicity,
+			&is_periodic
+		);
+		assert_true(is_periodic);
+		assert_int_equal(periodicity.period, 3);
+		assert_float_equal(periodicity_sum(&periodicity), sums[i], EPSILON);
+		periodicity_drop(&periodicity);
+	}
+
+	program_drop(&program);
+	expression_drop(&expression);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_periodicity_from_program),
+		cmocka_unit_test(test_periodicity_sum),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,286 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <math.h>
+#include <polynomial.h>
+
+#define EPSILON (0.000000001)
+
+static void test_polynomial_from_program(void **state) {
+	(void)state;
+
+	const struct {
+		const char *expression;
+		bool is_polynomial;
+		size_t degree;
+	} test_cases[] = {
+		{ "i ^ 2 + 3 * i - 1", true, 2 },
+		{ "(i + 1) ^ 3 / 2", true, 3 },
+		{ "-(i - 2) * (i + 2) + i * i", true, 0 },
+		{ "sin(2) * i", true, 1 },
+		{ "binom(i, 3) - binom(2 * i + 1, 0)", true, 3 },
+		{ "7", true, 0 },
+		{ "sin(i)", false, 0 },
+		{ "1 / i", false, 0 },
+		{ "i / 0", false, 0 },
+		{ "i ^ 0.5", false, 0 },
+		{ "i ^ 17", false, 0 },
+		{ "x * i", false, 0 },
+		{ "binom(i, 0.5)", false, 0 },
+	};
+	size_t count = sizeof(test_cases) / sizeof(test_cases[0]);
+
+	struct expression expressions[sizeof(test_cases) / sizeof(test_cases[0])];
+	for (size_t i = 0; i < count; i++) {
+		expressions[i] = expression_from_string(test_cases[i].expression);
+	}
+
+	struct program program = program_new(count, expressions);
+
+	struct polynomial polynomials[sizeof(test_cases) / sizeof(test_cases[0])];
+	bool is_polynomial[sizeof(test_cases) / sizeof(test_cases[0])];
+	polynomial_from_program(&program, 'i', polynomials, is_polynomial);
+
+	struct environment environment = environment_new();
+	for (size_t i = 0; i < count; i++) {
+		assert_int_equal(is_polynomial[i], test_cases[i].is_polynomial);
+		if (!is_polynomial[i]) {
+			continue;
+		}
+
+		assert_int_equal(polynomials[i].degree, test_cases[i].degree);
+		for (double value = -5; value <= 5; value += 0.5) {
+			environment_set_variable(&environment, 'i', value);
+			assert_float_equal(
+				polynomial_evaluate(&polynomials[i], value),
+				expression_evaluate(&expressions[i], &environment),
+				EPSILON
+			);
+		}
+	}
+
+	program_drop(&program);
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+}
+
+static void test_polynomial_from_samples(void **state) {
+	(void)state;
+
+	const struct {
+		const char *expression;
+		bool is_polynomial;
+		size_t degree;
+	} test_cases[] = {
+		{ "exp(2 * log(i))", true, 2 },
+		{ "i ^ 0.5 * i ^ 2.5 - 3 * i", true, 3 },
+		{ "sin(i) ^ 2 + cos(i) ^ 2", true, 0 },
+		{ "(i ^ 3 - 8) / (i - 2) + 1", true, 2 },
+		{ "lgamma(i + 3) - lgamma(i + 1) + log(3)", false, 0 },
+		{ "exp(i / 1000)", false, 0 },
+		{ "sin(i) / i", false, 0 },
+		{ "exp(-(i - 1234) ^ 2)", false, 0 },
+		{ "(floor(i / 7) != 100) * i", false, 0 },
+		{ "x * i", false, 0 },
+	};
+	size_t count = sizeof(test_cases) / sizeof(test_cases[0]);
+
+	struct expression expressions[sizeof(test_cases) / sizeof(test_cases[0])];
+	for (size_t i = 0; i < count; i++) {
+		expressions[i] = expression_from_string(test_cases[i].expression);
+	}
+
+	struct program program = program_new(count, expressions);
+
+	const long lower_bound = 3;
+	const long upper_bound = 100000;
+
+	struct polynomial polynomials[sizeof(test_cases) / sizeof(test_cases[0])];
+	bool is_polynomial[sizeof(test_cases) / sizeof(test_cases[0])];
+	polynomial_from_samples(&program, 'i', lower_bound, upper_bound, polynomials, is_polynomial);
+
+	struct environment environment = environment_new();
+	for (size_t i = 0; i < count; i++) {
+		assert_int_equal(is_polynomial[i], test_cases[i].is_polynomial);
+		if (!is_polynomial[i]) {
+			continue;
+		}
+
+		assert_int_equal(polynomials[i].degree, test_cases[i].degree);
+
+		double expected = 0;
+		for (long j = lower_bound; j <= upper_bound; j++) {
+			environment_set_variable(&environment, 'i', (double)j);
+			expected += expression_evaluate(&expressions[i], &environment);
+		}
+		assert_float_equal(
+			polynomial_sum(&polynomials[i], lower_bound, upper_bound),
+			expected,
+			EPSILON * fmax(1, fabs(expected))
+		);
+	}
+
+	// the coefficients are rounded to the rationals they approximate
+	assert_true(is_polynomial[0]);
+	assert_true(fpclassify(polynomials[0].coefficients[0]) == FP_ZERO);
+	assert_true(fpclassify(polynomials[0].coefficients[1]) == FP_ZERO);
+	assert_true(polynomials[0].coefficients[2] >= 1 && polynomials[0].coefficients[2] <= 1);
+
+	// too short to be worth sampling
+	polynomial_from_samples(&program, 'i', 1, 100, polynomials, is_polynomial);
+	assert_false(is_polynomial[0]);
+
+	program_drop(&program);
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+
+	// poles at a single integer of the range, between the samples
+	const char *const singular[] = {
+		"i / i", "i ^ 3 / i", "i ^ 2 * (i / i)", "binom(i, 3) / i", "exp(2 * log(i))",
+		"i ^ (-1) * i",
+	};
+	size_t singular_count = sizeof(singular) / sizeof(singular[0]);
+	struct expression singular_expressions[sizeof(singular) / sizeof(singular[0])];
+	for (size_t i = 0; i < singular_count; i++) {
+		singular_expressions[i] = expression_from_string(singular[i]);
+	}
+	program = program_new(singular_count, singular_expressions);
+
+	polynomial_from_samples(&program, 'i', -100000, 100000, polynomials, is_polynomial);
+	for (size_t i = 0; i < singular_count; i++) {
+		assert_false(is_polynomial[i]);
+	}
+	polynomial_from_samples(&program, 'i', 1, 100000, polynomials, is_polynomial);
+	for (size_t i = 0; i < singular_count; i++) {
+		assert_true(is_polynomial[i]);
+	}
+
+	program_drop(&program);
+	for (size_t i = 0; i < singular_count; i++) {
+		expression_drop(&singular_expressions[i]);
+	}
+}
+
+static void test_polynomial_sum(void **state) {
+	(void)state;
+
+	struct polynomial polynomials[] = {
+		polynomial_constant(2.5),
+		{ .degree = 2, .coefficients = { 0, 0, 1 } },
+		{ .degree = 3, .coefficients = { -1, 0.5, -2, 0.25 } },
+		{ .degree = 5, .coefficients = { 1, 1, 1, 1, 1, 1 } },
+	};
+	const struct {
+		long lower_bound;
+		long upper_bound;
+	} ranges[] = {
+		{ 1, 1000 }, { -17, 23 }, { 5, 5 }, { 5, 4 }, { 1000000, 1000010 },
+	};
+
+	for (size_t i = 0; i < sizeof(polynomials) / sizeof(polynomials[0]); i++) {
+		for (size_t j = 0; j < sizeof(ranges) / sizeof(ranges[0]); j++) {
+			double expected = 0;
+			for (long k = ranges[j].lower_bound; k <= ranges[j].upper_bound; k++) {
+				expected += polynomial_evaluate(&polynomials[i], (double)k);
+			}
+
+			assert_float_equal(
+				polynomial_sum(&polynomials[i], ranges[j].lower_bound, ranges[j].upper_bound),
+				expected,
+				EPSILON * fmax(1, fabs(expected))
+			);
+		}
+	}
+
+	// exact where the terms and the total are representable
+	assert_float_equal(polynomial_sum(&polynomials[1], 1, 1000), 333833500, 0);
+	assert_float_equal(polynomial_sum(&polynomials[0], -1000000000, 1000000000), 5000000002.5, 0);
+
+	// and for polynomials taking integer values at integers, like binom(i, 3)
+	struct polynomial binomial = { .degree = 3, .coefficients = { 0, 1.0 / 3, -0.5, 1.0 / 6 } };
+	double sum = polynomial_sum(&binomial, -50, 50);
+	assert_true(sum >= -42925 && sum <= -42925);
+}
+
+static void test_piecewise_polynomial_from_program(void **state) {
+	(void)state;
+
+	const struct {
+		const char *expression;
+		bool is_piecewise_polynomial;
+		size_t pieces_count;
+	} test_cases[] = {
+		{ "i ^ 2 + 1", true, 1 },
+		{ "max(0, i - 10)", true, 2 },
+		{ "abs(2 * i - 5) + abs(i + 3)", true, 3 },
+		{ "min(i, 3) * (i != 7) + if(i > 100, i, 0)", true, 4 },
+		{ "(i >= 0) * i ^ 3 - (i < 0) * i ^ 3", true, 2 },
+		{ "floor(3 * i) / 2 + ceil(i / 2 + 1)", false, 0 },
+		{ "abs(i ^ 2 - 4)", false, 0 },
+		{ "if(i % 2, 1, 0)", false, 0 },
+		{ "max(i, x)", false, 0 },
+	};
+	size_t count = sizeof(test_cases) / sizeof(test_cases[0]);
+
+	struct expression expressions[sizeof(test_cases) / sizeof(test_cases[0])];
+	for (size_t i = 0; i < count; i++) {
+		expressions[i] = expression_from_string(test_cases[i].expression);
+	}
+
+	struct program program = program_new(count, expressions);
+
+	const long lower_bound = -20;
+	const long upper_bound = 30;
+
+	struct piecewise_polynomial polynomials[sizeof(test_cases) / sizeof(test_cases[0])];
+	bool is_piecewise_polynomial[sizeof(test_cases) / sizeof(test_cases[0])];
+	piecewise_polynomial_from_program(
+		&program,
+		'i',
+		lower_bound,
+		upper_bound,
+		polynomials,
+		is_piecewise_polynomial
+	);
+
+	struct environment environment = environment_new();
+	for (size_t i = 0; i < count; i++) {
+		assert_int_equal(is_piecewise_polynomial[i], test_cases[i].is_piecewise_polynomial);
+		if (!is_piecewise_polynomial[i]) {
+			continue;
+		}
+
+		assert_int_equal(polynomials[i].pieces_count, test_cases[i].pieces_count);
+
+		double expected = 0;
+		for (long j = lower_bound; j <= upper_bound; j++) {
+			environment_set_variable(&environment, 'i', (double)j);
+			expected += expression_evaluate(&expressions[i], &environment);
+		}
+		assert_float_equal(piecewise_polynomial_sum(&polynomials[i]), expected, EPSILON);
+
+		piecewise_polynomial_drop(&polynomials[i]);
+	}
+
+	program_drop(&program);
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_polynomial_from_program),
+		cmocka_unit_test(test_polynomial_from_samples),
+		cmocka_unit_test(test_polynomial_sum),
+		cmocka_unit_test(test_piecewise_polynomial_from_program),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
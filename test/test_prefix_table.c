@@ -0,0 +1,146 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <limits.h>
+#include <math.h>
+#include <prefix_table.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <summation.h>
+#include <unistd.h>
+
+#define EPSILON (0.000000001)
+
+static const struct test_case {
+	long lower_bound;
+	long upper_bound;
+} queries[] = {
+	{ -20, 30 }, { -20, -20 }, { 30, 30 }, { -7, 12 }, { 3, 4 }, { 0, 29 }, { 5, 2 },
+};
+
+static const char *const summand = "i^3 / (i^2 + 1) + sin(i)";
+
+static void assert_queries(const struct prefix_table *table) {
+	for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+		assert_float_equal(
+			prefix_table_query(table, queries[i].lower_bound, queries[i].upper_bound),
+			summation(queries[i].lower_bound, queries[i].upper_bound, summand),
+			EPSILON
+		);
+	}
+}
+
+static void test_prefix_table_dense(void **state) {
+	(void)state;
+
+	struct prefix_table table = prefix_table_new(-20, 30, summand, 1);
+
+	assert_queries(&table);
+	assert_true(isnan(prefix_table_query(&table, -21, 0)));
+	assert_true(isnan(prefix_table_query(&table, 0, 31)));
+
+	prefix_table_drop(&table);
+}
+
+static void test_prefix_table_blocked(void **state) {
+	(void)state;
+
+	for (size_t block_size = 2; block_size <= 64; block_size *= 2) {
+		struct prefix_table table = prefix_table_new(-20, 30, summand, block_size);
+
+		assert_queries(&table);
+
+		prefix_table_drop(&table);
+	}
+}
+
+static void test_prefix_table_save_load(void **state) {
+	(void)state;
+
+	char path[] = "/tmp/test_prefix_table_XXXXXX";
+	int file = mkstemp(path);
+	assert_true(file >= 0);
+	close(file);
+
+	struct prefix_table table = prefix_table_new(-20, 30, summand, 4);
+	assert_int_equal(prefix_table_save(&table, path), EXIT_SUCCESS);
+	prefix_table_drop(&table);
+
+	struct prefix_table loaded;
+	assert_int_equal(prefix_table_load(&loaded, path), EXIT_SUCCESS);
+	assert_int_equal(loaded.lower_bound, -20);
+	assert_int_equal(loaded.upper_bound, 30);
+	assert_int_equal(loaded.block_size, 4);
+
+	assert_queries(&loaded);
+
+	prefix_table_drop(&loaded);
+	unlink(path);
+}
+
+static void test_prefix_table_invalid(void **state) {
+	(void)state;
+
+	// ranges with more indices than can be counted or allocated
+	struct prefix_table table = prefix_table_new(LONG_MIN, LONG_MAX, summand, 1);
+	assert_null(table.sums);
+	prefix_table_drop(&table);
+	table = prefix_table_new(LONG_MIN, LONG_MAX - 1, summand, 1);
+	assert_null(table.sums);
+	prefix_table_drop(&table);
+
+	char path[] = "/tmp/test_prefix_table_XXXXXX";
+	int file = mkstemp(path);
+	assert_true(file >= 0);
+	close(file);
+
+	table = prefix_table_new(-20, 30, summand, 4);
+	assert_int_equal(prefix_table_save(&table, path), EXIT_SUCCESS);
+	prefix_table_drop(&table);
+
+	FILE *stream = fopen(path, "rb");
+	assert_non_null(stream);
+	char contents[4096];
+	size_t size = fread(contents, 1, sizeof(contents), stream);
+	fclose(stream);
+	assert_true(size > 48 && size < sizeof(contents));
+
+	// the bounds, the block size, the number of prefix sums and the summand's terminator
+	const struct corruption {
+		size_t offset;
+		int64_t value;
+	} corruptions[] = {
+		{ 8, 31 }, { 16, -21 }, { 24, 0 }, { 24, 3 }, { 32, 12 }, { 32, 0 }, { 48 + 24, 1 },
+	};
+	for (size_t i = 0; i < sizeof(corruptions) / sizeof(corruptions[0]); i++) {
+		char corrupted[sizeof(contents)];
+		memcpy(corrupted, contents, size);
+		memcpy(&corrupted[corruptions[i].offset], &corruptions[i].value, sizeof(int64_t));
+
+		stream = fopen(path, "wb");
+		assert_non_null(stream);
+		assert_int_equal(fwrite(corrupted, 1, size, stream), size);
+		fclose(stream);
+
+		struct prefix_table loaded;
+		assert_int_equal(prefix_table_load(&loaded, path), EXIT_FAILURE);
+	}
+
+	unlink(path);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_prefix_table_dense),
+		cmocka_unit_test(test_prefix_table_blocked),
+		cmocka_unit_test(test_prefix_table_save_load),
+		cmocka_unit_test(test_prefix_table_invalid),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,88 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <math.h>
+#include <product.h>
+
+#define EPSILON (0.000000001)
+
+static void test_product(void **state) {
+	(void)state;
+
+	const struct {
+		long lower_bound;
+		long upper_bound;
+		const char *factor;
+		double product;
+	} test_cases[] = {
+		{ 1, 10, "i", 3628800 },
+		{ 1, 10, "-i", 3628800 },
+		{ 1, 11, "-i", -39916800 },
+		{ -3, 3, "i", 0 },
+		{ 1, 20, "1 + 1 / i", 21 },
+		{ 0, 1000, "0.5", 0 },
+		{ 5, 4, "i", 1 },
+	};
+
+	for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+		double expected = test_cases[i].product;
+		assert_float_equal(
+			product(test_cases[i].lower_bound, test_cases[i].upper_bound, test_cases[i].factor),
+			expected,
+			EPSILON * fmax(1, fabs(expected))
+		);
+	}
+}
+
+static void test_product_overflow(void **state) {
+	(void)state;
+
+	// 100000! and (-2)^100001 are far beyond the range of doubles
+	const char *factors[] = { "i", "-2", "i - 50000", "1 / i" };
+	size_t count = sizeof(factors) / sizeof(factors[0]);
+
+	struct product products[sizeof(factors) / sizeof(factors[0])];
+	product_fused(1, 100000, count, factors, products, NULL);
+
+	assert_float_equal(products[0].sign, 1, 0);
+	assert_float_equal(products[0].logarithm, lgamma(100001), EPSILON * lgamma(100001));
+	assert_true(isinf(product_value(&products[0])));
+
+	assert_float_equal(products[1].sign, 1, 0);
+	assert_float_equal(products[1].logarithm, 100000 * log(2), EPSILON * 100000);
+
+	assert_float_equal(products[2].sign, 0, 0);
+	assert_float_equal(product_value(&products[2]), 0, 0);
+
+	assert_float_equal(products[3].sign, 1, 0);
+	assert_float_equal(products[3].logarithm, -lgamma(100001), EPSILON * lgamma(100001));
+	assert_float_equal(product_value(&products[3]), 0, 0);
+
+	// the same reduction tree for any number of threads
+	struct summation_options options = summation_options_default();
+	options.threads_count = 1;
+
+	struct product single[sizeof(factors) / sizeof(factors[0])];
+	product_fused(1, 100000, count, factors, single, &options);
+
+	for (size_t i = 0; i < count; i++) {
+		assert_float_equal(single[i].sign, products[i].sign, 0);
+		assert_true(
+			(isinf(single[i].logarithm) && isinf(products[i].logarithm)) ||
+			fabs(single[i].logarithm - products[i].logarithm) <= 0
+		);
+	}
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_product),
+		cmocka_unit_test(test_product_overflow),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
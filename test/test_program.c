@@ -0,0 +1,342 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <fcntl.h>
+#include <math.h>
+#include <program.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define EPSILON (0.000000001)
+
+static void test_program_common_subexpressions(void **state) {
+	(void)state;
+
+	struct expression expressions[] = {
+		expression_from_string("sin(x) * sin(x)"),
+		expression_from_string("x * sin(x)"),
+		expression_from_string("sin(x)"),
+	};
+	size_t count = sizeof(expressions) / sizeof(expressions[0]);
+
+	struct program program = program_new(count, expressions);
+
+	// x, sin(x), sin(x) * sin(x), x * sin(x)
+	assert_int_equal(program.instructions_count, 4);
+	assert_int_equal(program.outputs_count, count);
+	assert_int_equal(program.outputs[2], 1);
+
+	program_drop(&program);
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+}
+
+static void test_program_evaluate(void **state) {
+	(void)state;
+
+	struct expression expressions[] = {
+		expression_from_string("x ^ 2 + 2 * y"),
+		expression_from_string("log(x ^ 2) - y"),
+	};
+	size_t count = sizeof(expressions) / sizeof(expressions[0]);
+
+	struct program program = program_new(count, expressions);
+
+	struct environment environment = environment_new();
+	environment_set_variable(&environment, 'x', 3);
+	environment_set_variable(&environment, 'y', 0.5);
+
+	double *values = malloc(program.instructions_count * sizeof(*values));
+	double results[2];
+	program_evaluate(&program, &environment, values, results);
+
+	for (size_t i = 0; i < count; i++) {
+		assert_float_equal(
+			results[i],
+			expression_evaluate(&expressions[i], &environment),
+			EPSILON
+		);
+	}
+
+	free(values);
+	program_drop(&program);
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+}
+
+static void test_program_evaluate_block(void **state) {
+	(void)state;
+
+	struct expression expressions[] = {
+		expression_from_string("x ^ 2 + 2 * y / x"),
+		expression_from_string("sin(x) * y - 1"),
+		expression_from_string("if(x % 3, max(x, y), abs(x - 9)) + (x <= 2) - min(x, floor(y))"),
+	};
+	size_t count = sizeof(expressions) / sizeof(expressions[0]);
+
+	struct program program = program_new(count, expressions);
+
+	struct environment environment = environment_new();
+	environment_set_variable(&environment, 'y', 0.5);
+
+	double indices[PROGRAM_BLOCK_SIZE];
+	for (size_t i = 0; i < PROGRAM_BLOCK_SIZE; i++) {
+		indices[i] = (double)i - 7;
+	}
+
+	double *values = malloc(program.instructions_count * PROGRAM_BLOCK_SIZE * sizeof(*values));
+	double *scalar_values = malloc(program.instructions_count * sizeof(*scalar_values));
+
+	// a full block, and a partial one
+	const size_t sizes[] = { PROGRAM_BLOCK_SIZE, 13 };
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		program_evaluate_block(&program, &environment, 'x', indices, sizes[i], values);
+
+		for (size_t j = 0; j < sizes[i]; j++) {
+			environment_set_variable(&environment, 'x', indices[j]);
+
+			double results[sizeof(expressions) / sizeof(expressions[0])];
+			program_evaluate(&program, &environment, scalar_values, results);
+
+			for (size_t k = 0; k < count; k++) {
+				assert_float_equal(
+					values[program.outputs[k] * sizes[i] + j],
+					results[k],
+					EPSILON
+				);
+			}
+		}
+	}
+
+	free(scalar_values);
+	free(values);
+	program_drop(&program);
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+}
+
+static void test_program_select(void **state) {
+	(void)state;
+
+	struct expression expressions[] = {
+		expression_from_string("sin(x) * y"),
+		expression_from_string("cos(x) + 1"),
+		expression_from_string("y ^ 2"),
+	};
+	size_t count = sizeof(expressions) / sizeof(expressions[0]);
+
+	struct program program = program_new(count, expressions);
+
+	const size_t outputs[] = { 2, 0 };
+	struct program selection = program_select(&program, 2, outputs);
+
+	// x, sin(x), y, sin(x) * y, 2, y ^ 2
+	assert_int_equal(selection.instructions_count, 6);
+	assert_int_equal(selection.outputs_count, 2);
+
+	struct environment environment = environment_new();
+	environment_set_variable(&environment, 'x', 0.25);
+	environment_set_variable(&environment, 'y', 3);
+
+	double values[16];
+	double results[3];
+	double selected_results[2];
+	program_evaluate(&program, &environment, values, results);
+	program_evaluate(&selection, &environment, values, selected_results);
+	assert_float_equal(selected_results[0], results[2], 0);
+	assert_float_equal(selected_results[1], results[0], 0);
+
+	program_drop(&selection);
+	program_drop(&program);
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+}
+
+static void test_program_evaluate_recurrence(void **state) {
+	(void)state;
+
+	struct expression expressions[] = {
+		expression_from_string("sin(x / 3 + 1) * cos(2 * x)"),
+		expression_from_string("exp(-x / 50) + 2 ^ (x / 8)"),
+		expression_from_string("sin(x * x)"),
+	};
+	size_t count = sizeof(expressions) / sizeof(expressions[0]);
+
+	struct program program = program_new(count, expressions);
+
+	double *steps = malloc(program.instructions_count * sizeof(*steps));
+	program_steps(&program, NULL, 'x', steps);
+
+	size_t recurrences_count = 0;
+	for (size_t i = 0; i < program.instructions_count; i++) {
+		recurrences_count += program_is_recurrence(&program, steps, i);
+	}
+	// sin(x / 3 + 1), cos(2 * x), exp(-x / 50), 2 ^ (x / 8)
+	assert_int_equal(recurrences_count, 4);
+
+	double indices[PROGRAM_BLOCK_SIZE];
+	for (size_t i = 0; i < PROGRAM_BLOCK_SIZE; i++) {
+		indices[i] = (double)i - 100;
+	}
+
+	double *values = malloc(program.instructions_count * PROGRAM_BLOCK_SIZE * sizeof(*values));
+	double *expected = malloc(program.instructions_count * PROGRAM_BLOCK_SIZE * sizeof(*values));
+
+	program_evaluate_block(&program, NULL, 'x', indices, PROGRAM_BLOCK_SIZE, expected);
+	program_evaluate_recurrence(&program, NULL, 'x', indices, PROGRAM_BLOCK_SIZE, steps, values);
+
+	for (size_t i = 0; i < count; i++) {
+		for (size_t j = 0; j < PROGRAM_BLOCK_SIZE; j++) {
+			double value = expected[program.outputs[i] * PROGRAM_BLOCK_SIZE + j];
+			assert_float_equal(
+				values[program.outputs[i] * PROGRAM_BLOCK_SIZE + j],
+				value,
+				EPSILON * fmax(1, fabs(value))
+			);
+		}
+	}
+
+	free(expected);
+	free(values);
+	free(steps);
+	program_drop(&program);
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+}
+
+static void test_program_evaluate_recurrence_combinatorics(void **state) {
+	(void)state;
+
+	struct expression expressions[] = {
+		expression_from_string("binom(30, x) + x! / 3 - binom(x + 4, 4)"),
+		expression_from_string("lfact(2 * x) + lbinom(x + 40, 5) - lgamma(x + 0.5)"),
+		expression_from_string("gamma(x) * lbinom(1000, x)"),
+	};
+	size_t count = sizeof(expressions) / sizeof(expressions[0]);
+
+	struct program program = program_new(count, expressions);
+
+	double *steps = malloc(program.instructions_count * sizeof(*steps));
+	program_steps(&program, NULL, 'x', steps);
+
+	size_t recurrences_count = 0;
+	for (size_t i = 0; i < program.instructions_count; i++) {
+		recurrences_count += program_is_recurrence(&program, steps, i);
+	}
+	assert_int_equal(recurrences_count, 8);
+
+	double *values = malloc(program.instructions_count * PROGRAM_BLOCK_SIZE * sizeof(*values));
+	double *expected = malloc(program.instructions_count * PROGRAM_BLOCK_SIZE * sizeof(*values));
+
+	// poles and zeros in the first block keep it from using the recurrences
+	const double firsts[] = { -20, 0, 1 };
+	for (size_t i = 0; i < sizeof(firsts) / sizeof(firsts[0]); i++) {
+		double indices[PROGRAM_BLOCK_SIZE];
+		for (size_t j = 0; j < PROGRAM_BLOCK_SIZE; j++) {
+			indices[j] = firsts[i] + (double)j;
+		}
+
+		program_evaluate_block(&program, NULL, 'x', indices, PROGRAM_BLOCK_SIZE, expected);
+		program_evaluate_recurrence(&program, NULL, 'x', indices, PROGRAM_BLOCK_SIZE, steps, values);
+
+		for (size_t j = 0; j < count; j++) {
+			for (size_t k = 0; k < PROGRAM_BLOCK_SIZE; k++) {
+				double value = expected[program.outputs[j] * PROGRAM_BLOCK_SIZE + k];
+				double result = values[program.outputs[j] * PROGRAM_BLOCK_SIZE + k];
+				if (isfinite(value)) {
+					assert_float_equal(result, value, EPSILON * fmax(1, fabs(value)));
+				} else {
+					assert_true(isnan(value) ? isnan(result) : result == value);
+				}
+			}
+		}
+	}
+
+	free(expected);
+	free(values);
+	free(steps);
+	program_drop(&program);
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+}
+
+static void test_program_save_load(void **state) {
+	(void)state;
+
+	struct expression expressions[] = {
+		expression_from_string("x ^ 2 + 2 * y"),
+		expression_from_string("sin(x ^ 2) / y"),
+	};
+	size_t count = sizeof(expressions) / sizeof(expressions[0]);
+
+	struct program program = program_new(count, expressions);
+
+	char path[] = "/tmp/test_program_XXXXXX";
+	int file = mkstemp(path);
+	assert_true(file >= 0);
+	close(file);
+
+	assert_int_equal(program_save(&program, "key", 3, path), EXIT_SUCCESS);
+
+	// only with the key it was saved with
+	struct program loaded;
+	assert_int_equal(program_load(&loaded, "yek", 3, path), EXIT_FAILURE);
+	assert_int_equal(program_load(&loaded, "key!", 4, path), EXIT_FAILURE);
+	assert_int_equal(program_load(&loaded, NULL, 0, path), EXIT_FAILURE);
+	assert_int_equal(program_load(&loaded, "key", 3, path), EXIT_SUCCESS);
+	assert_non_null(loaded.mapping);
+	assert_int_equal(loaded.instructions_count, program.instructions_count);
+	assert_int_equal(loaded.outputs_count, program.outputs_count);
+
+	struct environment environment = environment_new();
+	environment_set_variable(&environment, 'x', 1.5);
+	environment_set_variable(&environment, 'y', -4);
+
+	double *values = malloc(program.instructions_count * sizeof(*values));
+	double results[2];
+	double loaded_results[2];
+	program_evaluate(&program, &environment, values, results);
+	program_evaluate(&loaded, &environment, values, loaded_results);
+	assert_memory_equal(results, loaded_results, sizeof(results));
+
+	free(values);
+	program_drop(&loaded);
+	program_drop(&program);
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+
+	// anything else is rejected
+	file = open(path, O_WRONLY | O_TRUNC);
+	assert_true(file >= 0);
+	assert_int_equal(write(file, "not a program, definitely", 25), 25);
+	close(file);
+	assert_int_equal(program_load(&loaded, "key", 3, path), EXIT_FAILURE);
+
+	unlink(path);
+	assert_int_equal(program_load(&loaded, "key", 3, path), EXIT_FAILURE);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_program_common_subexpressions),
+		cmocka_unit_test(test_program_evaluate),
+		cmocka_unit_test(test_program_evaluate_block),
+		cmocka_unit_test(test_program_select),
+		cmocka_unit_test(test_program_evaluate_recurrence),
+		cmocka_unit_test(test_program_evaluate_recurrence_combinatorics),
+		cmocka_unit_test(test_program_save_load),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
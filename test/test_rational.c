@@ -0,0 +1,134 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <math.h>
+#include <rational.h>
+
+#define EPSILON (0.000000001)
+
+static void test_rational_from_program(void **state) {
+	(void)state;
+
+	const struct {
+		const char *expression;
+		bool is_rational;
+	} test_cases[] = {
+		{ "1 / i", true },
+		{ "1 / (i ^ 2 + 3 * i + 2)", true },
+		{ "i / (i + 5) ^ 2", true },
+		{ "1 / (i * i)", true },
+		{ "1 / (4 * i ^ 2 - 1)", true },
+		{ "(i ^ 3 + 1) / (i * (i + 0.5))", true },
+		{ "1 / i - 2 / (2 * i + 3) ^ 3 + i / 4", true },
+		{ "(i ^ 2 - 1) / (i + 1)", true },
+		{ "1 / (2 * i - 101)", true },
+		{ "3 / (2 * i - 101) ^ 2 - 1 / (3 * i + 1000)", true },
+		{ "i ^ 2 / ((i + 1000) ^ 4 * (i + 7))", true },
+		{ "1 / (i ^ 2 + 1)", false },
+		{ "1 / (i * (i + 0.1234567))", false },
+		{ "sin(i) / i", false },
+		{ "exp(i) / i", false },
+		{ "1 / (x + i)", false },
+	};
+	size_t count = sizeof(test_cases) / sizeof(test_cases[0]);
+
+	struct expression expressions[sizeof(test_cases) / sizeof(test_cases[0])];
+	struct environment environment = environment_new();
+	for (size_t i = 0; i < count; i++) {
+		expressions[i] = expression_from_string(test_cases[i].expression);
+		expression_simplify(&expressions[i], &environment);
+	}
+
+	struct program program = program_new(count, expressions);
+
+	const long bounds[][2] = { { 1, 1 }, { 1, 2 }, { 3, 1000 }, { 10, 100000 } };
+	for (size_t i = 0; i < sizeof(bounds) / sizeof(bounds[0]); i++) {
+		struct rational rationals[sizeof(test_cases) / sizeof(test_cases[0])];
+		bool is_rational[sizeof(test_cases) / sizeof(test_cases[0])];
+		rational_from_program(&program, 'i', bounds[i][0], bounds[i][1], rationals, is_rational);
+
+		for (size_t j = 0; j < count; j++) {
+			assert_int_equal(is_rational[j], test_cases[j].is_rational);
+			if (!is_rational[j]) {
+				continue;
+			}
+
+			double expected = 0;
+			double magnitude = 0;
+			for (long k = bounds[i][1]; k >= bounds[i][0]; k--) {
+				environment_set_variable(&environment, 'i', (double)k);
+				double term = expression_evaluate(&expressions[j], &environment);
+				expected += term;
+				magnitude += fabs(term);
+			}
+
+			assert_float_equal(rational_sum(&rationals[j]), expected, magnitude * EPSILON);
+		}
+	}
+
+	// poles in the range, but not between its integers
+	struct rational rationals[sizeof(test_cases) / sizeof(test_cases[0])];
+	bool is_rational[sizeof(test_cases) / sizeof(test_cases[0])];
+	rational_from_program(&program, 'i', -10, 10, rationals, is_rational);
+	assert_false(is_rational[0]);
+	assert_false(is_rational[1]);
+	assert_false(is_rational[7]);
+	assert_true(is_rational[4]);
+	assert_true(is_rational[9]);
+	assert_int_equal(rationals[9].fractions_count, 2);
+
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+
+	program_drop(&program);
+}
+
+static void test_rational_fraction_sum(void **state) {
+	(void)state;
+
+	// harmonic numbers, and differences of zetas and digammas, each to within rounding errors
+	assert_float_equal(
+		rational_fraction_sum(0, 1, 1, 1000000000000),
+		28.208236780830581068824,
+		1e-14 * 28.2
+	);
+	assert_float_equal(
+		rational_fraction_sum(0, 2, 1, 1000000000000),
+		1.644934066847226436472,
+		1e-15 * 1.64
+	);
+	assert_float_equal(
+		rational_fraction_sum(0, 1, 1000000000, 1000001000),
+		0.000001000999499500333833249,
+		1e-15 * 0.000001
+	);
+	assert_float_equal(
+		rational_fraction_sum(-0.5, 2, 0, 1000000),
+		4.934801200545679308500,
+		1e-15 * 4.93
+	);
+
+	// the indices on either side of the root
+	const double mirrored = -1.263162812816890283e-8;
+	assert_true(
+		fabs(rational_fraction_sum(50.5, 3, -2000, 2000) - mirrored) <= 1e-12 * fabs(mirrored)
+	);
+	assert_float_equal(rational_fraction_sum(2.5, 1, 2, 3), 0, EPSILON);
+	assert_float_equal(rational_fraction_sum(2.5, 2, 2, 3), 8, EPSILON);
+
+	assert_float_equal(rational_fraction_sum(0, 1, 2, 1), 0, EPSILON);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_rational_from_program),
+		cmocka_unit_test(test_rational_fraction_sum),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
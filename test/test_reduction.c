@@ -0,0 +1,127 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <math.h>
+#include <reduction.h>
+#include <scheduler.h>
+
+#define EPSILON (0.000000001)
+
+static void test_reduction_add(void **state) {
+	(void)state;
+
+	const double terms[] = { 3, -1, 4, NAN, 1, -5, INFINITY, 9, -5, 2 };
+	size_t count = sizeof(terms) / sizeof(terms[0]);
+
+	struct reduction reduction = reduction_new();
+	reduction_add(&reduction, -3, count, terms);
+
+	assert_int_equal(reduction.count, 10);
+	assert_int_equal(reduction.non_finite_count, 2);
+	assert_true(isnan(reduction.sum));
+	assert_float_equal(reduction.minimum, -5, EPSILON);
+	assert_int_equal(reduction.minimum_index, 2);
+	assert_float_equal(reduction.maximum, 9, EPSILON);
+	assert_int_equal(reduction.maximum_index, 4);
+	assert_float_equal(reduction.mean, 1, EPSILON);
+	assert_float_equal(reduction_variance(&reduction), 154.0 / 8, EPSILON);
+	assert_float_equal(reduction.absolute_sum, 30, EPSILON);
+	assert_float_equal(reduction_l2_norm(&reduction), sqrt(162), EPSILON);
+
+	// empty ranges
+	struct reduction empty = reduction_new();
+	reduction_add(&empty, 0, 0, NULL);
+	assert_int_equal(empty.count, 0);
+	assert_float_equal(empty.sum, 0, EPSILON);
+	assert_true(isinf(empty.minimum) && empty.minimum > 0);
+	assert_true(isinf(empty.maximum) && empty.maximum < 0);
+	assert_true(isnan(reduction_variance(&empty)));
+	assert_float_equal(reduction_l2_norm(&empty), 0, EPSILON);
+}
+
+static void test_reduction_merge(void **state) {
+	(void)state;
+
+	// large offsets cancel in the deviations, and large terms would overflow their squares
+	double terms[1000];
+	for (size_t i = 0; i < 1000; i++) {
+		terms[i] = 1e9 + (double)(i % 7) - (i == 500 ? NAN : 0);
+	}
+	const double large[] = { 1e200, -1e200, 1e-200 };
+
+	struct reduction expected = reduction_new();
+	reduction_add(&expected, 10, 1000, terms);
+	reduction_add(&expected, 1010, 3, large);
+
+	// any split merged back gives the same reduction
+	const size_t splits[] = { 0, 1, 499, 500, 501, 999, 1000 };
+	for (size_t i = 0; i < sizeof(splits) / sizeof(splits[0]); i++) {
+		struct reduction reductions[3] = { reduction_new(), reduction_new(), reduction_new() };
+		reduction_add(&reductions[0], 10, splits[i], terms);
+		reduction_add(&reductions[1], 10 + (long)splits[i], 1000 - splits[i], &terms[splits[i]]);
+		reduction_add(&reductions[2], 1010, 3, large);
+
+		struct reduction reduction = reduction_combine(reductions, 3, 1);
+		assert_int_equal(reduction.count, expected.count);
+		assert_int_equal(reduction.non_finite_count, 1);
+		assert_float_equal(reduction.minimum, -1e200, EPSILON);
+		assert_int_equal(reduction.minimum_index, 1011);
+		assert_float_equal(reduction.maximum, 1e200, EPSILON);
+		assert_int_equal(reduction.maximum_index, 1010);
+		assert_float_equal(
+			reduction_l2_norm(&reduction),
+			sqrt(2) * 1e200,
+			EPSILON * sqrt(2) * 1e200
+		);
+		assert_float_equal(reduction_l2_norm(&reduction), reduction_l2_norm(&expected), 1e191);
+	}
+
+	// the variance of the offset terms alone, within rounding errors of the small deviations
+	struct reduction reductions[2] = { reduction_new(), reduction_new() };
+	reduction_add(&reductions[0], 0, 300, terms);
+	reduction_add(&reductions[1], 300, 700, &terms[300]);
+	struct reduction reduction = reduction_combine(reductions, 2, 1);
+
+	double mean = 0;
+	for (size_t i = 0; i < 1000; i++) {
+		mean += i == 500 ? 0 : (double)(i % 7);
+	}
+	mean /= 999;
+	double variance = 0;
+	for (size_t i = 0; i < 1000; i++) {
+		double deviation = (double)(i % 7) - mean;
+		variance += i == 500 ? 0 : deviation * deviation;
+	}
+	variance /= 999;
+
+	assert_float_equal(reduction.mean, 1e9 + mean, 1e-5);
+	assert_float_equal(reduction_variance(&reduction), variance, 1e-5);
+	assert_int_equal(reduction.minimum_index, 0);
+	assert_int_equal(reduction.maximum_index, 6);
+
+	// the sums are merged like scheduler_sum()
+	struct reduction parts[5];
+	double sums[5];
+	for (size_t i = 0; i < 5; i++) {
+		parts[i] = reduction_new();
+		reduction_add(&parts[i], (long)i * 99, 99, &terms[i * 99]);
+		sums[i] = parts[i].sum;
+	}
+	double sum = reduction_combine(parts, 5, 1).sum;
+	double expected_sum = scheduler_sum(sums, 5, 1);
+	assert_memory_equal(&sum, &expected_sum, sizeof(sum));
+	assert_int_equal(reduction_combine(NULL, 0, 1).count, 0);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_reduction_add),
+		cmocka_unit_test(test_reduction_merge),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
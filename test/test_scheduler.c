@@ -0,0 +1,116 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <scheduler.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define EPSILON (0.000000001)
+#define LEAVES_COUNT 997
+#define THREADS_MAXIMUM 8
+
+struct context {
+	atomic_int visits[LEAVES_COUNT];
+	atomic_int threads[LEAVES_COUNT];
+};
+
+static void leaf_function(void *context_, size_t thread, size_t leaf) {
+	struct context *context = context_;
+
+	// make the later leaves more expensive, so that there's something to steal
+	volatile double sink = 0;
+	for (size_t i = 0; i < leaf * 10; i++) {
+		sink += (double)i;
+	}
+
+	atomic_fetch_add(&context->visits[leaf], 1);
+	atomic_store(&context->threads[leaf], (int)thread);
+}
+
+static void test_scheduler_run(void **state) {
+	(void)state;
+
+	for (size_t threads_count = 1; threads_count <= THREADS_MAXIMUM; threads_count++) {
+		struct context *context = calloc(1, sizeof(*context));
+		assert_non_null(context);
+
+		double busy_seconds[THREADS_MAXIMUM];
+		size_t leaves_count[THREADS_MAXIMUM];
+		struct scheduler_statistics statistics = {
+			.busy_seconds = busy_seconds,
+			.leaves_count = leaves_count,
+		};
+
+		scheduler_run(threads_count, LEAVES_COUNT, leaf_function, context, &statistics);
+
+		size_t total = 0;
+		for (size_t i = 0; i < threads_count; i++) {
+			total += leaves_count[i];
+		}
+		assert_int_equal(total, LEAVES_COUNT);
+
+		for (size_t i = 0; i < LEAVES_COUNT; i++) {
+			assert_int_equal(atomic_load(&context->visits[i]), 1);
+			assert_true((size_t)atomic_load(&context->threads[i]) < threads_count);
+		}
+
+		free(context);
+	}
+}
+
+static void test_scheduler_partition(void **state) {
+	(void)state;
+
+	const struct {
+		long lower_bound;
+		long upper_bound;
+		size_t parts_count;
+	} test_cases[] = {
+		{ 1, 10, 3 }, { -5, 5, 11 }, { 0, 0, 1 }, { -1000, 12345, 64 }, { 7, 100, 1 },
+	};
+
+	for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+		long expected_lower_bound = test_cases[i].lower_bound;
+		for (size_t part = 0; part < test_cases[i].parts_count; part++) {
+			long lower_bound = 0;
+			long upper_bound = 0;
+			scheduler_partition(
+				test_cases[i].lower_bound,
+				test_cases[i].upper_bound,
+				test_cases[i].parts_count,
+				part,
+				&lower_bound,
+				&upper_bound
+			);
+			assert_int_equal(lower_bound, expected_lower_bound);
+			assert_true(lower_bound <= upper_bound);
+			expected_lower_bound = upper_bound + 1;
+		}
+		assert_int_equal(expected_lower_bound, test_cases[i].upper_bound + 1);
+	}
+}
+
+static void test_scheduler_sum(void **state) {
+	(void)state;
+
+	double values[] = { 1, 100, 2, 200, 3, 300, 4, 400, 5, 500 };
+
+	assert_float_equal(scheduler_sum(values, 0, 2), 0, EPSILON);
+	assert_float_equal(scheduler_sum(values, 5, 2), 15, EPSILON);
+	assert_float_equal(scheduler_sum(&values[1], 5, 2), 1500, EPSILON);
+	assert_float_equal(scheduler_sum(values, 10, 1), 1515, EPSILON);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_scheduler_run),
+		cmocka_unit_test(test_scheduler_partition),
+		cmocka_unit_test(test_scheduler_sum),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
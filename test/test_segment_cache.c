@@ -0,0 +1,152 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <cache.h>
+#include <dirent.h>
+#include <math.h>
+#include <segment_cache.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <summation.h>
+#include <unistd.h>
+
+#define EPSILON (0.000000001)
+
+static void test_segment_cache_put(void **state) {
+	(void)state;
+
+	char directory[] = "/tmp/test_segment_cache_XXXXXX";
+	assert_non_null(mkdtemp(directory));
+
+	char path[sizeof(directory) + 16];
+	(void)snprintf(path, sizeof(path), "%s/cache.segments", directory);
+
+	// room for two entries
+	struct segment_cache cache;
+	assert_int_equal(segment_cache_open(&cache, path, segment_cache_size(2) + 1), EXIT_SUCCESS);
+	assert_int_equal(cache.entries_count, 2);
+
+	double sum = 0;
+	assert_false(segment_cache_get(&cache, 0, 20, &sum));
+	segment_cache_put(&cache, 0, 20, 1.5);
+	segment_cache_put(&cache, 1 << 21, 21, 2.5);
+	assert_true(segment_cache_get(&cache, 0, 20, &sum));
+	assert_float_equal(sum, 1.5, EPSILON);
+	assert_false(segment_cache_get(&cache, 0, 21, &sum));
+
+	assert_true(segment_cache_has_inside(&cache, 0, 22));
+	assert_true(segment_cache_has_inside(&cache, 0, 21));
+	assert_false(segment_cache_has_inside(&cache, 0, 20));
+	assert_false(segment_cache_has_inside(&cache, 1 << 22, 22));
+
+	// the least recently used entry is evicted
+	segment_cache_put(&cache, -(1L << 20), 20, 3.5);
+	assert_false(segment_cache_get(&cache, 1 << 21, 21, &sum));
+	assert_true(segment_cache_get(&cache, 0, 20, &sum));
+	assert_true(segment_cache_get(&cache, -(1L << 20), 20, &sum));
+	assert_float_equal(sum, 3.5, EPSILON);
+
+	segment_cache_close(&cache);
+
+	// the entries persist, and so does the size of the cache
+	assert_int_equal(segment_cache_open(&cache, path, segment_cache_size(64)), EXIT_SUCCESS);
+	assert_int_equal(cache.entries_count, 2);
+	assert_true(segment_cache_get(&cache, 0, 20, &sum));
+	assert_float_equal(sum, 1.5, EPSILON);
+	segment_cache_close(&cache);
+
+	unlink(path);
+	rmdir(directory);
+}
+
+static void test_segment_cache_summation(void **state) {
+	(void)state;
+
+	char directory[] = "/tmp/test_segment_cache_XXXXXX";
+	assert_non_null(mkdtemp(directory));
+
+	struct summation_options options = summation_options_default();
+	options.cache_directory = directory;
+	options.segment_cache_size = segment_cache_size(256);
+
+	const char *const summands[] = { "sin(i) / i", "i", "cos(i)^2" };
+	const long bounds[][2] = {
+		{ 1, 10000000 },
+		{ 1, 11000000 },
+		{ 3000000, 11000000 },
+		{ -5000000, -1000000 },
+		{ 1, 1000 },
+	};
+
+	for (size_t i = 0; i < sizeof(bounds) / sizeof(bounds[0]); i++) {
+		double sums[3];
+		summation_fused(bounds[i][0], bounds[i][1], 3, summands, sums, &options);
+
+		// assembling segments only changes the rounding of the totals
+		double expected[3];
+		summation_fused(bounds[i][0], bounds[i][1], 3, summands, expected, NULL);
+		for (size_t j = 0; j < 3; j++) {
+			assert_float_equal(sums[j], expected[j], fabs(expected[j]) * EPSILON + EPSILON);
+		}
+	}
+
+	// the second range reuses the segments of the first one
+	struct environment environment = environment_new();
+	struct expression expression = expression_from_string(summands[0]);
+	expression_simplify(&expression, &environment);
+	char *canonical = expression_to_string(&expression);
+	expression_drop(&expression);
+
+	uint64_t key = cache_hash(CACHE_HASH_INITIAL, "segments", sizeof("segments"));
+	key = cache_hash(key, canonical, strlen(canonical) + 1);
+	free(canonical);
+
+	char *path = cache_path(directory, key, "segments");
+	assert_non_null(path);
+
+	struct segment_cache cache;
+	assert_int_equal(segment_cache_open(&cache, path, segment_cache_size(1)), EXIT_SUCCESS);
+	assert_int_equal(cache.entries_count, 256);
+
+	double sum = 0;
+	assert_true(segment_cache_get(&cache, 1L << 20, 20, &sum));
+	assert_true(segment_cache_get(&cache, 1L << 22, 22, &sum));
+	assert_true(segment_cache_get(&cache, 1L << 23, 21, &sum));
+	assert_true(segment_cache_get(&cache, -(1L << 22), 21, &sum));
+	segment_cache_close(&cache);
+
+	// closed forms aren't cached
+	DIR *entries = opendir(directory);
+	assert_non_null(entries);
+	size_t segments_count = 0;
+	struct dirent *entry = NULL;
+	while ((entry = readdir(entries)) != NULL) {
+		if (strstr(entry->d_name, ".segments") != NULL) {
+			++segments_count;
+		}
+		if (entry->d_name[0] != '.') {
+			char file[sizeof(directory) + 256];
+			(void)snprintf(file, sizeof(file), "%s/%s", directory, entry->d_name);
+			unlink(file);
+		}
+	}
+	closedir(entries);
+	assert_int_equal(segments_count, 2);
+
+	free(path);
+	rmdir(directory);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_segment_cache_put),
+		cmocka_unit_test(test_segment_cache_summation),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
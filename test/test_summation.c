@@ -5,7 +5,13 @@
 
 #include <cmocka.h>
 
+#include <dirent.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <summation.h>
+#include <unistd.h>
 
 #define EPSILON (0.000000001)
 
@@ -51,7 +57,13 @@ static const struct test_case {
 		.upper_bound = 7,
 		.summand = "i^i",
 		.summation = 873612.212963,
-	}
+	},
+	{
+		.lower_bound = 1,
+		.upper_bound = 1000000,
+		.summand = "1 / (i * (i + 1))",
+		.summation = 0.999999000001,
+	},
 };
 
 static void test_summation(void **state) {
@@ -65,9 +77,338 @@ static void test_summation(void **state) {
 		);
 	}
 }
+
+static void test_summation_fused(void **state) {
+	(void)state;
+
+	const char *summands[sizeof(test_cases) / sizeof(test_cases[0])];
+	for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+		summands[i] = test_cases[i].summand;
+	}
+
+	double sums[sizeof(test_cases) / sizeof(test_cases[0])];
+	summation_fused(0, 7, sizeof(summands) / sizeof(summands[0]), summands, sums, NULL);
+
+	for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+		assert_float_equal(sums[i], summation(0, 7, test_cases[i].summand), EPSILON);
+	}
+}
+
+static void test_summation_threads(void **state) {
+	(void)state;
+
+	const char *summands[] = { "sin(i) / i", "1 / i ^ 2", "i" };
+	size_t count = sizeof(summands) / sizeof(summands[0]);
+
+	struct summation_options options = summation_options_default();
+	options.threads_count = 1;
+
+	double expected[sizeof(summands) / sizeof(summands[0])];
+	summation_fused(1, 1000000, count, summands, expected, &options);
+
+	// the totals are the same for any number of threads
+	for (size_t threads_count = 2; threads_count <= 8; threads_count++) {
+		options.threads_count = threads_count;
+
+		double sums[sizeof(summands) / sizeof(summands[0])];
+		summation_fused(1, 1000000, count, summands, sums, &options);
+
+		assert_memory_equal(sums, expected, sizeof(sums));
+	}
+}
+
+static void test_summation_engines(void **state) {
+	(void)state;
+
+	const char *summands[] = { "sin(i) / i", "1 / i ^ 2", "i * (i - 3)" };
+	size_t count = sizeof(summands) / sizeof(summands[0]);
+
+	struct summation_options options = summation_options_default();
+
+	options.engine = summation_engine_scalar;
+	double expected[sizeof(summands) / sizeof(summands[0])];
+	summation_fused(1, 100000, count, summands, expected, &options);
+
+	options.engine = summation_engine_block;
+	double sums[sizeof(summands) / sizeof(summands[0])];
+	summation_fused(1, 100000, count, summands, sums, &options);
+
+	for (size_t i = 0; i < count; i++) {
+		assert_float_equal(sums[i], expected[i], EPSILON * fabs(expected[i]));
+	}
+}
+
+static void test_summation_shifted(void **state) {
+	(void)state;
+
+	// shifted powers far from the origin, whose expanded coefficients would cancel out
+	const char *summands[] = { "(i - 100000) ^ 4", "1 / (1 + 1000000 * (i - 100000) ^ 2)" };
+	size_t count = sizeof(summands) / sizeof(summands[0]);
+	const double expected[] = { 50666, 1 + 2 * (1 / (1 + 1e6) + 1 / (1 + 4e6)) };
+
+	const enum summation_engine engines[] = {
+		summation_engine_automatic,
+		summation_engine_scalar,
+		summation_engine_block,
+		summation_engine_recurrence,
+	};
+	for (size_t i = 0; i < sizeof(engines) / sizeof(engines[0]); i++) {
+		struct summation_options options = summation_options_default();
+		options.engine = engines[i];
+
+		double sums[sizeof(summands) / sizeof(summands[0])];
+		summation_fused(99990, 100010, 1, summands, sums, &options);
+		summation_fused(99998, 100002, 1, &summands[1], &sums[1], &options);
+		for (size_t j = 0; j < count; j++) {
+			assert_true(fabs(sums[j] - expected[j]) <= EPSILON * expected[j]);
+		}
+	}
+}
+
+static void test_summation_plan(void **state) {
+	(void)state;
+
+	const char *summands[] = {
+		"sin(i) / i",
+		"(i + 1) ^ 2",
+		"2 ^ (-i / 100)",
+		"max(0, i - 1000) * i + abs(i - 50) * (i < 10) + if(i >= 7, i, 2)",
+		"floor(i / 3) + if(i % 2, i, -i)",
+		"log(i + 1000) - log(i + 999)",
+		"sin(3.141592653589793 * i / 6) * (i % 4)",
+		"(i + 0.5) / (i + 700.25) ^ 2",
+	};
+	size_t count = sizeof(summands) / sizeof(summands[0]);
+
+	struct summation_plan plan = summation_plan_new(-500, 100000, count, summands, NULL);
+
+	assert_false(plan.is_closed_form[0]);
+	assert_true(plan.is_closed_form[1]);
+	assert_int_equal(plan.polynomials[1].pieces_count, 1);
+	assert_int_equal(plan.polynomials[1].pieces[0].degree, 2);
+	assert_false(plan.is_closed_form[2]);
+	assert_true(plan.is_closed_form[3]);
+	assert_int_equal(plan.polynomials[3].pieces_count, 4);
+	assert_false(plan.is_closed_form[4]);
+	assert_true(plan.is_closed_form[5]);
+	assert_true(plan.is_telescoping[5]);
+	assert_false(plan.is_telescoping[1]);
+	assert_true(plan.is_closed_form[6]);
+	assert_true(plan.is_periodic[6]);
+	assert_int_equal(plan.periodicities[6].period, 12);
+	assert_true(plan.is_closed_form[7]);
+	assert_true(plan.is_rational[7]);
+	assert_int_equal(plan.rationals[7].fractions_count, 2);
+	assert_false(plan.is_rational[1]);
+	assert_int_equal(plan.program.outputs_count, 3);
+	assert_int_not_equal(plan.engine, summation_engine_automatic);
+	assert_true(plan.threads_count >= 1);
+
+	double sums[sizeof(summands) / sizeof(summands[0])];
+	summation_plan_execute(&plan, sums);
+	summation_plan_drop(&plan);
+
+	// forcing an engine evaluates every summand with it
+	struct summation_options options = summation_options_default();
+	options.engine = summation_engine_block;
+
+	plan = summation_plan_new(-500, 100000, count, summands, &options);
+	assert_false(plan.is_closed_form[1]);
+	assert_int_equal(plan.engine, summation_engine_block);
+
+	double expected[sizeof(summands) / sizeof(summands[0])];
+	summation_plan_execute(&plan, expected);
+	summation_plan_drop(&plan);
+
+	for (size_t i = 0; i < count; i++) {
+		if (isnan(expected[i])) {
+			assert_true(isnan(sums[i]));
+		} else {
+			assert_true(fabs(sums[i] - expected[i]) <= EPSILON * fmax(1, fabs(expected[i])));
+		}
+	}
+
+	options.engine = summation_engine_recurrence;
+	summation_fused(-500, 100000, count, summands, sums, &options);
+	for (size_t i = 0; i < count; i++) {
+		if (isnan(expected[i])) {
+			assert_true(isnan(sums[i]));
+		} else {
+			assert_true(fabs(sums[i] - expected[i]) <= EPSILON * fmax(1, fabs(expected[i])));
+		}
+	}
+
+	// recurrences seeded with values which underflow are evaluated exactly instead
+	const char *underflowing = "exp(i)";
+	double underflowing_sums[2];
+	options.engine = summation_engine_scalar;
+	summation_fused(-760, -505, 1, &underflowing, &underflowing_sums[0], &options);
+	options.engine = summation_engine_recurrence;
+	summation_fused(-760, -505, 1, &underflowing, &underflowing_sums[1], &options);
+	assert_true(underflowing_sums[0] > 0);
+	assert_true(
+		fabs(underflowing_sums[1] - underflowing_sums[0]) <= EPSILON * underflowing_sums[0]
+	);
+
+	// polynomials in disguise are found from their values
+	const char *summand = "exp(2 * log(i))";
+	plan = summation_plan_new(1, 100000, 1, &summand, NULL);
+	assert_true(plan.is_closed_form[0]);
+	assert_int_equal(plan.polynomials[0].pieces[0].degree, 2);
+	summation_plan_execute(&plan, sums);
+	summation_plan_drop(&plan);
+	assert_float_equal(sums[0], 333338333350000, EPSILON * 333338333350000);
+}
+
+static void test_summation_reduce(void **state) {
+	(void)state;
+
+	const char *summands[] = { "sin(i) / i", "1 / (i - 500)", "(i - 3000) ^ 2", "i % 7" };
+	size_t count = sizeof(summands) / sizeof(summands[0]);
+
+	// the terms in closed form are evaluated too, and added up in the same order as by blocks
+	struct summation_options options = summation_options_default();
+	options.engine = summation_engine_block;
+	double expected[sizeof(summands) / sizeof(summands[0])];
+	summation_fused(1, 100000, count, summands, expected, &options);
+
+	for (size_t threads_count = 1; threads_count <= 3; threads_count++) {
+		options.threads_count = threads_count;
+		options.engine = threads_count == 3 ? summation_engine_scalar : summation_engine_automatic;
+
+		struct reduction reductions[sizeof(summands) / sizeof(summands[0])];
+		summation_reduce_fused(1, 100000, count, summands, reductions, &options);
+
+		for (size_t i = 0; i < count; i++) {
+			assert_int_equal(reductions[i].count, 100000);
+			if (i != 1) {
+				assert_memory_equal(&reductions[i].sum, &expected[i], sizeof(expected[i]));
+			}
+		}
+
+		assert_int_equal(reductions[0].maximum_index, 1);
+		assert_float_equal(reductions[0].maximum, sin(1), EPSILON);
+		assert_int_equal(reductions[1].non_finite_count, 1);
+		assert_true(isinf(reductions[1].sum));
+		assert_float_equal(reductions[1].minimum, -1, EPSILON);
+		assert_int_equal(reductions[1].minimum_index, 499);
+		assert_float_equal(reductions[1].maximum, 1, EPSILON);
+		assert_int_equal(reductions[1].maximum_index, 501);
+		assert_float_equal(reductions[2].minimum, 0, EPSILON);
+		assert_int_equal(reductions[2].minimum_index, 3000);
+		assert_int_equal(reductions[2].maximum_index, 100000);
+		assert_float_equal(reductions[3].mean, 3, EPSILON);
+		assert_float_equal(reductions[3].absolute_sum, 300000, EPSILON);
+	}
+
+	// empty ranges
+	struct reduction reductions[sizeof(summands) / sizeof(summands[0])];
+	summation_reduce_fused(2, 1, count, summands, reductions, NULL);
+	for (size_t i = 0; i < count; i++) {
+		assert_int_equal(reductions[i].count, 0);
+		assert_float_equal(reductions[i].sum, 0, EPSILON);
+	}
+}
+
+static void test_summation_cache(void **state) {
+	(void)state;
+
+	char directory[] = "/tmp/test_summation_XXXXXX";
+	assert_non_null(mkdtemp(directory));
+
+	struct summation_options options = summation_options_default();
+	options.cache_directory = directory;
+
+	// the first pass fills the cache, and the second one is served from it
+	for (size_t pass = 0; pass < 2; pass++) {
+		for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++) {
+			double sum = 0;
+			summation_fused(
+				(long)test_cases[i].lower_bound,
+				(long)test_cases[i].upper_bound,
+				1,
+				&test_cases[i].summand,
+				&sum,
+				&options
+			);
+			assert_float_equal(sum, test_cases[i].summation, EPSILON);
+		}
+	}
+
+	DIR *entries = opendir(directory);
+	assert_non_null(entries);
+	size_t count = 0;
+	for (struct dirent *entry = readdir(entries); entry != NULL; entry = readdir(entries)) {
+		if (entry->d_name[0] != '.') {
+			char path[sizeof(directory) + sizeof(entry->d_name) + 1];
+			(void)snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+			assert_int_equal(unlink(path), 0);
+			++count;
+		}
+	}
+	closedir(entries);
+	assert_true(count > 0);
+	rmdir(directory);
+}
+
+/**
+ * @brief Finds the cached file not named `other`, or any if `other` is empty.
+ */
+static void find_cached(const char *directory, const char *other, char *path, size_t size) {
+	DIR *entries = opendir(directory);
+	assert_non_null(entries);
+	path[0] = '\0';
+	for (struct dirent *entry = readdir(entries); entry != NULL; entry = readdir(entries)) {
+		if (entry->d_name[0] != '.') {
+			(void)snprintf(path, size, "%s/%s", directory, entry->d_name);
+			if (strcmp(path, other) != 0) {
+				break;
+			}
+		}
+	}
+	closedir(entries);
+	assert_true(path[0] != '\0' && strcmp(path, other) != 0);
+}
+
+static void test_summation_cache_collision(void **state) {
+	(void)state;
+
+	char directory[] = "/tmp/test_summation_XXXXXX";
+	assert_non_null(mkdtemp(directory));
+
+	struct summation_options options = summation_options_default();
+	options.cache_directory = directory;
+
+	const char *const summands[] = { "i", "i ^ 2" };
+	char paths[2][sizeof(directory) + 256];
+	double sums[2];
+	for (size_t i = 0; i < 2; i++) {
+		summation_fused(1, 100, 1, &summands[i], &sums[i], &options);
+		find_cached(directory, i == 0 ? "" : paths[0], paths[i], sizeof(paths[i]));
+	}
+	assert_float_equal(sums[0], 5050, EPSILON);
+	assert_float_equal(sums[1], 338350, EPSILON);
+
+	// the program of another summand under the same hash isn't taken for this one's
+	assert_int_equal(rename(paths[0], paths[1]), 0);
+	summation_fused(1, 100, 1, &summands[1], &sums[1], &options);
+	assert_float_equal(sums[1], 338350, EPSILON);
+
+	assert_int_equal(unlink(paths[1]), 0);
+	rmdir(directory);
+}
+
 int main(void) {
 	const struct CMUnitTest tests[] = {
 		cmocka_unit_test(test_summation),
+		cmocka_unit_test(test_summation_fused),
+		cmocka_unit_test(test_summation_threads),
+		cmocka_unit_test(test_summation_engines),
+		cmocka_unit_test(test_summation_shifted),
+		cmocka_unit_test(test_summation_plan),
+		cmocka_unit_test(test_summation_reduce),
+		cmocka_unit_test(test_summation_cache),
+		cmocka_unit_test(test_summation_cache_collision),
 	};
 
 	return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,133 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <environment.h>
+#include <expression.h>
+#include <math.h>
+#include <stdlib.h>
+#include <summation.h>
+#include <sweep.h>
+
+#define EPSILON (0.000000001)
+
+static void test_sweep_parse(void **state) {
+	(void)state;
+
+	struct sweep sweep;
+	assert_int_equal(sweep_parse(&sweep, "x=-1:2:5"), EXIT_SUCCESS);
+	assert_int_equal(sweep.variable, 'x');
+	assert_int_equal(sweep.values_count, 5);
+	const double grid[] = { -1, -0.25, 0.5, 1.25, 2 };
+	for (size_t i = 0; i < 5; i++) {
+		assert_float_equal(sweep.values[i], grid[i], EPSILON);
+	}
+	sweep_drop(&sweep);
+
+	assert_int_equal(sweep_parse(&sweep, "a=3:7:1"), EXIT_SUCCESS);
+	assert_int_equal(sweep.values_count, 1);
+	assert_float_equal(sweep.values[0], 3, EPSILON);
+	sweep_drop(&sweep);
+
+	assert_int_equal(sweep_parse(&sweep, "y=0.5,-2,1e3"), EXIT_SUCCESS);
+	assert_int_equal(sweep.variable, 'y');
+	assert_int_equal(sweep.values_count, 3);
+	assert_float_equal(sweep.values[0], 0.5, EPSILON);
+	assert_float_equal(sweep.values[1], -2, EPSILON);
+	assert_float_equal(sweep.values[2], 1000, EPSILON);
+	sweep_drop(&sweep);
+
+	// the index, missing values, and malformed grids
+	const char *const invalid[] = {
+		"i=1,2", "x", "x=", "=1", "1=2", "x=1,", "x=1,,2", "x=1:2", "x=1:2:0", "x=1:2:2.5",
+		"x=1:2:3:4", "x=1;2",
+	};
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+		assert_int_equal(sweep_parse(&sweep, invalid[i]), EXIT_FAILURE);
+	}
+}
+
+static void test_sweep_summation_fused(void **state) {
+	(void)state;
+
+	// enough values for several blocks and a partial one
+	struct sweep sweep;
+	assert_int_equal(sweep_parse(&sweep, "x=-2:3:601"), EXIT_SUCCESS);
+
+	const char *const summands[] = {
+		"x^i / i!", "sin(i * x) / i", "i", "x", "y", "x * x + i * log(i) - x * i",
+		// constants under instructions only depending on i
+		"x^(i + 1)", "x * (i / 2)", "x * sin(i + 1)",
+	};
+	size_t count = sizeof(summands) / sizeof(summands[0]);
+
+	struct summation_options options = summation_options_default();
+	double *sums = malloc(sweep.values_count * count * sizeof(*sums));
+	double *expected = malloc(sweep.values_count * count * sizeof(*expected));
+
+	// the terms are added up in index order, as by a direct evaluation
+	struct expression expressions[sizeof(summands) / sizeof(summands[0])];
+	for (size_t i = 0; i < count; i++) {
+		expressions[i] = expression_from_string(summands[i]);
+	}
+	for (size_t i = 0; i < sweep.values_count; i++) {
+		struct environment environment = environment_new();
+		environment_set_variable(&environment, 'x', sweep.values[i]);
+		for (size_t j = 0; j < count; j++) {
+			expected[i * count + j] = 0;
+			for (long k = 1; k <= 60; k++) {
+				environment_set_variable(&environment, 'i', (double)k);
+				expected[i * count + j] += expression_evaluate(&expressions[j], &environment);
+			}
+		}
+	}
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+
+	for (size_t threads_count = 1; threads_count <= 2; threads_count++) {
+		options.threads_count = threads_count;
+		sweep_summation_fused(1, 60, &sweep, count, summands, sums, &options);
+		for (size_t i = 0; i < sweep.values_count * count; i++) {
+			if (isnan(expected[i])) {
+				assert_true(isnan(sums[i]));
+			} else {
+				assert_float_equal(sums[i], expected[i], fmax(fabs(expected[i]), 1) * EPSILON);
+			}
+		}
+	}
+
+	// empty ranges sum to 0
+	sweep_summation_fused(2, 1, &sweep, count, summands, sums, NULL);
+	for (size_t i = 0; i < sweep.values_count * count; i++) {
+		assert_float_equal(sums[i], 0, EPSILON);
+	}
+
+	free(expected);
+	free(sums);
+	sweep_drop(&sweep);
+
+	// few values over a long range, split over it
+	assert_int_equal(sweep_parse(&sweep, "x=1,2"), EXIT_SUCCESS);
+	const char *summand = "x^(i / 1e7) / exp(x)";
+	double split_sums[2];
+	sweep_summation_fused(1, 20000000, &sweep, 1, &summand, split_sums, &options);
+	const char *const substituted[] = { "1^(i / 1e7) / exp(1)", "2^(i / 1e7) / exp(2)" };
+	for (size_t i = 0; i < 2; i++) {
+		double expected_sum = summation(1, 20000000, substituted[i]);
+		assert_true(fabs(split_sums[i] - expected_sum) <= EPSILON * expected_sum);
+	}
+	sweep_drop(&sweep);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_sweep_parse),
+		cmocka_unit_test(test_sweep_summation_fused),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,139 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <math.h>
+#include <task.h>
+#include <time.h>
+
+#define EPSILON (0.000000001)
+
+static double seconds_now(void) {
+	struct timespec time;
+	(void)clock_gettime(CLOCK_MONOTONIC, &time);
+	return (double)time.tv_sec + (double)time.tv_nsec / 1000000000.0;
+}
+
+struct progress {
+	size_t reports_count;
+	unsigned long terms_done;
+	unsigned long terms_count;
+	double sums[2];
+};
+
+static void record_progress(void *context, const struct summation_progress *progress) {
+	struct progress *recorded = context;
+
+	assert_true(progress->terms_done >= recorded->terms_done);
+	assert_true(progress->terms_done <= progress->terms_count);
+	assert_true(progress->count <= 2);
+
+	++recorded->reports_count;
+	recorded->terms_done = progress->terms_done;
+	recorded->terms_count = progress->terms_count;
+	for (size_t i = 0; i < progress->count; i++) {
+		recorded->sums[i] = progress->sums[i];
+	}
+}
+
+static void test_task(void **state) {
+	(void)state;
+
+	const char *summands[] = { "sin(i) / i", "i ^ 2" };
+	size_t count = sizeof(summands) / sizeof(summands[0]);
+
+	double expected[sizeof(summands) / sizeof(summands[0])];
+	summation_fused(1, 1000000, count, summands, expected, NULL);
+
+	struct progress progress = { 0 };
+	struct task *task = task_submit(1, 1000000, count, summands, NULL, record_progress, &progress);
+
+	assert_true(task_wait(task, -1));
+	assert_int_equal(task_status(task), task_status_done);
+
+	double sums[sizeof(summands) / sizeof(summands[0])];
+	assert_int_equal(task_result(task, sums), EXIT_SUCCESS);
+
+	// the last report is the totals
+	assert_true(progress.reports_count >= 1);
+	assert_int_equal(progress.terms_done, 1000000);
+	assert_int_equal(progress.terms_count, 1000000);
+	for (size_t i = 0; i < count; i++) {
+		assert_float_equal(sums[i], expected[i], EPSILON * fabs(expected[i]));
+		assert_float_equal(progress.sums[i], sums[i], 0);
+	}
+
+	task_drop(task);
+}
+
+static void test_task_cancel(void **state) {
+	(void)state;
+
+	const char *summand = "sin(i) * cos(i / 3)";
+	struct summation_options options = summation_options_default();
+	options.engine = summation_engine_scalar;
+
+	// far too many terms to ever finish
+	struct progress progress = { 0 };
+	struct task *task =
+		task_submit(1, 1000000000000000, 1, &summand, &options, record_progress, &progress);
+
+	assert_false(task_wait(task, 0.2));
+	assert_int_equal(task_status(task), task_status_running);
+
+	double start = seconds_now();
+	task_cancel(task);
+	assert_true(task_wait(task, -1));
+	double seconds = seconds_now() - start;
+
+	assert_int_equal(task_status(task), task_status_cancelled);
+	assert_true(seconds < 0.1);
+	assert_true(progress.reports_count >= 1);
+	assert_true(progress.terms_done > 0);
+
+	double sum = 0;
+	assert_int_equal(task_result(task, &sum), EXIT_FAILURE);
+
+	task_drop(task);
+}
+
+static void test_task_queue(void **state) {
+	(void)state;
+
+	const char *summand = "sin(i)";
+
+	// more long tasks than the pool has threads, so that the last ones stay queued
+	struct task *tasks[TASK_POOL_THREADS_COUNT + 2];
+	for (size_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); i++) {
+		tasks[i] = task_submit(1, 1000000000000000, 1, &summand, NULL, NULL, NULL);
+	}
+
+	struct task *last = tasks[sizeof(tasks) / sizeof(tasks[0]) - 1];
+	assert_int_equal(task_status(last), task_status_queued);
+	task_cancel(last);
+	assert_int_equal(task_status(last), task_status_cancelled);
+
+	// dropping cancels the others
+	for (size_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); i++) {
+		task_drop(tasks[i]);
+	}
+
+	// and the pool is free again
+	struct task *task = task_submit(1, 100, 1, &summand, NULL, NULL, NULL);
+	assert_true(task_wait(task, -1));
+	assert_int_equal(task_status(task), task_status_done);
+	task_drop(task);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_task),
+		cmocka_unit_test(test_task_cancel),
+		cmocka_unit_test(test_task_queue),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
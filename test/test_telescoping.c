@@ -0,0 +1,165 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include <math.h>
+#include <telescoping.h>
+
+#define EPSILON (0.000000001)
+
+static void test_telescoping_from_program(void **state) {
+	(void)state;
+
+	const struct {
+		const char *expression;
+		bool is_telescoping;
+	} test_cases[] = {
+		{ "log(i + 1) - log(i)", true },
+		{ "sin(2 * (i + 1)) - sin(2 * i)", true },
+		{ "3 * exp(-(i + 2) / 7) - 3 * exp(-i / 7)", true },
+		{ "1 / i - 2 / (i + 1) + 1 / (i + 2)", true },
+		{ "1 / (i * (i + 1))", true },
+		{ "(2 * i + 3) / ((i + 1) * (i + 2) * (i + 3))", true },
+		{ "2 / (i ^ 2 + 4 * i + 3) + 1 / (i + 3) - 1 / (i + 5)", true },
+		{ "log(i + 1) + log(i)", false },
+		{ "log(i + 1) - log(2 * i)", false },
+		{ "1 / i", false },
+		{ "1 / (i * i)", false },
+		{ "1 / (i * (i + 1) + 1)", false },
+		{ "1 / (i * (i + 0.5))", false },
+		{ "i / (i * (i + 1))", false },
+		{ "1 / (i * (i + 100))", false },
+		{ "sin(x + 1) - sin(x)", false },
+	};
+	size_t count = sizeof(test_cases) / sizeof(test_cases[0]);
+
+	struct expression expressions[sizeof(test_cases) / sizeof(test_cases[0])];
+	struct environment environment = environment_new();
+	for (size_t i = 0; i < count; i++) {
+		expressions[i] = expression_from_string(test_cases[i].expression);
+		expression_simplify(&expressions[i], &environment);
+	}
+
+	struct program program = program_new(count, expressions);
+
+	const long bounds[][2] = { { 1, 1 }, { 1, 2 }, { 3, 1000 }, { 10, 100000 } };
+	for (size_t i = 0; i < sizeof(bounds) / sizeof(bounds[0]); i++) {
+		struct telescoping telescopings[sizeof(test_cases) / sizeof(test_cases[0])];
+		bool is_telescoping[sizeof(test_cases) / sizeof(test_cases[0])];
+		telescoping_from_program(
+			&program,
+			'i',
+			bounds[i][0],
+			bounds[i][1],
+			telescopings,
+			is_telescoping
+		);
+
+		for (size_t j = 0; j < count; j++) {
+			assert_int_equal(is_telescoping[j], test_cases[j].is_telescoping);
+			if (!is_telescoping[j]) {
+				continue;
+			}
+
+			double expected = 0;
+			for (long k = bounds[i][1]; k >= bounds[i][0]; k--) {
+				environment_set_variable(&environment, 'i', (double)k);
+				expected += expression_evaluate(&expressions[j], &environment);
+			}
+
+			assert_float_equal(telescoping_sum(&telescopings[j]), expected, EPSILON);
+			telescoping_drop(&telescopings[j]);
+		}
+	}
+
+	// poles in the range, of the fractions or of the shifted function, checked at each index of
+	// short ranges and from the operations over long ones
+	const long upper_bounds[] = { 10, 100000 };
+	for (size_t i = 0; i < sizeof(upper_bounds) / sizeof(upper_bounds[0]); i++) {
+		struct telescoping telescopings[sizeof(test_cases) / sizeof(test_cases[0])];
+		bool is_telescoping[sizeof(test_cases) / sizeof(test_cases[0])];
+		telescoping_from_program(&program, 'i', -10, upper_bounds[i], telescopings, is_telescoping);
+		assert_false(is_telescoping[0]);
+		assert_true(is_telescoping[1]);
+		assert_true(is_telescoping[2]);
+		assert_false(is_telescoping[3]);
+		assert_false(is_telescoping[4]);
+		assert_false(is_telescoping[5]);
+		for (size_t j = 0; j < count; j++) {
+			if (is_telescoping[j]) {
+				telescoping_drop(&telescopings[j]);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		expression_drop(&expressions[i]);
+	}
+
+	program_drop(&program);
+
+	// the shifted function is undefined at 0, inside the range or at its end
+	const char *const shifted[] = { "1 / i - 1 / (i + 1)", "1 / i - 1 / (i + 2)" };
+	struct expression shifted_expressions[2];
+	for (size_t i = 0; i < 2; i++) {
+		shifted_expressions[i] = expression_from_string(shifted[i]);
+	}
+	program = program_new(2, shifted_expressions);
+
+	const long shifted_bounds[][2] = { { -3, 5 }, { -10, -2 }, { -100000, 100000 } };
+	for (size_t i = 0; i < sizeof(shifted_bounds) / sizeof(shifted_bounds[0]); i++) {
+		struct telescoping telescopings[2];
+		bool is_telescoping[2];
+		telescoping_from_program(
+			&program,
+			'i',
+			shifted_bounds[i][0],
+			shifted_bounds[i][1],
+			telescopings,
+			is_telescoping
+		);
+		assert_false(is_telescoping[1]);
+		assert_true(is_telescoping[0] == (shifted_bounds[i][1] < -1));
+		if (is_telescoping[0]) {
+			assert_true(fabs(telescoping_sum(&telescopings[0]) - 0.9) <= EPSILON);
+			telescoping_drop(&telescopings[0]);
+		}
+	}
+
+	for (size_t i = 0; i < 2; i++) {
+		expression_drop(&shifted_expressions[i]);
+	}
+	program_drop(&program);
+}
+
+static void test_telescoping_sum(void **state) {
+	(void)state;
+
+	const char *summand = "1 / (i * (i + 1))";
+
+	struct expression expression = expression_from_string(summand);
+	struct program program = program_new(1, &expression);
+
+	// the partial sums are 1 - 1 / (n + 1), without any rounding errors piling up
+	struct telescoping telescoping;
+	bool is_telescoping = false;
+	telescoping_from_program(&program, 'i', 1, 1000000000000, &telescoping, &is_telescoping);
+	assert_true(is_telescoping);
+	assert_float_equal(telescoping_sum(&telescoping), 1 - 1 / 1000000000001.0, 1e-15);
+
+	telescoping_drop(&telescoping);
+	program_drop(&program);
+	expression_drop(&expression);
+}
+
+int main(void) {
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_telescoping_from_program),
+		cmocka_unit_test(test_telescoping_sum),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}